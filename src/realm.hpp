@@ -20,7 +20,9 @@
 #define REALM_HPP
 
 #include <realm/group_shared.hpp>
+#include <realm/async_query.hpp>
 #include <realm/descriptor.hpp>
+#include <realm/group_by.hpp>
 #include <realm/link_view.hpp>
 #include <realm/table_view.hpp>
 #include <realm/query.hpp>
@@ -680,22 +680,10 @@ MemRef SlabAlloc::do_realloc(size_t ref, char* addr, size_t old_size, size_t new
 }
 
 
-char* SlabAlloc::do_translate(ref_type ref) const noexcept
+inline char* SlabAlloc::do_translate_uncached(ref_type ref) const noexcept
 {
-    REALM_ASSERT_DEBUG(is_attached());
-    REALM_ASSERT_RELEASE_EX(!(ref & 7), ref, get_file_path_for_assertions());
-
     const char* addr = nullptr;
 
-    size_t cache_index = ref ^ ((ref >> 16) >> 16);
-    // we shift by 16 two times. On 32-bitters it's undefined to shift by
-    // 32. Shifting twice x16 however, is defined and gives zero. On 64-bitters
-    // the compiler should reduce it to a single 32 bit shift.
-    cache_index = cache_index ^ (cache_index >> 16);
-    cache_index = (cache_index ^ (cache_index >> 8)) & 0xFF;
-    if (cache[cache_index].ref == ref && cache[cache_index].version == version)
-        return const_cast<char*>(cache[cache_index].addr);
-
     if (ref < m_baseline) {
 
         const util::File::Map<char>* map;
@@ -735,11 +723,38 @@ char* SlabAlloc::do_translate(ref_type ref) const noexcept
         ref_type slab_ref = i == m_slabs.begin() ? m_baseline : (i - 1)->ref_end;
         addr = i->addr.get() + (ref - slab_ref);
     }
+    REALM_ASSERT_DEBUG(addr != nullptr);
+    return const_cast<char*>(addr);
+}
+
+
+char* SlabAlloc::do_translate(ref_type ref) const noexcept
+{
+    REALM_ASSERT_DEBUG(is_attached());
+    REALM_ASSERT_RELEASE_EX(!(ref & 7), ref, get_file_path_for_assertions());
+
+    size_t cache_index = ref ^ ((ref >> 16) >> 16);
+    // we shift by 16 two times. On 32-bitters it's undefined to shift by
+    // 32. Shifting twice x16 however, is defined and gives zero. On 64-bitters
+    // the compiler should reduce it to a single 32 bit shift.
+    cache_index = cache_index ^ (cache_index >> 16);
+    cache_index = (cache_index ^ (cache_index >> 8)) & 0xFF;
+    if (cache[cache_index].ref == ref && cache[cache_index].version == version)
+        return const_cast<char*>(cache[cache_index].addr);
+
+    char* addr = do_translate_uncached(ref);
     cache[cache_index].addr = addr;
     cache[cache_index].ref = ref;
     cache[cache_index].version = version;
-    REALM_ASSERT_DEBUG(addr != nullptr);
-    return const_cast<char*>(addr);
+    return addr;
+}
+
+
+char* SlabAlloc::translate_uncached(ref_type ref) const noexcept
+{
+    REALM_ASSERT_DEBUG(is_attached());
+    REALM_ASSERT_RELEASE_EX(!(ref & 7), ref, get_file_path_for_assertions());
+    return do_translate_uncached(ref);
 }
 
 
@@ -323,12 +323,18 @@ public:
 #endif
     struct MappedFile;
 
+    /// Same as translate(), but bypasses the translation cache, which is not
+    /// thread-safe. It may therefore be called from several threads at once,
+    /// provided that none of them modifies the allocator in the meantime.
+    char* translate_uncached(ref_type) const noexcept;
+
 protected:
     MemRef do_alloc(const size_t size) override;
     MemRef do_realloc(ref_type, char*, size_t old_size, size_t new_size) override;
     // FIXME: It would be very nice if we could detect an invalid free operation in debug mode
     void do_free(ref_type, char*) noexcept override;
     char* do_translate(ref_type) const noexcept override;
+    char* do_translate_uncached(ref_type) const noexcept;
 
     /// Returns the first section boundary *above* the given position.
     size_t get_upper_section_boundary(size_t start_pos) const noexcept;
@@ -0,0 +1,331 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/array_basic.hpp>
+
+#ifdef REALM_COMPILER_AVX
+
+#include <immintrin.h>
+
+// The AVX functions are compiled for AVX regardless of the target of the rest of the library, and must only be
+// called after checking sseavx<1>(). MSVC accepts the intrinsics without any annotation.
+#if defined(__GNUC__) || defined(__clang__)
+#define REALM_TARGET_AVX __attribute__((target("avx")))
+#else
+#define REALM_TARGET_AVX
+#endif
+
+using namespace realm;
+
+namespace {
+
+inline size_t first_set_bit(unsigned mask) noexcept
+{
+#ifdef _MSC_VER
+    unsigned long ndx;
+    _BitScanForward(&ndx, mask);
+    return ndx;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// Overloads for the float and double vectors, so that the kernels below can be written once. A float vector holds 8
+// elements and a double vector 4.
+
+REALM_TARGET_AVX inline __m256 load(const float* p) noexcept
+{
+    return _mm256_loadu_ps(p);
+}
+
+REALM_TARGET_AVX inline __m256d load(const double* p) noexcept
+{
+    return _mm256_loadu_pd(p);
+}
+
+REALM_TARGET_AVX inline __m256 broadcast(float value) noexcept
+{
+    return _mm256_set1_ps(value);
+}
+
+REALM_TARGET_AVX inline __m256d broadcast(double value) noexcept
+{
+    return _mm256_set1_pd(value);
+}
+
+template <int predicate>
+REALM_TARGET_AVX inline __m256 compare(__m256 a, __m256 b) noexcept
+{
+    return _mm256_cmp_ps(a, b, predicate);
+}
+
+template <int predicate>
+REALM_TARGET_AVX inline __m256d compare(__m256d a, __m256d b) noexcept
+{
+    return _mm256_cmp_pd(a, b, predicate);
+}
+
+REALM_TARGET_AVX inline unsigned bits(__m256 mask) noexcept
+{
+    return unsigned(_mm256_movemask_ps(mask));
+}
+
+REALM_TARGET_AVX inline unsigned bits(__m256d mask) noexcept
+{
+    return unsigned(_mm256_movemask_pd(mask));
+}
+
+// All ones in the lanes holding the null NaN. AVX has no 256 bit integer comparison, so the halves are compared
+// separately.
+REALM_TARGET_AVX inline __m256 null_mask(__m256 v) noexcept
+{
+    const __m128i null = _mm_castps_si128(_mm_set1_ps(null::get_null_float<float>()));
+    __m256i i = _mm256_castps_si256(v);
+    __m128i lo = ::_mm_cmpeq_epi32(_mm256_castsi256_si128(i), null);
+    __m128i hi = ::_mm_cmpeq_epi32(_mm256_extractf128_si256(i, 1), null);
+    return _mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+}
+
+REALM_TARGET_AVX inline __m256d null_mask(__m256d v) noexcept
+{
+    const __m128i null = _mm_castpd_si128(_mm_set1_pd(null::get_null_float<double>()));
+    __m256i i = _mm256_castpd_si256(v);
+    __m128i lo = ::_mm_cmpeq_epi64(_mm256_castsi256_si128(i), null);
+    __m128i hi = ::_mm_cmpeq_epi64(_mm256_extractf128_si256(i, 1), null);
+    return _mm256_castsi256_pd(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+}
+
+// Add the lanes, with the masked ones zeroed, to the double accumulator
+REALM_TARGET_AVX inline void accumulate(__m256d& acc, __m256 v, __m256 zero_mask) noexcept
+{
+    v = _mm256_andnot_ps(zero_mask, v);
+    acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+    acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+}
+
+REALM_TARGET_AVX inline void accumulate(__m256d& acc, __m256d v, __m256d zero_mask) noexcept
+{
+    acc = _mm256_add_pd(acc, _mm256_andnot_pd(zero_mask, v));
+}
+
+REALM_TARGET_AVX inline __m256 blend(__m256 a, __m256 b, __m256 mask) noexcept
+{
+    return _mm256_blendv_ps(a, b, mask);
+}
+
+REALM_TARGET_AVX inline __m256d blend(__m256d a, __m256d b, __m256d mask) noexcept
+{
+    return _mm256_blendv_pd(a, b, mask);
+}
+
+REALM_TARGET_AVX inline __m256 minmax(__m256 a, __m256 b, bool find_max) noexcept
+{
+    return find_max ? _mm256_max_ps(a, b) : _mm256_min_ps(a, b);
+}
+
+REALM_TARGET_AVX inline __m256d minmax(__m256d a, __m256d b, bool find_max) noexcept
+{
+    return find_max ? _mm256_max_pd(a, b) : _mm256_min_pd(a, b);
+}
+
+REALM_TARGET_AVX inline void store(float* p, __m256 v) noexcept
+{
+    _mm256_storeu_ps(p, v);
+}
+
+REALM_TARGET_AVX inline void store(double* p, __m256d v) noexcept
+{
+    _mm256_storeu_pd(p, v);
+}
+
+template <class T>
+struct Lanes {
+    static constexpr size_t value = 32 / sizeof(T);
+};
+
+
+template <class Condition, class T>
+REALM_TARGET_AVX size_t avx_find_first(const T* data, T value, size_t begin, size_t end) noexcept
+{
+    // The predicates are quiet, and all but NotEqual are ordered, so NaNs, including the null ones, never match. A
+    // null never equals a non-null value, so the unordered NotEqual matches it as it should.
+    const size_t lanes = Lanes<T>::value;
+    const auto needle = broadcast(value);
+    size_t i = begin;
+    for (; i + lanes <= end; i += lanes) {
+        unsigned matches = bits(compare<Condition::avx>(load(data + i), needle));
+        if (matches)
+            return i + first_set_bit(matches);
+    }
+    Condition cond;
+    for (; i < end; ++i) {
+        if (cond(data[i], value, null::is_null_float(data[i]), false))
+            return i;
+    }
+    return not_found;
+}
+
+template <class Condition, class T>
+REALM_TARGET_AVX size_t avx_count(const T* data, T value, size_t begin, size_t end) noexcept
+{
+    const size_t lanes = Lanes<T>::value;
+    const auto needle = broadcast(value);
+    size_t n = 0;
+    size_t i = begin;
+    for (; i + lanes <= end; i += lanes)
+        n += fast_popcount32(int32_t(bits(compare<Condition::avx>(load(data + i), needle))));
+    Condition cond;
+    for (; i < end; ++i)
+        n += cond(data[i], value, null::is_null_float(data[i]), false);
+    return n;
+}
+
+template <class T>
+REALM_TARGET_AVX double avx_sum(const T* data, size_t begin, size_t end, size_t* count) noexcept
+{
+    // Two accumulators, so that consecutive vectors do not wait for each other
+    const size_t lanes = Lanes<T>::value;
+    __m256d acc_1 = _mm256_setzero_pd();
+    __m256d acc_2 = _mm256_setzero_pd();
+    size_t nulls = 0;
+    size_t i = begin;
+    for (; i + 2 * lanes <= end; i += 2 * lanes) {
+        auto v_1 = load(data + i);
+        auto v_2 = load(data + i + lanes);
+        auto null_1 = null_mask(v_1);
+        auto null_2 = null_mask(v_2);
+        nulls += fast_popcount32(int32_t(bits(null_1) | (bits(null_2) << lanes)));
+        accumulate(acc_1, v_1, null_1);
+        accumulate(acc_2, v_2, null_2);
+    }
+    double partial[4];
+    _mm256_storeu_pd(partial, _mm256_add_pd(acc_1, acc_2));
+    double sum = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+    for (; i < end; ++i) {
+        if (null::is_null_float(data[i])) {
+            ++nulls;
+        }
+        else {
+            sum += data[i];
+        }
+    }
+    *count = end - begin - nulls;
+    return sum;
+}
+
+template <bool find_max, class T>
+REALM_TARGET_AVX size_t avx_find_minmax(const T* data, size_t begin, size_t end, size_t* count) noexcept
+{
+    // Find the extreme value first, with the NaNs replaced by a value which never wins, and then the first element
+    // which has it. This picks the same element as comparing one element at a time would, also when the extreme is
+    // zero and the elements have different signs.
+    const size_t lanes = Lanes<T>::value;
+    const T worst = find_max ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+    const auto worst_vector = broadcast(worst);
+    auto acc = worst_vector;
+    size_t nulls = 0;
+    size_t i = begin;
+    for (; i + lanes <= end; i += lanes) {
+        auto v = load(data + i);
+        nulls += fast_popcount32(int32_t(bits(null_mask(v))));
+        acc = minmax(acc, blend(v, worst_vector, compare<_CMP_UNORD_Q>(v, v)), find_max);
+    }
+    T partial[Lanes<T>::value];
+    store(partial, acc);
+    T extreme = worst;
+    for (T value : partial) {
+        if (find_max ? value > extreme : value < extreme)
+            extreme = value;
+    }
+    for (size_t j = i; j < end; ++j) {
+        if (null::is_null_float(data[j])) {
+            ++nulls;
+        }
+        else if (find_max ? data[j] > extreme : data[j] < extreme) {
+            extreme = data[j];
+        }
+    }
+    *count = end - begin - nulls;
+
+    // NaNs are never equal, and are therefore skipped
+    for (i = begin; i < end; ++i) {
+        if (data[i] == extreme)
+            return i;
+    }
+    return not_found;
+}
+
+} // anonymous namespace
+
+
+namespace realm {
+namespace _impl {
+
+// The target attribute must be on the first declaration of a function, so the functions declared in the header
+// forward to the kernels above.
+
+template <class Condition, class T>
+size_t find_first_avx(const T* data, T value, size_t begin, size_t end) noexcept
+{
+    return avx_find_first<Condition>(data, value, begin, end);
+}
+
+template <class Condition, class T>
+size_t count_avx(const T* data, T value, size_t begin, size_t end) noexcept
+{
+    return avx_count<Condition>(data, value, begin, end);
+}
+
+template <class T>
+double sum_avx(const T* data, size_t begin, size_t end, size_t* count) noexcept
+{
+    return avx_sum(data, begin, end, count);
+}
+
+template <bool find_max, class T>
+size_t find_minmax_avx(const T* data, size_t begin, size_t end, size_t* count) noexcept
+{
+    return avx_find_minmax<find_max>(data, begin, end, count);
+}
+
+
+#define REALM_INSTANTIATE_FIND(Condition, T)                                                                         \
+    template size_t find_first_avx<Condition, T>(const T*, T, size_t, size_t) noexcept;                              \
+    template size_t count_avx<Condition, T>(const T*, T, size_t, size_t) noexcept;
+
+#define REALM_INSTANTIATE(T)                                                                                         \
+    REALM_INSTANTIATE_FIND(Equal, T)                                                                                 \
+    REALM_INSTANTIATE_FIND(NotEqual, T)                                                                              \
+    REALM_INSTANTIATE_FIND(Greater, T)                                                                               \
+    REALM_INSTANTIATE_FIND(Less, T)                                                                                  \
+    REALM_INSTANTIATE_FIND(GreaterEqual, T)                                                                          \
+    REALM_INSTANTIATE_FIND(LessEqual, T)                                                                             \
+    template double sum_avx<T>(const T*, size_t, size_t, size_t*) noexcept;                                          \
+    template size_t find_minmax_avx<true, T>(const T*, size_t, size_t, size_t*) noexcept;                            \
+    template size_t find_minmax_avx<false, T>(const T*, size_t, size_t, size_t*) noexcept;
+
+REALM_INSTANTIATE(float)
+REALM_INSTANTIATE(double)
+
+#undef REALM_INSTANTIATE
+#undef REALM_INSTANTIATE_FIND
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_COMPILER_AVX
@@ -23,6 +23,21 @@
 
 namespace realm {
 
+namespace _impl {
+
+// AVX implementations of the BasicArray searches and aggregates below. They must only be called when `sseavx<1>()`
+// is true. See array_basic.cpp.
+template <class Condition, class T>
+size_t find_first_avx(const T* data, T value, size_t begin, size_t end) noexcept;
+template <class Condition, class T>
+size_t count_avx(const T* data, T value, size_t begin, size_t end) noexcept;
+template <class T>
+double sum_avx(const T* data, size_t begin, size_t end, size_t* count) noexcept;
+template <bool find_max, class T>
+size_t find_minmax_avx(const T* data, size_t begin, size_t end, size_t* count) noexcept;
+
+} // namespace _impl
+
 /// A BasicArray can currently only be used for simple unstructured
 /// types like float, double.
 template <class T>
@@ -54,6 +69,30 @@ public:
     bool maximum(T& result, size_t begin = 0, size_t end = npos) const;
     bool minimum(T& result, size_t begin = 0, size_t end = npos) const;
 
+    // The following use AVX when the CPU supports it. Null elements, which are stored as a NaN with a special
+    // payload, are never matched by the conditions, as long as `value` is not null itself, and are skipped by the
+    // aggregates.
+
+    /// Find the first element in [begin, end) for which `Condition(element, value)` holds. Condition must be one of
+    /// Equal, NotEqual, Greater, Less, GreaterEqual and LessEqual, and `value` must not be null.
+    template <class Condition>
+    size_t find_first(T value, size_t begin, size_t end) const noexcept;
+
+    /// Count the elements in [begin, end) for which `Condition(element, value)` holds, with the same restrictions as
+    /// find_first<Condition>().
+    template <class Condition>
+    size_t count(T value, size_t begin, size_t end) const noexcept;
+
+    /// Sum the non-null elements in [begin, end), and store their number in `*count`. The elements are not
+    /// necessarily added in order.
+    double sum(size_t begin, size_t end, size_t* count) const noexcept;
+
+    /// Return the index of the first element in [begin, end) which has the largest (or smallest) value, ignoring
+    /// nulls and NaNs, or `not_found` if there is no such element. The number of non-null elements is stored in
+    /// `*count`.
+    template <bool find_max>
+    size_t find_minmax(size_t begin, size_t end, size_t* count) const noexcept;
+
     /// Compare two arrays for equality.
     bool compare(const BasicArray<T>&) const;
 
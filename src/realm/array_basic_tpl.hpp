@@ -20,6 +20,7 @@
 #define REALM_ARRAY_BASIC_TPL_HPP
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <stdexcept>
 #include <iomanip>
@@ -315,18 +316,87 @@ size_t BasicArray<T>::count(T value, size_t begin, size_t end) const
     return std::count(data + begin, data + end, value);
 }
 
-#if 0
-// currently unused
 template <class T>
-double BasicArray<T>::sum(size_t begin, size_t end) const
+template <class Condition>
+size_t BasicArray<T>::find_first(T value, size_t begin, size_t end) const noexcept
 {
-    if (end == npos)
-        end = m_size;
-    REALM_ASSERT(begin <= m_size && end <= m_size && begin <= end);
+    REALM_ASSERT_DEBUG(begin <= end && end <= m_size);
+    REALM_ASSERT_DEBUG(!null::is_null_float(value));
+    const T* data = reinterpret_cast<const T*>(m_data);
+#ifdef REALM_COMPILER_AVX
+    if (sseavx<1>())
+        return _impl::find_first_avx<Condition>(data, value, begin, end);
+#endif
+    Condition cond;
+    for (size_t i = begin; i < end; ++i) {
+        if (cond(data[i], value, null::is_null_float(data[i]), false))
+            return i;
+    }
+    return not_found;
+}
+
+template <class T>
+template <class Condition>
+size_t BasicArray<T>::count(T value, size_t begin, size_t end) const noexcept
+{
+    REALM_ASSERT_DEBUG(begin <= end && end <= m_size);
+    REALM_ASSERT_DEBUG(!null::is_null_float(value));
+    const T* data = reinterpret_cast<const T*>(m_data);
+#ifdef REALM_COMPILER_AVX
+    if (sseavx<1>())
+        return _impl::count_avx<Condition>(data, value, begin, end);
+#endif
+    Condition cond;
+    size_t n = 0;
+    for (size_t i = begin; i < end; ++i)
+        n += cond(data[i], value, null::is_null_float(data[i]), false);
+    return n;
+}
+
+template <class T>
+double BasicArray<T>::sum(size_t begin, size_t end, size_t* count) const noexcept
+{
+    REALM_ASSERT_DEBUG(begin <= end && end <= m_size);
     const T* data = reinterpret_cast<const T*>(m_data);
-    return std::accumulate(data + begin, data + end, double(0));
+#ifdef REALM_COMPILER_AVX
+    if (sseavx<1>())
+        return _impl::sum_avx(data, begin, end, count);
+#endif
+    double sum = 0;
+    size_t n = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (!null::is_null_float(data[i])) {
+            sum += data[i];
+            ++n;
+        }
+    }
+    *count = n;
+    return sum;
 }
+
+template <class T>
+template <bool find_max>
+size_t BasicArray<T>::find_minmax(size_t begin, size_t end, size_t* count) const noexcept
+{
+    REALM_ASSERT_DEBUG(begin <= end && end <= m_size);
+    const T* data = reinterpret_cast<const T*>(m_data);
+#ifdef REALM_COMPILER_AVX
+    if (sseavx<1>())
+        return _impl::find_minmax_avx<find_max>(data, begin, end, count);
 #endif
+    size_t ndx = not_found;
+    size_t n = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (null::is_null_float(data[i]))
+            continue;
+        ++n;
+        // NaN compares false, so it is never chosen
+        if (ndx == not_found ? !std::isnan(data[i]) : (find_max ? data[i] > data[ndx] : data[i] < data[ndx]))
+            ndx = i;
+    }
+    *count = n;
+    return ndx;
+}
 
 template <class T>
 template <bool find_max>
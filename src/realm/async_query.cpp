@@ -0,0 +1,267 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/async_query.hpp>
+
+using namespace realm;
+
+using AsyncQuery = AsyncQueryExecutor::AsyncQuery;
+
+
+AsyncQueryExecutor::AsyncQueryExecutor(HistoryFactory make_history, SharedGroupOptions options, size_t num_threads)
+{
+    REALM_ASSERT(num_threads > 0);
+
+    // Attach all SharedGroups before starting any thread, so that a failure to
+    // open the file is reported here without any threads to clean up.
+    m_workers.resize(num_threads);
+    for (Worker& worker : m_workers) {
+        worker.history = make_history();                                      // Throws
+        worker.shared_group.reset(new SharedGroup(*worker.history, options)); // Throws
+    }
+
+    try {
+        for (Worker& worker : m_workers) {
+            SharedGroup& sg = *worker.shared_group;
+            worker.thread.start([this, &sg] { worker_loop(sg); }); // Throws
+        }
+    }
+    catch (...) {
+        {
+            util::LockGuard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_work_available.notify_all();
+        for (Worker& worker : m_workers) {
+            if (worker.thread.joinable())
+                worker.thread.join();
+        }
+        throw;
+    }
+}
+
+
+AsyncQueryExecutor::~AsyncQueryExecutor() noexcept
+{
+    {
+        util::LockGuard lock(m_mutex);
+        m_stopping = true;
+        // The workers still take the queued queries off the queue, as the
+        // versions they pin must be released by an attached SharedGroup.
+        for (auto& query : m_queue)
+            query->cancel();
+    }
+    m_work_available.notify_all();
+    for (Worker& worker : m_workers)
+        worker.thread.join();
+}
+
+
+std::shared_ptr<AsyncQuery> AsyncQueryExecutor::submit(SharedGroup& sg, const Query& query,
+                                                       bool cancel_on_new_version)
+{
+    auto handover = sg.export_for_handover(query, ConstSourcePayload::Copy); // Throws
+    return enqueue(sg, std::move(handover), nullptr, cancel_on_new_version); // Throws
+}
+
+
+std::shared_ptr<AsyncQuery> AsyncQueryExecutor::submit(SharedGroup& sg, const TableView& view,
+                                                       bool cancel_on_new_version)
+{
+    auto handover = sg.export_for_handover(view, ConstSourcePayload::Stay); // Throws
+    return enqueue(sg, nullptr, std::move(handover), cancel_on_new_version); // Throws
+}
+
+
+std::shared_ptr<AsyncQuery> AsyncQueryExecutor::enqueue(SharedGroup& sg,
+                                                        std::unique_ptr<SharedGroup::Handover<Query>> query,
+                                                        std::unique_ptr<SharedGroup::Handover<TableView>> view,
+                                                        bool cancel_on_new_version)
+{
+    // Released by the worker that takes the query off the queue
+    SharedGroup::VersionID version = sg.pin_version(); // Throws
+    std::shared_ptr<AsyncQuery> async_query;
+    try {
+        async_query.reset(new AsyncQuery(version, cancel_on_new_version)); // Throws
+        async_query->m_query = std::move(query);
+        async_query->m_view = std::move(view);
+        util::LockGuard lock(m_mutex);
+        m_queue.push_back(async_query); // Throws
+    }
+    catch (...) {
+        sg.unpin_version(version);
+        throw;
+    }
+    m_work_available.notify();
+    return async_query;
+}
+
+
+void AsyncQueryExecutor::worker_loop(SharedGroup& sg)
+{
+    util::Thread::set_name("realm-query");
+    for (;;) {
+        std::shared_ptr<AsyncQuery> query;
+        {
+            util::LockGuard lock(m_mutex);
+            while (m_queue.empty() && !m_stopping)
+                m_work_available.wait(lock);
+            if (m_queue.empty())
+                return;
+            query = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        query->run(sg);
+    }
+}
+
+
+AsyncQuery::AsyncQuery(SharedGroup::VersionID version, bool cancel_on_new_version)
+    : m_version(version)
+    , m_cancel_on_new_version(cancel_on_new_version)
+{
+}
+
+
+AsyncQuery::State AsyncQuery::get_state() const
+{
+    util::LockGuard lock(m_mutex);
+    return m_state;
+}
+
+
+bool AsyncQuery::is_ready() const
+{
+    State state = get_state();
+    return state != State::pending && state != State::running;
+}
+
+
+void AsyncQuery::wait() const
+{
+    util::LockGuard lock(m_mutex);
+    while (m_state == State::pending || m_state == State::running)
+        m_state_changed.wait(lock);
+}
+
+
+void AsyncQuery::cancel() noexcept
+{
+    util::LockGuard lock(m_mutex);
+    m_cancel_requested = true;
+}
+
+
+std::unique_ptr<TableView> AsyncQuery::import_result(SharedGroup& sg)
+{
+    std::unique_ptr<SharedGroup::Handover<TableView>> result;
+    {
+        util::LockGuard lock(m_mutex);
+        while (m_state == State::pending || m_state == State::running)
+            m_state_changed.wait(lock);
+        if (m_state == State::failed)
+            std::rethrow_exception(m_error);
+        if (!m_result)
+            return nullptr;
+        if (sg.get_version_of_current_transaction() != m_version)
+            throw SharedGroup::BadVersion();
+        result = std::move(m_result);
+    }
+    return sg.import_from_handover(std::move(result)); // Throws
+}
+
+
+bool AsyncQuery::start() noexcept
+{
+    util::LockGuard lock(m_mutex);
+    if (m_cancel_requested)
+        return false;
+    m_state = State::running;
+    return true;
+}
+
+
+void AsyncQuery::finish(State state, std::unique_ptr<SharedGroup::Handover<TableView>> result,
+                        std::exception_ptr error) noexcept
+{
+    {
+        util::LockGuard lock(m_mutex);
+        if (state == State::done && m_cancel_requested) {
+            state = State::cancelled;
+            result.reset();
+        }
+        m_state = state;
+        m_result = std::move(result);
+        m_error = std::move(error);
+    }
+    m_state_changed.notify_all();
+}
+
+
+void AsyncQuery::run(SharedGroup& sg)
+{
+    if (!start()) {
+        sg.unpin_version(m_version);
+        finish(State::cancelled, nullptr, nullptr);
+        return;
+    }
+
+    try {
+        sg.begin_read(m_version); // Throws
+    }
+    catch (...) {
+        sg.unpin_version(m_version);
+        finish(State::failed, nullptr, std::current_exception());
+        return;
+    }
+    // Our own read lock now keeps the version alive
+    sg.unpin_version(m_version);
+
+    State state = State::done;
+    std::unique_ptr<SharedGroup::Handover<TableView>> result;
+    std::exception_ptr error;
+    try {
+        if (m_cancel_on_new_version && sg.has_changed()) {
+            state = State::cancelled;
+        }
+        else {
+            std::unique_ptr<TableView> view;
+            if (m_query) {
+                std::unique_ptr<Query> query = sg.import_from_handover(std::move(m_query)); // Throws
+                view.reset(new TableView(query->find_all()));                              // Throws
+            }
+            else {
+                view = sg.import_from_handover(std::move(m_view)); // Throws
+                view->sync_if_needed();                             // Throws
+            }
+            if (m_cancel_on_new_version && sg.has_changed()) {
+                state = State::cancelled;
+            }
+            else {
+                result = sg.export_for_handover(*view, MutableSourcePayload::Move); // Throws
+            }
+        }
+    }
+    catch (...) {
+        state = State::failed;
+        result.reset();
+        error = std::current_exception();
+    }
+    sg.end_read();
+    finish(state, std::move(result), std::move(error));
+}
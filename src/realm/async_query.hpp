@@ -0,0 +1,169 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_ASYNC_QUERY_HPP
+#define REALM_ASYNC_QUERY_HPP
+
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <realm/group_shared.hpp>
+#include <realm/query.hpp>
+#include <realm/table_view.hpp>
+#include <realm/util/thread.hpp>
+
+namespace realm {
+
+/// Runs queries on background threads and hands the results back as table
+/// views.
+///
+/// Every worker thread has its own SharedGroup attached to the same file as
+/// the submitting SharedGroups. A submitted query is exported from the
+/// submitting SharedGroup at the version it is reading, and that version is
+/// pinned until a worker has started reading it. The worker runs the query and
+/// exports the resulting view with its payload, so importing it into a
+/// SharedGroup that reads the same version does not run the query again.
+///
+/// submit() and AsyncQuery::import_result() must be called by the thread that
+/// owns the SharedGroup passed to them, like any other handover.
+class AsyncQueryExecutor {
+public:
+    /// Called once per worker thread to create the history of its
+    /// SharedGroup. It must create the same kind of history as the one used by
+    /// the submitting SharedGroups, for example `make_in_realm_history(path)`.
+    using HistoryFactory = std::function<std::unique_ptr<Replication>()>;
+
+    class AsyncQuery;
+
+    /// Opens `num_threads` SharedGroups with `options` and starts a worker
+    /// thread for each of them.
+    AsyncQueryExecutor(HistoryFactory make_history, SharedGroupOptions options = SharedGroupOptions(),
+                       size_t num_threads = 1);
+
+    /// Cancels the queries that have not started yet, waits for the running
+    /// ones and stops the worker threads. AsyncQuery objects stay valid.
+    ~AsyncQueryExecutor() noexcept;
+
+    AsyncQueryExecutor(const AsyncQueryExecutor&) = delete;
+    AsyncQueryExecutor& operator=(const AsyncQueryExecutor&) = delete;
+
+    /// Run `query` against the version that `sg` is reading, which must be in
+    /// a read transaction.
+    ///
+    /// If `cancel_on_new_version` is true, the query is cancelled when a newer
+    /// version has been committed by the time a worker gets to it, or by the
+    /// time it has finished running. A caller that advances to every new
+    /// version can then submit the query again instead of waiting for a result
+    /// it can no longer import.
+    std::shared_ptr<AsyncQuery> submit(SharedGroup& sg, const Query& query, bool cancel_on_new_version = false);
+
+    /// Bring a copy of `view` in sync on a worker thread. This runs the query
+    /// of the view and applies its sort, distinct and limit descriptors. The
+    /// view itself is not changed.
+    std::shared_ptr<AsyncQuery> submit(SharedGroup& sg, const TableView& view, bool cancel_on_new_version = false);
+
+private:
+    struct Worker {
+        std::unique_ptr<Replication> history;
+        std::unique_ptr<SharedGroup> shared_group;
+        util::Thread thread;
+    };
+
+    std::vector<Worker> m_workers;
+    util::Mutex m_mutex;
+    util::CondVar m_work_available;
+    std::deque<std::shared_ptr<AsyncQuery>> m_queue; // Protected by m_mutex
+    bool m_stopping = false;                          // Protected by m_mutex
+
+    std::shared_ptr<AsyncQuery> enqueue(SharedGroup&, std::unique_ptr<SharedGroup::Handover<Query>>,
+                                        std::unique_ptr<SharedGroup::Handover<TableView>>,
+                                        bool cancel_on_new_version);
+    void worker_loop(SharedGroup&);
+};
+
+
+/// A query submitted to an AsyncQueryExecutor.
+class AsyncQueryExecutor::AsyncQuery {
+public:
+    enum class State {
+        pending,   ///< Waiting for a worker thread
+        running,   ///< Being run by a worker thread
+        done,      ///< The result is ready to be imported
+        cancelled, ///< No result will be produced
+        failed,    ///< Running the query threw an exception
+    };
+
+    /// The version the query runs against, and into which the result can be
+    /// imported.
+    SharedGroup::VersionID get_version() const noexcept
+    {
+        return m_version;
+    }
+
+    State get_state() const;
+
+    /// True if the state is `done`, `cancelled` or `failed`.
+    bool is_ready() const;
+
+    /// Block until is_ready() returns true.
+    void wait() const;
+
+    /// Request that no result is produced. A pending query is never run, and
+    /// the result of a running query is discarded when it finishes. Has no
+    /// effect if the query is already ready.
+    void cancel() noexcept;
+
+    /// Wait for the query to finish and import its result into `sg`, which
+    /// must be reading get_version(). The result can be imported only once;
+    /// null is returned after that, as well as for a cancelled query. If the
+    /// query failed, its exception is rethrown.
+    ///
+    /// \throw SharedGroup::BadVersion If `sg` does not read get_version(). The
+    /// result is kept and can still be imported by a SharedGroup which does.
+    std::unique_ptr<TableView> import_result(SharedGroup& sg);
+
+private:
+    const SharedGroup::VersionID m_version;
+    const bool m_cancel_on_new_version;
+
+    // Consumed by the worker thread
+    std::unique_ptr<SharedGroup::Handover<Query>> m_query;
+    std::unique_ptr<SharedGroup::Handover<TableView>> m_view;
+
+    mutable util::Mutex m_mutex;
+    mutable util::CondVar m_state_changed;
+    State m_state = State::pending;      // Protected by m_mutex
+    bool m_cancel_requested = false;     // Protected by m_mutex
+    std::unique_ptr<SharedGroup::Handover<TableView>> m_result; // Protected by m_mutex
+    std::exception_ptr m_error;          // Protected by m_mutex
+
+    AsyncQuery(SharedGroup::VersionID, bool cancel_on_new_version);
+
+    bool start() noexcept;
+    void finish(State, std::unique_ptr<SharedGroup::Handover<TableView>>, std::exception_ptr) noexcept;
+    void run(SharedGroup&);
+
+    friend class AsyncQueryExecutor;
+};
+
+} // namespace realm
+
+#endif // REALM_ASYNC_QUERY_HPP
@@ -285,6 +285,11 @@ public:
     /// function does nothing.
     virtual void discard_subtable_accessor(size_t row_ndx) noexcept;
 
+    /// Whether there are accessors attached to particular rows of this column,
+    /// such as subtable and link list accessors, which the adj_acc_*()
+    /// functions must move along with their rows.
+    virtual bool has_row_bound_accessors() const noexcept;
+
     virtual void adj_acc_insert_rows(size_t row_ndx, size_t num_rows) noexcept;
     virtual void adj_acc_erase_row(size_t row_ndx) noexcept;
     /// See Table::adj_acc_move_over()
@@ -824,6 +829,11 @@ inline void ColumnBase::discard_subtable_accessor(size_t) noexcept
     // Noop
 }
 
+inline bool ColumnBase::has_row_bound_accessors() const noexcept
+{
+    return false;
+}
+
 inline void ColumnBase::adj_acc_insert_rows(size_t, size_t) noexcept
 {
     // Noop
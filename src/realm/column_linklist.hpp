@@ -83,6 +83,7 @@ public:
     void adj_acc_move_row(size_t, size_t) noexcept override;
     void adj_acc_merge_rows(size_t, size_t) noexcept override;
     void refresh_accessor_tree(size_t, const Spec&) override;
+    bool has_row_bound_accessors() const noexcept override;
 
     void verify() const override;
     void verify(const Table&, size_t) const override;
@@ -222,6 +223,12 @@ inline void LinkListColumn::do_discard_child_accessors() noexcept
     discard_child_accessors();
 }
 
+inline bool LinkListColumn::has_row_bound_accessors() const noexcept
+{
+    // Tombstones included, which only makes this err on the safe side
+    return !m_list_accessors.empty();
+}
+
 inline ref_type LinkListColumn::get_row_ref(size_t row_ndx) const noexcept
 {
     return LinkColumnBase::get_as_ref(row_ndx);
@@ -95,6 +95,7 @@ public:
     TableRef get_subtable_accessor(size_t row_ndx) const noexcept override;
 
     void discard_subtable_accessor(size_t row_ndx) noexcept override;
+    bool has_row_bound_accessors() const noexcept override;
 
     /// If the value at the specified index is a subtable, return a
     /// TableRef to that accessor for that subtable. Otherwise return
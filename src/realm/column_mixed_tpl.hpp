@@ -83,6 +83,11 @@ inline void MixedColumn::discard_subtable_accessor(size_t row_ndx) noexcept
     m_data->discard_subtable_accessor(row_ndx);
 }
 
+inline bool MixedColumn::has_row_bound_accessors() const noexcept
+{
+    return m_data->has_row_bound_accessors();
+}
+
 inline TableRef MixedColumn::get_subtable_tableref(size_t row_ndx)
 {
     REALM_ASSERT_3(row_ndx, <, m_types->size());
@@ -48,6 +48,7 @@ public:
     void clear(size_t, bool) override;
     void swap_rows(size_t, size_t) override;
     void discard_subtable_accessor(size_t) noexcept override;
+    bool has_row_bound_accessors() const noexcept override;
     void update_from_parent(size_t) noexcept override;
     void adj_acc_insert_rows(size_t, size_t) noexcept override;
     void adj_acc_erase_row(size_t) noexcept override;
@@ -415,6 +416,12 @@ inline TableRef SubtableColumnBase::get_subtable_accessor(size_t row_ndx) const
     return subtable;
 }
 
+inline bool SubtableColumnBase::has_row_bound_accessors() const noexcept
+{
+    std::lock_guard<std::recursive_mutex> lg(m_subtable_map_lock);
+    return !m_subtable_map.empty();
+}
+
 inline void SubtableColumnBase::discard_subtable_accessor(size_t row_ndx) noexcept
 {
     // This function must assume no more than minimal consistency of the
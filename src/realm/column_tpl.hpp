@@ -20,6 +20,7 @@
 #define REALM_COLUMN_TPL_HPP
 
 #include <cstdlib>
+#include <type_traits>
 
 #include <realm/util/features.h>
 #include <realm/array.hpp>
@@ -69,6 +70,37 @@ struct FindInLeaf {
     static bool find(const LeafType& leaf, T target, size_t local_start, size_t local_end, size_t leaf_start,
                      QueryState<R>& state)
     {
+        // Without a limit, the column aggregates are computed for the whole leaf at once
+        if (state.m_limit == size_t(-1)) {
+            constexpr bool all_values =
+                std::is_same<Condition, None>::value || std::is_same<Condition, NotNull>::value;
+            if (action == act_Sum && all_values) {
+                size_t count;
+                state.m_state += static_cast<R>(leaf.sum(local_start, local_end, &count));
+                state.m_match_count += count;
+                return true;
+            }
+            if ((action == act_Max || action == act_Min) && all_values) {
+                size_t count;
+                size_t ndx = action == act_Max ? leaf.template find_minmax<true>(local_start, local_end, &count)
+                                               : leaf.template find_minmax<false>(local_start, local_end, &count);
+                state.m_match_count += count;
+                if (ndx != not_found) {
+                    R value = static_cast<R>(leaf.get(ndx));
+                    if (action == act_Max ? value > state.m_state : value < state.m_state) {
+                        state.m_state = value;
+                        state.m_minmax_index = leaf_start + ndx;
+                    }
+                }
+                return true;
+            }
+            if (action == act_Count && std::is_same<Condition, Equal>::value && !null::is_null_float(target)) {
+                state.m_state += static_cast<R>(leaf.template count<Equal>(target, local_start, local_end));
+                state.m_match_count = size_t(state.m_state);
+                return true;
+            }
+        }
+
         Condition cond;
         bool cont = true;
         // todo, make an additional loop with hard coded `false` instead of is_null(v) for non-nullable columns
@@ -1321,6 +1321,10 @@ public:
         if (group_level_ndx < m_group.m_table_accessors.size()) {
             TableRef table(m_group.m_table_accessors[group_level_ndx]);
             if (table) {
+                // Changes inside subtables are not tracked for the views of the
+                // group-level table
+                if (levels > 0)
+                    _impl::TableFriend::discard_view_changes(*table);
                 const size_t* path_begin = path;
                 const size_t* path_end = path_begin + 2 * levels;
                 for (;;) {
@@ -1423,58 +1427,70 @@ public:
     bool clear_table(size_t) noexcept
     {
         typedef _impl::TableFriend tf;
-        if (m_table)
+        if (m_table) {
             tf::adj_acc_clear_root_table(*m_table);
+            tf::discard_view_changes(*m_table);
+        }
         return true;
     }
 
-    bool set_int(size_t, size_t, int_fast64_t, _impl::Instruction, size_t) noexcept
+    bool set_int(size_t, size_t row_ndx, int_fast64_t, _impl::Instruction, size_t) noexcept
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
     }
 
-    bool add_int(size_t, size_t, int_fast64_t) noexcept
+    bool add_int(size_t, size_t row_ndx, int_fast64_t) noexcept
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
     }
 
-    bool set_bool(size_t, size_t, bool, _impl::Instruction) noexcept
+    bool set_bool(size_t, size_t row_ndx, bool, _impl::Instruction) noexcept
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
     }
 
-    bool set_float(size_t, size_t, float, _impl::Instruction) noexcept
+    bool set_float(size_t, size_t row_ndx, float, _impl::Instruction) noexcept
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
     }
 
-    bool set_double(size_t, size_t, double, _impl::Instruction) noexcept
+    bool set_double(size_t, size_t row_ndx, double, _impl::Instruction) noexcept
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
     }
 
-    bool set_string(size_t, size_t, StringData, _impl::Instruction, size_t) noexcept
+    bool set_string(size_t, size_t row_ndx, StringData, _impl::Instruction, size_t) noexcept
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
     }
 
-    bool set_binary(size_t, size_t, BinaryData, _impl::Instruction) noexcept
+    bool set_binary(size_t, size_t row_ndx, BinaryData, _impl::Instruction) noexcept
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
     }
 
-    bool set_olddatetime(size_t, size_t, OldDateTime, _impl::Instruction) noexcept
+    bool set_olddatetime(size_t, size_t row_ndx, OldDateTime, _impl::Instruction) noexcept
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
     }
 
-    bool set_timestamp(size_t, size_t, Timestamp, _impl::Instruction) noexcept
+    bool set_timestamp(size_t, size_t row_ndx, Timestamp, _impl::Instruction) noexcept
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
     }
 
     bool set_table(size_t col_ndx, size_t row_ndx, _impl::Instruction) noexcept
     {
+        track_changed_row(row_ndx);
         if (m_table) {
             typedef _impl::TableFriend tf;
             TableRef subtab(tf::get_subtable_accessor(*m_table, col_ndx, row_ndx));
@@ -1488,19 +1504,32 @@ public:
 
     bool set_mixed(size_t col_ndx, size_t row_ndx, const Mixed&, _impl::Instruction) noexcept
     {
+        track_changed_row(row_ndx);
         typedef _impl::TableFriend tf;
         if (m_table)
             tf::discard_subtable_accessor(*m_table, col_ndx, row_ndx);
         return true;
     }
 
-    bool set_null(size_t, size_t, _impl::Instruction, size_t) noexcept
+    bool set_null(size_t, size_t row_ndx, _impl::Instruction, size_t) noexcept
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
+    }
+
+    // Integer, boolean, float, double and null assignments need nothing but
+    // view tracking, so a whole instr_SetRange is handled in one call, with
+    // the view lock taken once
+    bool set_range(size_t, size_t row_ndx, size_t num_rows) noexcept
+    {
+        track_changed_row(row_ndx, num_rows);
+        return true;
     }
 
-    bool set_link(size_t col_ndx, size_t, size_t, size_t, _impl::Instruction) noexcept
+    bool set_link(size_t col_ndx, size_t row_ndx, size_t, size_t, _impl::Instruction) noexcept
     {
+        track_changed_row(row_ndx);
+
         // When links are changed, the link-target table is also affected and
         // its accessor must therefore be marked dirty too. Indeed, when it
         // exists, the link-target table accessor must be marked dirty
@@ -1526,14 +1555,16 @@ public:
         return true;
     }
 
-    bool insert_substring(size_t, size_t, size_t, StringData)
+    bool insert_substring(size_t, size_t row_ndx, size_t, StringData)
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
     }
 
-    bool erase_substring(size_t, size_t, size_t, size_t)
+    bool erase_substring(size_t, size_t row_ndx, size_t, size_t)
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
     }
 
     bool optimize_table() noexcept
@@ -1541,6 +1572,15 @@ public:
         return true; // No-op
     }
 
+    bool refresh_table() noexcept
+    {
+        // Any array of the table may have moved, including those of its
+        // subtables
+        if (m_table)
+            _impl::TableFriend::recursive_mark(*m_table);
+        return true;
+    }
+
     bool select_descriptor(int levels, const size_t* path)
     {
         m_desc.reset();
@@ -1695,8 +1735,11 @@ public:
         return true; // No-op
     }
 
-    bool select_link_list(size_t col_ndx, size_t, size_t) noexcept
+    bool select_link_list(size_t col_ndx, size_t row_ndx, size_t) noexcept
     {
+        // The instructions which follow change the link list of this row
+        track_changed_row(row_ndx);
+
         // See comments on link handling in TransactAdvancer::set_link().
         typedef _impl::TableFriend tf;
         if (m_table) {
@@ -1736,9 +1779,10 @@ public:
         return true; // No-op
     }
 
-    bool nullify_link(size_t, size_t, size_t)
+    bool nullify_link(size_t, size_t row_ndx, size_t)
     {
-        return true; // No-op
+        track_changed_row(row_ndx);
+        return true;
     }
 
     bool link_list_nullify(size_t, size_t)
@@ -1750,6 +1794,13 @@ private:
     Group& m_group;
     TableRef m_table;
     DescriptorRef m_desc;
+
+    void track_changed_row(size_t row_ndx, size_t num_rows = 1) noexcept
+    {
+        if (m_table)
+            _impl::TableFriend::track_changed_row(*m_table, row_ndx, num_rows);
+    }
+
     const size_t* m_desc_path_begin;
     const size_t* m_desc_path_end;
     bool& m_schema_changed;
@@ -1882,6 +1933,15 @@ void Group::advance_transact(ref_type new_top_ref, size_t new_file_size, _impl::
 
     m_alloc.update_reader_view(new_file_size); // Throws
 
+    // Views which are in sync record the rows changed by the instructions
+    // below, so that the next TableView::sync_if_needed() can update them from
+    // those rows instead of rerunning their queries, when the queries allow it.
+    using tf = _impl::TableFriend;
+    for (Table* table : m_table_accessors) {
+        if (table)
+            tf::begin_view_change_tracking(*table); // Throws
+    }
+
     bool schema_changed = false;
     _impl::TransactLogParser parser; // Throws
     TransactAdvancer advancer(*this, schema_changed);
@@ -1892,11 +1952,76 @@ void Group::advance_transact(ref_type new_top_ref, size_t new_file_size, _impl::
     attach(new_top_ref, create_group_when_missing); // Throws
     refresh_dirty_accessors();                      // Throws
 
+    for (Table* table : m_table_accessors) {
+        if (!table)
+            continue;
+        if (schema_changed) {
+            tf::discard_view_changes(*table);
+        }
+        else {
+            tf::end_view_change_tracking(*table);
+        }
+    }
+
     if (schema_changed)
         send_schema_change_notification();
 }
 
 
+bool Group::refresh_transact(ref_type new_top_ref, size_t new_file_size)
+{
+    REALM_ASSERT(is_attached());
+    if (!m_top.is_attached() || new_top_ref == 0)
+        return false;
+
+    m_alloc.update_reader_view(new_file_size); // Throws
+
+    // The space of the current snapshot cannot be reused while it is bound, so
+    // an unchanged ref means unchanged contents. The list of table names
+    // changes along with the set and order of the group-level tables.
+    Array new_top(m_alloc);
+    new_top.init_from_ref(new_top_ref);
+    if (new_top.get_as_ref(0) != m_table_names.get_ref())
+        return false;
+    Array new_tables(m_alloc);
+    new_tables.init_from_ref(new_top.get_as_ref(1));
+    REALM_ASSERT(new_tables.size() == m_tables.size());
+
+    using tf = _impl::TableFriend;
+    std::vector<Table*> changed_tables;
+    size_t num_tables = m_table_accessors.size();
+    for (size_t table_ndx = 0; table_ndx != num_tables; ++table_ndx) {
+        Table* table = m_table_accessors[table_ndx];
+        if (!table)
+            continue;
+        ref_type old_ref = m_tables.get_as_ref(table_ndx);
+        ref_type new_ref = new_tables.get_as_ref(table_ndx);
+        if (new_ref == old_ref)
+            continue;
+        if (tf::has_row_bound_accessors(*table))
+            return false;
+        // The spec is the 1st slot of the table top, and covers the specs of
+        // the subtables
+        Array old_table_top(m_alloc);
+        old_table_top.init_from_ref(old_ref);
+        Array new_table_top(m_alloc);
+        new_table_top.init_from_ref(new_ref);
+        if (new_table_top.get_as_ref(0) != old_table_top.get_as_ref(0))
+            return false;
+        changed_tables.push_back(table); // Throws
+    }
+
+    for (Table* table : changed_tables)
+        tf::recursive_mark(*table);
+
+    m_top.detach();                                 // Soft detach
+    bool create_group_when_missing = false;         // See Group::attach_shared().
+    attach(new_top_ref, create_group_when_missing); // Throws
+    refresh_dirty_accessors();                      // Throws
+    return true;
+}
+
+
 void Group::prepare_history_parent(Array& history_root, int history_type,
                                    int history_schema_version)
 {
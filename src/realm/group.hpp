@@ -706,6 +706,16 @@ private:
     void update_num_objects();
     class TransactAdvancer;
     void advance_transact(ref_type new_top_ref, size_t new_file_size, _impl::NoCopyInputStream&);
+    /// Bring the accessors to the snapshot at \a new_top_ref like
+    /// advance_transact(), but without replaying the changesets leading to
+    /// it. The tables are compared with those of the new snapshot instead, and
+    /// the changed ones refreshed. This is only possible when the changesets
+    /// did not change the schema, and when no accessor is attached to rows of a
+    /// changed table (row accessors, table views, subtables and link lists),
+    /// since moving those along with their rows takes the instructions.
+    /// Returns false, and leaves the accessors untouched, when it is not
+    /// possible.
+    bool refresh_transact(ref_type new_top_ref, size_t new_file_size);
     void refresh_dirty_accessors();
     template <class F>
     void update_table_indices(F&& map_function);
@@ -0,0 +1,665 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/group_by.hpp>
+
+#include <realm/column.hpp>
+#include <realm/exceptions.hpp>
+#include <realm/table.hpp>
+#include <realm/util/thread.hpp>
+
+#include <array>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace realm;
+
+namespace {
+
+// Gives every distinct string an id, so that rows can be grouped by plain integers
+class StringIds {
+public:
+    uint64_t get(StringData value)
+    {
+        auto inserted = m_ids.emplace(value, m_ids.size());
+        if (inserted.second)
+            m_strings.push_back(value);
+        return inserted.first->second;
+    }
+
+    StringData get_string(uint64_t id) const noexcept
+    {
+        return m_strings[size_t(id)];
+    }
+
+private:
+    std::unordered_map<StringData, uint64_t> m_ids;
+    std::vector<StringData> m_strings; // indexed by id
+};
+
+uint64_t hash_words(const uint64_t* words, size_t count) noexcept
+{
+    uint64_t h = 0;
+    for (size_t i = 0; i < count; ++i) {
+        h = (h ^ words[i]) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
+template <class Float>
+uint64_t float_word(Float value) noexcept
+{
+    if (value == 0)
+        value = 0; // -0 and 0 are the same value
+    typename std::conditional<sizeof(Float) == 4, uint32_t, uint64_t>::type bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// The rows aggregated by each thread, at least, so that starting the thread and merging its groups take little time
+// compared to aggregating them
+const size_t min_rows_per_thread = 16384;
+
+int64_t floor_div(int64_t a, int64_t b) noexcept
+{
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// A value seen by a count_distinct aggregate: the group followed by one or (for timestamps) two words
+using DistinctValue = std::array<uint64_t, 3>;
+
+struct DistinctValueHash {
+    size_t operator()(const DistinctValue& value) const noexcept
+    {
+        return size_t(hash_words(value.data(), value.size()));
+    }
+};
+
+struct AggregateState {
+    int64_t count = 0;
+    int64_t int_value = 0;
+    double double_value = 0;
+    Timestamp timestamp;
+};
+
+// The groups of a contiguous range of the rows, in the order in which they were first seen there. String ids are
+// local to each range.
+struct PartialAggregation {
+    size_t num_groups = 0;
+    std::vector<uint64_t> group_words;
+    std::vector<size_t> group_first_row;
+    std::vector<StringIds> key_strings;
+    std::vector<StringIds> aggregate_strings;
+    std::vector<std::vector<AggregateState>> states;
+    std::vector<std::unordered_set<DistinctValue, DistinctValueHash>> distinct_values;
+};
+
+// Fold the state of a group in one range into the state of the same group in another. The distinct values are
+// merged, and counted, separately.
+void merge_state(GroupByDescriptor::Aggregate type, DataType column_type, AggregateState& state,
+                 const AggregateState& other) noexcept
+{
+    using Aggregate = GroupByDescriptor::Aggregate;
+    switch (type) {
+        case Aggregate::count:
+            state.count += other.count;
+            break;
+        case Aggregate::count_distinct:
+            break;
+        case Aggregate::sum:
+        case Aggregate::average:
+            state.count += other.count;
+            state.int_value += other.int_value;
+            state.double_value += other.double_value;
+            break;
+        case Aggregate::min:
+        case Aggregate::max: {
+            if (other.count == 0)
+                break;
+            bool is_min = type == Aggregate::min;
+            bool first = state.count == 0;
+            state.count += other.count;
+            if (column_type == type_Int) {
+                if (first || (is_min ? other.int_value < state.int_value : other.int_value > state.int_value))
+                    state.int_value = other.int_value;
+            }
+            else if (column_type == type_Timestamp) {
+                if (first || (is_min ? other.timestamp < state.timestamp : other.timestamp > state.timestamp))
+                    state.timestamp = other.timestamp;
+            }
+            else {
+                if (first ||
+                    (is_min ? other.double_value < state.double_value : other.double_value > state.double_value))
+                    state.double_value = other.double_value;
+            }
+            break;
+        }
+    }
+}
+
+} // anonymous namespace
+
+GroupByDescriptor::GroupByDescriptor(const Table& table)
+    : m_table(&table)
+{
+}
+
+size_t GroupByDescriptor::ColumnPath::resolve(size_t row) const noexcept
+{
+    for (size_t i = 0; i + 1 < indices.size(); ++i) {
+        if (tables[i]->is_null_link(indices[i], row))
+            return npos;
+        row = tables[i]->get_link(indices[i], row);
+    }
+    return row;
+}
+
+GroupByDescriptor::ColumnPath GroupByDescriptor::make_path(std::vector<size_t> column_path) const
+{
+    ColumnPath path;
+    const Table* table = m_table;
+    for (size_t i = 0; i < column_path.size(); ++i) {
+        size_t col_ndx = column_path[i];
+        if (col_ndx >= table->get_column_count())
+            throw LogicError(LogicError::column_index_out_of_range);
+        path.tables.push_back(table);
+        path.indices.push_back(col_ndx);
+        path.type = table->get_column_type(col_ndx);
+        if (i + 1 < column_path.size()) {
+            // Only the last column in a link chain is allowed to be non-link
+            if (path.type != type_Link)
+                throw LogicError(LogicError::type_mismatch);
+            table = table->get_link_target(col_ndx).get();
+        }
+    }
+    return path;
+}
+
+GroupByDescriptor& GroupByDescriptor::add_key(std::vector<size_t> column_path)
+{
+    if (column_path.empty())
+        throw LogicError(LogicError::illegal_combination);
+    if (m_keys.size() == 64) // the null flags of a group are one word
+        throw LogicError(LogicError::illegal_combination);
+    ColumnPath path = make_path(std::move(column_path));
+    switch (path.type) {
+        case type_Int:
+        case type_Bool:
+        case type_String:
+        case type_Timestamp:
+        case type_Link:
+            break;
+        default:
+            throw LogicError(LogicError::type_mismatch);
+    }
+    m_keys.push_back({std::move(path), 0});
+    return *this;
+}
+
+GroupByDescriptor& GroupByDescriptor::add_timestamp_bucket(std::vector<size_t> column_path, int64_t bucket_seconds)
+{
+    if (bucket_seconds <= 0)
+        throw LogicError(LogicError::illegal_combination);
+    add_key(std::move(column_path));
+    if (m_keys.back().path.type != type_Timestamp) {
+        m_keys.pop_back();
+        throw LogicError(LogicError::type_mismatch);
+    }
+    m_keys.back().bucket_seconds = bucket_seconds;
+    return *this;
+}
+
+GroupByDescriptor& GroupByDescriptor::add_aggregate(Aggregate type, std::vector<size_t> column_path)
+{
+    if (column_path.empty()) {
+        if (type != Aggregate::count)
+            throw LogicError(LogicError::illegal_combination);
+        m_aggregates.push_back({type, {}});
+        return *this;
+    }
+
+    ColumnPath path = make_path(std::move(column_path));
+    bool numeric = path.type == type_Int || path.type == type_Float || path.type == type_Double;
+    bool supported = false;
+    switch (type) {
+        case Aggregate::count:
+            supported = true;
+            break;
+        case Aggregate::sum:
+        case Aggregate::average:
+            supported = numeric;
+            break;
+        case Aggregate::min:
+        case Aggregate::max:
+            supported = numeric || path.type == type_Timestamp;
+            break;
+        case Aggregate::count_distinct:
+            supported = numeric || path.type == type_Bool || path.type == type_String ||
+                        path.type == type_Timestamp || path.type == type_Link;
+            break;
+    }
+    if (!supported)
+        throw LogicError(LogicError::type_mismatch);
+    m_aggregates.push_back({type, std::move(path)});
+    return *this;
+}
+
+GroupByResult::GroupByResult(const GroupByDescriptor& descriptor, const IntegerColumn& rows)
+    : m_num_keys(descriptor.m_keys.size())
+    , m_num_aggregates(descriptor.m_aggregates.size())
+{
+    using Aggregate = GroupByDescriptor::Aggregate;
+    using ColumnPath = GroupByDescriptor::ColumnPath;
+    const auto& keys = descriptor.m_keys;
+    const auto& aggregates = descriptor.m_aggregates;
+
+    // Reads the value at the end of `path` for `row` as a word which is equal for equal values. Returns false for
+    // null values and null links.
+    auto read_word = [](const ColumnPath& path, size_t row, StringIds& ids, uint64_t& word) {
+        row = path.resolve(row);
+        if (row == npos)
+            return false;
+        const Table& table = *path.tables.back();
+        size_t col_ndx = path.indices.back();
+        if (table.is_null(col_ndx, row))
+            return false;
+        switch (path.type) {
+            case type_Int:
+                word = uint64_t(table.get_int(col_ndx, row));
+                break;
+            case type_Bool:
+                word = table.get_bool(col_ndx, row);
+                break;
+            case type_Float:
+                word = float_word(table.get_float(col_ndx, row));
+                break;
+            case type_Double:
+                word = float_word(table.get_double(col_ndx, row));
+                break;
+            case type_String:
+                word = ids.get(table.get_string(col_ndx, row));
+                break;
+            case type_Link:
+                word = table.get_link(col_ndx, row);
+                break;
+            default:
+                REALM_UNREACHABLE();
+        }
+        return true;
+    };
+
+    // Every group is identified by a word holding the null flags of its keys followed by one word per key, except
+    // for timestamps which take two
+    size_t num_words = 1;
+    for (auto& key : keys)
+        num_words += key.path.type == type_Timestamp ? 2 : 1;
+
+    // The groups of a range of the rows are found through a hash set of group numbers, which are hashed and
+    // compared by their words
+    auto make_group_set = [num_words](const std::vector<uint64_t>& group_words) {
+        auto hash = [&group_words, num_words](size_t group) {
+            return size_t(hash_words(&group_words[group * num_words], num_words));
+        };
+        auto equal = [&group_words, num_words](size_t a, size_t b) {
+            return std::equal(&group_words[a * num_words], &group_words[a * num_words] + num_words,
+                              &group_words[b * num_words]);
+        };
+        return std::unordered_set<size_t, decltype(hash), decltype(equal)>(16, hash, equal);
+    };
+
+    auto aggregate_range = [&](size_t begin, size_t end, PartialAggregation& partial) {
+        std::vector<uint64_t>& group_words = partial.group_words;
+        std::vector<size_t>& group_first_row = partial.group_first_row;
+        std::vector<StringIds>& key_strings = partial.key_strings;
+        std::vector<StringIds>& aggregate_strings = partial.aggregate_strings;
+        auto& states = partial.states;
+        auto& distinct_values = partial.distinct_values;
+        key_strings.resize(keys.size());
+        aggregate_strings.resize(aggregates.size());
+        states.resize(aggregates.size());
+        distinct_values.resize(aggregates.size());
+        auto groups = make_group_set(group_words);
+
+        for (size_t r = begin; r < end; ++r) {
+            int64_t row_ndx = rows.get(r);
+            if (row_ndx == -1)
+                continue; // detached ref
+            size_t row = size_t(row_ndx);
+
+            // Append the key of the row as a candidate group, and drop it again if the group already exists
+            size_t candidate = partial.num_groups;
+            group_words.resize((candidate + 1) * num_words);
+            uint64_t* words = &group_words[candidate * num_words];
+            words[0] = 0;
+            uint64_t& null_flags = words[0];
+            size_t w = 1;
+            for (size_t k = 0; k < keys.size(); ++k) {
+                const ColumnPath& path = keys[k].path;
+                if (path.type == type_Timestamp) {
+                    size_t target = path.resolve(row);
+                    Timestamp ts = target == npos ? Timestamp{}
+                                                  : path.tables.back()->get_timestamp(path.indices.back(), target);
+                    if (ts.is_null()) {
+                        null_flags |= uint64_t(1) << k;
+                        words[w] = words[w + 1] = 0;
+                    }
+                    else if (keys[k].bucket_seconds) {
+                        // A negative timestamp with nanoseconds lies before its whole second
+                        int64_t seconds = ts.get_seconds() - (ts.get_nanoseconds() < 0 ? 1 : 0);
+                        words[w] = uint64_t(floor_div(seconds, keys[k].bucket_seconds));
+                        words[w + 1] = 0;
+                    }
+                    else {
+                        words[w] = uint64_t(ts.get_seconds());
+                        words[w + 1] = uint64_t(int64_t(ts.get_nanoseconds()));
+                    }
+                    w += 2;
+                }
+                else {
+                    if (!read_word(path, row, key_strings[k], words[w])) {
+                        null_flags |= uint64_t(1) << k;
+                        words[w] = 0;
+                    }
+                    ++w;
+                }
+            }
+
+            size_t group;
+            auto inserted = groups.insert(candidate);
+            if (inserted.second) {
+                group = candidate;
+                ++partial.num_groups;
+                group_first_row.push_back(row);
+                for (auto& state : states)
+                    state.emplace_back();
+            }
+            else {
+                group = *inserted.first;
+                group_words.resize(candidate * num_words);
+            }
+
+            // Fold the row into the aggregates of its group
+            for (size_t a = 0; a < aggregates.size(); ++a) {
+                const auto& aggregate = aggregates[a];
+                AggregateState& state = states[a][group];
+                const ColumnPath& path = aggregate.path;
+                if (path.indices.empty()) {
+                    ++state.count;
+                    continue;
+                }
+                size_t target = path.resolve(row);
+                if (target == npos)
+                    continue;
+                const Table& table = *path.tables.back();
+                size_t col_ndx = path.indices.back();
+                if (table.is_null(col_ndx, target))
+                    continue;
+
+                switch (aggregate.type) {
+                    case Aggregate::count:
+                        ++state.count;
+                        break;
+                    case Aggregate::count_distinct: {
+                        DistinctValue value = {{group, 0, 0}};
+                        if (path.type == type_Timestamp) {
+                            Timestamp ts = table.get_timestamp(col_ndx, target);
+                            value[1] = uint64_t(ts.get_seconds());
+                            value[2] = uint64_t(int64_t(ts.get_nanoseconds()));
+                        }
+                        else {
+                            read_word(path, row, aggregate_strings[a], value[1]);
+                        }
+                        if (distinct_values[a].insert(value).second)
+                            ++state.count;
+                        break;
+                    }
+                    case Aggregate::sum:
+                    case Aggregate::average:
+                        ++state.count;
+                        if (path.type == type_Int)
+                            state.int_value += table.get_int(col_ndx, target);
+                        else if (path.type == type_Float)
+                            state.double_value += table.get_float(col_ndx, target);
+                        else
+                            state.double_value += table.get_double(col_ndx, target);
+                        break;
+                    case Aggregate::min:
+                    case Aggregate::max: {
+                        bool is_min = aggregate.type == Aggregate::min;
+                        bool first = state.count++ == 0;
+                        if (path.type == type_Int) {
+                            int64_t value = table.get_int(col_ndx, target);
+                            if (first || (is_min ? value < state.int_value : value > state.int_value))
+                                state.int_value = value;
+                        }
+                        else if (path.type == type_Timestamp) {
+                            Timestamp value = table.get_timestamp(col_ndx, target);
+                            if (first || (is_min ? value < state.timestamp : value > state.timestamp))
+                                state.timestamp = value;
+                        }
+                        else {
+                            double value = path.type == type_Float ? table.get_float(col_ndx, target)
+                                                                   : table.get_double(col_ndx, target);
+                            if (first || (is_min ? value < state.double_value : value > state.double_value))
+                                state.double_value = value;
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+    };
+
+    // Large inputs are split into contiguous ranges of rows that are aggregated by separate threads, and the
+    // partial results are merged in the order of the ranges, which keeps the groups in the order in which they were
+    // first seen. As the groups are identified by plain words, merging a range costs one hash lookup per group of
+    // the range, and one per distinct value for count_distinct. Sums of floating point values may differ in their
+    // last bits from those of a single range, as they are added up in a different order.
+    const size_t num_rows = rows.size();
+    size_t num_threads = descriptor.m_max_threads;
+    if (num_threads == 0)
+        num_threads = std::thread::hardware_concurrency();
+    num_threads = std::max(size_t(1), std::min(num_threads, num_rows / min_rows_per_thread));
+
+    std::vector<PartialAggregation> partials(num_threads);
+    std::vector<std::exception_ptr> errors(num_threads);
+    std::vector<util::Thread> threads(num_threads - 1);
+    size_t num_started = 0;
+    try {
+        for (size_t t = 1; t < num_threads; ++t) {
+            threads[t - 1].start([&, t] {
+                try {
+                    aggregate_range(num_rows * t / num_threads, num_rows * (t + 1) / num_threads, partials[t]);
+                }
+                catch (...) {
+                    errors[t] = std::current_exception();
+                }
+            }); // Throws
+            ++num_started;
+        }
+        aggregate_range(0, num_rows / num_threads, partials[0]); // Throws
+    }
+    catch (...) {
+        errors[0] = std::current_exception();
+    }
+    for (size_t t = 0; t < num_started; ++t)
+        threads[t].join();
+    for (const std::exception_ptr& error : errors) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    PartialAggregation& result = partials[0];
+    auto groups = make_group_set(result.group_words);
+    if (num_threads > 1) {
+        for (size_t group = 0; group < result.num_groups; ++group)
+            groups.insert(group);
+    }
+    for (size_t t = 1; t < num_threads; ++t) {
+        PartialAggregation& partial = partials[t];
+        std::vector<size_t> group_map(partial.num_groups); // from the groups of the range to those of the result
+        for (size_t g = 0; g < partial.num_groups; ++g) {
+            size_t candidate = result.num_groups;
+            const uint64_t* partial_words = &partial.group_words[g * num_words];
+            result.group_words.insert(result.group_words.end(), partial_words, partial_words + num_words);
+            uint64_t* words = &result.group_words[candidate * num_words];
+            size_t w = 1;
+            for (size_t k = 0; k < keys.size(); ++k) {
+                DataType type = keys[k].path.type;
+                if (type == type_String && !(words[0] & (uint64_t(1) << k)))
+                    words[w] = result.key_strings[k].get(partial.key_strings[k].get_string(words[w]));
+                w += type == type_Timestamp ? 2 : 1;
+            }
+
+            auto inserted = groups.insert(candidate);
+            if (inserted.second) {
+                ++result.num_groups;
+                result.group_first_row.push_back(partial.group_first_row[g]);
+                for (auto& state : result.states)
+                    state.emplace_back();
+            }
+            else {
+                result.group_words.resize(candidate * num_words);
+            }
+            size_t group = *inserted.first;
+            group_map[g] = group;
+            for (size_t a = 0; a < aggregates.size(); ++a)
+                merge_state(aggregates[a].type, aggregates[a].path.type, result.states[a][group],
+                            partial.states[a][g]);
+        }
+        for (size_t a = 0; a < aggregates.size(); ++a) {
+            for (const DistinctValue& partial_value : partial.distinct_values[a]) {
+                DistinctValue value = partial_value;
+                value[0] = group_map[size_t(value[0])];
+                if (aggregates[a].path.type == type_String)
+                    value[1] = result.aggregate_strings[a].get(partial.aggregate_strings[a].get_string(value[1]));
+                if (result.distinct_values[a].insert(value).second)
+                    ++result.states[a][size_t(value[0])].count;
+            }
+        }
+    }
+    m_num_groups = result.num_groups;
+    const std::vector<uint64_t>& group_words = result.group_words;
+    const std::vector<size_t>& group_first_row = result.group_first_row;
+    const auto& states = result.states;
+
+    // Materialize the keys, taking the values from the first row of each group
+    m_keys.reserve(m_num_groups * m_num_keys);
+    for (size_t group = 0; group < m_num_groups; ++group) {
+        const uint64_t* words = &group_words[group * num_words];
+        size_t w = 1;
+        for (size_t k = 0; k < keys.size(); ++k) {
+            const ColumnPath& path = keys[k].path;
+            size_t width = path.type == type_Timestamp ? 2 : 1;
+            if (words[0] & (uint64_t(1) << k)) {
+                m_keys.push_back(util::none);
+                w += width;
+                continue;
+            }
+            const Table& table = *path.tables.back();
+            size_t col_ndx = path.indices.back();
+            size_t target = path.resolve(group_first_row[group]);
+            switch (path.type) {
+                case type_Int:
+                    m_keys.push_back(Mixed(table.get_int(col_ndx, target)));
+                    break;
+                case type_Bool:
+                    m_keys.push_back(Mixed(table.get_bool(col_ndx, target)));
+                    break;
+                case type_String:
+                    m_strings.push_back(table.get_string(col_ndx, target));
+                    m_keys.push_back(Mixed(StringData(m_strings.back())));
+                    break;
+                case type_Link:
+                    m_keys.push_back(Mixed(int64_t(table.get_link(col_ndx, target))));
+                    break;
+                case type_Timestamp:
+                    if (keys[k].bucket_seconds) {
+                        int64_t bucket = int64_t(words[w]);
+                        m_keys.push_back(Mixed(Timestamp(bucket * keys[k].bucket_seconds, 0)));
+                    }
+                    else {
+                        m_keys.push_back(Mixed(table.get_timestamp(col_ndx, target)));
+                    }
+                    break;
+                default:
+                    REALM_UNREACHABLE();
+            }
+            w += width;
+        }
+    }
+
+    // Finish the aggregates
+    m_aggregates.reserve(m_num_groups * m_num_aggregates);
+    for (size_t group = 0; group < m_num_groups; ++group) {
+        for (size_t a = 0; a < aggregates.size(); ++a) {
+            const AggregateState& state = states[a][group];
+            DataType type = aggregates[a].path.type;
+            switch (aggregates[a].type) {
+                case Aggregate::count:
+                case Aggregate::count_distinct:
+                    m_aggregates.push_back(Mixed(state.count));
+                    break;
+                case Aggregate::sum:
+                    if (type == type_Int)
+                        m_aggregates.push_back(Mixed(state.int_value));
+                    else
+                        m_aggregates.push_back(Mixed(state.double_value));
+                    break;
+                case Aggregate::average:
+                    if (state.count == 0)
+                        m_aggregates.push_back(util::none);
+                    else if (type == type_Int)
+                        m_aggregates.push_back(Mixed(double(state.int_value) / state.count));
+                    else
+                        m_aggregates.push_back(Mixed(state.double_value / state.count));
+                    break;
+                case Aggregate::min:
+                case Aggregate::max:
+                    if (state.count == 0)
+                        m_aggregates.push_back(util::none);
+                    else if (type == type_Int)
+                        m_aggregates.push_back(Mixed(state.int_value));
+                    else if (type == type_Timestamp)
+                        m_aggregates.push_back(Mixed(state.timestamp));
+                    else if (type == type_Float)
+                        m_aggregates.push_back(Mixed(float(state.double_value)));
+                    else
+                        m_aggregates.push_back(Mixed(state.double_value));
+                    break;
+            }
+        }
+    }
+}
+
+util::Optional<Mixed> GroupByResult::get_key(size_t group, size_t key_ndx) const
+{
+    REALM_ASSERT(group < m_num_groups && key_ndx < m_num_keys);
+    return m_keys[group * m_num_keys + key_ndx];
+}
+
+util::Optional<Mixed> GroupByResult::get_aggregate(size_t group, size_t aggregate_ndx) const
+{
+    REALM_ASSERT(group < m_num_groups && aggregate_ndx < m_num_aggregates);
+    return m_aggregates[group * m_num_aggregates + aggregate_ndx];
+}
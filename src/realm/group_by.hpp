@@ -0,0 +1,167 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_GROUP_BY_HPP
+#define REALM_GROUP_BY_HPP
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <realm/column_fwd.hpp>
+#include <realm/mixed.hpp>
+#include <realm/util/optional.hpp>
+
+namespace realm {
+
+class Table;
+
+/// Describes a grouped aggregation: rows are partitioned by the values of one
+/// or more key columns, and every group gets one value per aggregate.
+///
+/// Columns are given as paths in which all but the last column are Link
+/// columns, as for SortDescriptor. Grouping by a Link column itself groups by
+/// the target row.
+///
+/// Run it with Query::group_by() or TableView::group_by().
+class GroupByDescriptor {
+public:
+    enum class Aggregate { count, sum, min, max, average, count_distinct };
+
+    explicit GroupByDescriptor(const Table& table);
+
+    /// Group by the value of the column at the end of `column_path`, which
+    /// must be an Int, Bool, String, Timestamp or Link column. Rows with a null
+    /// link on the way have a null key. Throws LogicError::type_mismatch for
+    /// other column types.
+    GroupByDescriptor& add_key(std::vector<size_t> column_path);
+
+    /// Group by a Timestamp column cut into buckets of `bucket_seconds`
+    /// seconds. The key of a group is the timestamp at which its bucket starts.
+    GroupByDescriptor& add_timestamp_bucket(std::vector<size_t> column_path, int64_t bucket_seconds);
+
+    /// Add an aggregate over the column at the end of `column_path`.
+    ///
+    /// `count` with an empty path counts the rows of a group, otherwise the
+    /// non-null values. `sum` and `average` take Int, Float and Double columns,
+    /// `min` and `max` additionally Timestamp, and `count_distinct` any column
+    /// type accepted as a key as well as Float and Double. Null values and rows
+    /// with a null link on the way are ignored.
+    ///
+    /// Sums of Int columns are Int, other sums and all averages are Double.
+    /// Minimum and maximum have the type of the column. Counts are Int.
+    GroupByDescriptor& add_aggregate(Aggregate type, std::vector<size_t> column_path = {});
+
+    /// Aggregate with at most `num_threads` threads, or as many as the hardware
+    /// runs concurrently if it is zero, which is the default. Fewer threads are
+    /// used when there are not enough rows for them to pay off.
+    GroupByDescriptor& set_max_threads(size_t num_threads) noexcept
+    {
+        m_max_threads = num_threads;
+        return *this;
+    }
+
+    /// The table that the rows to aggregate must belong to
+    const Table& get_table() const noexcept
+    {
+        return *m_table;
+    }
+
+    size_t key_count() const noexcept
+    {
+        return m_keys.size();
+    }
+
+    size_t aggregate_count() const noexcept
+    {
+        return m_aggregates.size();
+    }
+
+private:
+    struct ColumnPath {
+        std::vector<const Table*> tables; // tables[i] holds column indices[i]
+        std::vector<size_t> indices;
+        DataType type;
+
+        // Returns the row of the last table reached from `row`, or npos if a
+        // link on the way is null
+        size_t resolve(size_t row) const noexcept;
+    };
+
+    struct Key {
+        ColumnPath path;
+        int64_t bucket_seconds; // 0 if not bucketed
+    };
+
+    struct AggregateColumn {
+        Aggregate type;
+        ColumnPath path; // empty for counting rows
+    };
+
+    const Table* m_table;
+    std::vector<Key> m_keys;
+    std::vector<AggregateColumn> m_aggregates;
+    size_t m_max_threads = 0;
+
+    ColumnPath make_path(std::vector<size_t> column_path) const;
+
+    friend class GroupByResult;
+};
+
+/// The outcome of a grouped aggregation, with one entry per group in the order
+/// in which the groups were first seen. The result owns its values and stays
+/// valid when the table changes.
+class GroupByResult {
+public:
+    /// Aggregate the rows listed in `rows` (skipping detached entries) of the
+    /// table the descriptor was created for.
+    GroupByResult(const GroupByDescriptor& descriptor, const IntegerColumn& rows);
+
+    // String keys refer to the strings owned by the result, which stay in
+    // place when it is moved, but a copy would refer to those of the original
+    GroupByResult(GroupByResult&&) = default;
+    GroupByResult& operator=(GroupByResult&&) = default;
+    GroupByResult(const GroupByResult&) = delete;
+    GroupByResult& operator=(const GroupByResult&) = delete;
+
+    /// The number of groups
+    size_t size() const noexcept
+    {
+        return m_num_groups;
+    }
+
+    /// The value of key number `key_ndx` of `group`, or none if it is null.
+    /// Int keys and Link keys (the target row index) are returned as Int.
+    util::Optional<Mixed> get_key(size_t group, size_t key_ndx) const;
+
+    /// The value of aggregate number `aggregate_ndx` of `group`, or none if it
+    /// is undefined, such as the minimum of a group without values.
+    util::Optional<Mixed> get_aggregate(size_t group, size_t aggregate_ndx) const;
+
+private:
+    size_t m_num_groups = 0;
+    size_t m_num_keys;
+    size_t m_num_aggregates;
+    std::vector<util::Optional<Mixed>> m_keys;       // m_num_keys entries per group
+    std::vector<util::Optional<Mixed>> m_aggregates; // m_num_aggregates entries per group
+    std::deque<std::string> m_strings;               // storage for string keys
+};
+
+} // namespace realm
+
+#endif // REALM_GROUP_BY_HPP
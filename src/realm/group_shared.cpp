@@ -36,7 +36,9 @@
 #include <realm/group_shared.hpp>
 #include <realm/group_writer.hpp>
 #include <realm/link_view.hpp>
+#include <realm/query.hpp>
 #include <realm/replication.hpp>
+#include <realm/table_view.hpp>
 #include <realm/impl/simulated_failure.hpp>
 #include <realm/disable_sync_to_disk.hpp>
 
@@ -44,6 +46,12 @@
 #include <sys/wait.h>
 #include <sys/time.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#define REALM_FUTEX_CHANGE_NOTIFICATION 1
+#endif
 #else
 #include <windows.h>
 #include <process.h>
@@ -78,7 +86,52 @@ const uint16_t relaxed_sync_threshold = 50;
 //  9      Fair write transactions requires an additional condition variable,
 //         `write_fairness`
 // 10      Introducing SharedInfo::history_schema_version.
-const uint_fast16_t g_shared_info_version = 10;
+// 11      Group commit requires `durable_version` and an additional condition
+//         variable, `new_durable_version`.
+// 12      Durability::Background requires an additional mutex,
+//         `shared_syncmutex`.
+// 13      Durability::ChangesetLog requires `changeset_log_end` and
+//         `changeset_log_recovery`.
+// 14      Read locks may be held through `reader_slots` instead of the
+//         reference counts of the ringbuffer entries.
+// 15      Online compaction requires `compaction_limit`.
+// 16      Introducing `commit_sequence` and `num_change_waiters`, through
+//         which wait_for_change() is woken on Linux.
+const uint_fast16_t g_shared_info_version = 16;
+
+#ifdef REALM_FUTEX_CHANGE_NOTIFICATION
+
+// The futex word is in the memory mapped lock file, which is shared between
+// processes, so the operations must not be FUTEX_PRIVATE_FLAG ones.
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Unexpected size of futex word");
+
+inline uint32_t* futex_word(std::atomic<uint32_t>& word) noexcept
+{
+    return reinterpret_cast<uint32_t*>(&word);
+}
+
+// Sleeps until `word` is woken, unless it no longer holds `expected`. May
+// return spuriously.
+inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected) noexcept
+{
+    syscall(SYS_futex, futex_word(word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+}
+
+inline void futex_wake_all(std::atomic<uint32_t>& word) noexcept
+{
+    syscall(SYS_futex, futex_word(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Must be called after the change that the waiters are waiting for has been
+// made visible. The system call is skipped when nobody waits.
+inline void notify_change_waiters(std::atomic<uint32_t>& sequence, std::atomic<uint32_t>& num_waiters) noexcept
+{
+    sequence.fetch_add(1);
+    if (num_waiters.load() != 0)
+        futex_wake_all(sequence);
+}
+
+#endif // REALM_FUTEX_CHANGE_NOTIFICATION
 
 // The following functions are carefully designed for minimal overhead
 // in case of contention among read transactions. In case of contention,
@@ -161,6 +214,22 @@ const uint_fast16_t g_shared_info_version = 10;
 //   by a read memory barrier which would be faster on some architectures, but
 //   there is no standardized support for it.
 //
+// Reader slots:
+//
+// All readers of the latest version increment the same count field, so with
+// many threads starting short read transactions, the cache line holding it
+// bounces between the cores. To avoid that, each SharedGroup claims a reader
+// slot of its own, and holds its read lock by storing the index of the
+// ringbuffer entry in the slot instead. The cleanup process must then check
+// the slots before it frees an entry whose count is zero.
+//
+// A reader stores the index in its slot before it checks that the entry is not
+// free, and the cleanup process sets the free field before it checks the
+// slots. With sequentially consistent ordering of the four accesses, at least
+// one of them sees the other, and backs off. The reader releases the read lock
+// by clearing the slot with *release*, and the cleanup process reads the slots
+// with *acquire* (case 2 above).
+//
 
 template <typename T>
 bool atomic_double_inc_if_even(std::atomic<T>& counter)
@@ -183,7 +252,9 @@ inline void atomic_double_dec(std::atomic<T>& counter)
 template <typename T>
 bool atomic_one_if_zero(std::atomic<T>& counter)
 {
-    T old_val = counter.fetch_add(1, std::memory_order_acquire);
+    // Sequentially consistent, as it is ordered against the stores to the
+    // reader slots (see above)
+    T old_val = counter.fetch_add(1, std::memory_order_seq_cst);
     if (old_val != 0) {
         counter.fetch_sub(1, std::memory_order_relaxed);
         return false;
@@ -351,7 +422,10 @@ public:
         put_pos.store(uint32_t(next()), std::memory_order_release);
     }
 
-    void cleanup() noexcept
+    // `is_in_reader_slot(index)` must tell whether the entry is read locked
+    // through a reader slot
+    template <class F>
+    void cleanup(F is_in_reader_slot) noexcept
     {
         // invariant: entry held by put_pos has count > 1.
         // std::cout << "cleanup: from " << old_pos << " to " << put_pos.load_relaxed();
@@ -360,6 +434,10 @@ public:
             const ReadCount& r = get(old_pos.load(std::memory_order_relaxed));
             if (!atomic_one_if_zero(r.count))
                 break;
+            if (is_in_reader_slot(old_pos.load(std::memory_order_relaxed))) {
+                atomic_dec(r.count);
+                break;
+            }
             auto next_ndx = get(old_pos.load(std::memory_order_relaxed)).next;
             old_pos.store(next_ndx, std::memory_order_relaxed);
         }
@@ -382,6 +460,18 @@ private:
     ReadCount data[init_readers_size];
 };
 
+// A reader slot is owned by one SharedGroup at a time, and holds the index plus
+// one of the ringbuffer entry it has read locked, or zero. The slots are padded
+// so that the fields of two slots never share a cache line, regardless of the
+// alignment of the array.
+struct ReaderSlot {
+    std::atomic<uint32_t> owned{0};
+    std::atomic<uint32_t> entry{0};
+    char padding[120];
+};
+
+const uint_fast32_t num_reader_slots = 64;
+
 } // anonymous namespace
 
 
@@ -512,15 +602,59 @@ struct alignas(8) SharedGroup::SharedInfo {
     InterprocessMutex::SharedPart shared_balancemutex;
 #endif
     InterprocessMutex::SharedPart shared_controlmutex;
+    InterprocessMutex::SharedPart shared_syncmutex;
     // FIXME: windows pthread support for condvar not ready
     InterprocessCondVar::SharedPart room_to_write;
     InterprocessCondVar::SharedPart work_to_do;
     InterprocessCondVar::SharedPart daemon_becomes_ready;
     InterprocessCondVar::SharedPart new_commit_available;
     InterprocessCondVar::SharedPart pick_next_writer;
+    InterprocessCondVar::SharedPart new_durable_version;
     std::atomic<uint32_t> next_ticket;
     uint32_t next_served = 0;
 
+    /// The latest version which the header of the Realm file refers to, and
+    /// whose data has been synced to stable storage. With group commit it may
+    /// lag behind the latest version, until one of the writers makes the
+    /// versions in between durable. With Durability::Background it lags
+    /// behind until a background thread has synced the file, and with
+    /// Durability::ChangesetLog until the next checkpoint. Not maintained with
+    /// the other durability levels. Modified only while holding the control
+    /// mutex, and the write mutex (Full and ChangesetLog) or the sync mutex
+    /// (Background).
+    uint64_t durable_version = 0;
+
+    /// Durability::ChangesetLog: The end of the records appended to the
+    /// changeset log since the last checkpoint. Guarded by the write mutex.
+    uint64_t changeset_log_end = 0;
+
+    /// While an online compaction is in progress, the file size before which
+    /// the writers allocate space whenever they can, zero otherwise. Guarded
+    /// by the write mutex.
+    uint64_t compaction_limit = 0;
+
+    /// Durability::ChangesetLog: Whether the session initiator is replaying the
+    /// changeset log, during which the other participants wait to join. Guarded
+    /// by the control mutex.
+    uint8_t changeset_log_recovery = 0;
+
+    /// The reader slots, of which the first `num_reader_slots_used` may have
+    /// been claimed. Claimed and released without locking.
+    std::atomic<uint32_t> num_reader_slots_used{0};
+    ReaderSlot reader_slots[num_reader_slots];
+
+    /// Incremented after each commit, and by wait_for_change_release(). On
+    /// Linux, wait_for_change() sleeps on it with a futex, so that a commit
+    /// wakes all the waiting threads, in every process, with a single system
+    /// call, and without them contending for the control mutex when they wake
+    /// up. Accessed without locking.
+    std::atomic<uint32_t> commit_sequence{0};
+
+    /// The number of threads which are, or are about to go, to sleep on
+    /// `commit_sequence`. The futex is only woken when it is nonzero.
+    /// Accessed without locking.
+    std::atomic<uint32_t> num_change_waiters{0};
+
     // IMPORTANT: The ringbuffer MUST be the last field in SharedInfo - see above.
     Ringbuffer readers;
 
@@ -553,6 +687,7 @@ SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht
     , shared_balancemutex() // Throws
 #endif
     , shared_controlmutex() // Throws
+    , shared_syncmutex()    // Throws
 {
     durability = static_cast<uint16_t>(dura); // durability level is fixed from creation
     REALM_ASSERT(!util::int_cast_has_overflow<decltype(history_type)>(ht + 0));
@@ -561,6 +696,7 @@ SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht
     history_schema_version = static_cast<uint16_t>(hsv);
     InterprocessCondVar::init_shared_part(new_commit_available); // Throws
     InterprocessCondVar::init_shared_part(pick_next_writer); // Throws
+    InterprocessCondVar::init_shared_part(new_durable_version); // Throws
     next_ticket = 0;
 #ifdef REALM_ASYNC_DAEMON
     InterprocessCondVar::init_shared_part(room_to_write);        // Throws
@@ -636,6 +772,167 @@ SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht
 
 namespace {
 
+// The absolute time `duration` from now, as expected by
+// InterprocessCondVar::wait(). Like the timeouts of do_begin_write(), this uses
+// the non-monotonic system clock, so a clock adjustment may make a wait shorter
+// or longer.
+timespec time_limit_after(std::chrono::microseconds duration)
+{
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    int_fast64_t usec = tv.tv_usec + int_fast64_t(duration.count());
+    timespec time_limit;
+    time_limit.tv_sec = tv.tv_sec + time_t(usec / 1000000);
+    time_limit.tv_nsec = long(usec % 1000000) * 1000;
+    return time_limit;
+}
+
+bool has_passed(const timespec& time_limit)
+{
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    return time_limit.tv_sec < tv.tv_sec ||
+           (time_limit.tv_sec == tv.tv_sec && time_limit.tv_nsec <= tv.tv_usec * 1000);
+}
+
+// Values of SharedInfo::changeset_log_recovery
+enum : uint8_t {
+    changeset_log_NotReplaying = 0,
+    changeset_log_Replaying,
+    changeset_log_ReplayFailed,
+};
+
+// The changeset log starts with this header, which binds the records to the
+// snapshot of the Realm file that they continue from, the base. As the top ref
+// alone may well be the same in another file, the contents of the top array,
+// which include the logical file size and the refs of the tables, the
+// free-lists and the history, are checksummed too. The header is written along
+// with the first record after the log is restarted.
+struct ChangesetLogFileHeader {
+    uint64_t magic;
+    uint64_t base_version;
+    uint64_t base_top_ref;
+    uint64_t base_top_checksum;
+    uint64_t checksum;
+};
+
+const uint64_t changeset_log_magic = 0x474f4c5453534843ULL; // "CHSSTLOG"
+
+// A record of the changeset log is this header followed by the changeset. The
+// records appended since the last checkpoint follow the file header, and may be
+// followed by a partially written record, or by records left from before the
+// checkpoint, whose versions are lower.
+struct ChangesetLogHeader {
+    uint64_t version;
+    uint64_t size;
+    uint64_t checksum;
+};
+
+// The log is preallocated in steps of this size, so that most appends do not
+// change the size of the file
+const size_t changeset_log_growth = 1024 * 1024;
+
+uint64_t changeset_log_checksum(uint64_t version, const char* data, uint64_t size) noexcept
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&](const char* bytes, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            hash ^= uint8_t(bytes[i]);
+            hash *= 1099511628211ULL;
+        }
+    };
+    add(reinterpret_cast<const char*>(&version), sizeof version);
+    add(reinterpret_cast<const char*>(&size), sizeof size);
+    add(data, size_t(size));
+    return hash;
+}
+
+ChangesetLogFileHeader make_changeset_log_file_header(Allocator& alloc, uint64_t base_version,
+                                                      ref_type base_top_ref) noexcept
+{
+    ChangesetLogFileHeader header;
+    header.magic = changeset_log_magic;
+    header.base_version = base_version;
+    header.base_top_ref = uint64_t(base_top_ref);
+    header.base_top_checksum = changeset_log_checksum(base_version, nullptr, 0);
+    if (base_top_ref != 0) {
+        Array top(alloc);
+        top.init_from_ref(base_top_ref);
+        header.base_top_checksum = changeset_log_checksum(base_version, alloc.translate(base_top_ref),
+                                                          top.get_byte_size());
+    }
+    header.checksum = changeset_log_checksum(base_version, reinterpret_cast<const char*>(&header.base_top_ref),
+                                             sizeof header.base_top_ref + sizeof header.base_top_checksum);
+    return header;
+}
+
+struct ChangesetLogRecord {
+    uint64_t version;
+    std::vector<char> changeset;
+};
+
+// Returns the records of the changeset log with versions after the specified
+// snapshot of the Realm file. As the versions of the records appended since
+// the last checkpoint are consecutive from the base, reading stops at the first
+// record that does not continue them, or that is not completely written. A log
+// without a complete file header has no records. Throws if the base is not the
+// specified snapshot or an earlier one, since the records of such a log were
+// not committed on top of the Realm file.
+std::vector<ChangesetLogRecord> read_changeset_log(File& log, Allocator& alloc, uint64_t version,
+                                                   ref_type top_ref)
+{
+    std::vector<ChangesetLogRecord> records;
+    uint64_t log_size = uint64_t(log.get_size()); // Throws
+    if (log_size < sizeof(ChangesetLogFileHeader))
+        return records;
+    ChangesetLogFileHeader file_header;
+    log.seek(0);                                                         // Throws
+    log.read(reinterpret_cast<char*>(&file_header), sizeof file_header); // Throws
+    uint64_t checksum = changeset_log_checksum(file_header.base_version,
+                                               reinterpret_cast<const char*>(&file_header.base_top_ref),
+                                               sizeof file_header.base_top_ref + sizeof file_header.base_top_checksum);
+    if (file_header.magic != changeset_log_magic || file_header.checksum != checksum)
+        return records;
+    bool is_base = false;
+    if (file_header.base_version == version) {
+        ChangesetLogFileHeader expected = make_changeset_log_file_header(alloc, version, top_ref);
+        is_base = file_header.base_top_ref == expected.base_top_ref &&
+                  file_header.base_top_checksum == expected.base_top_checksum;
+    }
+    if (file_header.base_version > version || (file_header.base_version == version && !is_base))
+        throw std::runtime_error("The changeset log does not belong to the Realm file");
+
+    uint64_t offset = sizeof file_header;
+    uint64_t last_version = file_header.base_version;
+    std::vector<char> changeset;
+    while (log_size - offset >= sizeof(ChangesetLogHeader)) {
+        ChangesetLogHeader header;
+        log.seek(File::SizeType(offset));                          // Throws
+        log.read(reinterpret_cast<char*>(&header), sizeof header); // Throws
+        if (header.version != last_version + 1 || header.size > log_size - offset - sizeof header)
+            break;
+        changeset.resize(size_t(header.size));        // Throws
+        log.read(changeset.data(), changeset.size()); // Throws
+        if (header.checksum != changeset_log_checksum(header.version, changeset.data(), header.size))
+            break;
+        if (header.version > version)
+            records.push_back({header.version, changeset}); // Throws
+        last_version = header.version;
+        offset += sizeof header + header.size;
+    }
+    return records;
+}
+
+bool changeset_log_has_changes_after(const std::string& path, Allocator& alloc, uint64_t version,
+                                     ref_type top_ref)
+{
+    if (!File::exists(path))
+        return false;
+    File log(path, File::mode_Read);                           // Throws
+    return !read_changeset_log(log, alloc, version, top_ref).empty(); // Throws
+}
+
 #ifdef REALM_ASYNC_DAEMON
 
 void spawn_daemon(const std::string& file)
@@ -768,6 +1065,17 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
     if (options.durability == Durability::Async)
         throw std::runtime_error("Async mode not yet supported on Windows, iOS and watchOS");
 #endif
+    // The background thread syncs the file descriptor, which does not reach the
+    // pages still held by the encryption layer
+    if (options.durability == Durability::Background && options.encryption_key)
+        throw std::runtime_error("Background durability is not supported with encryption");
+    // The changesets would be stored unencrypted in the log
+    if (options.durability == Durability::ChangesetLog) {
+        if (options.encryption_key)
+            throw std::runtime_error("Changeset log durability is not supported with encryption");
+        if (!m_group.get_replication())
+            throw std::runtime_error("Changeset log durability requires a history");
+    }
 
     m_db_path = path;
     m_coordination_dir = path + ".management";
@@ -783,6 +1091,16 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
         m_group.set_metrics(m_metrics);
     }
 #endif // REALM_METRICS
+    m_query_cache = options.query_cache;
+    // Group commit makes versions durable by syncing the file descriptor, which
+    // does not reach the pages still held by the encryption layer
+    bool group_commit = options.durability == Durability::Full && !options.encryption_key;
+    m_group_commit_window = group_commit ? options.group_commit_window : std::chrono::microseconds::zero();
+    m_changeset_log_checkpoint_size = options.changeset_log_checkpoint_size;
+    m_accessor_refresh_threshold = options.accessor_refresh_threshold;
+    m_max_write_threads = options.max_write_threads;
+    std::string changeset_log_path = path + ".changeset_log";
+    bool changeset_log_needs_replay = false;
 
     Replication::HistoryType openers_hist_type = Replication::hist_None;
     int openers_hist_schema_version = 0;
@@ -983,6 +1301,7 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
             m_balancemutex.set_shared_part(info->shared_balancemutex, m_lockfile_prefix, "balance");
 #endif
         m_controlmutex.set_shared_part(info->shared_controlmutex, m_lockfile_prefix, "control");
+        m_syncmutex.set_shared_part(info->shared_syncmutex, m_lockfile_prefix, "sync");
 
         // even though fields match wrt alignment and size, there may still be incompatibilities
         // between implementations, so lets ask one of the mutexes if it thinks it'll work.
@@ -1175,6 +1494,27 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
                 info->number_of_versions = 1;
 
                 info->latest_version_number = version;
+                info->durable_version = version;
+                info->changeset_log_end = 0;
+                // Slots may be left claimed by participants of the previous
+                // session that crashed
+                for (ReaderSlot& slot : info->reader_slots) {
+                    slot.owned.store(0, std::memory_order_relaxed);
+                    slot.entry.store(0, std::memory_order_relaxed);
+                }
+                info->num_reader_slots_used.store(0, std::memory_order_relaxed);
+                // Whatever the durability of this session, the Realm file must
+                // not move on without the changesets logged by an earlier one
+                changeset_log_needs_replay =
+                    changeset_log_has_changes_after(changeset_log_path, alloc, version, top_ref); // Throws
+                if (options.durability != Durability::ChangesetLog) {
+                    if (changeset_log_needs_replay)
+                        throw std::runtime_error("The changeset log has commits that are not in the Realm file, "
+                                                 "which are replayed by opening it with Durability::ChangesetLog");
+                    File::try_remove(changeset_log_path); // Throws
+                }
+                info->changeset_log_recovery =
+                    changeset_log_needs_replay ? changeset_log_Replaying : changeset_log_NotReplaying;
 
                 SharedInfo* r_info = m_reader_map.get_addr();
                 size_t file_size = alloc.get_baseline();
@@ -1252,6 +1592,15 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
                                                    options.temp_dir);
             m_pick_next_writer.set_shared_part(info->pick_next_writer, m_lockfile_prefix, "pick_writer",
                                                    options.temp_dir);
+            m_new_durable_version.set_shared_part(info->new_durable_version, m_lockfile_prefix, "new_durable",
+                                                  options.temp_dir);
+            if (!begin_new_session) {
+                // Wait for the session initiator to replay the changeset log
+                while (info->changeset_log_recovery == changeset_log_Replaying)
+                    m_new_commit_available.wait(m_controlmutex, nullptr);
+                if (info->changeset_log_recovery == changeset_log_ReplayFailed)
+                    throw std::runtime_error("The session initiator failed to replay the changeset log");
+            }
 #ifdef REALM_ASYNC_DAEMON
             if (options.durability == Durability::Async) {
                 m_daemon_becomes_ready.set_shared_part(info->daemon_becomes_ready, m_lockfile_prefix, "daemon_ready",
@@ -1300,6 +1649,7 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
         break;
     }
 
+    claim_reader_slot();
     set_transact_stage(transact_Ready);
 // std::cerr << "open completed" << std::endl;
 
@@ -1315,6 +1665,10 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
 
     // Upgrade file format and/or history schema
     try {
+        if (options.durability == Durability::ChangesetLog)
+            m_changeset_log.open(changeset_log_path, File::access_ReadWrite, File::create_Auto, 0); // Throws
+        start_background_sync(); // Throws
+
         using gf = _impl::GroupFriend;
         if (stored_hist_schema_version == -1) {
             // current_hist_schema_version has not been read. Read it now
@@ -1334,11 +1688,32 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
         }
         else {
             gf::set_file_format_version(m_group, current_file_format_version);
+        }
+
+        // The changesets in the log were committed by the previous session,
+        // which used the file format of the file
+        if (changeset_log_needs_replay)
+            replay_changeset_log(); // Throws
+
+        if (current_file_format_version != 0) {
             upgrade_file_format(options.allow_file_format_upgrade, target_file_format_version,
                                 stored_hist_schema_version, openers_hist_schema_version); // Throws
         }
     }
     catch (...) {
+        if (changeset_log_needs_replay) {
+            // Let the participants that are waiting to join fail too
+            try {
+                SharedInfo* info = m_file_map.get_addr();
+                std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+                if (info->changeset_log_recovery == changeset_log_Replaying) {
+                    info->changeset_log_recovery = changeset_log_ReplayFailed;
+                    m_new_commit_available.notify_all();
+                }
+            }
+            catch (...) {
+            }
+        }
         close();
         throw;
     }
@@ -1360,6 +1735,22 @@ bool SharedGroup::compact(bool bump_version_number, util::Optional<const char*>
     Durability dura = Durability(info->durability);
     std::string tmp_path = m_db_path + ".tmp_compaction_space";
     const char* write_key = bool(output_encryption_key) ? *output_encryption_key : m_key;
+
+    // The background thread must be stopped before the control mutex is taken
+    // below, and is started again by do_open(), or here if the file is not
+    // reopened
+    stop_background_sync();
+    auto background_sync_guard = util::make_scope_exit([&]() noexcept {
+        if (!is_attached())
+            return;
+        try {
+            start_background_sync(); // Throws
+        }
+        catch (...) {
+            // wait_for_durable() syncs the versions the background thread
+            // would have synced
+        }
+    });
     {
         std::unique_lock<InterprocessMutex> lock(m_controlmutex); // Throws
         if (info->num_participants > 1)
@@ -1413,6 +1804,12 @@ bool SharedGroup::compact(bool bump_version_number, util::Optional<const char*>
 #else
         util::File::move(tmp_path, m_db_path);
 #endif
+        // The compacted file holds the logged versions, and its top ref is
+        // not the base of the log
+        if (dura == Durability::ChangesetLog) {
+            info->changeset_log_end = 0;
+            m_changeset_log.resize(0); // Throws
+        }
         close_internal(/* with lock held: */ std::move(lock));
 
     }
@@ -1420,10 +1817,290 @@ bool SharedGroup::compact(bool bump_version_number, util::Optional<const char*>
     new_options.durability = dura;
     new_options.encryption_key = write_key;
     new_options.allow_file_format_upgrade = false;
+    new_options.group_commit_window = m_group_commit_window;
+    new_options.accessor_refresh_threshold = m_accessor_refresh_threshold;
+    new_options.max_write_threads = m_max_write_threads;
     do_open(m_db_path, true, false, new_options);
     return true;
 }
 
+struct SharedGroup::CompactionStep {
+    size_t limit;
+    std::chrono::steady_clock::time_point deadline;
+    // The length of m_compaction_path when the step began
+    size_t resume_depth;
+    size_t num_visited = 0;
+    size_t num_relocated = 0;
+    // Group level indexes of the tables with relocated arrays, in order
+    std::vector<size_t> relocated_tables = {};
+};
+
+
+bool SharedGroup::compact_incrementally(std::chrono::microseconds time_slice)
+{
+    if (m_transact_stage != transact_Ready)
+        throw LogicError(LogicError::wrong_transact_state);
+
+    auto deadline = std::chrono::steady_clock::now() + time_slice;
+    SharedInfo* info = m_file_map.get_addr();
+    std::vector<size_t> relocated_tables;
+
+    do_begin_write(); // Throws
+    try {
+        VersionID version_id = VersionID(); // Latest available snapshot
+        bool writable = true;
+        do_begin_read(version_id, writable); // Throws
+
+        size_t logical_file_size = 0;
+        if (m_group.m_top.is_attached())
+            logical_file_size = to_size_t(m_group.m_top.get(2) / 2);
+        truncate_file(logical_file_size); // Throws
+
+        // The ringbuffer is not cleaned up here, which at worst makes the
+        // oldest version older than it needs to be
+        SharedInfo* r_info = m_reader_map.get_addr();
+        if (grow_reader_mapping(r_info->readers.get_num_entries() - 1)) // Throws
+            r_info = m_reader_map.get_addr();
+        version_type oldest_version = r_info->readers.get_oldest().version;
+        version_type oldest_retained_version = get_oldest_retained_version(oldest_version); // Throws
+        std::vector<FreeChunk> free_chunks = get_free_chunks(oldest_retained_version); // Throws
+
+        if (info->compaction_limit == 0)
+            info->compaction_limit = choose_compaction_limit(logical_file_size, free_chunks); // Throws
+        if (m_compaction_limit != info->compaction_limit) {
+            // Started here, or by another session participant
+            m_compaction_path.clear();
+            m_compaction_limit = size_t(info->compaction_limit);
+            m_compaction_start_size = logical_file_size;
+            m_compaction_prev_pass_relocations = std::numeric_limits<size_t>::max();
+            m_compaction_relocation_done = false;
+            m_compaction_done_version = 0;
+            m_compaction_last_commit = false;
+        }
+
+        // Once the arrays are relocated, the commits give up the free space
+        // at the end of the file as it falls out of use. When the space freed
+        // by the relocation was no longer in use at the previous commit, and
+        // the file still extends beyond the limit, the free lists or the top
+        // array did not fit before it.
+        bool done = m_compaction_limit == 0 || logical_file_size > m_compaction_start_size ||
+                    (m_compaction_relocation_done &&
+                     (logical_file_size <= m_compaction_limit || m_compaction_last_commit));
+        if (done) {
+            info->compaction_limit = 0;
+            m_compaction_limit = 0;
+            do_end_read();
+            do_end_write();
+            return false;
+        }
+
+        if (m_compaction_relocation_done) {
+            if (m_compaction_done_version == 0)
+                m_compaction_done_version = m_read_lock.m_version;
+            m_compaction_last_commit = oldest_retained_version > m_compaction_done_version;
+        }
+        else {
+            CompactionStep step{m_compaction_limit, deadline, m_compaction_path.size()};
+            bool resume = !m_compaction_path.empty();
+            if (!resume) {
+                m_compaction_pass_relocations = 0;
+                m_compaction_pass_clean = true;
+            }
+            else if (m_read_lock.m_version != m_compaction_pass_version) {
+                // Arrays changed by other writers may have moved to where the
+                // pass has already been
+                m_compaction_pass_clean = false;
+            }
+            bool pass_complete = relocate_arrays(m_group.m_top, 0, resume, step); // Throws
+            m_compaction_pass_relocations += step.num_relocated;
+            relocated_tables = std::move(step.relocated_tables);
+            if (step.num_relocated != 0) {
+                m_compaction_pass_clean = false;
+
+                // The accessors of the group must follow the relocated arrays
+                m_group.detach_table_accessors();
+                m_group.m_table_accessors.clear();
+                m_group.m_table_names.init_from_parent();
+                m_group.m_tables.init_from_parent();
+            }
+            if (pass_complete) {
+                m_compaction_path.clear();
+                m_compaction_relocation_done = m_compaction_pass_clean;
+
+                // Arrays which do not fit before the limit end up beyond it
+                // again, so give up unless there are fewer of them each pass
+                if (m_compaction_pass_relocations >= m_compaction_prev_pass_relocations) {
+                    info->compaction_limit = 0;
+                    m_compaction_limit = 0;
+                }
+                m_compaction_prev_pass_relocations = m_compaction_pass_relocations;
+            }
+        }
+
+        if (Replication* repl = m_group.get_replication()) {
+            version_type current_version = m_read_lock.m_version;
+            bool history_updated = false;
+            repl->initiate_transact(Replication::TransactionType::trans_Write, current_version,
+                                    history_updated); // Throws
+        }
+    }
+    catch (...) {
+        do_end_read();
+        do_end_write();
+        throw;
+    }
+
+    set_transact_stage(transact_Writing);
+    try {
+        // The table accessors of the other session participants still refer
+        // to the old arrays, and LangBindHelper::advance_read() only refreshes
+        // those of tables that the changeset mentions
+        if (Replication* repl = m_group.get_replication()) {
+            for (size_t table_ndx : relocated_tables) {
+                TableRef table = m_group.get_table(table_ndx); // Throws
+                repl->refresh_table(table.get());              // Throws
+            }
+        }
+        m_compaction_pass_version = commit(); // Throws
+    }
+    catch (...) {
+        rollback();
+        throw;
+    }
+    return m_compaction_limit != 0;
+}
+
+
+std::vector<SharedGroup::FreeChunk> SharedGroup::get_free_chunks(version_type oldest_retained_version)
+{
+    std::vector<FreeChunk> chunks;
+    const Array& top = m_group.m_top;
+    if (!top.is_attached() || top.size() < 7 || top.get_as_ref(3) == 0)
+        return chunks;
+    Allocator& alloc = m_group.m_alloc;
+    Array positions(alloc);
+    Array lengths(alloc);
+    Array versions(alloc);
+    positions.init_from_ref(top.get_as_ref(3));
+    lengths.init_from_ref(top.get_as_ref(4));
+    versions.init_from_ref(top.get_as_ref(5));
+    chunks.reserve(positions.size()); // Throws
+    for (size_t i = 0; i < positions.size(); ++i) {
+        bool reusable = uint64_t(versions.get(i)) < oldest_retained_version;
+        chunks.push_back({to_size_t(positions.get(i)), to_size_t(lengths.get(i)), reusable});
+    }
+    return chunks;
+}
+
+
+size_t SharedGroup::choose_compaction_limit(size_t logical_file_size, const std::vector<FreeChunk>& free_chunks)
+{
+    size_t free_size = 0;
+    for (auto& chunk : free_chunks)
+        free_size += chunk.size;
+    auto size_before = [&](size_t limit, bool only_reusable) {
+        size_t size = 0;
+        for (auto& chunk : free_chunks) {
+            if (chunk.pos < limit && (chunk.reusable || !only_reusable))
+                size += std::min(chunk.size, limit - chunk.pos);
+        }
+        return size;
+    };
+
+    // Ask for twice the room that the relocated arrays take up, as the free
+    // space may be too fragmented for the larger ones, and leave room for the
+    // free lists
+    SlabAlloc& alloc = m_group.m_alloc;
+    size_t margin = 24 * free_chunks.size() + 4096;
+    size_t used_size = logical_file_size - free_size;
+    for (size_t limit = alloc.get_upper_section_boundary(used_size); limit < logical_file_size;
+         limit = alloc.get_upper_section_boundary(limit)) {
+        size_t relocated_size = logical_file_size - limit - (free_size - size_before(limit, false));
+        if (size_before(limit, true) >= 2 * relocated_size + margin)
+            return limit;
+    }
+    return 0;
+}
+
+
+bool SharedGroup::relocate_arrays(Array& array, size_t depth, bool resume, CompactionStep& step)
+{
+    // When resuming, the arrays on the path were visited by an earlier step
+    bool visited = resume && depth < step.resume_depth;
+    if (!visited) {
+        if (step.num_visited != 0 && std::chrono::steady_clock::now() >= step.deadline) {
+            m_compaction_path.resize(depth);
+            return false;
+        }
+        ++step.num_visited;
+
+        // The top array is written anew by every commit
+        Allocator& alloc = array.get_alloc();
+        ref_type ref = array.get_ref();
+        if (depth != 0 && alloc.is_read_only(ref) && ref + array.get_byte_size() > step.limit) {
+            GroupWriter::relocate_array(array); // Throws
+            ++step.num_relocated;
+
+            // Below the list of tables (slot 1 of the top array), the path
+            // continues with the index of the table
+            if (depth >= 2 && m_compaction_path[0] == 1) {
+                size_t table_ndx = m_compaction_path[1];
+                if (step.relocated_tables.empty() || step.relocated_tables.back() != table_ndx)
+                    step.relocated_tables.push_back(table_ndx); // Throws
+            }
+        }
+    }
+    if (!array.has_refs())
+        return true;
+
+    size_t begin = visited ? m_compaction_path[depth] : 0;
+    if (m_compaction_path.size() <= depth)
+        m_compaction_path.resize(depth + 1); // Throws
+    Array child(array.get_alloc());
+    child.set_parent(&array, 0);
+    for (size_t i = begin; i < array.size(); ++i) {
+        // The free lists are written anew by every commit
+        if (depth == 0 && i >= 3 && i <= 5)
+            continue;
+        int_fast64_t value = array.get(i);
+        if (value == 0 || (value & 1) != 0)
+            continue;
+        m_compaction_path[depth] = i;
+        child.set_ndx_in_parent(i);
+        child.init_from_ref(to_ref(value));
+        if (!relocate_arrays(child, depth + 1, visited && i == begin, step)) // Throws
+            return false;
+    }
+    return true;
+}
+
+
+void SharedGroup::truncate_file(size_t logical_file_size)
+{
+#ifndef _WIN32
+    // The mappings of an encrypted file do not expect its end to move
+    if (m_key)
+        return;
+
+    // A new session would start from the version that the header refers to,
+    // whose file may be larger
+    SharedInfo* info = m_file_map.get_addr();
+    Durability dura = Durability(info->durability);
+    if (dura == Durability::Full || dura == Durability::Background || dura == Durability::ChangesetLog) {
+        std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+        if (info->durable_version != info->latest_version_number)
+            return;
+    }
+
+    util::File& file = m_group.m_alloc.get_file();
+    if (logical_file_size != 0 && size_t(file.get_size()) > logical_file_size)
+        file.resize(logical_file_size); // Throws
+#else
+    // A mapped file cannot be truncated
+    static_cast<void>(logical_file_size);
+#endif
+}
+
 uint_fast64_t SharedGroup::get_number_of_versions()
 {
     SharedInfo* info = m_file_map.get_addr();
@@ -1460,6 +2137,8 @@ void SharedGroup::close_internal(std::unique_lock<InterprocessMutex> lock) noexc
     if (!is_attached())
         return;
 
+    stop_background_sync();
+
     switch (m_transact_stage) {
         case transact_Ready:
             break;
@@ -1472,6 +2151,7 @@ void SharedGroup::close_internal(std::unique_lock<InterprocessMutex> lock) noexc
     }
     m_group.detach();
     set_transact_stage(transact_Ready);
+    release_reader_slot();
     SharedInfo* info = m_file_map.get_addr();
     {
         bool is_sync_agent = false;
@@ -1481,6 +2161,10 @@ void SharedGroup::close_internal(std::unique_lock<InterprocessMutex> lock) noexc
         if (!lock.owns_lock())
             lock.lock();
 
+        if (Durability(info->durability) == Durability::ChangesetLog && info->num_participants == 1 &&
+            m_group.m_alloc.is_attached())
+            checkpoint_at_end_of_session();
+
         if (m_group.m_alloc.is_attached())
             m_group.m_alloc.detach();
 
@@ -1516,6 +2200,8 @@ void SharedGroup::close_internal(std::unique_lock<InterprocessMutex> lock) noexc
 #endif
     m_new_commit_available.close();
     m_pick_next_writer.close();
+    m_new_durable_version.close();
+    m_changeset_log.close();
 
     // On Windows it is important that we unmap before unlocking, else a SetEndOfFile() call from another thread may
     // interleave which is not permitted on Windows. It is permitted on *nix.
@@ -1535,11 +2221,28 @@ bool SharedGroup::has_changed()
 bool SharedGroup::wait_for_change()
 {
     SharedInfo* info = m_file_map.get_addr();
+#ifdef REALM_FUTEX_CHANGE_NOTIFICATION
+    // The waiter is counted before the sequence number is read, and the
+    // notifier increments the sequence number before it reads the count, so
+    // either the notifier sees the waiter, or the waiter sees the new sequence
+    // number and does not go to sleep.
+    info->num_change_waiters.fetch_add(1);
+    auto unregister = util::make_scope_exit([info]() noexcept { info->num_change_waiters.fetch_sub(1); });
+    for (;;) {
+        uint32_t sequence = info->commit_sequence.load();
+        if (m_read_lock.m_version != get_version_of_latest_snapshot()) // Throws
+            return true;
+        if (!m_wait_for_change_enabled)
+            return false;
+        futex_wait(info->commit_sequence, sequence);
+    }
+#else
     std::lock_guard<InterprocessMutex> lock(m_controlmutex);
     while (m_read_lock.m_version == info->latest_version_number && m_wait_for_change_enabled) {
         m_new_commit_available.wait(m_controlmutex, 0);
     }
     return m_read_lock.m_version != info->latest_version_number;
+#endif
 }
 
 
@@ -1547,7 +2250,14 @@ void SharedGroup::wait_for_change_release()
 {
     std::lock_guard<InterprocessMutex> lock(m_controlmutex);
     m_wait_for_change_enabled = false;
+#ifdef REALM_FUTEX_CHANGE_NOTIFICATION
+    // This wakes the waiters of the other SharedGroups too, but they go back to
+    // sleep when they find no new commit
+    SharedInfo* info = m_file_map.get_addr();
+    notify_change_waiters(info->commit_sequence, info->num_change_waiters);
+#else
     m_new_commit_available.notify_all();
+#endif
 }
 
 
@@ -1579,6 +2289,8 @@ void SharedGroup::set_transact_stage(SharedGroup::TransactStage stage) noexcept
                                                 num_decrypted_pages);
             }
             m_metrics->start_write_transaction();
+            m_metrics->report_write_lock_wait_time(m_write_lock_wait_time);
+            m_write_lock_wait_time = 0;
         } else if (stage == transact_Ready) {
             m_metrics->end_read_transaction(total_size, free_space, num_objects, num_available_versions,
                                             num_decrypted_pages);
@@ -1792,6 +2504,14 @@ SharedGroup::VersionID SharedGroup::get_version_of_current_transaction()
 
 void SharedGroup::release_read_lock(ReadLockInfo& read_lock) noexcept
 {
+    if (read_lock.m_in_reader_slot) {
+        SharedInfo* info = m_file_map.get_addr();
+        info->reader_slots[m_reader_slot].entry.store(0, std::memory_order_release);
+        read_lock.m_in_reader_slot = false;
+        m_reader_slot_in_use = false;
+        return;
+    }
+
     // The release may be tried on a version imported from a different thread,
     // hence generated on a different shared group, which may have memory mapped
     // a larger ringbuffer than we - so make sure we've mapped enough of the
@@ -1805,6 +2525,93 @@ void SharedGroup::release_read_lock(ReadLockInfo& read_lock) noexcept
 
 void SharedGroup::grab_read_lock(ReadLockInfo& read_lock, VersionID version_id)
 {
+    if (m_reader_slot != no_reader_slot && !m_reader_slot_in_use) {
+        grab_read_lock_in_reader_slot(read_lock, version_id); // Throws
+    }
+    else {
+        grab_read_lock_in_ringbuffer(read_lock, version_id); // Throws
+    }
+}
+
+
+void SharedGroup::grab_read_lock_in_reader_slot(ReadLockInfo& read_lock, VersionID version_id)
+{
+    SharedInfo* info = m_file_map.get_addr();
+    ReaderSlot& slot = info->reader_slots[m_reader_slot];
+    bool latest = version_id.version == std::numeric_limits<version_type>::max();
+    for (;;) {
+        SharedInfo* r_info = m_reader_map.get_addr();
+        uint_fast32_t index = latest ? r_info->readers.last() : version_id.index;
+        if (grow_reader_mapping(index)) { // Throws
+            // remapping takes time, so retry with a fresh entry
+            continue;
+        }
+        r_info = m_reader_map.get_addr();
+        const Ringbuffer::ReadCount& r = r_info->readers.get(index);
+        slot.entry.store(uint32_t(index + 1), std::memory_order_seq_cst);
+        if (r.count.load(std::memory_order_seq_cst) & 1) {
+            // The entry is free, or the cleanup process is probing it. In the
+            // latter case the entry is the oldest one.
+            slot.entry.store(0, std::memory_order_relaxed);
+            if (latest || &r_info->readers.get_oldest() == &r)
+                continue;
+            throw BadVersion();
+        }
+        if (!latest && r.version != version_id.version) {
+            slot.entry.store(0, std::memory_order_release);
+            throw BadVersion();
+        }
+        read_lock.m_reader_idx = index;
+        read_lock.m_version = r.version;
+        read_lock.m_top_ref = to_size_t(r.current_top);
+        read_lock.m_file_size = to_size_t(r.filesize);
+        read_lock.m_in_reader_slot = true;
+        m_reader_slot_in_use = true;
+        REALM_ASSERT(m_group.m_alloc.matches_section_boundary(read_lock.m_file_size));
+        REALM_ASSERT(read_lock.m_file_size > read_lock.m_top_ref);
+        return;
+    }
+}
+
+
+void SharedGroup::claim_reader_slot() noexcept
+{
+    SharedInfo* info = m_file_map.get_addr();
+    m_reader_slot = no_reader_slot;
+    m_reader_slot_in_use = false;
+    for (uint32_t i = 0; i < num_reader_slots; ++i) {
+        uint32_t expected = 0;
+        if (info->reader_slots[i].owned.compare_exchange_strong(expected, 1, std::memory_order_relaxed)) {
+            m_reader_slot = i;
+            break;
+        }
+    }
+    if (m_reader_slot == no_reader_slot)
+        return; // Read locks are held through the ringbuffer
+
+    // Must be visible to the cleanup process before the slot is used
+    uint32_t n = info->num_reader_slots_used.load(std::memory_order_relaxed);
+    while (n <= m_reader_slot &&
+           !info->num_reader_slots_used.compare_exchange_weak(n, uint32_t(m_reader_slot + 1),
+                                                              std::memory_order_seq_cst)) {
+    }
+}
+
+
+void SharedGroup::release_reader_slot() noexcept
+{
+    if (m_reader_slot == no_reader_slot)
+        return;
+    SharedInfo* info = m_file_map.get_addr();
+    REALM_ASSERT(!m_reader_slot_in_use);
+    info->reader_slots[m_reader_slot].owned.store(0, std::memory_order_release);
+    m_reader_slot = no_reader_slot;
+}
+
+
+void SharedGroup::grab_read_lock_in_ringbuffer(ReadLockInfo& read_lock, VersionID version_id)
+{
+    read_lock.m_in_reader_slot = false;
     if (version_id.version == std::numeric_limits<version_type>::max()) {
         for (;;) {
             SharedInfo* r_info = m_reader_map.get_addr();
@@ -1991,6 +2798,8 @@ SharedGroup::version_type SharedGroup::commit()
     do_end_read();
     m_read_lock = lock_after_commit;
     set_transact_stage(transact_Ready);
+
+    wait_for_group_commit(new_version); // Throws
     return new_version;
 }
 
@@ -2023,8 +2832,10 @@ SharedGroup::VersionID SharedGroup::pin_version()
     // Get current version
     VersionID version_id(m_read_lock.m_version, m_read_lock.m_reader_idx);
 
+    // The pin is released through the ringbuffer entry, possibly by another
+    // SharedGroup
     ReadLockInfo read_lock;
-    grab_read_lock(read_lock, version_id); // Throws
+    grab_read_lock_in_ringbuffer(read_lock, version_id); // Throws
 
     return version_id;
 }
@@ -2046,6 +2857,63 @@ std::shared_ptr<Metrics> SharedGroup::get_metrics()
 #endif // REALM_METRICS
 }
 
+TableView SharedGroup::find_all_cached(Query& query)
+{
+    return find_all_cached(query, DescriptorOrdering());
+}
+
+TableView SharedGroup::find_all_cached(Query& query, const DescriptorOrdering& ordering)
+{
+    Table& table = *query.m_table;
+    if (!m_query_cache || m_transact_stage != transact_Reading || !table.is_group_level() || query.m_view)
+        return query.find_all(ordering); // Throws
+
+    std::string key;
+    try {
+        key = util::to_string(table.get_index_in_group()) + " " + query.get_description() + " " +
+              ordering.get_description(query.m_table); // Throws
+    }
+    catch (const SerialisationError&) {
+        return query.find_all(ordering); // Throws
+    }
+
+    version_type version = m_read_lock.m_version;
+    if (QueryResultCache::Rows rows = m_query_cache->lookup(key, version)) {
+#if REALM_METRICS
+        if (m_metrics)
+            m_metrics->add_query_cache_hit();
+#endif // REALM_METRICS
+        // Build the view that `query.find_all(ordering)` would have returned
+        TableView result(table, query, 0, size_t(-1), size_t(-1));
+        result.m_descriptor_ordering = ordering;
+        for (size_t row : *rows)
+            result.m_row_indexes.add(row); // Throws
+        result.m_last_seen_version = result.outside_version();
+        return result;
+    }
+
+#if REALM_METRICS
+    if (m_metrics)
+        m_metrics->add_query_cache_miss();
+#endif // REALM_METRICS
+    TableView result = query.find_all(ordering); // Throws
+    auto rows = std::make_shared<std::vector<size_t>>();
+    size_t num_rows = result.m_row_indexes.size();
+    rows->reserve(num_rows);
+    for (size_t i = 0; i < num_rows; ++i)
+        rows->push_back(to_size_t(result.m_row_indexes.get(i)));
+    m_query_cache->store(key, version, QueryResultCache::get_dependencies(table), std::move(rows)); // Throws
+    return result;
+}
+
+void SharedGroup::report_query_cache_changes(_impl::NoCopyInputStream& in, version_type begin_version,
+                                             version_type end_version)
+{
+    QueryResultCache::Changes changes;
+    QueryResultCache::collect_changes(in, changes); // Throws
+    m_query_cache->report_changes(begin_version, end_version, changes);
+}
+
 void SharedGroup::do_begin_read(VersionID version_id, bool writable)
 {
     // FIXME: BadVersion must be thrown in every case where the specified
@@ -2090,6 +2958,9 @@ bool SharedGroup::do_try_begin_write()
 void SharedGroup::do_begin_write()
 {
     SharedInfo* info = m_file_map.get_addr();
+#if REALM_METRICS
+    MetricTimer lock_timer;
+#endif // REALM_METRICS
 
     // Get write lock - the write lock is held until do_end_write().
     //
@@ -2146,6 +3017,9 @@ void SharedGroup::do_begin_write()
     // In doing so, we may bypass other waiters, hence the condition for yielding
     // should take this situation into account by comparing with '>' instead of '!='
     info->next_served = my_ticket;
+#if REALM_METRICS
+    m_write_lock_wait_time = lock_timer.get_elapsed_nanoseconds();
+#endif // REALM_METRICS
     finish_begin_write();
 }
 
@@ -2195,6 +3069,22 @@ Replication::version_type SharedGroup::do_commit()
 
     version_type current_version = r_info->get_current_version_unchecked();
     version_type new_version = current_version + 1;
+
+    // The changes of this transaction, obtained before the history moves them
+    // out of the uncommitted state. The changeset log needs the changeset, and
+    // the query cache the tables it changes.
+    SharedInfo* info = m_file_map.get_addr();
+    bool log_changes = Durability(info->durability) == Durability::ChangesetLog && !m_replaying_changeset_log;
+    _impl::History* hist = (m_query_cache || log_changes) ? get_history() : nullptr;
+    BinaryData uncommitted_changes;
+    if (hist)
+        uncommitted_changes = hist->get_uncommitted_changes();
+    QueryResultCache::Changes query_cache_changes;
+    if (m_query_cache && hist) {
+        _impl::SimpleInputStream in(uncommitted_changes.data(), uncommitted_changes.size());
+        QueryResultCache::collect_changes(in, query_cache_changes); // Throws
+    }
+
     if (Replication* repl = m_group.get_replication()) {
         // If Replication::prepare_commit() fails, then the entire transaction
         // fails. The application then has the option of terminating the
@@ -2202,7 +3092,7 @@ Replication::version_type SharedGroup::do_commit()
         // must call Replication::abort_transact().
         new_version = repl->prepare_commit(current_version); // Throws
         try {
-            low_level_commit(new_version); // Throws
+            low_level_commit(new_version, uncommitted_changes); // Throws
         }
         catch (...) {
             repl->abort_transact();
@@ -2211,8 +3101,10 @@ Replication::version_type SharedGroup::do_commit()
         repl->finalize_commit();
     }
     else {
-        low_level_commit(new_version); // Throws
+        low_level_commit(new_version, uncommitted_changes); // Throws
     }
+    if (m_query_cache && hist)
+        m_query_cache->report_changes(current_version, new_version, query_cache_changes);
     return new_version;
 }
 
@@ -2250,6 +3142,7 @@ SharedGroup::version_type SharedGroup::commit_and_continue_as_read()
 
     set_transact_stage(transact_Reading);
 
+    wait_for_group_commit(version); // Throws
     return version;
 }
 
@@ -2307,13 +3200,14 @@ SharedGroup::version_type SharedGroup::get_version_of_latest_snapshot()
 }
 
 
-void SharedGroup::low_level_commit(uint_fast64_t new_version)
+void SharedGroup::low_level_commit(uint_fast64_t new_version, BinaryData changeset)
 {
     SharedInfo* info = m_file_map.get_addr();
 
     // Version of oldest snapshot currently (or recently) bound in a transaction
     // of the current session.
     uint_fast64_t oldest_version;
+    uint_fast64_t latest_version;
     {
         SharedInfo* r_info = m_reader_map.get_addr();
 
@@ -2323,9 +3217,18 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
         if (grow_reader_mapping(r_info->readers.get_num_entries() - 1)) { // throws
             r_info = m_reader_map.get_addr();
         }
-        r_info->readers.cleanup();
+        r_info->readers.cleanup([info](uint_fast32_t index) {
+            uint32_t entry = uint32_t(index + 1);
+            uint32_t n = info->num_reader_slots_used.load(std::memory_order_seq_cst);
+            for (uint32_t i = 0; i < n; ++i) {
+                if (info->reader_slots[i].entry.load(std::memory_order_seq_cst) == entry)
+                    return true;
+            }
+            return false;
+        });
         const Ringbuffer::ReadCount& rc = r_info->readers.get_oldest();
         oldest_version = rc.version;
+        latest_version = r_info->readers.get_last().version;
 
         // Allow for trimming of the history. Some types of histories do not
         // need store changesets prior to the oldest bound snapshot.
@@ -2341,8 +3244,12 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
     m_group.update_num_objects();
 #endif // REALM_METRICS
     // info->readers.dump();
+    uint_fast64_t oldest_retained_version = get_oldest_retained_version(oldest_version); // Throws
+
     GroupWriter out(m_group, Durability(info->durability)); // Throws
-    out.set_versions(new_version, oldest_version);
+    out.set_versions(new_version, oldest_retained_version);
+    out.set_compaction_limit(size_t(info->compaction_limit));
+    out.set_max_threads(m_max_write_threads);
     // Recursively write all changed arrays to end of file
     ref_type new_top_ref = out.write_group(); // Throws
     m_free_space = out.get_free_space_size();
@@ -2350,11 +3257,41 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
     m_used_space = out.get_file_size() - m_free_space;
     // std::cout << "Writing version " << new_version << ", Topptr " << new_top_ref
     //     << " Read lock at version " << oldest_version << std::endl;
+    bool made_durable = false;
+    uint64_t changeset_log_end = 0;
     switch (Durability(info->durability)) {
         case Durability::Full:
+            if (m_group_commit_window.count() != 0 && other_writers_waiting()) {
+                // Group commit: leave it to the writers waiting for the write
+                // mutex to make this version durable along with their own
+                break;
+            }
+            // Earlier versions left unsynced by group commit may have data
+            // outside of the mappings of this GroupWriter
+            if (info->durable_version != latest_version && !get_disable_sync_to_disk()) {
+#if REALM_METRICS
+                std::unique_ptr<MetricTimer> fsync_timer = Metrics::report_fsync_time(m_group);
+                std::unique_ptr<MetricTimer> sync_timer =
+                    Metrics::report_commit_phase_time(m_group, TransactionInfo::commit_DataSync);
+#endif // REALM_METRICS
+                m_group.m_alloc.get_file().sync(); // Throws
+            }
+            out.commit(new_top_ref); // Throws
+            made_durable = true;
+            break;
         case Durability::Unsafe:
             out.commit(new_top_ref); // Throws
             break;
+        case Durability::Background:
+            // Handed over to the background thread below, once the version
+            // is visible
+            break;
+        case Durability::ChangesetLog:
+            // The version is durable once its changeset is in the log. The
+            // changesets replayed from the log are synced afterwards.
+            if (!m_replaying_changeset_log)
+                changeset_log_end = append_to_changeset_log(new_version, changeset); // Throws
+            break;
         case Durability::MemOnly:
         case Durability::Async:
             // In Durability::MemOnly mode, we just use the file as backing for
@@ -2364,6 +3301,10 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
             break;
     }
     size_t new_file_size = out.get_file_size();
+#if REALM_METRICS
+    std::unique_ptr<MetricTimer> refresh_timer =
+        Metrics::report_commit_phase_time(m_group, TransactionInfo::commit_ReaderRefresh);
+#endif // REALM_METRICS
     // Update reader info. If this fails in any way, the ringbuffer may be corrupted.
     // This can lead to other readers seing invalid data which is likely to cause them
     // to crash. Other writers *must* be prevented from writing any further updates
@@ -2399,7 +3340,396 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
         info->number_of_versions = new_version - oldest_version + 1;
         info->latest_version_number = new_version;
 
+#ifndef REALM_FUTEX_CHANGE_NOTIFICATION
         m_new_commit_available.notify_all();
+#endif
+        if (made_durable) {
+            info->durable_version = new_version;
+            m_new_durable_version.notify_all();
+        }
+    }
+#ifdef REALM_FUTEX_CHANGE_NOTIFICATION
+    // Outside of the control mutex, which the woken threads have no need for
+    notify_change_waiters(info->commit_sequence, info->num_change_waiters);
+#endif
+#if REALM_METRICS
+    refresh_timer.reset();
+#endif // REALM_METRICS
+
+    if (m_background_sync) {
+        BackgroundSync& bs = *m_background_sync;
+        util::LockGuard lock(bs.mutex);
+        if (bs.pending_version == 0)
+            bs.first_pending_commit = std::chrono::steady_clock::now();
+        bs.pending_version = new_version;
+        bs.pending_top_ref = new_top_ref;
+        bs.pending_file_format_version = get_file_format_version();
+        ++bs.num_pending_versions;
+        bs.last_handed_over_version = new_version;
+        bs.work_to_do.notify();
+    }
+
+    if (changeset_log_end != 0) {
+        info->changeset_log_end = changeset_log_end;
+        if (changeset_log_end >= m_changeset_log_checkpoint_size) {
+            try {
+                make_durable(new_version, new_top_ref, get_file_format_version()); // Throws
+                info->changeset_log_end = 0;
+            }
+            catch (...) {
+                // The version is durable in the log, and the checkpoint is
+                // retried by the next commit
+            }
+        }
+    }
+}
+
+
+bool SharedGroup::other_writers_waiting() const noexcept
+{
+    // The writers waiting in do_begin_write() hold the tickets after the one
+    // being served. A writer which got the write mutex through
+    // try_begin_write() has no ticket, so this may miss one waiting writer,
+    // which only costs an extra sync.
+    SharedInfo* info = m_file_map.get_addr();
+    int32_t num_tickets = int32_t(info->next_ticket.load(std::memory_order_relaxed) - info->next_served);
+    return num_tickets > 1;
+}
+
+
+SharedGroup::version_type SharedGroup::get_oldest_retained_version(version_type oldest_bound_version)
+{
+    // The space of the latest durable snapshot must not be reused before a
+    // later snapshot has been made durable, as that is the one a new session
+    // would find after a crash
+    SharedInfo* info = m_file_map.get_addr();
+    Durability dura = Durability(info->durability);
+    if (dura == Durability::Full || dura == Durability::ChangesetLog)
+        return std::min(oldest_bound_version, version_type(info->durable_version));
+    if (dura == Durability::Background) {
+        // The background threads update it without the write mutex
+        std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+        return std::min(oldest_bound_version, version_type(info->durable_version));
+    }
+    return oldest_bound_version;
+}
+
+
+void SharedGroup::sync_latest_version()
+{
+    SharedInfo* r_info = m_reader_map.get_addr();
+    uint_fast32_t index = r_info->readers.last();
+    if (grow_reader_mapping(index)) // Throws
+        r_info = m_reader_map.get_addr();
+    const Ringbuffer::ReadCount& rc = r_info->readers.get(index);
+    make_durable(rc.version, ref_type(rc.current_top), get_file_format_version()); // Throws
+}
+
+
+void SharedGroup::make_durable(version_type version, ref_type top_ref, int file_format_version)
+{
+    GroupWriter::commit_unsynced(m_group.m_alloc, top_ref, file_format_version); // Throws
+
+    SharedInfo* info = m_file_map.get_addr();
+    std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+    info->durable_version = version;
+    m_new_durable_version.notify_all();
+}
+
+
+void SharedGroup::wait_for_group_commit(version_type version)
+{
+    if (m_group_commit_window.count() == 0)
+        return;
+
+    SharedInfo* info = m_file_map.get_addr();
+    {
+        std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+        timespec time_limit = time_limit_after(m_group_commit_window);
+        while (info->durable_version < version && !has_passed(time_limit))
+            m_new_durable_version.wait(m_controlmutex, &time_limit);
+        if (info->durable_version >= version)
+            return;
+    }
+
+    // The writers that were waiting when the version was committed did not make
+    // it durable in time. They may have long running transactions, or may have
+    // rolled back.
+    do_begin_write(); // Throws
+    try {
+        if (info->durable_version < version)
+            sync_latest_version(); // Throws
+    }
+    catch (...) {
+        do_end_write();
+        throw;
+    }
+    do_end_write();
+}
+
+
+void SharedGroup::wait_for_durable(version_type version)
+{
+    if (m_transact_stage == transact_Writing)
+        throw LogicError(LogicError::wrong_transact_state);
+    SharedInfo* info = m_file_map.get_addr();
+    Durability dura = Durability(info->durability);
+    if (dura != Durability::Full && dura != Durability::Background)
+        return;
+    if (version > get_version_of_latest_snapshot())
+        throw LogicError(LogicError::bad_version);
+
+    {
+        std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+        if (m_background_sync) {
+            // Wait for the background thread if the version was handed over
+            // to it, and it does not fail to sync it
+            BackgroundSync& bs = *m_background_sync;
+            auto will_sync = [&] {
+                util::LockGuard lock_2(bs.mutex);
+                return version <= bs.last_handed_over_version && version > bs.last_failed_version;
+            };
+            while (info->durable_version < version && will_sync())
+                m_new_durable_version.wait(m_controlmutex, nullptr);
+        }
+        if (info->durable_version >= version)
+            return;
+    }
+
+    // The version was committed by another SharedGroup, or the background
+    // thread failed to sync it. Syncing the latest version makes all the
+    // earlier ones durable too.
+    do_begin_write(); // Throws
+    try {
+        std::lock_guard<InterprocessMutex> lock(m_syncmutex); // Throws
+        if (info->durable_version < version)
+            sync_latest_version(); // Throws
+    }
+    catch (...) {
+        do_end_write();
+        throw;
+    }
+    do_end_write();
+}
+
+
+SharedGroup::version_type SharedGroup::get_durable_version()
+{
+    SharedInfo* info = m_file_map.get_addr();
+    Durability dura = Durability(info->durability);
+    std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+    if (dura != Durability::Full && dura != Durability::Background)
+        return info->latest_version_number;
+    return info->durable_version;
+}
+
+
+uint64_t SharedGroup::append_to_changeset_log(version_type version, BinaryData changeset)
+{
+    SharedInfo* info = m_file_map.get_addr();
+    ChangesetLogHeader header;
+    header.version = version;
+    header.size = changeset.size();
+    header.checksum = changeset_log_checksum(version, changeset.data(), changeset.size());
+
+    // A record left by a commit that failed after appending it is overwritten
+    uint64_t begin = info->changeset_log_end;
+    bool restart = begin == 0;
+    if (restart)
+        begin = sizeof(ChangesetLogFileHeader);
+    uint64_t end = begin + sizeof header + changeset.size();
+    if (end > uint64_t(m_changeset_log.get_size()))
+        m_changeset_log.prealloc(size_t(end + changeset_log_growth)); // Throws
+    if (restart) {
+        // The log was restarted when the version this one is committed on top
+        // of was synced to the Realm file, which makes that version the base
+        REALM_ASSERT_3(m_read_lock.m_version + 1, ==, version);
+        ChangesetLogFileHeader file_header =
+            make_changeset_log_file_header(m_group.m_alloc, m_read_lock.m_version, m_read_lock.m_top_ref);
+        m_changeset_log.seek(0);                                                                // Throws
+        m_changeset_log.write(reinterpret_cast<const char*>(&file_header), sizeof file_header); // Throws
+    }
+    m_changeset_log.seek(File::SizeType(begin));                                  // Throws
+    m_changeset_log.write(reinterpret_cast<const char*>(&header), sizeof header); // Throws
+    m_changeset_log.write(changeset.data(), changeset.size());                    // Throws
+    if (!get_disable_sync_to_disk())
+        m_changeset_log.sync_data(); // Throws
+    return end;
+}
+
+
+void SharedGroup::replay_changeset_log()
+{
+    using _impl::SimulatedFailure;
+    SharedInfo* info = m_file_map.get_addr();
+    SharedInfo* r_info = m_reader_map.get_addr();
+    uint_fast32_t index = r_info->readers.last();
+    if (grow_reader_mapping(index)) // Throws
+        r_info = m_reader_map.get_addr();
+    const Ringbuffer::ReadCount& rc = r_info->readers.get(index);
+    std::vector<ChangesetLogRecord> records =
+        read_changeset_log(m_changeset_log, m_group.m_alloc, rc.version, ref_type(rc.current_top)); // Throws
+
+    m_replaying_changeset_log = true;
+    try {
+        for (const ChangesetLogRecord& record : records) {
+            Group& group = begin_write(); // Throws
+            try {
+                _impl::SimpleNoCopyInputStream in(record.changeset.data(), record.changeset.size());
+                Replication::apply_changeset(in, group); // Throws
+            }
+            catch (...) {
+                rollback();
+                throw;
+            }
+            version_type version = commit(); // Throws
+            REALM_ASSERT_RELEASE(version == record.version);
+            SimulatedFailure::trigger(SimulatedFailure::shared_group__replay_changeset_log); // Throws
+        }
+
+        // The replayed changesets were not logged again, so the Realm file must
+        // be synced before the log is restarted
+        do_begin_write(); // Throws
+        try {
+            sync_latest_version(); // Throws
+        }
+        catch (...) {
+            do_end_write();
+            throw;
+        }
+        info->changeset_log_end = 0;
+        do_end_write();
+    }
+    catch (...) {
+        m_replaying_changeset_log = false;
+        throw;
+    }
+    m_replaying_changeset_log = false;
+
+    std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+    info->changeset_log_recovery = changeset_log_NotReplaying;
+    m_new_commit_available.notify_all();
+}
+
+
+void SharedGroup::checkpoint_at_end_of_session() noexcept
+{
+    SharedInfo* info = m_file_map.get_addr();
+    // The versions replayed before the failure are not synced, and the log
+    // still has the ones after it, which the next session initiator replays
+    if (info->changeset_log_recovery == changeset_log_ReplayFailed)
+        return;
+    try {
+        SharedInfo* r_info = m_reader_map.get_addr();
+        uint_fast32_t index = r_info->readers.last();
+        if (grow_reader_mapping(index)) // Throws
+            r_info = m_reader_map.get_addr();
+        const Ringbuffer::ReadCount& rc = r_info->readers.get(index);
+        if (info->durable_version < rc.version) {
+            GroupWriter::commit_unsynced(m_group.m_alloc, ref_type(rc.current_top),
+                                         get_file_format_version()); // Throws
+            info->durable_version = rc.version;
+        }
+        info->changeset_log_end = 0;
+        m_changeset_log.resize(0); // Throws
+    }
+    catch (...) {
+        // The next session initiator replays the log
+    }
+}
+
+
+void SharedGroup::start_background_sync()
+{
+    SharedInfo* info = m_file_map.get_addr();
+    if (Durability(info->durability) != Durability::Background || m_background_sync)
+        return;
+    m_background_sync = std::make_unique<BackgroundSync>(); // Throws
+    try {
+        m_background_sync->thread.start([this] { background_sync(); }); // Throws
+    }
+    catch (...) {
+        m_background_sync.reset();
+        throw;
+    }
+}
+
+
+void SharedGroup::stop_background_sync() noexcept
+{
+    if (!m_background_sync)
+        return;
+    BackgroundSync& bs = *m_background_sync;
+    {
+        util::LockGuard lock(bs.mutex);
+        bs.stop = true;
+        bs.work_to_do.notify();
+    }
+    bs.thread.join();
+    m_background_sync.reset();
+}
+
+
+void SharedGroup::background_sync() noexcept
+{
+    SharedInfo* info = m_file_map.get_addr();
+    BackgroundSync& bs = *m_background_sync;
+    for (;;) {
+        // Everything committed while the previous sync was in progress is made
+        // durable by this one
+        version_type version;
+        ref_type top_ref;
+        int file_format_version;
+        size_t num_versions;
+        std::chrono::steady_clock::time_point first_commit;
+        {
+            util::LockGuard lock(bs.mutex);
+            while (bs.pending_version == 0 && !bs.stop)
+                bs.work_to_do.wait(lock);
+            // When stopping, the pending versions are synced first
+            if (bs.pending_version == 0)
+                return;
+            version = bs.pending_version;
+            top_ref = bs.pending_top_ref;
+            file_format_version = bs.pending_file_format_version;
+            num_versions = bs.num_pending_versions;
+            first_commit = bs.first_pending_commit;
+            bs.pending_version = 0;
+            bs.num_pending_versions = 0;
+        }
+
+        try {
+            std::lock_guard<InterprocessMutex> lock(m_syncmutex); // Throws
+            // The background thread of another SharedGroup may have synced a
+            // later version already
+            if (info->durable_version >= version)
+                continue;
+            make_durable(version, top_ref, file_format_version); // Throws
+        }
+        catch (...) {
+            {
+                util::LockGuard lock(bs.mutex);
+                bs.last_failed_version = version;
+            }
+            // Wake up wait_for_durable(), which then syncs the file itself
+            try {
+                std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+                m_new_durable_version.notify_all();
+            }
+            catch (...) {
+            }
+            continue;
+        }
+
+#if REALM_METRICS
+        if (m_metrics) {
+            std::chrono::duration<double> lag = std::chrono::steady_clock::now() - first_commit;
+            m_metrics->add_background_sync(num_versions, lag.count());
+        }
+#else
+        static_cast<void>(num_versions);
+        static_cast<void>(first_commit);
+#endif // REALM_METRICS
     }
 }
 
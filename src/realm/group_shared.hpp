@@ -19,6 +19,7 @@
 #ifndef REALM_GROUP_SHARED_HPP
 #define REALM_GROUP_SHARED_HPP
 
+#include <atomic>
 #include <functional>
 #include <limits>
 #include <realm/util/features.h>
@@ -30,11 +31,16 @@
 #include <realm/handover_defs.hpp>
 #include <realm/impl/transact_log.hpp>
 #include <realm/metrics/metrics.hpp>
+#include <realm/query_cache.hpp>
 #include <realm/replication.hpp>
 #include <realm/version_id.hpp>
 
 namespace realm {
 
+class DescriptorOrdering;
+class Query;
+class TableView;
+
 namespace _impl {
 class SharedGroupFriend;
 class WriteLogCollector;
@@ -265,6 +271,10 @@ public:
     /// immediately. To restore the ability to wait for a change, a call to
     /// enable_wait_for_change() is required. Return true if the database has
     /// changed, false if it might have.
+    ///
+    /// On Linux the waiting threads sleep on a futex in the lock file, so a
+    /// commit wakes all of them, in all processes, with a single system call,
+    /// and they check for the change without taking any lock.
     bool wait_for_change();
 
     /// release any thread waiting in wait_for_change() on *this* SharedGroup.
@@ -325,6 +335,11 @@ public:
     /// (Table, Row, Descriptor). Note that the transaction is also left in a
     /// bad state when a modifying operation on any subordinate accessor throws.
     ///
+    /// With group commit (SharedGroupOptions::group_commit_window), commit()
+    /// waits until the new snapshot is durable. If syncing the file fails at
+    /// that point, commit() throws, but the changes have been committed, and
+    /// the transaction is terminated.
+    ///
     /// rollback() terminates the active write transaction and discards any
     /// changes performed in the context of it. If no write transaction is
     /// active, rollback() does nothing. It is an error to call this function in
@@ -394,6 +409,22 @@ public:
     /// a read transaction will not immediately release any versions.
     uint_fast64_t get_number_of_versions();
 
+    /// Wait until the specified version, as returned by commit(), is durable,
+    /// which with Durability::Background may happen some time after the
+    /// commit. If the background thread of this SharedGroup is going to sync
+    /// the version, this waits for it to do so, and otherwise the file is
+    /// synced here. Returns immediately unless the durability is Full or
+    /// Background. With Durability::ChangesetLog, a version is durable in the
+    /// log when commit() returns.
+    ///
+    /// \throw LogicError If called during a write transaction, or with a
+    /// version that has not been committed.
+    void wait_for_durable(version_type version);
+
+    /// Returns the latest version that is known to be durable. Without group
+    /// commit or Durability::Background, this is the latest version.
+    version_type get_durable_version();
+
     /// Get the approximate size of the data that would be written to the file if
     /// a commit were done at this point. The reported size will always be bigger
     /// than what will eventually be needed as we reserve a bit more memory that
@@ -432,6 +463,30 @@ public:
     /// because it's not crash safe! It may corrupt your database if something fails
     bool compact(bool bump_version_number = false, util::Optional<const char*> output_encryption_key = util::none);
 
+    /// Shrink the database file a step at a time, without the exclusive access
+    /// that compact() needs. Each call runs a write transaction of its own,
+    /// which moves the arrays stored beyond a target size into the free space
+    /// before it for about \a time_slice, so that the other writers are held
+    /// up no longer than that. Until the compaction is complete, the writers
+    /// of all session participants allocate space before the target size
+    /// whenever they can. Once nothing is stored beyond it anymore, and the
+    /// space there is no longer used by any snapshot that is still bound, the
+    /// file is truncated.
+    ///
+    /// Returns true if more steps are needed, and false when the file is as
+    /// small as this can make it, including when there was nothing to gain.
+    /// A reader that stays at an old snapshot delays the truncation, and the
+    /// compaction gives up if the file has to grow in the meantime.
+    ///
+    /// Encrypted files, and files on Windows, where a mapped file cannot be
+    /// truncated, only shrink logically: the free space at the end is reused
+    /// before the file grows again. With Durability::Background and
+    /// Durability::ChangesetLog, the file is truncated by a later call once
+    /// the latest version is durable.
+    ///
+    /// It is an error to call this function inside a transaction.
+    bool compact_incrementally(std::chrono::microseconds time_slice = std::chrono::milliseconds(10));
+
 #ifdef REALM_DEBUG
     void test_ringbuf();
 #endif
@@ -547,6 +602,19 @@ public:
 
     std::shared_ptr<metrics::Metrics> get_metrics();
 
+    /// Equivalent to `query.find_all(ordering)`, except that the result is
+    /// taken from SharedGroupOptions::query_cache if the same query and
+    /// ordering were run on the same table at the version of the current read
+    /// transaction, or at an older version after which none of the tables the
+    /// result depends on was changed. Otherwise the query is run and its result
+    /// stored in the cache.
+    ///
+    /// The cache is bypassed when there is none, in write transactions, and
+    /// for queries that are restricted by a view, run on a subtable or cannot
+    /// be described by Query::get_description().
+    TableView find_all_cached(Query& query);
+    TableView find_all_cached(Query& query, const DescriptorOrdering& ordering);
+
     // Try to grab a exclusive lock of the given realm path's lock file. If the lock
     // can be acquired, the callback will be executed with the lock and then return true.
     // Otherwise false will be returned directly.
@@ -572,6 +640,9 @@ private:
         uint_fast32_t m_reader_idx = 0;
         ref_type m_top_ref = 0;
         size_t m_file_size = 0;
+        // Held through the reader slot of this SharedGroup rather than the
+        // reference count of the ringbuffer entry
+        bool m_in_reader_slot = false;
     };
     class ReadLockUnlockGuard;
 
@@ -585,7 +656,12 @@ private:
     util::File m_file;
     util::File::Map<SharedInfo> m_file_map; // Never remapped
     util::File::Map<SharedInfo> m_reader_map;
-    bool m_wait_for_change_enabled;
+    // The reader slot claimed by this SharedGroup, or `no_reader_slot` if all
+    // of them were taken
+    static const uint_fast32_t no_reader_slot = uint_fast32_t(-1);
+    uint_fast32_t m_reader_slot = no_reader_slot;
+    bool m_reader_slot_in_use = false;
+    std::atomic<bool> m_wait_for_change_enabled{false};
     std::string m_lockfile_path;
     std::string m_lockfile_prefix;
     std::string m_db_path;
@@ -597,6 +673,7 @@ private:
     util::InterprocessMutex m_balancemutex;
 #endif
     util::InterprocessMutex m_controlmutex;
+    util::InterprocessMutex m_syncmutex;
 #ifdef REALM_ASYNC_DAEMON
     util::InterprocessCondVar m_room_to_write;
     util::InterprocessCondVar m_work_to_do;
@@ -604,11 +681,57 @@ private:
 #endif
     util::InterprocessCondVar m_new_commit_available;
     util::InterprocessCondVar m_pick_next_writer;
+    util::InterprocessCondVar m_new_durable_version;
     std::function<void(int, int)> m_upgrade_callback;
+    std::chrono::microseconds m_group_commit_window{0};
+    size_t m_accessor_refresh_threshold = 0;
+    size_t m_max_write_threads = 0;
+
+    // Durability::Background: The versions committed by this SharedGroup are
+    // handed over to the thread as the pending version, which is zero when
+    // there is nothing to sync. Guarded by `mutex`.
+    struct BackgroundSync {
+        util::Thread thread;
+        util::Mutex mutex;
+        util::CondVar work_to_do;
+        bool stop = false;
+        version_type pending_version = 0;
+        ref_type pending_top_ref = 0;
+        int pending_file_format_version = 0;
+        size_t num_pending_versions = 0;
+        std::chrono::steady_clock::time_point first_pending_commit;
+        version_type last_handed_over_version = 0;
+        // The versions up to this one were handed over to a sync that failed
+        version_type last_failed_version = 0;
+    };
+    std::unique_ptr<BackgroundSync> m_background_sync;
+
+    // Online compaction: The path, as indexes of child arrays from the top
+    // array, to the array where the relocation continues in the next step,
+    // and the progress of the current pass over the arrays
+    std::vector<size_t> m_compaction_path;
+    size_t m_compaction_limit = 0;
+    size_t m_compaction_start_size = 0;
+    size_t m_compaction_pass_relocations = 0;
+    size_t m_compaction_prev_pass_relocations = 0;
+    version_type m_compaction_pass_version = 0;
+    version_type m_compaction_done_version = 0;
+    bool m_compaction_pass_clean = false;
+    bool m_compaction_relocation_done = false;
+    bool m_compaction_last_commit = false;
+
+    // Durability::ChangesetLog
+    util::File m_changeset_log;
+    size_t m_changeset_log_checkpoint_size = 0;
+    bool m_replaying_changeset_log = false;
 
 #if REALM_METRICS
     std::shared_ptr<metrics::Metrics> m_metrics;
+    // Time spent waiting in do_begin_write(), reported when the write
+    // transaction is started
+    metrics::nanosecond_storage_t m_write_lock_wait_time = 0;
 #endif // REALM_METRICS
+    std::shared_ptr<QueryResultCache> m_query_cache;
 
     void do_open(const std::string& file, bool no_create, bool is_backend, const SharedGroupOptions options);
 
@@ -637,12 +760,23 @@ private:
     /// this function fails. Also, why is it useful to promise anything about
     /// detection of bad versions? Can we really promise enough to make such a
     /// promise useful to the caller?
+    ///
+    /// The read lock is held through the reader slot of this SharedGroup when
+    /// it is not already in use, and otherwise through the reference count of
+    /// the ringbuffer entry. The slot is a cache line of its own, so unlike the
+    /// reference count, it is not written by the other readers of the same
+    /// version.
     void grab_read_lock(ReadLockInfo&, VersionID);
+    void grab_read_lock_in_reader_slot(ReadLockInfo&, VersionID);
+    void grab_read_lock_in_ringbuffer(ReadLockInfo&, VersionID);
 
     // Release a specific read lock. The read lock MUST have been obtained by a
     // call to grab_read_lock().
     void release_read_lock(ReadLockInfo&) noexcept;
 
+    void claim_reader_slot() noexcept;
+    void release_reader_slot() noexcept;
+
     void do_begin_read(VersionID, bool writable);
     void do_end_read() noexcept;
     /// return true if write transaction can commence, false otherwise.
@@ -665,8 +799,88 @@ private:
     bool grow_reader_mapping(uint_fast32_t index);
 
     // Must be called only by someone that has a lock on the write
-    // mutex.
-    void low_level_commit(uint_fast64_t new_version);
+    // mutex. The changeset is only used with Durability::ChangesetLog.
+    void low_level_commit(uint_fast64_t new_version, BinaryData changeset);
+
+    /// Group commit: Returns true if other writers are waiting for the write
+    /// mutex. Must be called only by someone that has a lock on the write
+    /// mutex.
+    bool other_writers_waiting() const noexcept;
+
+    /// Group commit: Sync the file, and make the latest version the one the
+    /// header refers to. Must be called only by someone that has a lock on the
+    /// write mutex.
+    void sync_latest_version();
+
+    /// Group commit: Wait until the specified version is durable. If none of
+    /// the other writers makes it durable within the group commit window, grab
+    /// the write mutex and do it here. Returns immediately when group commit is
+    /// not in use.
+    void wait_for_group_commit(version_type);
+
+    /// Sync the file, and make the specified version the one the header refers
+    /// to. Must be called only by someone that has a lock on the write mutex
+    /// (Durability::Full and Durability::ChangesetLog) or the sync mutex
+    /// (Durability::Background), and not with an earlier version than the
+    /// durable one.
+    void make_durable(version_type, ref_type top_ref, int file_format_version);
+
+    /// Durability::Background: Start the thread that makes the versions
+    /// committed by this SharedGroup durable, and stop it again after it has
+    /// made the last of them durable. The thread takes the sync mutex and the
+    /// control mutex, so it must not be stopped while holding either.
+    void start_background_sync();
+    void stop_background_sync() noexcept;
+    void background_sync() noexcept;
+
+    /// Durability::ChangesetLog: Append a record to the changeset log, and
+    /// sync it. Returns the end of the record, which becomes the end of the
+    /// log once the version has been published. Must be called only by someone
+    /// that has a lock on the write mutex.
+    uint64_t append_to_changeset_log(version_type, BinaryData changeset);
+
+    /// Durability::ChangesetLog: Called by the session initiator to commit the
+    /// changesets logged after the version the Realm file was last synced at,
+    /// while the other participants wait to join.
+    void replay_changeset_log();
+
+    /// Durability::ChangesetLog: Sync the Realm file at the latest version, and
+    /// empty the changeset log. Called by the last participant of a session,
+    /// with the control mutex locked.
+    void checkpoint_at_end_of_session() noexcept;
+
+    /// The version of the oldest snapshot whose space must not be reused
+    /// yet, given the oldest one bound by a reader. Must be called only by
+    /// someone that has a lock on the write mutex.
+    version_type get_oldest_retained_version(version_type oldest_bound_version);
+
+    /// Online compaction: The entries of the free list of the bound snapshot,
+    /// and whether their space can be reused, given the oldest snapshot whose
+    /// space must be retained.
+    struct FreeChunk {
+        size_t pos;
+        size_t size;
+        bool reusable;
+    };
+    std::vector<FreeChunk> get_free_chunks(version_type oldest_retained_version);
+
+    /// Online compaction: Find the smallest file size, on a section boundary,
+    /// that the arrays beyond it are likely to be moved below. Returns zero if
+    /// there is none smaller than the current size.
+    size_t choose_compaction_limit(size_t logical_file_size, const std::vector<FreeChunk>&);
+
+    /// Online compaction: Copy the array and the arrays below it which lie
+    /// (partly) beyond the compaction limit into slab memory, from where they
+    /// are written into the file before the limit. Returns false if the time
+    /// slice ran out, in which case m_compaction_path leads to the array to
+    /// continue from.
+    struct CompactionStep;
+    bool relocate_arrays(Array&, size_t depth, bool resume, CompactionStep&);
+
+    /// Online compaction: Truncate the file to the logical size of the latest
+    /// version, provided that the header of the file refers to it. Must be
+    /// called only by someone that has a lock on the write mutex.
+    void truncate_file(size_t logical_file_size);
 
     void do_async_commits();
 
@@ -690,6 +904,11 @@ private:
     template <class O>
     bool do_advance_read(O* observer, VersionID, _impl::History&);
 
+    /// Report the tables changed by the transaction logs in `in`, which take
+    /// the Realm from `begin_version` to `end_version`, to m_query_cache.
+    void report_query_cache_changes(_impl::NoCopyInputStream& in, version_type begin_version,
+                                    version_type end_version);
+
     /// If there is an associated \ref Replication object, then this function
     /// returns `repl->get_history()` where `repl` is that Replication object,
     /// otherwise this function returns null.
@@ -1103,6 +1322,13 @@ inline bool SharedGroup::do_advance_read(O* observer, VersionID version_id, _imp
         observer->parse_complete();  // Throws
     }
 
+    if (m_query_cache) {
+        version_type old_version = m_read_lock.m_version;
+        version_type new_version = new_read_lock.m_version;
+        _impl::ChangesetInputStream in(hist, old_version, new_version);
+        report_query_cache_changes(in, old_version, new_version); // Throws
+    }
+
     // The old read lock must be retained for as long as the change history is
     // accessed (until Group::advance_transact() returns). This ensures that the
     // oldest needed changeset remains in the history, even when the history is
@@ -1118,8 +1344,23 @@ inline bool SharedGroup::do_advance_read(O* observer, VersionID version_id, _imp
         version_type new_version = new_read_lock.m_version;
         ref_type new_top_ref = new_read_lock.m_top_ref;
         size_t new_file_size = new_read_lock.m_file_size;
-        _impl::ChangesetInputStream in(hist, old_version, new_version);
-        m_group.advance_transact(new_top_ref, new_file_size, in); // Throws
+        bool refreshed = false;
+        if (m_accessor_refresh_threshold != std::numeric_limits<size_t>::max()) {
+            // Only the size of the blocks is needed, which does not take
+            // parsing them
+            size_t changeset_size = 0;
+            _impl::ChangesetInputStream in(hist, old_version, new_version);
+            const char* begin;
+            const char* end;
+            while (changeset_size < m_accessor_refresh_threshold && in.next_block(begin, end))
+                changeset_size += size_t(end - begin);
+            if (changeset_size >= m_accessor_refresh_threshold)
+                refreshed = m_group.refresh_transact(new_top_ref, new_file_size); // Throws
+        }
+        if (!refreshed) {
+            _impl::ChangesetInputStream in(hist, old_version, new_version);
+            m_group.advance_transact(new_top_ref, new_file_size, in); // Throws
+        }
     }
 
     g.release();
@@ -19,11 +19,15 @@
 #ifndef REALM_GROUP_SHARED_OPTIONS_HPP
 #define REALM_GROUP_SHARED_OPTIONS_HPP
 
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <string>
 
 namespace realm {
 
+class QueryResultCache;
+
 struct SharedGroupOptions {
 
     /// The persistence level of the SharedGroup.
@@ -32,7 +36,26 @@ struct SharedGroupOptions {
         Full,
         MemOnly,
         Async, ///< Not yet supported on windows.
-        Unsafe  // If you use this, you loose ACID property
+        Unsafe, // If you use this, you loose ACID property
+        /// Like Full, except that commit() returns as soon as the new version
+        /// is visible to readers, and a background thread of each SharedGroup
+        /// syncs the file afterwards. A version committed while a sync is in
+        /// progress is made durable by the next one, along with all the others
+        /// committed in the meantime. Use SharedGroup::wait_for_durable() to
+        /// wait for a particular version. Not supported with encryption.
+        Background,
+        /// A commit appends the changeset of the transaction to the changeset
+        /// log (the Realm file path with ".changeset_log" appended) and syncs
+        /// only that, which is one sequential write, instead of syncing the
+        /// pages of the Realm file changed by the transaction. The Realm file
+        /// is synced, and the log restarted, once the log has grown beyond
+        /// `changeset_log_checkpoint_size`, and when the session ends. After a
+        /// crash, the session initiator applies the changesets that were
+        /// logged after the version the Realm file was last synced at. Until
+        /// then, opening the file with any other durability fails, and once
+        /// the log has nothing to replay, such a session removes it. Requires
+        /// a history (Replication). Not supported with encryption.
+        ChangesetLog
     };
 
     explicit SharedGroupOptions(Durability level = Durability::Full, const char* key = nullptr,
@@ -102,6 +125,50 @@ struct SharedGroupOptions {
     /// is exceeded without being consumed, only the most recent entries will be stored.
     size_t metrics_buffer_size;
 
+    /// An optional cache of query results used by
+    /// SharedGroup::find_all_cached(). The same cache can be given to all the
+    /// SharedGroups of a process that are attached to the same file.
+    std::shared_ptr<QueryResultCache> query_cache;
+
+    /// Enables group commit when nonzero. Only used with Durability::Full, and
+    /// not with encryption.
+    ///
+    /// With group commit, a writer which commits while other writers are
+    /// waiting for the write mutex does not sync the file. It leaves that to
+    /// the last writer in line, whose single sync then makes the versions of
+    /// all of them durable. SharedGroup::commit() still returns only when the
+    /// version it produced is durable, and if that has not happened within
+    /// this window, because the writers in line are slow or roll back, it
+    /// syncs the file itself. Readers may see a version before it is durable.
+    ///
+    /// The participants of a session do not need to agree on the use of group
+    /// commit.
+    std::chrono::microseconds group_commit_window = std::chrono::microseconds::zero();
+
+    /// With Durability::ChangesetLog, the size of the changeset log that makes
+    /// a commit sync the Realm file and restart the log. The versions committed
+    /// since the last restart keep the space they use in the Realm file from
+    /// being reused, so this also bounds how much the file grows in between.
+    size_t changeset_log_checkpoint_size = 8 * 1024 * 1024;
+
+    /// SharedGroup::advance_read() and SharedGroup::promote_to_write() bring
+    /// the accessors up to date by replaying the changesets of the versions
+    /// they advance over. When those amount to at least this many bytes, the
+    /// accessors are instead refreshed from the tables that changed, which
+    /// does not depend on the number of changes. That is possible when the
+    /// schema did not change, and no row accessors, table views, subtables or
+    /// link lists are attached to the changed tables. An observer passed to
+    /// advance_read() still receives all the instructions. Use
+    /// `std::numeric_limits<size_t>::max()` to always replay the changesets.
+    size_t accessor_refresh_threshold = 1024 * 1024;
+
+    /// The number of threads that write the modified tables of a commit, or
+    /// zero, the default, for as many as the hardware runs concurrently. They
+    /// are only used when several tables have plenty of changes, and they are
+    /// shared by all SharedGroups of the process. The file is the same
+    /// whatever the number of threads.
+    size_t max_write_threads = 0;
+
     /// sys_tmp_dir will be used if the temp_dir is empty when creating SharedGroupOptions.
     /// It must be writable and allowed to create pipe/fifo file on it.
     /// set_sys_tmp_dir is not a thread-safe call and it is only supposed to be called once
@@ -17,6 +17,11 @@
  **************************************************************************/
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <thread>
 
 #ifdef REALM_DEBUG
 #include <iostream>
@@ -24,9 +29,11 @@
 
 #include <realm/util/miscellaneous.hpp>
 #include <realm/util/safe_int_ops.hpp>
+#include <realm/util/thread.hpp>
 #include <realm/group_writer.hpp>
 #include <realm/group_shared.hpp>
 #include <realm/alloc_slab.hpp>
+#include <realm/impl/destroy_guard.hpp>
 #include <realm/disable_sync_to_disk.hpp>
 #include <realm/metrics/metric_timer.hpp>
 
@@ -153,6 +160,187 @@ void GroupWriter::MapWindow::encryption_write_barrier(void* start_addr, size_t s
     realm::util::encryption_write_barrier(start_addr, size, m_map.get_encrypted_mapping());
 }
 
+bool inline is_aligned(char* addr) {
+    size_t as_binary = reinterpret_cast<size_t>(addr);
+    return (as_binary & 7) == 0;
+}
+
+
+// Writes arrays one after the other into a chunk of free space reserved
+// beforehand, through a mapping of its own, so that several ChunkWriters can
+// write at the same time.
+class GroupWriter::ChunkWriter : public _impl::ArrayWriterBase {
+public:
+    ChunkWriter(size_t alignment, util::File& f, size_t pos, size_t size)
+        : m_window(new MapWindow(alignment, f, pos, size)) // Throws
+        , m_begin(pos)
+        , m_pos(pos)
+        , m_end(pos + size)
+    {
+    }
+
+    ref_type write_array(const char* data, size_t size, uint32_t checksum) override
+    {
+        REALM_ASSERT_RELEASE_EX(size <= m_end - m_pos, size, m_end - m_pos);
+        char* dest_addr = m_window->translate(m_pos);
+        REALM_ASSERT_RELEASE(is_aligned(dest_addr));
+        memcpy(dest_addr, &checksum, 4);
+        memcpy(dest_addr + 4, data + 4, size - 4);
+        ref_type ref = to_ref(m_pos);
+        m_pos += size;
+        return ref;
+    }
+
+    std::unique_ptr<MapWindow> m_window;
+    size_t m_begin;
+    size_t m_pos;
+    size_t m_end;
+};
+
+
+// Gives several threads read access to the arrays of a SlabAlloc at the same
+// time, which its translation cache does not allow.
+class GroupWriter::ConcurrentReader : public Allocator {
+public:
+    ConcurrentReader(const SlabAlloc& alloc, ref_type baseline) noexcept
+        : m_alloc(alloc)
+    {
+        m_baseline = baseline;
+    }
+
+    void verify() const override
+    {
+    }
+
+protected:
+    MemRef do_alloc(const size_t) override
+    {
+        REALM_TERMINATE("Read only");
+    }
+    MemRef do_realloc(ref_type, char*, size_t, size_t) override
+    {
+        REALM_TERMINATE("Read only");
+    }
+    void do_free(ref_type, char*) noexcept override
+    {
+        REALM_TERMINATE("Read only");
+    }
+    char* do_translate(ref_type ref) const noexcept override
+    {
+        return m_alloc.translate_uncached(ref);
+    }
+
+private:
+    const SlabAlloc& m_alloc;
+};
+
+
+namespace {
+
+// The threads that help GroupWriter::write_tables() write the tables. They are
+// started when first needed and kept until the process exits, as a commit is
+// too short to pay for starting threads of its own.
+class WriterThreadPool {
+public:
+    ~WriterThreadPool() noexcept;
+
+    // Run `work` on the calling thread and on up to `num_helpers` threads of
+    // the pool, and return when all of them have returned from it. `work` must
+    // not throw, and all of it must be done when it returns on any thread, as
+    // the threads that have not started on it by then are not waited for.
+    void run(const std::function<void()>& work, size_t num_helpers);
+
+private:
+    struct Job {
+        const std::function<void()>* work;
+        size_t num_unclaimed; // The threads that may still start on it
+        size_t num_running;
+    };
+
+    util::Mutex m_mutex;
+    util::CondVar m_work_available;
+    util::CondVar m_job_done;
+    std::vector<util::Thread> m_threads; // Protected by m_mutex
+    std::deque<Job*> m_jobs;             // Protected by m_mutex
+    bool m_stopping = false;             // Protected by m_mutex
+
+    void worker_loop();
+};
+
+WriterThreadPool::~WriterThreadPool() noexcept
+{
+    {
+        util::LockGuard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_work_available.notify_all();
+    for (util::Thread& thread : m_threads)
+        thread.join();
+}
+
+void WriterThreadPool::run(const std::function<void()>& work, size_t num_helpers)
+{
+    Job job{&work, 0, 0};
+    {
+        util::LockGuard lock(m_mutex);
+        try {
+            while (m_threads.size() < num_helpers) {
+                m_threads.emplace_back();                          // Throws
+                m_threads.back().start([this] { worker_loop(); }); // Throws
+            }
+        }
+        catch (...) {
+            // Carry on with the threads that could be started
+            if (!m_threads.empty() && !m_threads.back().joinable())
+                m_threads.pop_back();
+        }
+        job.num_unclaimed = std::min(num_helpers, m_threads.size());
+        if (job.num_unclaimed != 0)
+            m_jobs.push_back(&job); // Throws
+    }
+    m_work_available.notify_all();
+    work();
+
+    util::LockGuard lock(m_mutex);
+    if (job.num_unclaimed != 0)
+        m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), &job));
+    while (job.num_running != 0)
+        m_job_done.wait(lock);
+}
+
+void WriterThreadPool::worker_loop()
+{
+    util::Thread::set_name("realm-writer");
+    for (;;) {
+        Job* job;
+        {
+            util::LockGuard lock(m_mutex);
+            while (m_jobs.empty() && !m_stopping)
+                m_work_available.wait(lock);
+            if (m_stopping)
+                return;
+            job = m_jobs.front();
+            if (--job->num_unclaimed == 0)
+                m_jobs.pop_front();
+            ++job->num_running;
+        }
+        (*job->work)();
+        {
+            util::LockGuard lock(m_mutex);
+            if (--job->num_running == 0)
+                m_job_done.notify_all();
+        }
+    }
+}
+
+WriterThreadPool& get_writer_thread_pool()
+{
+    static WriterThreadPool pool;
+    return pool;
+}
+
+} // anonymous namespace
+
 
 GroupWriter::GroupWriter(Group& group, Durability dura)
     : m_group(group)
@@ -263,13 +451,34 @@ size_t GroupWriter::get_file_size() const noexcept
     return sz;
 }
 
+void GroupWriter::relocate_array(Array& array)
+{
+    REALM_ASSERT(array.is_read_only());
+    if (array.has_refs()) {
+        array.copy_on_write(); // Throws
+        return;
+    }
+    // Leaves need not use wtype_Bits, which copy_on_write() assumes
+    Allocator& alloc = array.get_alloc();
+    ref_type ref = array.get_ref();
+    MemRef mem = array.clone_deep(alloc); // Throws
+    alloc.free_(ref, alloc.translate(ref));
+    array.init_from_mem(mem);
+    array.update_parent(); // Throws
+}
+
 void GroupWriter::sync_all_mappings()
 {
-    if (m_durability == Durability::Unsafe)
+    // With Durability::Background and Durability::ChangesetLog, the whole file
+    // is synced when a version is made durable
+    if (!syncs_mappings())
         return;
     for (const auto& window : m_map_windows) {
         window->sync();
     }
+    for (const auto& window : m_chunk_windows) {
+        window->sync();
+    }
 }
 
 // Get a window matching a request, either creating a new window or reusing an
@@ -279,24 +488,164 @@ void GroupWriter::sync_all_mappings()
 GroupWriter::MapWindow* GroupWriter::get_window(ref_type start_ref, size_t size)
 {
     auto match = std::find_if(m_map_windows.begin(), m_map_windows.end(), [=](auto& window) {
-        return window->matches(start_ref, size) || window->extends_to_match(m_alloc.get_file(), start_ref, size);
+        return window->matches(start_ref, size);
     });
-    if (match != m_map_windows.end()) {
-        // move matching window to top (to keep LRU order)
-        std::rotate(m_map_windows.begin(), match, match + 1);
-        return m_map_windows[0].get();
-    }
-    // no window found, make room for a new one at the top
-    if (m_map_windows.size() == num_map_windows) {
-        if (m_durability != Durability::Unsafe)
-            m_map_windows.back()->sync();
-        m_map_windows.pop_back();
-    }
-    auto new_window = std::make_unique<MapWindow>(m_window_alignment, m_alloc.get_file(), start_ref, size);
-    m_map_windows.insert(m_map_windows.begin(), std::move(new_window));
+    if (match == m_map_windows.end()) {
+        // Extending or creating a mapping is part of growing the file
+#if REALM_METRICS
+        std::unique_ptr<MetricTimer> growth_timer =
+            Metrics::report_commit_phase_time(m_group, TransactionInfo::commit_FileGrowth);
+#endif // REALM_METRICS
+        match = std::find_if(m_map_windows.begin(), m_map_windows.end(), [=](auto& window) {
+            return window->extends_to_match(m_alloc.get_file(), start_ref, size);
+        });
+        if (match == m_map_windows.end()) {
+            // no window found, make room for a new one at the top
+            if (m_map_windows.size() == num_map_windows) {
+                if (syncs_mappings())
+                    m_map_windows.back()->sync();
+                m_map_windows.pop_back();
+            }
+            auto new_window = std::make_unique<MapWindow>(m_window_alignment, m_alloc.get_file(), start_ref, size);
+            m_map_windows.insert(m_map_windows.begin(), std::move(new_window));
+            return m_map_windows[0].get();
+        }
+    }
+    // move matching window to top (to keep LRU order)
+    std::rotate(m_map_windows.begin(), match, match + 1);
     return m_map_windows[0].get();
 }
 
+size_t GroupWriter::get_max_write_size(ref_type ref, Allocator& alloc)
+{
+    if (alloc.is_read_only(ref))
+        return 0;
+    char* header = alloc.translate(ref);
+    if (!Array::get_hasrefs_from_header(header))
+        return Array::get_byte_size_from_header(header);
+
+    // The refs of the written copy may need all of 64 bits
+    Array array(alloc);
+    array.init_from_mem(MemRef(header, ref, alloc));
+    size_t n = array.size();
+    size_t size = Array::get_max_byte_size(n);
+    for (size_t i = 0; i < n; ++i) {
+        int_fast64_t value = array.get(i);
+        if (value != 0 && (value & 1) == 0)
+            size += get_max_write_size(to_ref(value), alloc);
+    }
+    return size;
+}
+
+ref_type GroupWriter::write_tables()
+{
+    Array& tables = m_group.m_tables;
+    bool deep = true, only_if_modified = true;
+    if (m_alloc.is_read_only(tables.get_ref()))
+        return tables.get_ref();
+
+    struct Task {
+        size_t ndx;
+        ref_type ref;
+        size_t max_size;
+        std::unique_ptr<ChunkWriter> writer;
+        ref_type new_ref;
+    };
+    std::vector<Task> tasks;
+    // The encryption layer does not support writing through several mappings
+    // at once. Otherwise the tables are written into chunks even when there is
+    // only one thread to write them, so that the file does not depend on the
+    // number of threads.
+    if (!m_alloc.get_file().get_encryption_key()) {
+        size_t n = tables.size();
+        for (size_t i = 0; i < n; ++i) {
+            ref_type ref = tables.get_as_ref(i);
+            if (ref != 0 && !m_alloc.is_read_only(ref))
+                tasks.push_back({i, ref, 0, nullptr, 0}); // Throws
+        }
+    }
+    // Threads only pay off for commits with plenty of changes in more than one
+    // table
+    const size_t min_parallel_write_size = 1024 * 1024;
+    size_t total_size = 0;
+    if (tasks.size() > 1) {
+        for (Task& task : tasks) {
+            task.max_size = get_max_write_size(task.ref, m_alloc);
+            total_size += task.max_size;
+        }
+    }
+    if (tasks.size() < 2 || total_size < min_parallel_write_size)
+        return tables.write(*this, deep, only_if_modified); // Throws
+
+    // Reserve the space in table order, and hand the largest tables out first
+    util::File& file = m_alloc.get_file();
+    for (Task& task : tasks) {
+        size_t pos = get_free_space(task.max_size); // Throws
+        task.writer.reset(new ChunkWriter(m_window_alignment, file, pos, task.max_size)); // Throws
+    }
+    std::vector<Task*> order;
+    for (Task& task : tasks)
+        order.push_back(&task); // Throws
+    std::stable_sort(order.begin(), order.end(),
+                     [](const Task* a, const Task* b) { return a->max_size > b->max_size; });
+
+    ConcurrentReader reader(m_alloc, m_alloc.m_baseline);
+    std::atomic<size_t> next_task(0);
+    util::Mutex error_mutex;
+    std::exception_ptr error;
+    auto work = [&] {
+        for (;;) {
+            size_t i = next_task.fetch_add(1);
+            if (i >= order.size())
+                return;
+            Task& task = *order[i];
+            try {
+                task.new_ref = Array::write(task.ref, reader, *task.writer, only_if_modified); // Throws
+            }
+            catch (...) {
+                util::LockGuard lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+                next_task = order.size();
+            }
+        }
+    };
+    size_t num_threads = m_max_threads != 0 ? m_max_threads : std::thread::hardware_concurrency();
+    num_threads = std::min(num_threads, tasks.size());
+    if (num_threads > 1) {
+        get_writer_thread_pool().run(work, num_threads - 1); // Throws
+    }
+    else {
+        work();
+    }
+    if (error)
+        std::rethrow_exception(error);
+
+    // Give back what the tables did not use, also in table order
+    for (Task& task : tasks) {
+        ChunkWriter& writer = *task.writer;
+        count_written(writer.m_begin, writer.m_pos - writer.m_begin);
+        if (writer.m_pos != writer.m_end)
+            m_size_map.emplace(writer.m_end - writer.m_pos, writer.m_pos); // Throws
+        m_chunk_windows.push_back(std::move(writer.m_window)); // Throws
+    }
+
+    Array new_tables(Allocator::get_default());
+    new_tables.create(Array::type_HasRefs, tables.get_context_flag()); // Throws
+    _impl::ShallowArrayDestroyGuard dg(&new_tables);
+    auto task = tasks.begin();
+    size_t n = tables.size();
+    for (size_t i = 0; i < n; ++i) {
+        int_fast64_t value = tables.get(i);
+        if (task != tasks.end() && task->ndx == i) {
+            value = from_ref(task->new_ref);
+            ++task;
+        }
+        new_tables.add(value); // Throws
+    }
+    return new_tables.do_write_shallow(*this); // Throws
+}
+
 #define REALM_ALLOC_DEBUG 0
 
 ref_type GroupWriter::write_group()
@@ -312,7 +661,13 @@ ref_type GroupWriter::write_group()
     std::cout << "    In-file freelist before merge: " << m_free_positions.size();
 #endif
 
-    read_in_freelist();
+    {
+#if REALM_METRICS
+        std::unique_ptr<MetricTimer> read_timer =
+            Metrics::report_commit_phase_time(m_group, TransactionInfo::commit_FreeListRead);
+#endif // REALM_METRICS
+        read_in_freelist();
+    }
     // Now, 'm_size_map' holds all free elements candidate for recycling
 
     Array& top = m_group.m_top;
@@ -329,7 +684,7 @@ ref_type GroupWriter::write_group()
     // version.
     bool deep = true, only_if_modified = true;
     ref_type names_ref = m_group.m_table_names.write(*this, deep, only_if_modified); // Throws
-    ref_type tables_ref = m_group.m_tables.write(*this, deep, only_if_modified);     // Throws
+    ref_type tables_ref = write_tables();                                            // Throws
 
     int_fast64_t value_1 = from_ref(names_ref);
     int_fast64_t value_2 = from_ref(tables_ref);
@@ -355,6 +710,11 @@ ref_type GroupWriter::write_group()
     std::cout << "    Freelist size after allocations: " << m_size_map.size() << std::endl;
 #endif
 
+#if REALM_METRICS
+    std::unique_ptr<MetricTimer> recreate_timer =
+        Metrics::report_commit_phase_time(m_group, TransactionInfo::commit_FreeListRecreate);
+#endif // REALM_METRICS
+
     // We now have a bit of a chicken-and-egg problem. We need to write the
     // free-lists to the file, but the act of writing them will consume free
     // space, and thereby change the free-lists. To solve this problem, we
@@ -380,6 +740,7 @@ ref_type GroupWriter::write_group()
 #endif
     max_free_list_size += free_read_only_size;
     max_free_list_size += m_not_free_in_file.size();
+    max_free_list_size += m_free_beyond_limit.size();
     // The final allocation of free space (i.e., the call to
     // reserve_free_space() below) may add extra entries to the free-lists.
     // We reserve room for the worst case scenario, which is as follows:
@@ -512,6 +873,10 @@ ref_type GroupWriter::write_group()
     // Write top
     write_array_at(window, top_ref, top.get_header(), top_byte_size); // Throws
     window->encryption_write_barrier(start_addr, used);
+    count_written(reserve_pos, used);
+#if REALM_METRICS
+    Metrics::report_commit_size(m_group, m_num_bytes_written, m_num_pages_dirtied, m_file_growth);
+#endif // REALM_METRICS
     // Return top_ref so that it can be saved in lock file used for coordination
     return top_ref;
 }
@@ -561,16 +926,47 @@ void GroupWriter::read_in_freelist()
     }
 
     free_in_file.merge_adjacent_entries_in_freelist();
+    if (m_compaction_limit)
+        apply_compaction_limit(free_in_file);
     // Previous step produces - potentially - some entries with size of zero. These
     // entries will be skipped in the next step.
     free_in_file.move_free_in_file_to_size_map(m_size_map);
 }
 
+void GroupWriter::apply_compaction_limit(FreeList& free_in_file)
+{
+    // Give up the free space at the end of the file, down to a section
+    // boundary. The file itself is truncated by SharedGroup, once no snapshot
+    // refers to the old size anymore.
+    auto last = std::find_if(free_in_file.rbegin(), free_in_file.rend(), [](auto& entry) { return entry.size != 0; });
+    size_t logical_file_size = to_size_t(m_group.m_top.get(2) / 2);
+    if (last != free_in_file.rend() && last->ref + last->size == logical_file_size) {
+        size_t new_file_size = last->ref;
+        if (!m_alloc.matches_section_boundary(new_file_size))
+            new_file_size = m_alloc.get_upper_section_boundary(new_file_size);
+        if (new_file_size < logical_file_size) {
+            last->size = new_file_size - last->ref;
+            m_group.m_top.set(2, 1 + 2 * uint64_t(new_file_size)); // Throws
+        }
+    }
+
+    // Keep the free space beyond the limit out of reach of the allocations,
+    // so that what is relocated by the compaction ends up before it
+    for (auto& entry : free_in_file) {
+        if (entry.size == 0 || entry.ref + entry.size <= m_compaction_limit)
+            continue;
+        size_t begin = std::max(entry.ref, m_compaction_limit);
+        m_free_beyond_limit.emplace_back(begin, entry.ref + entry.size - begin, 0);
+        entry.size = begin - entry.ref;
+    }
+}
+
 size_t GroupWriter::recreate_freelist(size_t reserve_pos)
 {
     std::vector<FreeSpaceEntry> free_in_file;
     auto& new_free_space = m_group.m_alloc.get_free_read_only(); // Throws
-    auto nb_elements = m_size_map.size() + m_not_free_in_file.size() + new_free_space.size();
+    auto nb_elements =
+        m_size_map.size() + m_not_free_in_file.size() + m_free_beyond_limit.size() + new_free_space.size();
     free_in_file.reserve(nb_elements);
 
     size_t reserve_ndx = realm::npos;
@@ -579,6 +975,7 @@ size_t GroupWriter::recreate_freelist(size_t reserve_pos)
     for (const auto& entry : m_size_map) {
         free_in_file.emplace_back(entry.second, entry.first, 0);
     }
+    free_in_file.insert(free_in_file.end(), m_free_beyond_limit.begin(), m_free_beyond_limit.end());
 
     {
         size_t locked_space_size = 0;
@@ -766,6 +1163,14 @@ GroupWriter::FreeListElement GroupWriter::search_free_space_in_part_of_freelist(
 GroupWriter::FreeListElement GroupWriter::reserve_free_space(size_t size)
 {
     auto chunk = search_free_space_in_part_of_freelist(size);
+    if (chunk == m_size_map.end() && !m_free_beyond_limit.empty()) {
+        // Rather give up keeping the allocations before the compaction limit
+        // than extend the file
+        for (const auto& entry : m_free_beyond_limit)
+            m_size_map.emplace(entry.size, entry.ref);
+        m_free_beyond_limit.clear();
+        chunk = search_free_space_in_part_of_freelist(size);
+    }
     while (chunk == m_size_map.end()) {
         // No free space, so we have to extend the file.
         auto new_chunk = extend_free_space(size);
@@ -781,6 +1186,10 @@ GroupWriter::FreeListElement GroupWriter::reserve_free_space(size_t size)
 GroupWriter::FreeListElement GroupWriter::extend_free_space(size_t requested_size)
 {
     SlabAlloc& alloc = m_group.m_alloc;
+#if REALM_METRICS
+    std::unique_ptr<MetricTimer> growth_timer =
+        Metrics::report_commit_phase_time(m_group, TransactionInfo::commit_FileGrowth);
+#endif // REALM_METRICS
 
     // We need to consider the "logical" size of the file here, and not the real
     // size. The real size may have changed without the free space information
@@ -820,6 +1229,7 @@ GroupWriter::FreeListElement GroupWriter::extend_free_space(size_t requested_siz
     REALM_ASSERT_RELEASE_EX(!(chunk_size & 7), chunk_size);
     REALM_ASSERT_RELEASE(chunk_size != 0);
     auto it = m_size_map.emplace(chunk_size, logical_file_size);
+    m_file_growth += chunk_size;
 
     // Update the logical file size
     m_group.m_top.set(2, 1 + 2 * uint64_t(new_file_size)); // Throws
@@ -827,11 +1237,6 @@ GroupWriter::FreeListElement GroupWriter::extend_free_space(size_t requested_siz
     return it;
 }
 
-bool inline is_aligned(char* addr) {
-    size_t as_binary = reinterpret_cast<size_t>(addr);
-    return (as_binary & 7) == 0;
-}
-
 ref_type GroupWriter::write_array(const char* data, size_t size, uint32_t checksum)
 {
     // Get position of free space to write in (expanding file if needed)
@@ -845,12 +1250,28 @@ ref_type GroupWriter::write_array(const char* data, size_t size, uint32_t checks
     memcpy(dest_addr, &checksum, 4);
     memcpy(dest_addr + 4, data + 4, size - 4);
     window->encryption_write_barrier(dest_addr, size);
+    count_written(pos, size);
     // return ref of the written array
     ref_type ref = to_ref(pos);
     return ref;
 }
 
 
+void GroupWriter::count_written(size_t pos, size_t size) noexcept
+{
+    if (size == 0)
+        return;
+    static const size_t page_size = util::page_size();
+    size_t first_page = pos / page_size;
+    size_t last_page = (pos + size - 1) / page_size;
+    m_num_bytes_written += size;
+    m_num_pages_dirtied += last_page - first_page + 1;
+    if (first_page == m_last_page_dirtied)
+        --m_num_pages_dirtied;
+    m_last_page_dirtied = last_page;
+}
+
+
 void GroupWriter::write_array_at(MapWindow* window, ref_type ref, const char* data, size_t size)
 {
     size_t pos = size_t(ref);
@@ -903,8 +1324,13 @@ void GroupWriter::commit(ref_type new_top_ref)
     // stable storage before flipping the slot selector
     window->encryption_write_barrier(&file_header.m_top_ref[slot_selector], 
                                      sizeof(file_header.m_top_ref[slot_selector]));
-    if (!disable_sync)
+    if (!disable_sync) {
+#if REALM_METRICS
+        std::unique_ptr<MetricTimer> sync_timer =
+            Metrics::report_commit_phase_time(m_group, TransactionInfo::commit_DataSync);
+#endif // REALM_METRICS
         sync_all_mappings();
+    }
 
     // Flip the slot selector bit.
     using type_2 = std::remove_reference<decltype(file_header.m_flags)>::type;
@@ -913,8 +1339,41 @@ void GroupWriter::commit(ref_type new_top_ref)
     // Write new selector to disk
     // FIXME: we might optimize this to write of a single page?
     window->encryption_write_barrier(&file_header.m_flags, sizeof(file_header.m_flags));
-    if (!disable_sync)
+    if (!disable_sync) {
+#if REALM_METRICS
+        std::unique_ptr<MetricTimer> sync_timer =
+            Metrics::report_commit_phase_time(m_group, TransactionInfo::commit_HeaderSync);
+#endif // REALM_METRICS
         window->sync();
+    }
+}
+
+
+void GroupWriter::commit_unsynced(SlabAlloc& alloc, ref_type top_ref, int file_format_version)
+{
+    util::File& file = alloc.get_file();
+    REALM_ASSERT(!file.get_encryption_key());
+    util::File::Map<SlabAlloc::Header> map(file, util::File::access_ReadWrite); // Throws
+    SlabAlloc::Header& file_header = *map.get_addr();
+
+    // See commit()
+    unsigned new_flags = file_header.m_flags ^ SlabAlloc::flags_SelectBit;
+    int slot_selector = ((new_flags & SlabAlloc::flags_SelectBit) != 0 ? 1 : 0);
+    using type_1 = std::remove_reference<decltype(file_header.m_file_format[0])>::type;
+    REALM_ASSERT(!util::int_cast_has_overflow<type_1>(file_format_version));
+    file_header.m_file_format[slot_selector] = type_1(file_format_version);
+    file_header.m_top_ref[slot_selector] = top_ref;
+
+    // The data of the snapshot may have been written through any mapping of
+    // the file, by any process, so the whole file is synced
+    bool disable_sync = get_disable_sync_to_disk();
+    if (!disable_sync)
+        file.sync(); // Throws
+
+    using type_2 = std::remove_reference<decltype(file_header.m_flags)>::type;
+    file_header.m_flags = type_2(new_flags);
+    if (!disable_sync)
+        map.sync(); // Throws
 }
 
 
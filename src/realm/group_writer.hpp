@@ -58,6 +58,15 @@ public:
 
     void set_versions(uint64_t current, uint64_t read_lock) noexcept;
 
+    /// Online compaction: Do not allocate space at or beyond \a limit, unless
+    /// the file must be extended, and give up the free space at the end of the
+    /// file by reducing its logical size. Zero means no limit.
+    void set_compaction_limit(size_t limit) noexcept;
+
+    /// Write the modified tables with at most this many threads, or as many as
+    /// the hardware runs concurrently if it is zero, which is the default.
+    void set_max_threads(size_t num_threads) noexcept;
+
     /// Write all changed array nodes into free space.
     ///
     /// Returns the new top ref. When in full durability mode, call
@@ -69,8 +78,20 @@ public:
     /// returned by write_group().
     void commit(ref_type new_top_ref);
 
+    /// Make a snapshot that was written by an earlier GroupWriter, whose
+    /// commit() was not called, durable: Flush the entire file to physical
+    /// medium, then write the top ref to the file header, then flush
+    /// again. Used for group commit, where one writer makes the snapshots of
+    /// several writers durable. Does not support encrypted files.
+    static void commit_unsynced(SlabAlloc&, ref_type top_ref, int file_format_version);
+
     size_t get_file_size() const noexcept;
 
+    /// Online compaction: Copy the array, which must be in the file, into
+    /// slab memory, from where the next commit writes it into free space,
+    /// update its parent, and free the space it took up.
+    static void relocate_array(Array&);
+
     ref_type write_array(const char*, size_t, uint32_t) override;
 
 #ifdef REALM_DEBUG
@@ -89,6 +110,8 @@ public:
 
 private:
     class MapWindow;
+    class ChunkWriter;
+    class ConcurrentReader;
     Group& m_group;
     SlabAlloc& m_alloc;
     ArrayInteger m_free_positions; // 4th slot in Group::m_top
@@ -99,8 +122,17 @@ private:
     size_t m_window_alignment;
     size_t m_free_space_size = 0;
     size_t m_locked_space_size = 0;
+    size_t m_compaction_limit = 0;
+    size_t m_max_threads = 0;
     Durability m_durability;
 
+    // What the commit writes, for the transaction metrics. Consecutive writes
+    // to the same page dirty it once.
+    size_t m_num_bytes_written = 0;
+    size_t m_num_pages_dirtied = 0;
+    size_t m_last_page_dirtied = size_t(-1);
+    size_t m_file_growth = 0;
+
     struct FreeSpaceEntry {
         FreeSpaceEntry(size_t r, size_t s, uint64_t v)
             : ref(r)
@@ -122,10 +154,26 @@ private:
     };
     //  m_free_in_file;
     std::vector<FreeSpaceEntry> m_not_free_in_file;
+    // Free space beyond the compaction limit, which is kept out of the size map
+    std::vector<FreeSpaceEntry> m_free_beyond_limit;
     std::multimap<size_t, size_t> m_size_map;
     using FreeListElement = std::multimap<size_t, size_t>::iterator;
 
+    /// Write the modified tables. When several of them have enough changes,
+    /// each is written into a chunk of free space reserved for the table
+    /// beforehand, in table order, and the tables are shared out among the
+    /// committing thread and the threads of a pool kept for the process. The
+    /// result depends neither on the number of threads nor on their
+    /// scheduling.
+    ref_type write_tables();
+
+    /// An upper bound on the space which Array::write() needs for the
+    /// modified arrays of the specified subtree.
+    static size_t get_max_write_size(ref_type, Allocator&);
+
     void read_in_freelist();
+    void count_written(size_t pos, size_t size) noexcept;
+    void apply_compaction_limit(FreeList&);
     size_t recreate_freelist(size_t reserve_pos);
     // Currently cached memory mappings. We keep as many as 16 1MB windows
     // open for writing. The allocator will favor sequential allocation
@@ -136,6 +184,10 @@ private:
     const static int num_map_windows = 16;
     std::vector<std::unique_ptr<MapWindow>> m_map_windows;
 
+    // The mappings through which write_tables() wrote the tables in parallel,
+    // which must be sync'ed along with the cached ones
+    std::vector<std::unique_ptr<MapWindow>> m_chunk_windows;
+
     // Get a suitable memory mapping for later access:
     // potentially adding it to the cache, potentially closing
     // the least recently used and sync'ing it to disk
@@ -144,6 +196,14 @@ private:
     // Sync all cached memory mappings
     void sync_all_mappings();
 
+    // Whether the mappings are synced as they are written. They are not when
+    // the whole file is synced later, or never.
+    bool syncs_mappings() const noexcept
+    {
+        return m_durability != Durability::Unsafe && m_durability != Durability::Background &&
+               m_durability != Durability::ChangesetLog;
+    }
+
     /// Allocate a chunk of free space of the specified size. The
     /// specified size must be 8-byte aligned. Extend the file if
     /// required. The returned chunk is removed from the amount of
@@ -197,6 +257,16 @@ inline void GroupWriter::set_versions(uint64_t current, uint64_t read_lock) noex
     m_readlock_version = read_lock;
 }
 
+inline void GroupWriter::set_compaction_limit(size_t limit) noexcept
+{
+    m_compaction_limit = limit;
+}
+
+inline void GroupWriter::set_max_threads(size_t num_threads) noexcept
+{
+    m_max_threads = num_threads;
+}
+
 } // namespace realm
 
 #endif // REALM_GROUP_WRITER_HPP
@@ -199,6 +199,8 @@ std::string ErrorCategory::message(int value) const
             return "Simulated failure (slab_alloc__remap)";
         case SimulatedFailure::shared_group__grow_reader_mapping:
             return "Simulated failure (shared_group__grow_reader_mapping)";
+        case SimulatedFailure::shared_group__replay_changeset_log:
+            return "Simulated failure (shared_group__replay_changeset_log)";
         case SimulatedFailure::sync_client__read_head:
             return "Simulated failure (sync_client__read_head)";
         case SimulatedFailure::sync_server__read_head:
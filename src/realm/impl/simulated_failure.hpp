@@ -38,6 +38,7 @@ public:
         slab_alloc__reset_free_space_tracking,
         slab_alloc__remap,
         shared_group__grow_reader_mapping,
+        shared_group__replay_changeset_log,
         sync_client__read_head,
         sync_server__read_head,
         _num_failure_types
@@ -19,7 +19,10 @@
 #ifndef REALM_IMPL_TRANSACT_LOG_HPP
 #define REALM_IMPL_TRANSACT_LOG_HPP
 
+#include <algorithm>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 #include <realm/string_data.hpp>
 #include <realm/data_type.hpp>
@@ -81,6 +84,8 @@ enum Instruction {
     instr_LinkListClear = 38,   // Ramove all entries from a link list
     instr_LinkListSetAll = 39,  // Assign to link list entry
     instr_AddRowWithKey = 40,   // Insert a row with a given key
+    instr_SetRange = 41,        // Assign to consecutive rows of a column, or fill them with one value
+    instr_RefreshTable = 42,    // Arrays of the selected table were moved, but its contents did not change
 };
 
 class TransactLogStream {
@@ -246,6 +251,10 @@ public:
     {
         return true;
     }
+    bool refresh_table()
+    {
+        return true;
+    }
 
     // Must have descriptor selected:
     bool insert_link_column(size_t, DataType, StringData, size_t, size_t)
@@ -359,6 +368,7 @@ public:
     bool insert_substring(size_t col_ndx, size_t row_ndx, size_t pos, StringData);
     bool erase_substring(size_t col_ndx, size_t row_ndx, size_t pos, size_t size);
     bool optimize_table();
+    bool refresh_table();
 
     // Must have descriptor selected:
     bool insert_link_column(size_t col_ndx, DataType, StringData name, size_t link_target_table_ndx,
@@ -383,6 +393,22 @@ public:
 
     /// End of methods expected by parser.
 
+    /// Must have table selected. Assign to `num_rows` consecutive rows,
+    /// starting at `row_ndx`. `num_values` must be either `num_rows`, or 1 to
+    /// assign the same value to all of them. These are recorded as a single
+    /// instr_SetRange. An `InstructionHandler` that does not need the values
+    /// can define `bool set_range(size_t col_ndx, size_t row_ndx, size_t
+    /// num_rows)` to receive it as a single call. Otherwise the parser expands
+    /// it into a set_*() call for each row. NullInstructionObserver does not
+    /// define set_range(), so that observers which override set_int() and
+    /// friends still see every row.
+    bool set_int_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const int64_t* values, size_t num_values);
+    bool set_bool_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const bool* values, size_t num_values);
+    bool set_float_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const float* values, size_t num_values);
+    bool set_double_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const double* values,
+                          size_t num_values);
+    bool set_null_range(size_t col_ndx, size_t row_ndx, size_t num_rows);
+
 
     TransactLogEncoder(TransactLogStream& out_stream);
     void set_buffer(char* new_free_begin, char* new_free_end);
@@ -463,6 +489,10 @@ private:
     template <class... L>
     void append_mixed_instr(Instruction instr, const Mixed& value, L... numbers);
 
+    template <class T>
+    void append_range_instr(DataType, size_t col_ndx, size_t row_ndx, size_t num_rows, const T* values,
+                            size_t num_values);
+
     template <class T>
     static char* encode_int(char*, T value);
     friend class TransactLogParser;
@@ -493,6 +523,19 @@ public:
     virtual void set_link(const Table*, size_t col_ndx, size_t ndx, size_t value, Instruction variant = instr_Set);
     virtual void set_null(const Table*, size_t col_ndx, size_t ndx, Instruction variant = instr_Set);
     virtual void set_link_list(const LinkView&, const IntegerColumn& values);
+
+    /// Assign to `num_rows` consecutive rows, starting at `ndx`, where
+    /// `num_values` is either `num_rows` or 1 (same value for all rows).
+    virtual void set_int_range(const Table*, size_t col_ndx, size_t ndx, size_t num_rows, const int64_t* values,
+                               size_t num_values);
+    virtual void set_bool_range(const Table*, size_t col_ndx, size_t ndx, size_t num_rows, const bool* values,
+                                size_t num_values);
+    virtual void set_float_range(const Table*, size_t col_ndx, size_t ndx, size_t num_rows, const float* values,
+                                 size_t num_values);
+    virtual void set_double_range(const Table*, size_t col_ndx, size_t ndx, size_t num_rows, const double* values,
+                                  size_t num_values);
+    virtual void set_null_range(const Table*, size_t col_ndx, size_t ndx, size_t num_rows);
+
     virtual void insert_substring(const Table*, size_t col_ndx, size_t row_ndx, size_t pos, StringData);
     virtual void erase_substring(const Table*, size_t col_ndx, size_t row_ndx, size_t pos, size_t size);
 
@@ -516,6 +559,12 @@ public:
     virtual void clear_table(const Table*, size_t prior_num_rows);
     virtual void optimize_table(const Table*);
 
+    /// Tell the other session participants that arrays of the table, or of
+    /// its subtables, were moved to new refs without changing the contents
+    /// (see SharedGroup::compact_incrementally()), so that they refresh all
+    /// of its accessors.
+    virtual void refresh_table(const Table*);
+
     virtual void link_list_set(const LinkView&, size_t link_ndx, size_t value);
     virtual void link_list_insert(const LinkView&, size_t link_ndx, size_t value);
     virtual void link_list_move(const LinkView&, size_t from_link_ndx, size_t to_link_ndx);
@@ -620,6 +669,22 @@ private:
     void parse_one(InstructionHandler&);
     bool has_next() noexcept;
 
+    template <class InstructionHandler, class = void>
+    struct HasSetRange : std::false_type {
+    };
+    template <class InstructionHandler>
+    struct HasSetRange<InstructionHandler, decltype(std::declval<InstructionHandler&>().set_range(size_t(), size_t(),
+                                                                                                  size_t()),
+                                                    void())> : std::true_type {
+    };
+
+    template <class InstructionHandler>
+    void parse_set_range(InstructionHandler&, int type, size_t col_ndx, size_t row_ndx, size_t num_rows,
+                         size_t num_values, std::true_type);
+    template <class InstructionHandler>
+    void parse_set_range(InstructionHandler&, int type, size_t col_ndx, size_t row_ndx, size_t num_rows,
+                         size_t num_values, std::false_type);
+
     template <class T>
     T read_int();
 
@@ -1380,6 +1445,93 @@ inline void TransactLogConvenientEncoder::set_null(const Table* t, size_t col_nd
     m_encoder.set_null(col_ndx, row_ndx, variant, prior_num_rows); // Throws
 }
 
+template <class T>
+void TransactLogEncoder::append_range_instr(DataType type, size_t col_ndx, size_t row_ndx, size_t num_rows,
+                                            const T* values, size_t num_values)
+{
+    REALM_ASSERT_EX(num_values <= num_rows && (num_values == num_rows || num_values == 1), num_values, num_rows);
+    append_simple_instr(instr_SetRange, type, col_ndx, row_ndx, num_rows, num_values); // Throws
+
+    // Like IntegerList, the values are reserved for in chunks
+    const T* end = values + num_values;
+    while (values != end) {
+        size_t n = std::min(size_t(end - values), size_t(max_numbers_per_chunk));
+        char* ptr = reserve(max_enc_bytes_per_num * n); // Throws
+        for (size_t i = 0; i < n; ++i)
+            ptr = encode(ptr, *values++);
+        advance(ptr);
+    }
+}
+
+inline bool TransactLogEncoder::set_int_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const int64_t* values,
+                                              size_t num_values)
+{
+    append_range_instr(type_Int, col_ndx, row_ndx, num_rows, values, num_values); // Throws
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::set_int_range(const Table* t, size_t col_ndx, size_t ndx, size_t num_rows,
+                                                        const int64_t* values, size_t num_values)
+{
+    select_table(t);                                                   // Throws
+    m_encoder.set_int_range(col_ndx, ndx, num_rows, values, num_values); // Throws
+}
+
+inline bool TransactLogEncoder::set_bool_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const bool* values,
+                                               size_t num_values)
+{
+    append_range_instr(type_Bool, col_ndx, row_ndx, num_rows, values, num_values); // Throws
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::set_bool_range(const Table* t, size_t col_ndx, size_t ndx, size_t num_rows,
+                                                         const bool* values, size_t num_values)
+{
+    select_table(t);                                                    // Throws
+    m_encoder.set_bool_range(col_ndx, ndx, num_rows, values, num_values); // Throws
+}
+
+inline bool TransactLogEncoder::set_float_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const float* values,
+                                                size_t num_values)
+{
+    append_range_instr(type_Float, col_ndx, row_ndx, num_rows, values, num_values); // Throws
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::set_float_range(const Table* t, size_t col_ndx, size_t ndx, size_t num_rows,
+                                                          const float* values, size_t num_values)
+{
+    select_table(t);                                                     // Throws
+    m_encoder.set_float_range(col_ndx, ndx, num_rows, values, num_values); // Throws
+}
+
+inline bool TransactLogEncoder::set_double_range(size_t col_ndx, size_t row_ndx, size_t num_rows,
+                                                 const double* values, size_t num_values)
+{
+    append_range_instr(type_Double, col_ndx, row_ndx, num_rows, values, num_values); // Throws
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::set_double_range(const Table* t, size_t col_ndx, size_t ndx,
+                                                           size_t num_rows, const double* values, size_t num_values)
+{
+    select_table(t);                                                      // Throws
+    m_encoder.set_double_range(col_ndx, ndx, num_rows, values, num_values); // Throws
+}
+
+inline bool TransactLogEncoder::set_null_range(size_t col_ndx, size_t row_ndx, size_t num_rows)
+{
+    size_t num_values = 0;
+    append_simple_instr(instr_SetRange, set_null_sentinel(), col_ndx, row_ndx, num_rows, num_values); // Throws
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::set_null_range(const Table* t, size_t col_ndx, size_t ndx, size_t num_rows)
+{
+    select_table(t);                                  // Throws
+    m_encoder.set_null_range(col_ndx, ndx, num_rows); // Throws
+}
+
 inline bool TransactLogEncoder::nullify_link(size_t col_ndx, size_t ndx, size_t target_group_level_ndx)
 {
     append_simple_instr(instr_NullifyLink, col_ndx, ndx, target_group_level_ndx); // Throws
@@ -1568,6 +1720,18 @@ inline void TransactLogConvenientEncoder::optimize_table(const Table* t)
     m_encoder.optimize_table(); // Throws
 }
 
+inline bool TransactLogEncoder::refresh_table()
+{
+    append_simple_instr(instr_RefreshTable); // Throws
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::refresh_table(const Table* t)
+{
+    select_table(t);           // Throws
+    m_encoder.refresh_table(); // Throws
+}
+
 inline bool TransactLogEncoder::link_list_set(size_t link_ndx, size_t value, size_t prior_size)
 {
     append_simple_instr(instr_LinkListSet, link_ndx, value, prior_size); // Throws
@@ -1722,6 +1886,98 @@ inline bool TransactLogParser::has_next() noexcept
     return m_input_begin != m_input_end || next_input_buffer();
 }
 
+template <class InstructionHandler>
+void TransactLogParser::parse_set_range(InstructionHandler& handler, int type, size_t col_ndx, size_t row_ndx,
+                                        size_t num_rows, size_t num_values, std::true_type)
+{
+    // The handler only needs to know which rows were assigned, so skip the
+    // values
+    if (type != TransactLogEncoder::set_null_sentinel()) {
+        switch (DataType(type)) {
+            case type_Int:
+                for (size_t i = 0; i < num_values; ++i)
+                    read_int<int64_t>(); // Throws
+                break;
+            case type_Bool:
+                for (size_t i = 0; i < num_values; ++i)
+                    read_bool(); // Throws
+                break;
+            case type_Float:
+                for (size_t i = 0; i < num_values; ++i)
+                    read_float(); // Throws
+                break;
+            case type_Double:
+                for (size_t i = 0; i < num_values; ++i)
+                    read_double(); // Throws
+                break;
+            default:
+                parser_error();
+        }
+    }
+    if (!handler.set_range(col_ndx, row_ndx, num_rows)) // Throws
+        parser_error();
+}
+
+template <class InstructionHandler>
+void TransactLogParser::parse_set_range(InstructionHandler& handler, int type, size_t col_ndx, size_t row_ndx,
+                                        size_t num_rows, size_t num_values, std::false_type)
+{
+    if (type == TransactLogEncoder::set_null_sentinel()) {
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (!handler.set_null(col_ndx, row_ndx + i, instr_Set, 0)) // Throws
+                parser_error();
+        }
+        return;
+    }
+    // With a single value, it is assigned to all the rows
+    switch (DataType(type)) {
+        case type_Int: {
+            int_fast64_t value = 0;
+            for (size_t i = 0; i < num_rows; ++i) {
+                if (i < num_values)
+                    value = read_int<int64_t>(); // Throws
+                if (!handler.set_int(col_ndx, row_ndx + i, value, instr_Set, 0)) // Throws
+                    parser_error();
+            }
+            return;
+        }
+        case type_Bool: {
+            bool value = false;
+            for (size_t i = 0; i < num_rows; ++i) {
+                if (i < num_values)
+                    value = read_bool(); // Throws
+                if (!handler.set_bool(col_ndx, row_ndx + i, value, instr_Set)) // Throws
+                    parser_error();
+            }
+            return;
+        }
+        case type_Float: {
+            float value = 0;
+            for (size_t i = 0; i < num_rows; ++i) {
+                if (i < num_values)
+                    value = read_float(); // Throws
+                if (!handler.set_float(col_ndx, row_ndx + i, value, instr_Set)) // Throws
+                    parser_error();
+            }
+            return;
+        }
+        case type_Double: {
+            double value = 0;
+            for (size_t i = 0; i < num_rows; ++i) {
+                if (i < num_values)
+                    value = read_double(); // Throws
+                if (!handler.set_double(col_ndx, row_ndx + i, value, instr_Set)) // Throws
+                    parser_error();
+            }
+            return;
+        }
+        default:
+            break;
+    }
+    parser_error();
+}
+
+
 template <class InstructionHandler>
 void TransactLogParser::parse_one(InstructionHandler& handler)
 {
@@ -1830,6 +2086,23 @@ void TransactLogParser::parse_one(InstructionHandler& handler)
             parser_error();
             return;
         }
+        case instr_SetRange: {
+            int type = read_int<int>();             // Throws
+            size_t col_ndx = read_int<size_t>();    // Throws
+            size_t row_ndx = read_int<size_t>();    // Throws
+            size_t num_rows = read_int<size_t>();   // Throws
+            size_t num_values = read_int<size_t>(); // Throws
+            if (type == TransactLogEncoder::set_null_sentinel()) {
+                if (num_values != 0)
+                    parser_error();
+            }
+            else if (num_values > num_rows || (num_values != num_rows && num_values != 1)) {
+                parser_error();
+            }
+            parse_set_range(handler, type, col_ndx, row_ndx, num_rows, num_values,
+                            HasSetRange<InstructionHandler>()); // Throws
+            return;
+        }
         case instr_AddInteger: {
             size_t col_ndx = read_int<size_t>();           // Throws
             size_t row_ndx = read_int<size_t>();           // Throws
@@ -2133,6 +2406,11 @@ void TransactLogParser::parse_one(InstructionHandler& handler)
                 parser_error();
             return;
         }
+        case instr_RefreshTable: {
+            if (!handler.refresh_table()) // Throws
+                parser_error();
+            return;
+        }
     }
 
     throw BadTransactLog();
@@ -2420,6 +2698,14 @@ public:
         return true; // No-op
     }
 
+    bool refresh_table()
+    {
+        // The accessors must be refreshed when the relocation is undone too
+        m_encoder.refresh_table(); // Throws
+        append_instruction();
+        return true;
+    }
+
     bool insert_empty_rows(size_t row_ndx, size_t num_rows_to_insert, size_t prior_num_rows, bool unordered)
     {
         size_t num_rows_to_erase = num_rows_to_insert;
@@ -0,0 +1,219 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include <realm/like_pattern.hpp>
+#include <realm/unicode.hpp>
+
+using namespace realm;
+
+namespace {
+
+const size_t npos = size_t(-1);
+
+// Position after the character starting at `pos`, as '?' consumes it. The
+// continuation bytes of a multi-byte UTF-8 character belong to it.
+inline size_t skip_character(StringData text, size_t pos) noexcept
+{
+    if ((text[pos] & 0x80) == 0)
+        return pos + 1;
+    ++pos;
+    while (pos != text.size() && (text[pos] & 0xc0) == 0x80)
+        ++pos;
+    return pos;
+}
+
+inline size_t find_byte(const char* data, char c, size_t begin, size_t end) noexcept
+{
+    // memchr() is vectorized by the C library
+    const void* p = std::memchr(data + begin, c, end - begin);
+    return p ? static_cast<const char*>(p) - data : npos;
+}
+
+} // anonymous namespace
+
+
+LikePattern::LikePattern(StringData pattern)
+    : m_pattern(pattern)
+    , m_is_null(pattern.is_null())
+{
+    compile();
+}
+
+
+LikePattern::LikePattern(StringData upper, StringData lower)
+    : m_pattern(upper)
+    , m_alternate(lower)
+    , m_is_null(upper.is_null() || lower.is_null())
+    , m_case_insensitive(m_pattern != m_alternate)
+{
+    compile();
+}
+
+
+void LikePattern::compile()
+{
+    // The backtracking matcher only accepts the end of the text when the rest
+    // of the pattern is empty or a single '*'
+    m_generic = m_pattern.find("**") != std::string::npos ||
+                (m_case_insensitive && m_pattern.size() != m_alternate.size());
+    if (m_generic)
+        return;
+
+    size_t begin = 0;
+    bool has_wildcard = false;
+    for (size_t i = 0; i <= m_pattern.size(); ++i) {
+        if (i == m_pattern.size() || m_pattern[i] == '*') {
+            m_segments.push_back({begin, i - begin, has_wildcard}); // Throws
+            begin = i + 1;
+            has_wildcard = false;
+        }
+        else if (m_pattern[i] == '?') {
+            has_wildcard = true;
+        }
+    }
+}
+
+
+bool LikePattern::byte_matches(size_t pattern_pos, char c) const noexcept
+{
+    return m_pattern[pattern_pos] == c || (m_case_insensitive && m_alternate[pattern_pos] == c);
+}
+
+
+// Returns the end of the match of the segment starting at `pos`, or npos if it
+// does not match there. Since a '?' consumes the rest of the character it
+// starts in, the end never decreases when `pos` increases, so the leftmost
+// match leaves the most text for the rest of the pattern.
+size_t LikePattern::match_at(const Segment& segment, StringData text, size_t pos) const noexcept
+{
+    if (text.size() - pos < segment.size)
+        return npos;
+
+    if (!segment.has_wildcard) {
+        if (!m_case_insensitive)
+            return std::memcmp(m_pattern.data() + segment.begin, text.data() + pos, segment.size) == 0
+                       ? pos + segment.size
+                       : npos;
+        for (size_t i = 0; i < segment.size; ++i) {
+            if (!byte_matches(segment.begin + i, text[pos + i]))
+                return npos;
+        }
+        return pos + segment.size;
+    }
+
+    for (size_t i = 0; i < segment.size; ++i) {
+        if (pos == text.size())
+            return npos;
+        if (m_pattern[segment.begin + i] == '?') {
+            pos = skip_character(text, pos);
+        }
+        else if (byte_matches(segment.begin + i, text[pos])) {
+            ++pos;
+        }
+        else {
+            return npos;
+        }
+    }
+    return pos;
+}
+
+
+// Returns the end of the leftmost match of the segment which starts at or
+// after `begin` and ends at or before `end`, or npos if there is none.
+size_t LikePattern::find(const Segment& segment, StringData text, size_t begin, size_t end) const noexcept
+{
+    if (end < begin || end - begin < segment.size)
+        return npos;
+    if (segment.size == 0)
+        return begin;
+
+    if (segment.has_wildcard) {
+        for (size_t pos = begin; pos < end; ++pos) {
+            size_t match_end = match_at(segment, text, pos);
+            if (match_end != npos && match_end <= end)
+                return match_end;
+        }
+        return npos;
+    }
+
+    // Look for the first byte of the segment, in either case, and compare the
+    // rest where it is found
+    const char* data = text.data();
+    const char first = m_pattern[segment.begin];
+    const char alternate_first = m_case_insensitive ? m_alternate[segment.begin] : first;
+    const size_t last_start = end - segment.size + 1;
+    size_t next_first = find_byte(data, first, begin, last_start);
+    size_t next_alternate = alternate_first == first ? npos : find_byte(data, alternate_first, begin, last_start);
+    while (true) {
+        size_t pos = std::min(next_first, next_alternate);
+        if (pos == npos)
+            return npos;
+        if (match_at(segment, text, pos) != npos)
+            return pos + segment.size;
+        if (next_first == pos)
+            next_first = find_byte(data, first, pos + 1, last_start);
+        if (next_alternate == pos)
+            next_alternate = find_byte(data, alternate_first, pos + 1, last_start);
+    }
+}
+
+
+bool LikePattern::matches(StringData text) const noexcept
+{
+    if (text.is_null() || m_is_null)
+        return text.is_null() && m_is_null;
+
+    if (m_generic)
+        return m_case_insensitive ? string_like_ins(text, m_alternate, m_pattern) : text.like(m_pattern);
+
+    const Segment& first = m_segments.front();
+    size_t pos = match_at(first, text, 0);
+    if (pos == npos)
+        return false;
+    if (m_segments.size() == 1)
+        return pos == text.size();
+
+    // Without a '?' the last segment has a fixed position at the end of the
+    // text, and the segments in between must end before it
+    const Segment& last = m_segments.back();
+    size_t end = text.size();
+    if (!last.has_wildcard) {
+        if (end - pos < last.size)
+            return false;
+        end -= last.size;
+        if (match_at(last, text, end) == npos)
+            return false;
+    }
+
+    for (size_t i = 1; i + 1 < m_segments.size(); ++i) {
+        pos = find(m_segments[i], text, pos, end);
+        if (pos == npos)
+            return false;
+    }
+
+    if (!last.has_wildcard)
+        return true;
+    for (; pos < text.size(); ++pos) {
+        if (match_at(last, text, pos) == text.size())
+            return true;
+    }
+    return false;
+}
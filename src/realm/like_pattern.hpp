@@ -0,0 +1,83 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_LIKE_PATTERN_HPP
+#define REALM_LIKE_PATTERN_HPP
+
+#include <string>
+#include <vector>
+
+#include <realm/string_data.hpp>
+
+namespace realm {
+
+/// A LIKE pattern ('*' for zero or more characters, '?' for a single UTF-8
+/// character), analysed once so that it can be matched against many strings.
+///
+/// The pattern is split at the '*'s into segments. The first segment must
+/// match at the start of the text and the last at the end, which are plain
+/// memcmp()s when the segments have no '?', and the segments in between are
+/// searched for from left to right. Patterns without '*' are therefore
+/// compared directly, and a prefix pattern like "abc*" costs a single
+/// memcmp().
+///
+/// The results are exactly those of StringData::like() and, for the case
+/// insensitive version, string_like_ins().
+class LikePattern {
+public:
+    LikePattern() = default;
+
+    /// Case sensitive matching of \a pattern.
+    explicit LikePattern(StringData pattern);
+
+    /// Case insensitive matching, where \a upper and \a lower are the upper
+    /// and lower case versions of the pattern (see case_map()). A byte of the
+    /// text matches if it equals the byte of either version.
+    LikePattern(StringData upper, StringData lower);
+
+    /// A null pattern matches only null, and null matches only the null
+    /// pattern.
+    bool matches(StringData text) const noexcept;
+
+private:
+    struct Segment {
+        size_t begin;
+        size_t size;
+        bool has_wildcard; // contains '?'
+    };
+
+    std::string m_pattern;
+    std::string m_alternate;
+    bool m_is_null = true;
+    bool m_case_insensitive = false;
+    // Use the backtracking matcher. This is the case for patterns with
+    // consecutive '*'s, since it lets a trailing "**" match only a non-empty
+    // remainder, and for case insensitive patterns whose upper and lower case
+    // versions have different lengths.
+    bool m_generic = false;
+    std::vector<Segment> m_segments;
+
+    void compile();
+    bool byte_matches(size_t pattern_pos, char c) const noexcept;
+    size_t match_at(const Segment&, StringData text, size_t pos) const noexcept;
+    size_t find(const Segment&, StringData text, size_t begin, size_t end) const noexcept;
+};
+
+} // namespace realm
+
+#endif // REALM_LIKE_PATTERN_HPP
@@ -43,7 +43,7 @@ nanosecond_storage_t MetricTimerResult::get_elapsed_nanoseconds() const
 
 void MetricTimerResult::report_nanoseconds(nanosecond_storage_t time)
 {
-    m_elapsed_nanoseconds = time;
+    m_elapsed_nanoseconds += time;
 }
 
 
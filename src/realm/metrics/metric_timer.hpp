@@ -36,6 +36,8 @@ public:
     MetricTimerResult();
     ~MetricTimerResult();
     nanosecond_storage_t get_elapsed_nanoseconds() const;
+    /// Adds to the elapsed time, so that something that is timed several
+    /// times is reported in total.
     void report_nanoseconds(nanosecond_storage_t time);
 protected:
     nanosecond_storage_t m_elapsed_nanoseconds;
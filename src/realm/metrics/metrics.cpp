@@ -16,6 +16,8 @@
  *
  **************************************************************************/
 
+#include <algorithm>
+
 #include <realm/group.hpp>
 #include <realm/metrics/metrics.hpp>
 
@@ -118,6 +120,35 @@ std::unique_ptr<MetricTimer> Metrics::report_write_time(const Group& g)
     return nullptr;
 }
 
+std::unique_ptr<MetricTimer> Metrics::report_commit_phase_time(const Group& g, TransactionInfo::CommitPhase phase)
+{
+    std::shared_ptr<Metrics> instance = g.get_metrics();
+    if (instance) {
+        REALM_ASSERT_DEBUG(instance->m_transaction_info);
+        if (instance->m_pending_write) {
+            return std::make_unique<MetricTimer>(instance->m_pending_write->m_commit_phase_times[phase]);
+        }
+    }
+    return nullptr;
+}
+
+void Metrics::report_write_lock_wait_time(nanosecond_storage_t time)
+{
+    if (m_pending_write)
+        m_pending_write->m_commit_phase_times[TransactionInfo::commit_WriteLockWait]->report_nanoseconds(time);
+}
+
+void Metrics::report_commit_size(const Group& g, size_t num_bytes_written, size_t num_pages_dirtied,
+                                 size_t file_growth)
+{
+    std::shared_ptr<Metrics> instance = g.get_metrics();
+    if (instance && instance->m_pending_write) {
+        instance->m_pending_write->m_num_bytes_written += num_bytes_written;
+        instance->m_pending_write->m_num_pages_dirtied += num_pages_dirtied;
+        instance->m_pending_write->m_file_growth += file_growth;
+    }
+}
+
 
 std::unique_ptr<Metrics::QueryInfoList> Metrics::take_queries()
 {
@@ -133,3 +164,49 @@ std::unique_ptr<Metrics::TransactionInfoList> Metrics::take_transactions()
     values.swap(m_transaction_info);
     return values;
 }
+
+void Metrics::add_query_cache_hit() noexcept
+{
+    ++m_num_query_cache_hits;
+}
+
+void Metrics::add_query_cache_miss() noexcept
+{
+    ++m_num_query_cache_misses;
+}
+
+size_t Metrics::num_query_cache_hits() const noexcept
+{
+    return m_num_query_cache_hits;
+}
+
+size_t Metrics::num_query_cache_misses() const noexcept
+{
+    return m_num_query_cache_misses;
+}
+
+void Metrics::add_background_sync(size_t num_versions, double lag_seconds) noexcept
+{
+    util::LockGuard lock(m_background_sync_mutex);
+    ++m_num_background_syncs;
+    m_num_background_synced_versions += num_versions;
+    m_max_background_sync_lag = std::max(m_max_background_sync_lag, lag_seconds);
+}
+
+size_t Metrics::num_background_syncs() const noexcept
+{
+    util::LockGuard lock(m_background_sync_mutex);
+    return m_num_background_syncs;
+}
+
+size_t Metrics::num_background_synced_versions() const noexcept
+{
+    util::LockGuard lock(m_background_sync_mutex);
+    return m_num_background_synced_versions;
+}
+
+double Metrics::max_background_sync_lag() const noexcept
+{
+    util::LockGuard lock(m_background_sync_mutex);
+    return m_max_background_sync_lag;
+}
@@ -24,6 +24,7 @@
 #include <realm/metrics/query_info.hpp>
 #include <realm/metrics/transaction_info.hpp>
 #include <realm/util/features.h>
+#include <realm/util/thread.hpp>
 #include "realm/util/fixed_size_buffer.hpp"
 
 namespace realm {
@@ -50,6 +51,10 @@ public:
                                size_t num_decrypted_pages);
     static std::unique_ptr<MetricTimer> report_fsync_time(const Group& g);
     static std::unique_ptr<MetricTimer> report_write_time(const Group& g);
+    static std::unique_ptr<MetricTimer> report_commit_phase_time(const Group& g, TransactionInfo::CommitPhase);
+    void report_write_lock_wait_time(nanosecond_storage_t);
+    static void report_commit_size(const Group& g, size_t num_bytes_written, size_t num_pages_dirtied,
+                                   size_t file_growth);
 
     using QueryInfoList = util::FixedSizeBuffer<QueryInfo>;
     using TransactionInfoList = util::FixedSizeBuffer<TransactionInfo>;
@@ -57,6 +62,20 @@ public:
     // Get the list of metric objects tracked since the last take
     std::unique_ptr<QueryInfoList> take_queries();
     std::unique_ptr<TransactionInfoList> take_transactions();
+
+    // Lookups in SharedGroupOptions::query_cache by SharedGroup::find_all_cached()
+    void add_query_cache_hit() noexcept;
+    void add_query_cache_miss() noexcept;
+    size_t num_query_cache_hits() const noexcept;
+    size_t num_query_cache_misses() const noexcept;
+
+    // Syncs by the background thread of Durability::Background, which may be
+    // called concurrently with the rest. The lag of a sync is the time from
+    // the first of the commits it made durable.
+    void add_background_sync(size_t num_versions, double lag_seconds) noexcept;
+    size_t num_background_syncs() const noexcept;
+    size_t num_background_synced_versions() const noexcept;
+    double max_background_sync_lag() const noexcept;
 private:
     std::unique_ptr<QueryInfoList> m_query_info;
     std::unique_ptr<TransactionInfoList> m_transaction_info;
@@ -66,6 +85,14 @@ private:
 
     size_t m_max_num_queries;
     size_t m_max_num_transactions;
+
+    size_t m_num_query_cache_hits = 0;
+    size_t m_num_query_cache_misses = 0;
+
+    mutable util::Mutex m_background_sync_mutex;
+    size_t m_num_background_syncs = 0;
+    size_t m_num_background_synced_versions = 0;
+    double m_max_background_sync_lag = 0;
 };
 
 } // namespace metrics
@@ -17,6 +17,7 @@
  **************************************************************************/
 
 #include <realm/metrics/transaction_info.hpp>
+#include <realm/util/assert.hpp>
 
 using namespace realm;
 using namespace metrics;
@@ -33,6 +34,8 @@ TransactionInfo::TransactionInfo(TransactionInfo::TransactionType type)
     if (m_type == write_transaction) {
         m_fsync_time = std::make_shared<MetricTimerResult>();
         m_write_time = std::make_shared<MetricTimerResult>();
+        for (auto& time : m_commit_phase_times)
+            time = std::make_shared<MetricTimerResult>();
     }
 #endif
 }
@@ -67,6 +70,30 @@ nanosecond_storage_t TransactionInfo::get_write_time_nanoseconds() const
     return 0;
 }
 
+nanosecond_storage_t TransactionInfo::get_commit_phase_time_nanoseconds(CommitPhase phase) const
+{
+    REALM_ASSERT(phase < num_commit_phases);
+    if (m_commit_phase_times[phase]) {
+        return m_commit_phase_times[phase]->get_elapsed_nanoseconds();
+    }
+    return 0;
+}
+
+size_t TransactionInfo::get_num_bytes_written() const
+{
+    return m_num_bytes_written;
+}
+
+size_t TransactionInfo::get_num_pages_dirtied() const
+{
+    return m_num_pages_dirtied;
+}
+
+size_t TransactionInfo::get_file_growth() const
+{
+    return m_file_growth;
+}
+
 size_t TransactionInfo::get_disk_size() const
 {
     return m_realm_disk_size;
@@ -36,6 +36,19 @@ public:
         read_transaction,
         write_transaction
     };
+    /// The phases of a commit which are timed separately. Phases that do not
+    /// apply to a commit, such as the syncs with Durability::MemOnly, take no
+    /// time.
+    enum CommitPhase {
+        commit_WriteLockWait,    ///< Waiting for the write lock
+        commit_FreeListRead,     ///< Reading and merging the free-lists
+        commit_FreeListRecreate, ///< Recreating and writing the free-lists and the top array
+        commit_FileGrowth,       ///< Extending the file, and mapping the parts to write to (overlaps the above)
+        commit_DataSync,         ///< Syncing the written data to stable storage
+        commit_HeaderSync,       ///< Syncing the header, once it selects the new top ref
+        commit_ReaderRefresh,    ///< Making the new version available to readers
+        num_commit_phases
+    };
     TransactionInfo(TransactionType type);
     TransactionInfo(const TransactionInfo&) = default;
     ~TransactionInfo() noexcept;
@@ -51,10 +64,25 @@ public:
     size_t get_num_available_versions() const;
     size_t get_num_decrypted_pages() const;
 
+    // Breakdown of the commit of a write transaction. The write time includes
+    // FreeListRead and FreeListRecreate, and the fsync time DataSync and
+    // HeaderSync. FileGrowth is counted wherever the file is extended or a new
+    // part of it mapped, so it overlaps the write time, including
+    // FreeListRecreate, rather than adding to it.
+    nanosecond_storage_t get_commit_phase_time_nanoseconds(CommitPhase) const;
+    /// The size of the arrays written to the file by the commit.
+    size_t get_num_bytes_written() const;
+    /// The number of pages which the written arrays were on, where pages
+    /// written to by consecutive arrays are counted once.
+    size_t get_num_pages_dirtied() const;
+    /// The number of bytes by which the commit extended the file.
+    size_t get_file_growth() const;
+
 private:
     MetricTimerResult m_transaction_time;
     std::shared_ptr<MetricTimerResult> m_fsync_time;
     std::shared_ptr<MetricTimerResult> m_write_time;
+    std::shared_ptr<MetricTimerResult> m_commit_phase_times[num_commit_phases];
     MetricTimer m_transact_timer;
 
     size_t m_realm_disk_size;
@@ -63,6 +91,9 @@ private:
     TransactionType m_type;
     size_t m_num_versions;
     size_t m_num_decrypted_pages;
+    size_t m_num_bytes_written = 0;
+    size_t m_num_pages_dirtied = 0;
+    size_t m_file_growth = 0;
 
     friend class Metrics;
     void update_stats(size_t disk_size, size_t free_space, size_t total_objects, size_t available_versions,
@@ -133,6 +133,12 @@ struct agg_all : seq< string_token_t("all"), plus<blank>, agg_target, pad< sor<
 struct agg_none : seq< string_token_t("none"), plus<blank>, agg_target, pad< sor< string_oper, symbolic_oper >, blank >, expr > {};
 struct agg_shortcut_pred : sor< agg_any, agg_all, agg_none > {};
 
+// value lists, as in "key IN {1, 2, 3}"
+struct list_begin : one< '{' > {};
+struct list_end : one< '}' > {};
+struct list_item : sor< dq_string, sq_string, timestamp, number, argument, true_value, false_value, null_value, base64 > {};
+struct value_list : if_must< list_begin, star< blank >, opt< list< list_item, one< ',' >, blank > >, star< blank >, list_end > {};
+
 // expressions and operators
 struct expr : sor< dq_string, sq_string, timestamp, number, argument, true_value, false_value, null_value, base64, collection_operator_match, subquery, key_path > {};
 struct case_insensitive : TAOCPP_PEGTL_ISTRING("[c]") {};
@@ -172,7 +178,7 @@ struct string_oper : seq< sor< contains, begins, ends, like>, star< blank >, opt
 struct symbolic_oper : sor< noteq, lteq, lt, gteq, gt, eq, in, between > {};
 
 // predicates
-struct comparison_pred : seq< expr, pad< sor< string_oper, symbolic_oper >, blank >, expr > {};
+struct comparison_pred : seq< expr, pad< sor< string_oper, symbolic_oper >, blank >, sor< value_list, expr > > {};
 
 // we need to alias the group tokens because these are also used in other expressions above and we have to match
 // the predicate group tokens without also matching () in other expressions.
@@ -240,6 +246,7 @@ struct ParserState
     bool negate_next = false;
     Predicate::Type next_type = Predicate::Type::And;
     Expression* last_expression = nullptr;
+    Expression* current_list = nullptr;
 
     void add_collection_aggregate_expression()
     {
@@ -257,6 +264,10 @@ struct ParserState
 
     void add_expression(Expression && exp)
     {
+        if (current_list) {
+            current_list->list_items.push_back(std::move(exp));
+            return;
+        }
         Predicate *current = last_predicate();
         if (current->type == Predicate::Type::Comparison && current->cmpr.expr[1].type == parser::Expression::Type::None) {
             current->cmpr.expr[1] = std::move(exp);
@@ -364,6 +375,27 @@ EXPRESSION_ACTION(null_value, Expression::Type::Null)
 EXPRESSION_ACTION(argument_index, Expression::Type::Argument)
 EXPRESSION_ACTION(base64, Expression::Type::Base64)
 
+template<> struct action< list_begin >
+{
+    template< typename Input >
+    static void apply(const Input&, ParserState& state)
+    {
+        DEBUG_PRINT_TOKEN("<begin_list>");
+        state.add_expression(Expression(Expression::Type::List));
+        state.current_list = state.last_expression;
+    }
+};
+
+template<> struct action< list_end >
+{
+    template< typename Input >
+    static void apply(const Input&, ParserState& state)
+    {
+        DEBUG_PRINT_TOKEN("<end_list>");
+        state.current_list = nullptr;
+    }
+};
+
 template<> struct action< timestamp >
 {
     template< typename Input >
@@ -796,6 +828,68 @@ DescriptorOrderingState parse_include_path(const realm::StringData& path)
     return state.ordering_state;
 }
 
+ParserCache::ParserCache(size_t capacity)
+    : m_capacity(capacity > 0 ? capacity : 1)
+{
+}
+
+std::shared_ptr<const ParserResult> ParserCache::get(const std::string& query)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_lookup.find(query);
+        if (it != m_lookup.end()) {
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            ++m_hits;
+            return it->second->second;
+        }
+        ++m_misses;
+    }
+
+    // Parse outside the lock so that concurrent misses on different shapes do not serialize
+    auto result = std::make_shared<const ParserResult>(parse(query));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_lookup.find(query);
+    if (it != m_lookup.end()) {
+        // another thread won the race, keep its entry
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return it->second->second;
+    }
+    m_entries.emplace_front(query, result);
+    m_lookup.emplace(query, m_entries.begin());
+    if (m_entries.size() > m_capacity) {
+        m_lookup.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+    return result;
+}
+
+size_t ParserCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+size_t ParserCache::hits() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+size_t ParserCache::misses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
+void ParserCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lookup.clear();
+    m_entries.clear();
+}
+
 size_t analyze_grammar()
 {
     return analyze<pred>();
@@ -19,8 +19,11 @@
 #ifndef REALM_PARSER_HPP
 #define REALM_PARSER_HPP
 
+#include <list>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <realm/string_data.hpp>
 
@@ -32,13 +35,14 @@ struct Predicate;
 
 struct Expression
 {
-    enum class Type { None, Number, String, KeyPath, Argument, True, False, Null, Timestamp, Base64, SubQuery } type;
+    enum class Type { None, Number, String, KeyPath, Argument, True, False, Null, Timestamp, Base64, SubQuery, List } type;
     enum class KeyPathOp { None, Min, Max, Avg, Sum, Count, SizeString, SizeBinary, BacklinkCount } collection_op;
     std::string s;
     std::vector<std::string> time_inputs;
     std::string op_suffix;
     std::string subquery_path, subquery_var;
     std::shared_ptr<Predicate> subquery;
+    std::vector<Expression> list_items; // only used by Type::List
     Expression(Type t = Type::None, std::string input = "") : type(t), collection_op(KeyPathOp::None), s(input) {}
     Expression(std::vector<std::string>&& timestamp) : type(Type::Timestamp), collection_op(KeyPathOp::None), time_inputs(timestamp) {}
     Expression(std::string prefix, KeyPathOp op, std::string suffix) : type(Type::KeyPath), collection_op(op), s(prefix), op_suffix(suffix) {}
@@ -138,6 +142,40 @@ ParserResult parse(const realm::StringData& query);
 
 DescriptorOrderingState parse_include_path(const realm::StringData& path);
 
+// A thread safe, bounded cache of parse results keyed by the query text.
+// The result of parsing only depends on the text (not on the schema or on
+// the values of any $N arguments) so applications that issue the same query
+// shapes repeatedly can use this to skip running the grammar each time.
+// The least recently used entry is evicted when the capacity is exceeded.
+class ParserCache {
+public:
+    explicit ParserCache(size_t capacity = 64);
+
+    // Returns the cached result for `query`, parsing and inserting it on a miss.
+    // Throws on invalid syntax exactly like parse(), in which case nothing is cached.
+    std::shared_ptr<const ParserResult> get(const std::string& query);
+
+    size_t size() const;
+    size_t capacity() const noexcept
+    {
+        return m_capacity;
+    }
+    size_t hits() const;
+    size_t misses() const;
+    void clear();
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const ParserResult>>;
+    using EntryList = std::list<Entry>;
+
+    mutable std::mutex m_mutex;
+    const size_t m_capacity;
+    EntryList m_entries; // most recently used first
+    std::unordered_map<std::string, EntryList::iterator> m_lookup;
+    size_t m_hits = 0;
+    size_t m_misses = 0;
+};
+
 // run the analysis tool to check for cycles in the grammar
 // returns the number of problems found and prints some info to std::cout
 size_t analyze_grammar();
@@ -681,11 +681,38 @@ bool is_property_operation(parser::Expression::Type type)
     return type == parser::Expression::Type::KeyPath || type == parser::Expression::Type::SubQuery;
 }
 
+void update_query_with_predicate(Query &query, const Predicate &pred, Arguments &arguments, parser::KeyPathMapping& mapping);
+
+// "key IN {v1, v2, ...}" is evaluated as "key == v1 OR key == v2 OR ...". The query engine collapses such a chain of
+// equality conditions on a single column into one hash set lookup (or a union of index lookups).
+void add_list_comparison_to_query(Query &query, const Predicate::Comparison& cmpr, Arguments &args, parser::KeyPathMapping& mapping)
+{
+    if (cmpr.op != Predicate::Operator::In) {
+        throw std::logic_error("A list of values can only be used with the 'IN' operator.");
+    }
+    Predicate any_of(Predicate::Type::Or);
+    for (auto& item : cmpr.expr[1].list_items) {
+        Predicate equal(Predicate::Type::Comparison);
+        equal.cmpr.op = Predicate::Operator::Equal;
+        equal.cmpr.option = cmpr.option;
+        equal.cmpr.compare_type = cmpr.compare_type;
+        equal.cmpr.expr[0] = cmpr.expr[0];
+        equal.cmpr.expr[1] = item;
+        any_of.cpnd.sub_predicates.push_back(std::move(equal));
+    }
+    update_query_with_predicate(query, any_of, args, mapping);
+}
+
 void add_comparison_to_query(Query &query, const Predicate &pred, Arguments &args, parser::KeyPathMapping& mapping)
 {
     Predicate::Comparison cmpr = pred.cmpr;
     auto lhs_type = cmpr.expr[0].type, rhs_type = cmpr.expr[1].type;
 
+    if (rhs_type == parser::Expression::Type::List) {
+        add_list_comparison_to_query(query, cmpr, args, mapping);
+        return;
+    }
+
     if (!is_property_operation(lhs_type) && !is_property_operation(rhs_type)) {
         // value vs value expressions are not supported (ex: 2 < 3 or null != null)
         throw std::logic_error("Predicate expressions must compare a keypath and another keypath or a constant value");
@@ -752,6 +779,29 @@ void update_query_with_predicate(Query &query, const Predicate &pred, Arguments
             throw std::logic_error("Invalid predicate type");
     }
 }
+
+bool predicate_has_arguments(const Predicate& pred)
+{
+    if (pred.type == Predicate::Type::Comparison) {
+        for (auto& expr : pred.cmpr.expr) {
+            if (expr.type == parser::Expression::Type::Argument)
+                return true;
+            for (auto& item : expr.list_items) {
+                if (item.type == parser::Expression::Type::Argument)
+                    return true;
+            }
+            if (expr.type == parser::Expression::Type::SubQuery && expr.subquery &&
+                predicate_has_arguments(*expr.subquery))
+                return true;
+        }
+        return false;
+    }
+    for (auto& sub : pred.cpnd.sub_predicates) {
+        if (predicate_has_arguments(sub))
+            return true;
+    }
+    return false;
+}
 } // anonymous namespace
 
 namespace realm {
@@ -873,5 +923,35 @@ void apply_ordering(DescriptorOrdering& ordering, ConstTableRef target, const pa
     apply_ordering(ordering, target, state, args, mapping);
 }
 
+PreparedQuery::PreparedQuery(TableRef table, std::shared_ptr<const parser::ParserResult> parsed,
+                             parser::KeyPathMapping mapping)
+    : m_table(std::move(table))
+    , m_parsed(std::move(parsed))
+    , m_mapping(std::move(mapping))
+    , m_has_arguments(predicate_has_arguments(m_parsed->predicate))
+{
+    REALM_ASSERT(m_table);
+}
+
+PreparedQuery::PreparedQuery(TableRef table, const std::string& query, parser::ParserCache& cache,
+                             parser::KeyPathMapping mapping)
+    : PreparedQuery(std::move(table), cache.get(query), std::move(mapping))
+{
+}
+
+Query PreparedQuery::bind(Arguments& arguments) const
+{
+    Query query = m_table->where();
+    apply_predicate(query, m_parsed->predicate, arguments, m_mapping);
+    return query;
+}
+
+DescriptorOrdering PreparedQuery::bind_ordering(Arguments& arguments) const
+{
+    DescriptorOrdering ordering;
+    apply_ordering(ordering, m_table, m_parsed->ordering, arguments, m_mapping);
+    return ordering;
+}
+
 } // namespace query_builder
 } // namespace realm
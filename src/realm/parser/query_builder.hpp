@@ -42,6 +42,8 @@ using RowExpr = BasicRowExpr<Table>;
 namespace parser {
     struct Predicate;
     struct DescriptorOrderingState;
+    struct ParserResult;
+    class ParserCache;
 }
 
 namespace query_builder {
@@ -134,6 +136,38 @@ private:
     }
 };
 
+// A query that has been parsed once and can be applied repeatedly to the same
+// table with different argument values. The predicate and ordering are kept in
+// their parsed form, so binding only rebuilds the query nodes from the already
+// validated tree and never runs the grammar again. Argument values are baked
+// into the nodes by the query engine, so a new Query is produced per bind.
+class PreparedQuery {
+public:
+    PreparedQuery(TableRef table, std::shared_ptr<const parser::ParserResult> parsed,
+                  parser::KeyPathMapping mapping = parser::KeyPathMapping());
+    PreparedQuery(TableRef table, const std::string& query, parser::ParserCache& cache,
+                  parser::KeyPathMapping mapping = parser::KeyPathMapping());
+
+    Query bind(Arguments& arguments) const;
+    DescriptorOrdering bind_ordering(Arguments& arguments) const;
+
+    // True if the query contains at least one $N placeholder
+    bool has_arguments() const noexcept
+    {
+        return m_has_arguments;
+    }
+    const parser::ParserResult& parsed() const noexcept
+    {
+        return *m_parsed;
+    }
+
+private:
+    TableRef m_table;
+    std::shared_ptr<const parser::ParserResult> m_parsed;
+    parser::KeyPathMapping m_mapping;
+    bool m_has_arguments;
+};
+
 class NoArgsError : public std::runtime_error {
 public:
     NoArgsError() : std::runtime_error("Attempt to retreive an argument when no arguments were given") {}
@@ -654,6 +654,42 @@ Query& Query::links_to(size_t origin_column, const std::vector<ConstRow>& target
     return *this;
 }
 
+namespace {
+template <class T, class... Args>
+Query& add_in_condition(Query& query, size_t column_ndx, const std::vector<T>& values, Args... args)
+{
+    if (values.empty()) {
+        return query.and_query(std::unique_ptr<Expression>(new FalseExpression));
+    }
+    // OrNode collapses the resulting chain of equality conditions into a single node (see
+    // OrNode::combine_conditions())
+    query.group();
+    bool is_first = true;
+    for (auto& value : values) {
+        if (!is_first)
+            query.Or();
+        query.equal(column_ndx, value, args...);
+        is_first = false;
+    }
+    return query.end_group();
+}
+} // anonymous namespace
+
+Query& Query::in(size_t column_ndx, const std::vector<int64_t>& values)
+{
+    return add_in_condition(*this, column_ndx, values);
+}
+
+Query& Query::in(size_t column_ndx, const std::vector<Timestamp>& values)
+{
+    return add_in_condition(*this, column_ndx, values);
+}
+
+Query& Query::in(size_t column_ndx, const std::vector<StringData>& values, bool case_sensitive)
+{
+    return add_in_condition(*this, column_ndx, values, case_sensitive);
+}
+
 // int64 constant vs column
 Query& Query::equal(size_t column_ndx, int64_t value)
 {
@@ -1392,6 +1428,38 @@ void Query::find_all(TableViewBase& ret, size_t begin, size_t end, size_t limit)
     }
 }
 
+void Query::find_all(TableViewBase& ret, TopKCollector& collector) const
+{
+    REALM_ASSERT(!m_view);
+    if (m_table->is_degenerate())
+        return;
+
+    init();
+
+    const size_t window_size = 0x10000;
+    const size_t end = m_table->size();
+    IntegerColumn& matches = ret.m_row_indexes;
+    for (size_t begin = 0; begin < end; begin += window_size) {
+        size_t window_end = std::min(begin + window_size, end);
+        matches.clear();
+        if (has_conditions()) {
+            QueryState<int64_t> st;
+            st.init(act_FindAll, &matches, size_t(-1));
+            aggregate_internal(act_FindAll, ColumnTypeTraits<int64_t>::id, false, root_node(), &st, begin,
+                               window_end, nullptr);
+            size_t num_matches = matches.size();
+            for (size_t i = 0; i < num_matches; ++i)
+                collector.add(to_size_t(matches.get(i)));
+        }
+        else {
+            for (size_t i = begin; i < window_end; ++i)
+                collector.add(i);
+        }
+    }
+    matches.clear();
+    collector.release(matches);
+}
+
 TableView Query::find_all(size_t start, size_t end, size_t limit)
 {
 #if REALM_METRICS
@@ -1403,6 +1471,96 @@ TableView Query::find_all(size_t start, size_t end, size_t limit)
     return ret;
 }
 
+QueryCursor Query::iterate(size_t start, size_t end, size_t limit) const
+{
+    return QueryCursor(*this, start, end, limit);
+}
+
+constexpr size_t QueryCursor::batch_size;
+
+QueryCursor::QueryCursor(const Query& query, size_t start, size_t end, size_t limit)
+    : m_query(query)
+    , m_row_begin(start)
+    , m_limit(limit)
+{
+    if (m_query.m_table->is_degenerate()) {
+        m_row_end = m_position = m_end = 0;
+        return;
+    }
+
+    REALM_ASSERT_3(start, <=, m_query.m_table->size());
+    m_row_end = (end == size_t(-1)) ? m_query.m_table->size() : end;
+
+    m_query.init();
+
+    if (m_query.m_view) {
+        m_position = 0;
+        m_end = m_query.m_view->size();
+    }
+    else {
+        m_position = start;
+        m_end = m_row_end;
+    }
+}
+
+size_t QueryCursor::next()
+{
+    if (m_limit == 0)
+        return not_found;
+
+    size_t row = find_next(m_end);
+    if (row != not_found) {
+        --m_limit;
+        ++m_count;
+    }
+    return row;
+}
+
+bool QueryCursor::next_batch(std::vector<size_t>& rows)
+{
+    rows.clear();
+    while (rows.empty() && m_limit > 0 && m_position < m_end) {
+        // Search to the end of the window that m_position is in
+        size_t window_end = std::min((m_position / batch_size + 1) * batch_size, m_end);
+        while (m_limit > 0) {
+            size_t row = find_next(window_end);
+            if (row == not_found)
+                break;
+            rows.push_back(row);
+            --m_limit;
+            ++m_count;
+        }
+    }
+    return !rows.empty();
+}
+
+size_t QueryCursor::find_next(size_t end)
+{
+    if (m_query.m_view) {
+        while (m_position < end) {
+            size_t row = static_cast<size_t>(m_query.m_view->m_row_indexes.get(m_position++));
+            if (row >= m_row_begin && row < m_row_end && m_query.peek_tablerow(row) != not_found)
+                return row;
+        }
+        return not_found;
+    }
+
+    if (m_position >= end)
+        return not_found;
+
+    if (!m_query.has_conditions())
+        return m_position++;
+
+    size_t row = m_query.root_node()->find_first(m_position, end);
+    if (row >= end) {
+        // No match, find_first() returns not_found
+        m_position = end;
+        return not_found;
+    }
+    m_position = row + 1;
+    return row;
+}
+
 size_t Query::do_count(size_t start, size_t end, size_t limit) const
 {
     if (limit == 0 || m_table->is_degenerate())
@@ -1489,6 +1647,12 @@ TableView Query::find_all(const DescriptorOrdering& descriptor)
     return ret;
 }
 
+GroupByResult Query::group_by(const GroupByDescriptor& descriptor)
+{
+    TableView matches = find_all();
+    return matches.group_by(descriptor);
+}
+
 size_t Query::count(const DescriptorOrdering& descriptor)
 {
 #if REALM_METRICS
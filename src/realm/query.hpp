@@ -56,7 +56,11 @@ class ConstTableView;
 class Array;
 class Expression;
 class SequentialGetterBase;
+class TopKCollector;
+class GroupByDescriptor;
+class GroupByResult;
 class Group;
+class QueryCursor;
 
 namespace metrics {
 class QueryInfo;
@@ -106,6 +110,13 @@ public:
     // Find links that point to specific target rows
     Query& links_to(size_t column_ndx, const std::vector<ConstRow>& target_row);
 
+    // Find rows whose value in the given column equals any of the given values. Equivalent to a group of equal()
+    // conditions joined by Or(), but evaluated with a single hash lookup per row if the column has no search index,
+    // and by combining index lookups otherwise. An empty list of values matches no rows.
+    Query& in(size_t column_ndx, const std::vector<int64_t>& values);
+    Query& in(size_t column_ndx, const std::vector<Timestamp>& values);
+    Query& in(size_t column_ndx, const std::vector<StringData>& values, bool case_sensitive = true);
+
     // Conditions: null
     Query& equal(size_t column_ndx, null);
     Query& not_equal(size_t column_ndx, null);
@@ -263,12 +274,19 @@ public:
     size_t find(size_t begin_at_table_row = size_t(0));
     TableView find_all(size_t start = 0, size_t end = size_t(-1), size_t limit = size_t(-1));
 
+    // Produce the matches in row order, a batch at a time, without collecting
+    // them all in a TableView. See QueryCursor.
+    QueryCursor iterate(size_t start = 0, size_t end = size_t(-1), size_t limit = size_t(-1)) const;
+
     // Aggregates
     size_t count(size_t start = 0, size_t end = size_t(-1), size_t limit = size_t(-1)) const;
 
     TableView find_all(const DescriptorOrdering& descriptor);
     size_t count(const DescriptorOrdering& descriptor);
 
+    // Grouped aggregation over the matching rows, see GroupByDescriptor
+    GroupByResult group_by(const GroupByDescriptor& descriptor);
+
     int64_t sum_int(size_t column_ndx, size_t* resultcount = nullptr, size_t start = 0, size_t end = size_t(-1),
                     size_t limit = size_t(-1)) const;
 
@@ -426,6 +444,8 @@ private:
                             size_t start, size_t end, SequentialGetterBase* source_column) const;
 
     void find_all(TableViewBase& tv, size_t start = 0, size_t end = size_t(-1), size_t limit = size_t(-1)) const;
+    // Feed all matches to `collector`, storing no more than a window of them in `tv` at a time
+    void find_all(TableViewBase& tv, TopKCollector& collector) const;
     size_t do_count(size_t start = 0, size_t end = size_t(-1), size_t limit = size_t(-1)) const;
     void delete_nodes() noexcept;
 
@@ -443,6 +463,8 @@ private:
 
     friend class Table;
     friend class TableViewBase;
+    friend class QueryCursor;
+    friend class SharedGroup;
     friend class metrics::QueryInfo;
 
     std::string error_code;
@@ -466,6 +488,67 @@ private:
     std::unique_ptr<TableViewBase> m_owned_source_table_view; // <--- except when indicated here
 };
 
+/// A pull-based cursor over the matches of a query, as returned by
+/// Query::iterate().
+///
+/// Matches are produced in increasing row order. The search resumes where the
+/// previous call stopped, so a consumer that stops early does not pay for the
+/// rest of the table, and nothing is allocated per match beyond what the
+/// caller asks for. The cursor holds its own copy of the query, but the table
+/// (and the restricting view, if any) must not be modified while it is in use.
+class QueryCursor {
+public:
+    /// The number of table rows searched by a call to next_batch(), in windows
+    /// aligned like the leaves of the columns.
+    static constexpr size_t batch_size = REALM_MAX_BPNODE_SIZE;
+
+    /// Return the next matching row, or `not_found` when there are no more
+    /// matches or the limit has been reached.
+    size_t next();
+
+    /// Replace the contents of `rows` with the next batch of matching rows.
+    /// Every call searches whole windows of batch_size rows until it has found
+    /// at least one match (or a restricting view, batch_size entries of it).
+    /// Returns false, with `rows` empty, when there are no more matches or the
+    /// limit has been reached.
+    bool next_batch(std::vector<size_t>& rows);
+
+    /// True if the cursor has searched everything up to its end, or has
+    /// produced as many matches as its limit allows.
+    bool at_end() const noexcept
+    {
+        return m_limit == 0 || m_position >= m_end;
+    }
+
+    /// The number of matches produced so far.
+    size_t get_count() const noexcept
+    {
+        return m_count;
+    }
+
+    QueryCursor(QueryCursor&&) = default;
+    QueryCursor& operator=(QueryCursor&&) = default;
+
+private:
+    Query m_query;
+    size_t m_row_begin;
+    size_t m_row_end;
+    // Next table row and end of the search, or for a query restricted by a
+    // view, next index into the view and its size
+    size_t m_position;
+    size_t m_end;
+    size_t m_limit; // Remaining number of matches to produce
+    size_t m_count = 0;
+
+    QueryCursor(const Query& query, size_t start, size_t end, size_t limit);
+
+    // Search rows (or view entries) from m_position up to `end`, and return the
+    // first match, or not_found with m_position set to `end`
+    size_t find_next(size_t end);
+
+    friend class Query;
+};
+
 // Implementation:
 
 inline Query& Query::equal(size_t column_ndx, const char* c_str, bool case_sensitive)
@@ -0,0 +1,248 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <algorithm>
+
+#include <realm/query_cache.hpp>
+#include <realm/impl/transact_log.hpp>
+#include <realm/group.hpp>
+#include <realm/table.hpp>
+
+using namespace realm;
+
+namespace {
+
+// Records the group-level tables selected by a transaction log. Selecting a
+// table does not necessarily mean that it is changed, but the result is a
+// superset of the changed tables, which is what the cache needs.
+class ChangedTableCollector : public _impl::NullInstructionObserver {
+public:
+    ChangedTableCollector(QueryResultCache::Changes& changes)
+        : m_changes(changes)
+    {
+    }
+
+    bool select_table(size_t group_level_ndx, size_t, const size_t*)
+    {
+        m_changes.tables.push_back(group_level_ndx);
+        return true;
+    }
+
+    // Don't have the parser expand instr_SetRange into a call for each row
+    bool set_range(size_t, size_t, size_t)
+    {
+        return true;
+    }
+
+    bool insert_group_level_table(size_t, size_t, StringData)
+    {
+        m_changes.schema_changed = true;
+        return true;
+    }
+
+    bool erase_group_level_table(size_t, size_t)
+    {
+        m_changes.schema_changed = true;
+        return true;
+    }
+
+    bool rename_group_level_table(size_t, StringData)
+    {
+        m_changes.schema_changed = true;
+        return true;
+    }
+
+    // Link columns also change the backlink columns of their target tables
+    bool insert_link_column(size_t, DataType, StringData, size_t, size_t)
+    {
+        m_changes.schema_changed = true;
+        return true;
+    }
+
+    bool insert_column(size_t, DataType, StringData, bool)
+    {
+        m_changes.schema_changed = true;
+        return true;
+    }
+
+    bool erase_link_column(size_t, size_t, size_t)
+    {
+        m_changes.schema_changed = true;
+        return true;
+    }
+
+    bool erase_column(size_t)
+    {
+        m_changes.schema_changed = true;
+        return true;
+    }
+
+private:
+    QueryResultCache::Changes& m_changes;
+};
+
+template <class Stream>
+void parse_changes(Stream& in, QueryResultCache::Changes& changes)
+{
+    ChangedTableCollector collector(changes);
+    _impl::TransactLogParser parser;
+    parser.parse(in, collector); // Throws
+
+    std::sort(changes.tables.begin(), changes.tables.end());
+    changes.tables.erase(std::unique(changes.tables.begin(), changes.tables.end()), changes.tables.end());
+}
+
+bool intersects(const std::vector<size_t>& a, const std::vector<size_t>& b)
+{
+    auto i = a.begin();
+    auto j = b.begin();
+    while (i != a.end() && j != b.end()) {
+        if (*i < *j) {
+            ++i;
+        }
+        else if (*j < *i) {
+            ++j;
+        }
+        else {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+
+QueryResultCache::QueryResultCache(size_t max_entries)
+    : m_max_entries(max_entries)
+{
+    REALM_ASSERT(max_entries > 0);
+}
+
+
+QueryResultCache::Rows QueryResultCache::lookup(const std::string& key, version_type version)
+{
+    util::LockGuard lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+        return nullptr;
+
+    Entry& entry = it->second;
+    if (version < entry.version || version > entry.valid_until)
+        return nullptr;
+
+    entry.last_use = ++m_use_counter;
+    return entry.rows;
+}
+
+
+void QueryResultCache::store(const std::string& key, version_type version, std::vector<size_t> tables, Rows rows)
+{
+    util::LockGuard lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        if (it->second.version > version)
+            return;
+    }
+    else if (m_entries.size() >= m_max_entries) {
+        auto lru = m_entries.begin();
+        for (auto i = m_entries.begin(); i != m_entries.end(); ++i) {
+            if (i->second.last_use < lru->second.last_use)
+                lru = i;
+        }
+        m_entries.erase(lru);
+    }
+
+    Entry& entry = m_entries[key]; // Throws
+    entry.version = version;
+    entry.valid_until = version;
+    entry.tables = std::move(tables);
+    entry.rows = std::move(rows);
+    entry.last_use = ++m_use_counter;
+}
+
+
+void QueryResultCache::report_changes(version_type begin_version, version_type end_version, const Changes& changes)
+{
+    if (changes.schema_changed)
+        return;
+
+    util::LockGuard lock(m_mutex);
+    for (auto& key_and_entry : m_entries) {
+        Entry& entry = key_and_entry.second;
+        // The reported range must connect to the versions the entry is
+        // already known to be valid at
+        if (begin_version > entry.valid_until || end_version <= entry.valid_until)
+            continue;
+        if (!intersects(entry.tables, changes.tables))
+            entry.valid_until = end_version;
+    }
+}
+
+
+void QueryResultCache::collect_changes(_impl::NoCopyInputStream& in, Changes& changes)
+{
+    parse_changes(in, changes); // Throws
+}
+
+
+void QueryResultCache::collect_changes(_impl::InputStream& in, Changes& changes)
+{
+    parse_changes(in, changes); // Throws
+}
+
+
+std::vector<size_t> QueryResultCache::get_dependencies(const Table& table)
+{
+    REALM_ASSERT(table.is_group_level());
+    std::vector<size_t> tables;
+    tables.push_back(table.get_index_in_group());
+
+    // Breadth first through the link and backlink columns, including the
+    // hidden backlink columns of the spec
+    const Group* group = _impl::TableFriend::get_parent_group(table);
+    for (size_t i = 0; i < tables.size(); ++i) {
+        ConstTableRef current = group->get_table(tables[i]);
+        const Spec& spec = _impl::TableFriend::get_spec(*current);
+        for (size_t col = 0; col < spec.get_column_count(); ++col) {
+            ColumnType type = spec.get_column_type(col);
+            if (type != col_type_Link && type != col_type_LinkList && type != col_type_BackLink)
+                continue;
+            size_t target = spec.get_opposite_link_table_ndx(col);
+            if (std::find(tables.begin(), tables.end(), target) == tables.end())
+                tables.push_back(target);
+        }
+    }
+
+    std::sort(tables.begin(), tables.end());
+    return tables;
+}
+
+
+size_t QueryResultCache::size() const
+{
+    util::LockGuard lock(m_mutex);
+    return m_entries.size();
+}
+
+
+void QueryResultCache::clear() noexcept
+{
+    util::LockGuard lock(m_mutex);
+    m_entries.clear();
+}
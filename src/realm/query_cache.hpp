@@ -0,0 +1,111 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_QUERY_CACHE_HPP
+#define REALM_QUERY_CACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <realm/util/thread.hpp>
+
+namespace realm {
+
+class Table;
+
+namespace _impl {
+class InputStream;
+class NoCopyInputStream;
+}
+
+/// A cache of query results that can be shared by all the SharedGroups of a
+/// process which are attached to the same file. Install it with
+/// SharedGroupOptions::query_cache and use it through
+/// SharedGroup::find_all_cached().
+///
+/// A result is stored as the row indices it contained at the version it was
+/// computed at, together with the group-level tables it depends on: the
+/// queried table and every table reachable from it through links and
+/// backlinks. The SharedGroups report which tables were changed by the
+/// versions they advance over or commit, and a result stays valid for later
+/// versions as long as these reports cover them without a change to any of
+/// its tables. A result is never used at a version older than the one it was
+/// computed at.
+///
+/// All member functions are thread-safe.
+class QueryResultCache {
+public:
+    using version_type = uint_fast64_t;
+    using Rows = std::shared_ptr<const std::vector<size_t>>;
+
+    /// The tables changed by a range of versions.
+    struct Changes {
+        std::vector<size_t> tables; ///< Group-level indices, sorted and unique
+        bool schema_changed = false; ///< Tables or columns were added, removed or moved
+    };
+
+    /// When the cache is full, the least recently used result is evicted.
+    explicit QueryResultCache(size_t max_entries = 256);
+
+    QueryResultCache(const QueryResultCache&) = delete;
+    QueryResultCache& operator=(const QueryResultCache&) = delete;
+
+    /// The rows stored for `key`, if they are valid at `version`, or null.
+    Rows lookup(const std::string& key, version_type version);
+
+    /// Store `rows` computed at `version` for `key`. `tables` lists the
+    /// group-level indices of the tables the result depends on. A result
+    /// computed at an older version than the one already stored is ignored.
+    void store(const std::string& key, version_type version, std::vector<size_t> tables, Rows rows);
+
+    /// Report the tables changed by the versions after `begin_version` up to
+    /// and including `end_version`.
+    void report_changes(version_type begin_version, version_type end_version, const Changes&);
+
+    /// Add the tables changed by the transaction logs in `in` to `changes`.
+    static void collect_changes(_impl::NoCopyInputStream& in, Changes& changes);
+    static void collect_changes(_impl::InputStream& in, Changes& changes);
+
+    /// The group-level indices of `table` and every table reachable from it
+    /// through link and backlink columns, sorted.
+    static std::vector<size_t> get_dependencies(const Table& table);
+
+    size_t size() const;
+    void clear() noexcept;
+
+private:
+    struct Entry {
+        version_type version;     // The version the rows were computed at
+        version_type valid_until; // The last version the rows are known to be valid at
+        std::vector<size_t> tables;
+        Rows rows;
+        uint_fast64_t last_use;
+    };
+
+    const size_t m_max_entries;
+    mutable util::Mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries; // Protected by m_mutex
+    uint_fast64_t m_use_counter = 0;                  // Protected by m_mutex
+};
+
+} // namespace realm
+
+#endif // REALM_QUERY_CACHE_HPP
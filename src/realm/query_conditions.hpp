@@ -252,7 +252,7 @@ struct Equal {
 };
 
 struct NotEqual {
-    static const int avx = 0x0B; // _CMP_FALSE_OQ
+    static const int avx = 0x04; // _CMP_NEQ_UQ
     bool operator()(StringData v1, const char*, const char*, StringData v2, bool = false, bool = false) const
     {
         return v1 != v2;
@@ -52,6 +52,29 @@ size_t ParentNode::find_first(size_t start, size_t end)
     return not_found;
 }
 
+bool ParentNode::collect_matches(RowBitmap& matches)
+{
+    matches.clear();
+    if (!collect_local_matches(matches))
+        return false;
+    if (m_child) {
+        RowBitmap child_matches;
+        if (!m_child->collect_matches(child_matches))
+            return false;
+        matches &= child_matches;
+    }
+    return true;
+}
+
+bool ParentNode::depends_only_on_own_row() const
+{
+    for (const ParentNode* node = this; node; node = node->m_child.get()) {
+        if (!node->local_depends_only_on_own_row())
+            return false;
+    }
+    return true;
+}
+
 void ParentNode::aggregate_local_prepare(Action TAction, DataType col_id, bool nullable)
 {
     if (TAction == act_ReturnFirst) {
@@ -226,6 +249,15 @@ void StringNodeEqualBase::init()
     }
 }
 
+bool StringNodeEqualBase::collect_local_matches(RowBitmap& matches)
+{
+    if (!m_condition_column->has_search_index())
+        return false;
+    if (m_index_matches)
+        matches.add_all(*m_index_matches, m_results_start, m_results_end);
+    return true;
+}
+
 size_t StringNodeEqualBase::find_first_local(size_t start, size_t end)
 {
     REALM_ASSERT(m_table);
@@ -499,6 +531,9 @@ size_t StringNode<EqualIns>::_find_first_local(size_t start, size_t end)
 
 size_t NotNode::find_first_local(size_t start, size_t end)
 {
+    if (m_matches_bitmap) {
+        return m_matches_bitmap->find_first(start, end);
+    }
     if (start <= m_known_range_start && end >= m_known_range_end) {
         return find_first_covers_known(start, end);
     }
@@ -694,6 +729,9 @@ size_t TimestampNode<Greater>::find_first_local(size_t start, size_t end)
     if (this->m_value.is_null()) {
         return not_found;
     }
+    if (can_pack(m_value)) {
+        return this->find_first_local_ordered<Greater, Greater, GreaterEqual>(start, end);
+    }
     while (start < end) {
         size_t ret = this->find_first_local_seconds<GreaterEqual>(start, end);
 
@@ -728,6 +766,9 @@ size_t TimestampNode<Less>::find_first_local(size_t start, size_t end)
     if (this->m_value.is_null()) {
         return not_found;
     }
+    if (can_pack(m_value)) {
+        return this->find_first_local_ordered<Less, Less, LessEqual>(start, end);
+    }
     while (start < end) {
         size_t ret = this->find_first_local_seconds<LessEqual>(start, end);
 
@@ -759,6 +800,10 @@ size_t TimestampNode<GreaterEqual>::find_first_local(size_t start, size_t end)
 {
     REALM_ASSERT(this->m_table);
 
+    // A null needle matches the null values, which have no packed key
+    if (can_pack(m_value)) {
+        return this->find_first_local_ordered<GreaterEqual, Greater, GreaterEqual>(start, end);
+    }
     while (start < end) {
         size_t ret = this->find_first_local_seconds<GreaterEqual>(start, end);
 
@@ -793,6 +838,10 @@ size_t TimestampNode<LessEqual>::find_first_local(size_t start, size_t end)
 {
     REALM_ASSERT(this->m_table);
 
+    // A null needle matches the null values, which have no packed key
+    if (can_pack(m_value)) {
+        return this->find_first_local_ordered<LessEqual, Less, LessEqual>(start, end);
+    }
     while (start < end) {
         size_t ret = this->find_first_local_seconds<LessEqual>(start, end);
 
@@ -822,11 +871,35 @@ size_t TimestampNode<LessEqual>::find_first_local(size_t start, size_t end)
     return not_found;
 }
 
-template <>
+void TimestampNode<Equal>::consume_condition(TimestampNode<Equal>* other)
+{
+    // See StringNode<Equal>::consume_condition() for when conditions are combined
+    REALM_ASSERT(m_condition_column == other->m_condition_column);
+    REALM_ASSERT(other->m_needles.empty());
+    if (m_needles.empty()) {
+        m_needles.insert(m_value);
+    }
+    m_needles.insert(other->m_value);
+}
+
+size_t TimestampNode<Equal>::find_first_haystack(size_t start, size_t end)
+{
+    for (; start < end; ++start) {
+        util::Optional<int64_t> seconds = get_seconds_and_cache(start);
+        Timestamp value = seconds ? Timestamp(*seconds, get_nanoseconds_and_cache(start)) : Timestamp();
+        if (m_needles.count(value))
+            return start;
+    }
+    return not_found;
+}
+
 size_t TimestampNode<Equal>::find_first_local(size_t start, size_t end)
 {
     REALM_ASSERT(this->m_table);
 
+    if (!m_needles.empty())
+        return find_first_haystack(start, end);
+
     if (m_value.is_null()) {
         if (REALM_UNLIKELY(!m_condition_column_is_nullable)) {
             return not_found;
@@ -852,6 +925,24 @@ size_t TimestampNode<Equal>::find_first_local(size_t start, size_t end)
     return not_found;
 }
 
+std::string TimestampNode<Equal>::describe(util::serializer::SerialisationState& state) const
+{
+    REALM_ASSERT(m_condition_column != nullptr);
+    const std::string column = state.describe_column(ParentNode::m_table, m_condition_column->get_column_index());
+    if (m_needles.empty()) {
+        return column + " " + Equal::description() + " " + util::serializer::print_value(m_value);
+    }
+
+    std::string desc;
+    bool is_first = true;
+    for (auto& needle : m_needles) {
+        desc += (is_first ? "" : " or ") + column + " " + Equal::description() + " " +
+                util::serializer::print_value(needle);
+        is_first = false;
+    }
+    return "(" + desc + ")";
+}
+
 template <>
 size_t TimestampNode<NotEqual>::find_first_local(size_t start, size_t end)
 {
@@ -900,7 +991,6 @@ template size_t TimestampNode<Greater>::find_first_local(size_t start, size_t en
 template size_t TimestampNode<Less>::find_first_local(size_t start, size_t end);
 template size_t TimestampNode<GreaterEqual>::find_first_local(size_t start, size_t end);
 template size_t TimestampNode<LessEqual>::find_first_local(size_t start, size_t end);
-template size_t TimestampNode<Equal>::find_first_local(size_t start, size_t end);
 template size_t TimestampNode<NotEqual>::find_first_local(size_t start, size_t end);
 template size_t TimestampNode<NotNull>::find_first_local(size_t start, size_t end);
 #endif
@@ -86,6 +86,7 @@ AggregateState      State of the aggregate - contains a state variable that stor
 
 #include <algorithm>
 #include <functional>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <array>
@@ -104,10 +105,12 @@ AggregateState      State of the aggregate - contains a state variable that stor
 #include <realm/column_type_traits.hpp>
 #include <realm/column_type_traits.hpp>
 #include <realm/impl/sequential_getter.hpp>
+#include <realm/like_pattern.hpp>
 #include <realm/link_view.hpp>
 #include <realm/metrics/query_info.hpp>
 #include <realm/query_conditions.hpp>
 #include <realm/query_operators.hpp>
+#include <realm/row_bitmap.hpp>
 #include <realm/table.hpp>
 #include <realm/unicode.hpp>
 #include <realm/util/miscellaneous.hpp>
@@ -195,6 +198,27 @@ public:
 
     virtual size_t find_first_local(size_t start, size_t end) = 0;
 
+    // Nodes that can produce their complete set of matches up front, typically from a search index, override this
+    // to add them to `matches` and return true. Only valid after init().
+    virtual bool collect_local_matches(RowBitmap&)
+    {
+        return false;
+    }
+
+    // Replace the contents of `matches` with the rows matching this node and all the conditions AND'ed to it.
+    // Returns false if any of them can only be evaluated row by row.
+    bool collect_matches(RowBitmap& matches);
+
+    // Whether this node and all the conditions AND'ed to it decide on a row by the values of that row alone, so
+    // that the outcome for a row can only change when the row itself is changed.
+    bool depends_only_on_own_row() const;
+
+    // Nodes which read other rows, typically through links, override this to return false
+    virtual bool local_depends_only_on_own_row() const
+    {
+        return true;
+    }
+
     virtual void aggregate_local_prepare(Action TAction, DataType col_id, bool nullable);
 
     template <Action TAction, class TSourceColumn>
@@ -376,6 +400,11 @@ public:
         }
     }
 
+    bool local_depends_only_on_own_row() const override
+    {
+        return false;
+    }
+
     void table_changed() override
     {
         m_col_type = m_table->get_real_column_type(m_condition_column_idx);
@@ -929,6 +958,15 @@ public:
         return IntegerNodeBase<ColType>::m_condition_column->has_search_index();
     }
 
+    bool collect_local_matches(RowBitmap& matches) override
+    {
+        if (!has_search_index())
+            return false;
+        REALM_ASSERT(m_result);
+        matches.add_all(*m_result);
+        return true;
+    }
+
     size_t find_first_local(size_t start, size_t end) override
     {
         REALM_ASSERT(this->m_table);
@@ -1101,6 +1139,20 @@ public:
 
     size_t find_first_local(size_t start, size_t end) override
     {
+        // Nulls never match a non-null value, so the leaves can be searched without regard to the nullability
+        if (!null::is_null_float(m_value)) {
+            while (start < end) {
+                m_condition_column.cache_next(start);
+                size_t end2 = m_condition_column.local_end(end);
+                size_t s = m_condition_column.m_leaf_ptr->template find_first<TConditionFunction>(
+                    m_value, start - m_condition_column.m_leaf_start, end2);
+                if (s != not_found)
+                    return s + m_condition_column.m_leaf_start;
+                start = m_condition_column.m_leaf_start + end2;
+            }
+            return not_found;
+        }
+
         TConditionFunction cond;
 
         auto find = [&](bool nullability) {
@@ -1370,6 +1422,137 @@ protected:
         return int32_t(this->m_leaf_ptr_nanos->get(ndx - this->m_leaf_start_nanos));
     }
 
+    template <class Condition>
+    size_t find_first_local_seconds(size_t start, size_t end)
+    {
+        while (start < end) {
+            // Cache internal leaves
+            if (start >= this->m_leaf_end_seconds || start < this->m_leaf_start_seconds) {
+                this->get_leaf_seconds(*this->m_condition_column, start);
+            }
+
+            size_t end2;
+            if (end > this->m_leaf_end_seconds)
+                end2 = this->m_leaf_end_seconds - this->m_leaf_start_seconds;
+            else
+                end2 = end - this->m_leaf_start_seconds;
+
+            size_t s = this->m_leaf_ptr_seconds->template find_first<Condition>(
+                m_needle_seconds, start - this->m_leaf_start_seconds, end2);
+
+            if (s == not_found) {
+                start = this->m_leaf_end_seconds;
+                continue;
+            }
+            return s + this->m_leaf_start_seconds;
+        }
+        return not_found;
+    }
+
+    // Seconds and nanoseconds packed into a single order-preserving 64-bit key. As the nanoseconds always have the
+    // sign of the seconds, comparing keys gives the same result as comparing the pairs, provided that the product
+    // does not overflow. This holds for seconds of at most 32 bits, which covers the years 1901 to 2038.
+    static int64_t packed_key(int64_t seconds, int64_t nanoseconds) noexcept
+    {
+        return seconds * Timestamp::nanoseconds_per_second + nanoseconds;
+    }
+
+    static bool can_pack(const Timestamp& value) noexcept
+    {
+        return !value.is_null() && value.get_seconds() >= std::numeric_limits<int32_t>::min() &&
+               value.get_seconds() <= std::numeric_limits<int32_t>::max();
+    }
+
+    // Find the first non-null value for which `Condition(value, m_value)` holds, where Condition is one of the
+    // ordering conditions. Rows are compared a chunk at a time on their packed keys, which reads both leaves
+    // sequentially and leaves a branch free comparison loop. Leaves with seconds wider than 32 bits are compared a
+    // row at a time on the pairs instead. Requires can_pack(m_value).
+    template <class Condition>
+    size_t find_first_local_packed(size_t start, size_t end)
+    {
+        Condition cond;
+        const int64_t needle_seconds = m_value.get_seconds();
+        const int64_t needle_nanos = m_value.get_nanoseconds();
+        const int64_t needle = packed_key(needle_seconds, needle_nanos);
+
+        while (start < end) {
+            // Cache internal leaves
+            if (start >= this->m_leaf_end_seconds || start < this->m_leaf_start_seconds) {
+                this->get_leaf_seconds(*this->m_condition_column, start);
+            }
+            if (start >= this->m_leaf_end_nanos || start < this->m_leaf_start_nanos) {
+                this->get_leaf_nanos(*this->m_condition_column, start);
+            }
+            const size_t end2 = std::min(end, std::min(this->m_leaf_end_seconds, this->m_leaf_end_nanos));
+
+            // The first element of a nullable leaf holds its null value
+            const Array& seconds = *this->m_leaf_ptr_seconds;
+            const int64_t null_value = this->m_leaf_ptr_seconds->null_value();
+            const size_t seconds_offset = this->m_leaf_start_seconds - 1;
+            const LeafTypeNanos& nanos = *this->m_leaf_ptr_nanos;
+            const size_t nanos_offset = this->m_leaf_start_nanos;
+
+            if (seconds.get_width() <= 32) {
+                int64_t s[8];
+                int64_t n[8];
+                while (start < end2) {
+                    seconds.get_chunk(start - seconds_offset, s);
+                    nanos.get_chunk(start - nanos_offset, n);
+                    const size_t chunk_size = std::min(size_t(8), end2 - start);
+                    unsigned matches = 0;
+                    for (size_t i = 0; i < chunk_size; ++i)
+                        matches |= unsigned(s[i] != null_value && cond(packed_key(s[i], n[i]), needle)) << i;
+                    if (matches) {
+                        while (!(matches & 1)) {
+                            matches >>= 1;
+                            ++start;
+                        }
+                        return start;
+                    }
+                    start += chunk_size;
+                }
+            }
+            else {
+                for (; start < end2; ++start) {
+                    int64_t s = seconds.get(start - seconds_offset);
+                    if (s == null_value)
+                        continue;
+                    if (s == needle_seconds ? cond(nanos.get(start - nanos_offset), needle_nanos)
+                                            : cond(s, needle_seconds))
+                        return start;
+                }
+            }
+        }
+        return not_found;
+    }
+
+    // Find the first value for which `Condition(value, m_value)` holds. The candidates are found by searching the
+    // seconds alone with the non-strict SecondsCondition, and a candidate is a match if its seconds also satisfy the
+    // strict StrictCondition. Only when the seconds are equal (or null) are the nanoseconds needed, and then the
+    // remainder of the leaf is compared on packed keys instead of going back and forth between the two leaves for
+    // every row with the same seconds. Requires can_pack(m_value).
+    template <class Condition, class StrictCondition, class SecondsCondition>
+    size_t find_first_local_ordered(size_t start, size_t end)
+    {
+        StrictCondition strict;
+        while (start < end) {
+            size_t ret = this->find_first_local_seconds<SecondsCondition>(start, end);
+            if (ret == not_found)
+                return not_found;
+
+            util::Optional<int64_t> seconds = get_seconds_and_cache(ret);
+            if (seconds && strict(*seconds, *m_needle_seconds))
+                return ret;
+
+            const size_t leaf_end = std::min(end, this->m_leaf_end_seconds);
+            ret = this->find_first_local_packed<Condition>(ret, leaf_end);
+            if (ret != not_found)
+                return ret;
+            start = leaf_end;
+        }
+        return not_found;
+    }
+
     TimestampNodeBase(const TimestampNodeBase& from, QueryNodeHandoverPatches* patches)
         : ParentNode(from, patches)
         , m_value(from.m_value)
@@ -1409,33 +1592,6 @@ class TimestampNode : public TimestampNodeBase {
 public:
     using TimestampNodeBase::TimestampNodeBase;
 
-    template <class Condition>
-    size_t find_first_local_seconds(size_t start, size_t end)
-    {
-        while (start < end) {
-            // Cache internal leaves
-            if (start >= this->m_leaf_end_seconds || start < this->m_leaf_start_seconds) {
-                this->get_leaf_seconds(*this->m_condition_column, start);
-            }
-
-            size_t end2;
-            if (end > this->m_leaf_end_seconds)
-                end2 = this->m_leaf_end_seconds - this->m_leaf_start_seconds;
-            else
-                end2 = end - this->m_leaf_start_seconds;
-
-            size_t s = this->m_leaf_ptr_seconds->template find_first<Condition>(
-                m_needle_seconds, start - this->m_leaf_start_seconds, end2);
-
-            if (s == not_found) {
-                start = this->m_leaf_end_seconds;
-                continue;
-            }
-            return s + this->m_leaf_start_seconds;
-        }
-        return not_found;
-    }
-
     // see query_engine.cpp for operator specialisations
     size_t find_first_local(size_t start, size_t end) override
     {
@@ -1467,12 +1623,46 @@ size_t TimestampNode<GreaterEqual>::find_first_local(size_t start, size_t end);
 template <>
 size_t TimestampNode<LessEqual>::find_first_local(size_t start, size_t end);
 template <>
-size_t TimestampNode<Equal>::find_first_local(size_t start, size_t end);
-template <>
 size_t TimestampNode<NotEqual>::find_first_local(size_t start, size_t end);
 template <>
 size_t TimestampNode<NotNull>::find_first_local(size_t start, size_t end);
 
+// Specialization for Equal on Timestamps. Like the integer and string equality nodes, it can absorb other equality
+// conditions on the same column so that a long chain of OR'ed values (an "IN" query) is evaluated with a single hash
+// lookup per row.
+template <>
+class TimestampNode<Equal> : public TimestampNodeBase {
+public:
+    using TimestampNodeBase::TimestampNodeBase;
+
+    TimestampNode(const TimestampNode& from, QueryNodeHandoverPatches* patches)
+        : TimestampNodeBase(from, patches)
+        , m_needles(from.m_needles)
+    {
+    }
+
+    bool has_search_index() const
+    {
+        return m_condition_column->has_search_index();
+    }
+
+    void consume_condition(TimestampNode<Equal>* other);
+
+    size_t find_first_local(size_t start, size_t end) override;
+
+    std::string describe(util::serializer::SerialisationState& state) const override;
+
+    std::unique_ptr<ParentNode> clone(QueryNodeHandoverPatches* patches) const override
+    {
+        return std::unique_ptr<ParentNode>(new TimestampNode(*this, patches));
+    }
+
+private:
+    std::unordered_set<Timestamp> m_needles;
+
+    size_t find_first_haystack(size_t start, size_t end);
+};
+
 class StringNodeBase : public ParentNode {
 public:
     using TConditionValue = StringData;
@@ -1804,6 +1994,116 @@ protected:
     std::string m_lcase;
 };
 
+// Specializations for Like and LikeIns on Strings - the pattern is compiled once instead of being interpreted for
+// every row
+template <>
+class StringNode<Like> : public StringNodeBase {
+public:
+    StringNode(StringData v, size_t column)
+        : StringNodeBase(v, column)
+        , m_pattern(v)
+    {
+    }
+
+    void init() override
+    {
+        clear_leaf_state();
+
+        m_dD = 100.0;
+
+        StringNodeBase::init();
+    }
+
+    size_t find_first_local(size_t start, size_t end) override
+    {
+        for (size_t s = start; s < end; ++s) {
+            StringData t = get_string(s);
+
+            if (m_pattern.matches(t))
+                return s;
+        }
+        return not_found;
+    }
+
+    virtual std::string describe_condition() const override
+    {
+        return Like::description();
+    }
+
+    std::unique_ptr<ParentNode> clone(QueryNodeHandoverPatches* patches) const override
+    {
+        return std::unique_ptr<ParentNode>(new StringNode<Like>(*this, patches));
+    }
+
+    StringNode(const StringNode& from, QueryNodeHandoverPatches* patches)
+        : StringNodeBase(from, patches)
+        , m_pattern(from.m_pattern)
+    {
+    }
+
+protected:
+    LikePattern m_pattern;
+};
+
+template <>
+class StringNode<LikeIns> : public StringNodeBase {
+public:
+    StringNode(StringData v, size_t column)
+        : StringNodeBase(v, column)
+    {
+        if (v.is_null())
+            return;
+
+        auto upper = case_map(v, true);
+        auto lower = case_map(v, false);
+        if (!upper || !lower) {
+            error_code = "Malformed UTF-8: " + std::string(v);
+        }
+        else {
+            m_pattern = LikePattern(*upper, *lower);
+        }
+    }
+
+    void init() override
+    {
+        clear_leaf_state();
+
+        m_dD = 100.0;
+
+        StringNodeBase::init();
+    }
+
+    size_t find_first_local(size_t start, size_t end) override
+    {
+        for (size_t s = start; s < end; ++s) {
+            StringData t = get_string(s);
+
+            if (m_pattern.matches(t))
+                return s;
+        }
+        return not_found;
+    }
+
+    virtual std::string describe_condition() const override
+    {
+        return LikeIns::description();
+    }
+
+    std::unique_ptr<ParentNode> clone(QueryNodeHandoverPatches* patches) const override
+    {
+        return std::unique_ptr<ParentNode>(new StringNode<LikeIns>(*this, patches));
+    }
+
+    StringNode(const StringNode& from, QueryNodeHandoverPatches* patches)
+        : StringNodeBase(from, patches)
+        , m_pattern(from.m_pattern)
+    {
+    }
+
+protected:
+    LikePattern m_pattern;
+};
+
 class StringNodeEqualBase : public StringNodeBase {
 public:
     StringNodeEqualBase(StringData v, size_t column)
@@ -1822,6 +2122,7 @@ public:
     void deallocate() noexcept;
     void init() override;
     size_t find_first_local(size_t start, size_t end) override;
+    bool collect_local_matches(RowBitmap& matches) override;
 
     virtual std::string describe_condition() const override
     {
@@ -2009,6 +2310,7 @@ public:
         combine_conditions<StringNode<Equal>>();
         combine_conditions<IntegerNode<IntegerColumn, Equal>>();
         combine_conditions<IntegerNode<IntNullColumn, Equal>>();
+        combine_conditions<TimestampNode<Equal>>();
 
         m_start.clear();
         m_start.resize(m_conditions.size(), 0);
@@ -2025,6 +2327,39 @@ public:
             v.clear();
             condition->gather_children(v);
         }
+
+        // When every alternative can be answered from an index, the union is computed once
+        // instead of probing each condition row by row.
+        m_matches_bitmap.reset();
+        if (m_conditions.size() > 1) {
+            auto bitmap = std::make_unique<RowBitmap>();
+            RowBitmap condition_matches;
+            bool all_collected = true;
+            for (auto& condition : m_conditions) {
+                if (!condition->collect_matches(condition_matches)) {
+                    all_collected = false;
+                    break;
+                }
+                *bitmap |= condition_matches;
+            }
+            if (all_collected)
+                m_matches_bitmap = std::move(bitmap);
+        }
+        m_dT = m_matches_bitmap ? 0.0 : 50.0;
+    }
+
+    bool collect_local_matches(RowBitmap& matches) override
+    {
+        if (!m_matches_bitmap)
+            return false;
+        matches |= *m_matches_bitmap;
+        return true;
+    }
+
+    bool local_depends_only_on_own_row() const override
+    {
+        return std::all_of(m_conditions.begin(), m_conditions.end(),
+                           [](auto& condition) { return condition->depends_only_on_own_row(); });
     }
 
     size_t find_first_local(size_t start, size_t end) override
@@ -2032,6 +2367,9 @@ public:
         if (start >= end)
             return not_found;
 
+        if (m_matches_bitmap)
+            return m_matches_bitmap->find_first(start, end);
+
         size_t index = not_found;
 
         for (size_t c = 0; c < m_conditions.size(); ++c) {
@@ -2103,6 +2441,7 @@ private:
     void combine_conditions() {
         QueryNodeType* first_match = nullptr;
         QueryNodeType* advance = nullptr;
+        bool consumed_any = false;
         auto it = m_conditions.begin();
         while (it != m_conditions.end()) {
             // Only try to optimize on QueryNodeType conditions without search index
@@ -2115,11 +2454,12 @@ private:
                     auto next_node = next->get();
                     if ((advance = dynamic_cast<QueryNodeType*>(next_node)) && next_node->m_child == nullptr) {
                         first_match->consume_condition(advance);
-                        next = m_conditions.erase(next);
-                    }
-                    else {
-                        ++next;
+                        // Consumed conditions are removed in one pass below, as erasing them one at a time is
+                        // quadratic in the length of long OR chains
+                        next->reset();
+                        consumed_any = true;
                     }
+                    ++next;
                 }
                 it = next;
             }
@@ -2127,8 +2467,13 @@ private:
                 ++it;
             }
         }
+        if (consumed_any) {
+            m_conditions.erase(std::remove(m_conditions.begin(), m_conditions.end(), nullptr), m_conditions.end());
+        }
     }
 
+    std::unique_ptr<RowBitmap> m_matches_bitmap;
+
     // start index of the last find for each cond
     std::vector<size_t> m_start;
     // last looked at index of the lasft find for each cond
@@ -2172,10 +2517,32 @@ public:
         m_known_range_start = 0;
         m_known_range_end = 0;
         m_first_in_known_range = not_found;
+
+        // If the negated condition is answered by an index, its complement is computed once
+        m_matches_bitmap.reset();
+        auto bitmap = std::make_unique<RowBitmap>();
+        if (m_condition->collect_matches(*bitmap)) {
+            bitmap->complement(m_table->size());
+            m_matches_bitmap = std::move(bitmap);
+        }
+        m_dT = m_matches_bitmap ? 0.0 : 50.0;
     }
 
     size_t find_first_local(size_t start, size_t end) override;
 
+    bool collect_local_matches(RowBitmap& matches) override
+    {
+        if (!m_matches_bitmap)
+            return false;
+        matches |= *m_matches_bitmap;
+        return true;
+    }
+
+    bool local_depends_only_on_own_row() const override
+    {
+        return m_condition->depends_only_on_own_row();
+    }
+
     std::string validate() override
     {
         if (error_code != "")
@@ -2229,6 +2596,7 @@ private:
     size_t m_known_range_start;
     size_t m_known_range_end;
     size_t m_first_in_known_range;
+    std::unique_ptr<RowBitmap> m_matches_bitmap;
 
     bool evaluate_at(size_t rowndx);
     void update_known(size_t start, size_t end, size_t first);
@@ -2381,6 +2749,12 @@ public:
     void table_changed() override;
     void verify_column() const override;
 
+    // Expressions may follow links, which is not tracked
+    bool local_depends_only_on_own_row() const override
+    {
+        return false;
+    }
+
     virtual std::string describe(util::serializer::SerialisationState& state) const override;
 
     std::unique_ptr<ParentNode> clone(QueryNodeHandoverPatches* patches) const override;
@@ -2439,37 +2813,38 @@ public:
         return "links to";
     }
 
-
-    size_t find_first_local(size_t start, size_t end) override
+    void init() override
     {
-        REALM_ASSERT(m_column);
-        if (m_column_type == type_Link) {
-            LinkColumn& cl = static_cast<LinkColumn&>(*m_column);
-            for (auto& row : m_target_rows) {
-                if (row.is_attached()) {
-                    // LinkColumn stores link to row N as the integer N + 1
-                    auto pos = cl.find_first(row.get_index() + 1, start, end);
-                    if (pos != realm::npos) {
-                        return pos;
-                    }
-                }
-            }
-        }
-        else if (m_column_type == type_LinkList) {
-            LinkListColumn& cll = static_cast<LinkListColumn&>(*m_column);
+        ParentNode::init();
 
-            for (size_t i = start; i < end; i++) {
-                LinkViewRef lv = cll.get(i);
-                for (auto& row : m_target_rows) {
-                    if (row.is_attached()) {
-                        if (lv->find(row.get_index()) != not_found)
-                            return i;
-                    }
-                }
+        // The origin rows are found directly through the backlinks of the targets. The column index is
+        // taken from the accessor as columns may have been inserted since the query was built.
+        m_dT = 0.0;
+        m_matches_bitmap.clear();
+        size_t origin_col = m_column->get_column_index();
+        for (auto& row : m_target_rows) {
+            if (row.is_attached()) {
+                size_t count = row.get_backlink_count(*m_table, origin_col);
+                for (size_t i = 0; i < count; ++i)
+                    m_matches_bitmap.add(row.get_backlink(*m_table, origin_col, i));
             }
         }
+    }
 
-        return not_found;
+    bool collect_local_matches(RowBitmap& matches) override
+    {
+        matches |= m_matches_bitmap;
+        return true;
+    }
+
+    bool local_depends_only_on_own_row() const override
+    {
+        return false;
+    }
+
+    size_t find_first_local(size_t start, size_t end) override
+    {
+        return m_matches_bitmap.find_first(start, end);
     }
 
     std::unique_ptr<ParentNode> clone(QueryNodeHandoverPatches* patches) const override
@@ -2501,6 +2876,7 @@ private:
     std::vector<ConstRow> m_target_rows;
     LinkColumnBase* m_column = nullptr;
     DataType m_column_type;
+    RowBitmap m_matches_bitmap;
 
     LinksToNode(const LinksToNode& source, QueryNodeHandoverPatches* patches)
         : ParentNode(source, patches)
@@ -19,6 +19,8 @@
 #include <realm/query_expression.hpp>
 #include <realm/group.hpp>
 
+#include <algorithm>
+
 namespace realm {
 
 std::vector<size_t> LinkMap::get_origin_ndxs(size_t index, size_t column) const
@@ -28,7 +30,8 @@ std::vector<size_t> LinkMap::get_origin_ndxs(size_t index, size_t column) const
     }
     std::vector<size_t> ndxs = get_origin_ndxs(index, column + 1);
     std::vector<size_t> ret;
-    auto origin_col = m_link_column_indexes[column];
+    // The stored index may be stale if columns have been inserted or removed since the query was built
+    auto origin_col = m_link_columns[column]->get_column_index();
     auto origin = m_tables[column];
     auto link_type = m_link_types[column];
     if (link_type == col_type_BackLink) {
@@ -63,6 +66,39 @@ std::vector<size_t> LinkMap::get_origin_ndxs(size_t index, size_t column) const
     return ret;
 }
 
+bool LinkMap::prefer_reverse_traversal(const Expression& target_condition) const
+{
+    const size_t origin_size = base_table()->size();
+    const size_t target_size = target_table()->size();
+    if (target_size == 0)
+        return true;
+
+    // Estimate the selectivity of the condition from a few windows spread evenly over the target table
+    const size_t window_size = 256;
+    const size_t step = std::max(target_size / 4, window_size);
+    size_t sampled = 0;
+    size_t matches = 0;
+    for (size_t begin = 0; begin < target_size; begin += step) {
+        size_t end = std::min(begin + window_size, target_size);
+        size_t ndx = target_condition.find_first(begin, end);
+        while (ndx != not_found) {
+            ++matches;
+            ndx = target_condition.find_first(ndx + 1, end);
+        }
+        sampled += end - begin;
+    }
+
+    // Going forward, every row of the base table follows every link of the path. Going in reverse, the target table
+    // is scanned once without following any links, which is considerably cheaper per row, after which the backlinks
+    // of each match are followed. Walking backlinks allocates, so it is weighted as more expensive.
+    const double hops = double(m_link_columns.size());
+    const double selectivity = double(matches) / double(sampled);
+    const double fan_in = std::max(1.0, double(origin_size) / double(target_size));
+    const double forward_cost = double(origin_size) * hops;
+    const double reverse_cost = double(target_size) / 2 + 2 * selectivity * double(target_size) * fan_in * hops;
+    return reverse_cost < forward_cost;
+}
+
 void Columns<Link>::evaluate(size_t index, ValueBase& destination)
 {
     std::vector<size_t> links = m_link_map.get_links(index);
@@ -404,6 +404,8 @@ std::unique_ptr<Expression> make_expression(Args&&... args)
     return std::unique_ptr<Expression>(new T(std::forward<Args>(args)...));
 }
 
+class LinkMap;
+
 class Subexpr {
 public:
     virtual ~Subexpr()
@@ -452,6 +454,21 @@ public:
         return {};
     }
 
+    // The link path followed to reach the column read by this expression, or nullptr if the expression does not
+    // read a column through links.
+    virtual const LinkMap* get_link_path() const
+    {
+        return nullptr;
+    }
+
+    // A copy of this expression which reads the same column directly from the target table of its link path, or
+    // nullptr if that is not supported. Used by Compare to evaluate a condition on the target table first and then
+    // walk the backlinks of the matches, see Compare::init_reverse_traversal().
+    virtual std::unique_ptr<Subexpr> clone_for_target_table() const
+    {
+        return nullptr;
+    }
+
     virtual void evaluate(size_t index, ValueBase& destination) = 0;
 };
 
@@ -1947,6 +1964,11 @@ public:
 
     std::vector<size_t> get_origin_ndxs(size_t index, size_t column = 0) const;
 
+    // Estimate whether it is cheaper to evaluate `target_condition` (which must be bound to the target table) over
+    // the whole target table and follow the backlinks of the matching rows, than to follow the links forward from
+    // every row of the base table.
+    bool prefer_reverse_traversal(const Expression& target_condition) const;
+
     size_t count_links(size_t row)
     {
         CountLinks counter;
@@ -2114,6 +2136,16 @@ public:
         return m_link_map.target_table()->has_search_index(m_column_ndx);
     }
 
+    const LinkMap* get_link_path() const override
+    {
+        return links_exist() ? &m_link_map : nullptr;
+    }
+
+    std::unique_ptr<Subexpr> clone_for_target_table() const override
+    {
+        return make_subexpr<Columns<T>>(column_ndx(), m_link_map.target_table());
+    }
+
     std::vector<size_t> find_all(util::Optional<Mixed> value) const override
     {
         std::vector<size_t> ret;
@@ -3227,6 +3259,16 @@ public:
         return m_link_map.target_table()->has_search_index(m_column_ndx);
     }
 
+    const LinkMap* get_link_path() const override
+    {
+        return links_exist() ? &m_link_map : nullptr;
+    }
+
+    std::unique_ptr<Subexpr> clone_for_target_table() const override
+    {
+        return make_subexpr<Columns<T>>(column_ndx(), m_link_map.target_table());
+    }
+
     std::vector<size_t> find_all(util::Optional<Mixed> value) const override
     {
         std::vector<size_t> ret;
@@ -3997,6 +4039,9 @@ public:
     double init() override
     {
         double dT = m_left_is_const ? 10.0 : 50.0;
+        // Which strategy is cheapest may change between runs of the same query
+        m_has_matches = false;
+        m_index_last_start = 0;
         if (std::is_same<TCond, Equal>::value && m_left_is_const && m_right->has_search_index()) {
             if (m_left_value.m_storage.is_null(0)) {
                 m_matches = m_right->find_all(util::Optional<Mixed>());
@@ -4014,6 +4059,15 @@ public:
             m_index_end = m_matches.size();
             dT = 0;
         }
+        else if (m_left_is_const && init_reverse_traversal()) {
+            std::sort(m_matches.begin(), m_matches.end());
+            m_matches.erase(std::unique(m_matches.begin(), m_matches.end()), m_matches.end());
+
+            m_has_matches = true;
+            m_index_get = 0;
+            m_index_end = m_matches.size();
+            dT = 0;
+        }
 
         return dT;
     }
@@ -4130,6 +4184,44 @@ private:
         }
     }
 
+    // A semi-join for a condition on a column behind links: the condition is evaluated on the target table of the
+    // link path, and the backlinks of the matching rows are followed back to the base table. The resulting rows are
+    // placed in m_matches. This is only done when a missing link (which evaluates to null) can not satisfy the
+    // condition, and when LinkMap::prefer_reverse_traversal() estimates it to be cheaper than the forward direction.
+    bool init_reverse_traversal()
+    {
+        const LinkMap* link_map = m_right->get_link_path();
+        if (!link_map)
+            return false;
+
+        Value<T> null_value;
+        null_value.init(false, 1);
+        null_value.m_storage.set_null(0);
+        if (Value<T>::template compare_const<TCond>(&m_left_value, &null_value) != not_found)
+            return false;
+
+        std::unique_ptr<Subexpr> target_column = m_right->clone_for_target_table();
+        if (!target_column)
+            return false;
+
+        const Table* target_table = link_map->target_table();
+        Compare target_condition(m_left->clone(), std::move(target_column));
+        target_condition.set_base_table(target_table);
+        target_condition.init();
+        if (!link_map->prefer_reverse_traversal(target_condition))
+            return false;
+
+        m_matches.clear();
+        size_t target_size = target_table->size();
+        size_t target_ndx = target_condition.find_first(0, target_size);
+        while (target_ndx != not_found) {
+            auto ndxs = link_map->get_origin_ndxs(target_ndx);
+            m_matches.insert(m_matches.end(), ndxs.begin(), ndxs.end());
+            target_ndx = target_condition.find_first(target_ndx + 1, target_size);
+        }
+        return true;
+    }
+
     std::unique_ptr<TLeft> m_left;
     std::unique_ptr<TRight> m_right;
     bool m_left_is_const;
@@ -567,6 +567,12 @@ public:
         return true;
     }
 
+    bool refresh_table()
+    {
+        // Nothing changed in the contents of the table
+        return true;
+    }
+
     bool optimize_table()
     {
         if (REALM_LIKELY(REALM_COVER_ALWAYS(m_table && m_table->is_attached()))) {
@@ -0,0 +1,393 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <algorithm>
+#include <iterator>
+
+#include <realm/row_bitmap.hpp>
+#include <realm/column.hpp>
+#include <realm/utilities.hpp>
+
+using namespace realm;
+
+
+bool RowBitmap::Chunk::contains(size_t offset) const noexcept
+{
+    if (is_dense())
+        return (dense[offset / 64] >> (offset % 64)) & 1;
+    return std::binary_search(sparse.begin(), sparse.end(), uint16_t(offset));
+}
+
+size_t RowBitmap::Chunk::find_first(size_t offset) const noexcept
+{
+    if (is_dense()) {
+        size_t w = offset / 64;
+        uint64_t word = dense[w] & (~uint64_t(0) << (offset % 64));
+        for (;;) {
+            if (word)
+                return w * 64 + lowest_bit(word);
+            if (++w == s_words_per_chunk)
+                return npos;
+            word = dense[w];
+        }
+    }
+    auto it = std::lower_bound(sparse.begin(), sparse.end(), uint16_t(offset));
+    return it == sparse.end() ? npos : size_t(*it);
+}
+
+void RowBitmap::Chunk::make_dense()
+{
+    if (is_dense())
+        return;
+    dense.assign(s_words_per_chunk, 0);
+    for (auto offset : sparse)
+        dense[offset / 64] |= uint64_t(1) << (offset % 64);
+    sparse.clear();
+    sparse.shrink_to_fit();
+}
+
+void RowBitmap::Chunk::make_sparse_if_small()
+{
+    if (!is_dense() || count > s_max_sparse)
+        return;
+    sparse.clear();
+    sparse.reserve(count);
+    for (size_t w = 0; w < s_words_per_chunk; ++w) {
+        uint64_t word = dense[w];
+        while (word) {
+            sparse.push_back(uint16_t(w * 64 + lowest_bit(word)));
+            word &= word - 1;
+        }
+    }
+    dense.clear();
+    dense.shrink_to_fit();
+}
+
+void RowBitmap::Chunk::recount() noexcept
+{
+    if (!is_dense()) {
+        count = sparse.size();
+        return;
+    }
+    size_t n = 0;
+    for (size_t w = 0; w < s_words_per_chunk; ++w)
+        n += size_t(fast_popcount64(int64_t(dense[w])));
+    count = n;
+}
+
+void RowBitmap::add(size_t row)
+{
+    size_t key = row >> s_chunk_bits;
+    auto offset = uint16_t(row & s_chunk_mask);
+
+    // Fast path for ascending insertion, which is the order index lookups produce
+    auto it = m_chunks.end();
+    if (m_chunks.empty() || m_chunks.back().key < key) {
+        m_chunks.emplace_back();
+        m_chunks.back().key = key;
+        it = m_chunks.end() - 1;
+    }
+    else if (m_chunks.back().key == key) {
+        it = m_chunks.end() - 1;
+    }
+    else {
+        it = std::lower_bound(m_chunks.begin(), m_chunks.end(), key,
+                              [](const Chunk& c, size_t k) { return c.key < k; });
+        if (it == m_chunks.end() || it->key != key) {
+            it = m_chunks.emplace(it);
+            it->key = key;
+        }
+    }
+
+    Chunk& chunk = *it;
+    if (chunk.is_dense()) {
+        uint64_t& word = chunk.dense[offset / 64];
+        uint64_t bit = uint64_t(1) << (offset % 64);
+        if (!(word & bit)) {
+            word |= bit;
+            ++chunk.count;
+        }
+        return;
+    }
+    if (chunk.sparse.empty() || chunk.sparse.back() < offset) {
+        chunk.sparse.push_back(offset);
+    }
+    else {
+        auto pos = std::lower_bound(chunk.sparse.begin(), chunk.sparse.end(), offset);
+        if (*pos == offset)
+            return;
+        chunk.sparse.insert(pos, offset);
+    }
+    if (++chunk.count > s_max_sparse)
+        chunk.make_dense();
+}
+
+void RowBitmap::add_all(const IntegerColumn& rows, size_t begin, size_t end)
+{
+    if (end == npos)
+        end = rows.size();
+    for (size_t i = begin; i < end; ++i)
+        add(to_size_t(rows.get(i)));
+}
+
+bool RowBitmap::contains(size_t row) const noexcept
+{
+    size_t key = row >> s_chunk_bits;
+    auto it = std::lower_bound(m_chunks.begin(), m_chunks.end(), key,
+                               [](const Chunk& c, size_t k) { return c.key < k; });
+    return it != m_chunks.end() && it->key == key && it->contains(row & s_chunk_mask);
+}
+
+size_t RowBitmap::find_first(size_t begin, size_t end) const noexcept
+{
+    if (begin >= end)
+        return not_found;
+    size_t key = begin >> s_chunk_bits;
+    auto it = std::lower_bound(m_chunks.begin(), m_chunks.end(), key,
+                               [](const Chunk& c, size_t k) { return c.key < k; });
+    for (; it != m_chunks.end(); ++it) {
+        size_t base = it->key << s_chunk_bits;
+        if (base >= end)
+            break;
+        size_t offset = it->key == key ? begin & s_chunk_mask : 0;
+        size_t found = it->find_first(offset);
+        if (found != npos)
+            return base + found < end ? base + found : not_found;
+    }
+    return not_found;
+}
+
+size_t RowBitmap::size() const noexcept
+{
+    size_t n = 0;
+    for (auto& chunk : m_chunks)
+        n += chunk.count;
+    return n;
+}
+
+RowBitmap::Chunk RowBitmap::chunk_or(const Chunk& a, const Chunk& b)
+{
+    Chunk result;
+    result.key = a.key;
+    if (!a.is_dense() && !b.is_dense()) {
+        result.sparse.reserve(a.sparse.size() + b.sparse.size());
+        std::set_union(a.sparse.begin(), a.sparse.end(), b.sparse.begin(), b.sparse.end(),
+                       std::back_inserter(result.sparse));
+        result.count = result.sparse.size();
+        if (result.count > s_max_sparse)
+            result.make_dense();
+        return result;
+    }
+    const Chunk& d = a.is_dense() ? a : b;
+    const Chunk& other = a.is_dense() ? b : a;
+    result.dense = d.dense;
+    if (other.is_dense()) {
+        for (size_t w = 0; w < s_words_per_chunk; ++w)
+            result.dense[w] |= other.dense[w];
+    }
+    else {
+        for (auto offset : other.sparse)
+            result.dense[offset / 64] |= uint64_t(1) << (offset % 64);
+    }
+    result.recount();
+    return result;
+}
+
+RowBitmap::Chunk RowBitmap::chunk_and(const Chunk& a, const Chunk& b)
+{
+    Chunk result;
+    result.key = a.key;
+    if (a.is_dense() && b.is_dense()) {
+        result.dense.resize(s_words_per_chunk);
+        for (size_t w = 0; w < s_words_per_chunk; ++w)
+            result.dense[w] = a.dense[w] & b.dense[w];
+        result.recount();
+        result.make_sparse_if_small();
+        return result;
+    }
+    if (!a.is_dense() && !b.is_dense()) {
+        std::set_intersection(a.sparse.begin(), a.sparse.end(), b.sparse.begin(), b.sparse.end(),
+                              std::back_inserter(result.sparse));
+    }
+    else {
+        const Chunk& s = a.is_dense() ? b : a;
+        const Chunk& d = a.is_dense() ? a : b;
+        for (auto offset : s.sparse) {
+            if (d.contains(offset))
+                result.sparse.push_back(offset);
+        }
+    }
+    result.count = result.sparse.size();
+    return result;
+}
+
+RowBitmap::Chunk RowBitmap::chunk_and_not(const Chunk& a, const Chunk& b)
+{
+    Chunk result;
+    result.key = a.key;
+    if (a.is_dense()) {
+        result.dense = a.dense;
+        if (b.is_dense()) {
+            for (size_t w = 0; w < s_words_per_chunk; ++w)
+                result.dense[w] &= ~b.dense[w];
+        }
+        else {
+            for (auto offset : b.sparse)
+                result.dense[offset / 64] &= ~(uint64_t(1) << (offset % 64));
+        }
+        result.recount();
+        result.make_sparse_if_small();
+        return result;
+    }
+    if (b.is_dense()) {
+        for (auto offset : a.sparse) {
+            if (!b.contains(offset))
+                result.sparse.push_back(offset);
+        }
+    }
+    else {
+        std::set_difference(a.sparse.begin(), a.sparse.end(), b.sparse.begin(), b.sparse.end(),
+                            std::back_inserter(result.sparse));
+    }
+    result.count = result.sparse.size();
+    return result;
+}
+
+RowBitmap& RowBitmap::operator|=(const RowBitmap& other)
+{
+    std::vector<Chunk> result;
+    result.reserve(m_chunks.size() + other.m_chunks.size());
+    auto a = m_chunks.begin();
+    auto b = other.m_chunks.begin();
+    while (a != m_chunks.end() || b != other.m_chunks.end()) {
+        if (b == other.m_chunks.end() || (a != m_chunks.end() && a->key < b->key)) {
+            result.push_back(std::move(*a++));
+        }
+        else if (a == m_chunks.end() || b->key < a->key) {
+            result.push_back(*b++);
+        }
+        else {
+            result.push_back(chunk_or(*a++, *b++));
+        }
+    }
+    m_chunks = std::move(result);
+    return *this;
+}
+
+RowBitmap& RowBitmap::operator&=(const RowBitmap& other)
+{
+    std::vector<Chunk> result;
+    auto a = m_chunks.begin();
+    auto b = other.m_chunks.begin();
+    while (a != m_chunks.end() && b != other.m_chunks.end()) {
+        if (a->key < b->key) {
+            ++a;
+        }
+        else if (b->key < a->key) {
+            ++b;
+        }
+        else {
+            Chunk c = chunk_and(*a++, *b++);
+            if (c.count)
+                result.push_back(std::move(c));
+        }
+    }
+    m_chunks = std::move(result);
+    return *this;
+}
+
+RowBitmap& RowBitmap::operator-=(const RowBitmap& other)
+{
+    std::vector<Chunk> result;
+    result.reserve(m_chunks.size());
+    auto b = other.m_chunks.begin();
+    for (auto a = m_chunks.begin(); a != m_chunks.end(); ++a) {
+        while (b != other.m_chunks.end() && b->key < a->key)
+            ++b;
+        if (b == other.m_chunks.end() || b->key != a->key) {
+            result.push_back(std::move(*a));
+            continue;
+        }
+        Chunk c = chunk_and_not(*a, *b);
+        if (c.count)
+            result.push_back(std::move(c));
+    }
+    m_chunks = std::move(result);
+    return *this;
+}
+
+void RowBitmap::complement(size_t row_count)
+{
+    std::vector<Chunk> result;
+    size_t num_chunks = (row_count + s_chunk_size - 1) >> s_chunk_bits;
+    auto it = m_chunks.begin();
+    for (size_t key = 0; key < num_chunks; ++key) {
+        Chunk c;
+        c.key = key;
+        if (it != m_chunks.end() && it->key == key) {
+            c = std::move(*it++);
+            c.make_dense();
+            for (auto& word : c.dense)
+                word = ~word;
+        }
+        else {
+            c.dense.assign(s_words_per_chunk, ~uint64_t(0));
+        }
+        // Clear the bits past the end of the row range in the last chunk
+        size_t rows_in_chunk = row_count - (key << s_chunk_bits);
+        if (rows_in_chunk > s_chunk_size)
+            rows_in_chunk = s_chunk_size;
+        if (rows_in_chunk < s_chunk_size) {
+            size_t w = rows_in_chunk / 64;
+            if (rows_in_chunk % 64)
+                c.dense[w++] &= ~(~uint64_t(0) << (rows_in_chunk % 64));
+            std::fill(c.dense.begin() + w, c.dense.end(), 0);
+        }
+        c.recount();
+        if (c.count) {
+            c.make_sparse_if_small();
+            result.push_back(std::move(c));
+        }
+    }
+    m_chunks = std::move(result);
+}
+
+bool RowBitmap::operator==(const RowBitmap& other) const noexcept
+{
+    if (m_chunks.size() != other.m_chunks.size())
+        return false;
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+        const Chunk& a = m_chunks[i];
+        const Chunk& b = other.m_chunks[i];
+        if (a.key != b.key || a.count != b.count)
+            return false;
+        if (a.is_dense() == b.is_dense()) {
+            if (a.is_dense() ? a.dense != b.dense : a.sparse != b.sparse)
+                return false;
+        }
+        else {
+            const Chunk& s = a.is_dense() ? b : a;
+            const Chunk& d = a.is_dense() ? a : b;
+            for (auto offset : s.sparse) {
+                if (!d.contains(offset))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
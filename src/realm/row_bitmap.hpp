@@ -0,0 +1,162 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_ROW_BITMAP_HPP
+#define REALM_ROW_BITMAP_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <realm/array.hpp>
+#include <realm/column_fwd.hpp>
+
+namespace realm {
+
+/// A compressed set of row indexes.
+///
+/// The layout follows the Roaring bitmap scheme: the row space is divided into
+/// chunks of 2^16 rows, and every non-empty chunk is stored either as a sorted
+/// array of 16-bit offsets (when it holds few rows) or as a plain 8 KiB bitset
+/// (when it holds many). Set operations are performed chunk by chunk; dense
+/// chunks are combined a 64-bit word at a time in straight loops that the
+/// compiler is free to vectorize.
+///
+/// The query engine uses this to combine results of index lookups (see
+/// ParentNode::collect_matches()) without probing the conditions row by row.
+class RowBitmap {
+public:
+    RowBitmap() = default;
+
+    /// Insert `row`. Insertion in ascending order is amortized constant time.
+    void add(size_t row);
+
+    /// Insert every row index stored in `rows`, which is typically the result
+    /// of a search index lookup.
+    void add_all(const IntegerColumn& rows, size_t begin = 0, size_t end = npos);
+
+    bool contains(size_t row) const noexcept;
+
+    /// Returns the lowest row in [begin, end) that is in the set, or
+    /// `realm::not_found` if there is none.
+    size_t find_first(size_t begin = 0, size_t end = npos) const noexcept;
+
+    /// The number of rows in the set
+    size_t size() const noexcept;
+
+    bool empty() const noexcept
+    {
+        return m_chunks.empty();
+    }
+
+    void clear() noexcept
+    {
+        m_chunks.clear();
+    }
+
+    RowBitmap& operator|=(const RowBitmap&);
+    RowBitmap& operator&=(const RowBitmap&);
+    RowBitmap& operator-=(const RowBitmap&);
+
+    /// Replace the set with all rows in [0, row_count) that are not currently
+    /// members of it. Members at or beyond `row_count` are dropped.
+    void complement(size_t row_count);
+
+    /// Call `fn(row)` for every member in ascending order
+    template <class F>
+    void for_each(F fn) const;
+
+    bool operator==(const RowBitmap&) const noexcept;
+    bool operator!=(const RowBitmap& other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+private:
+    static const size_t s_chunk_bits = 16;
+    static const size_t s_chunk_size = size_t(1) << s_chunk_bits;
+    static const size_t s_chunk_mask = s_chunk_size - 1;
+    static const size_t s_words_per_chunk = s_chunk_size / 64;
+    // Above this many members a chunk is smaller as a bitset than as an array
+    static const size_t s_max_sparse = 4096;
+
+    struct Chunk {
+        size_t key = 0; // row >> s_chunk_bits
+        size_t count = 0;
+        std::vector<uint16_t> sparse; // sorted, only used when `dense` is empty
+        std::vector<uint64_t> dense;  // s_words_per_chunk words when in use
+
+        bool is_dense() const noexcept
+        {
+            return !dense.empty();
+        }
+        bool contains(size_t offset) const noexcept;
+        size_t find_first(size_t offset) const noexcept;
+        void make_dense();
+        void make_sparse_if_small();
+        void recount() noexcept;
+    };
+
+    std::vector<Chunk> m_chunks; // ordered by key
+
+    // Index of the least significant set bit, `word` must be non-zero
+    static size_t lowest_bit(uint64_t word) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return size_t(__builtin_ctzll(word));
+#else
+        size_t bit = 0;
+        while (!(word & 1)) {
+            word >>= 1;
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    static Chunk chunk_or(const Chunk&, const Chunk&);
+    static Chunk chunk_and(const Chunk&, const Chunk&);
+    static Chunk chunk_and_not(const Chunk&, const Chunk&);
+};
+
+
+// Implementation:
+
+template <class F>
+void RowBitmap::for_each(F fn) const
+{
+    for (auto& chunk : m_chunks) {
+        size_t base = chunk.key << s_chunk_bits;
+        if (chunk.is_dense()) {
+            for (size_t w = 0; w < s_words_per_chunk; ++w) {
+                uint64_t word = chunk.dense[w];
+                while (word) {
+                    fn(base + w * 64 + lowest_bit(word));
+                    word &= word - 1;
+                }
+            }
+        }
+        else {
+            for (auto offset : chunk.sparse)
+                fn(base + offset);
+        }
+    }
+}
+
+} // namespace realm
+
+#endif // REALM_ROW_BITMAP_HPP
@@ -3526,6 +3526,111 @@ void Table::set(size_t col_ndx, size_t row_ndx, util::Optional<double> value, bo
         set(col_ndx, row_ndx, null(), is_default);
 }
 
+void Table::do_set_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const int64_t* values, size_t num_values)
+{
+    REALM_ASSERT_3(col_ndx, <, get_column_count());
+    REALM_ASSERT_3(get_real_column_type(col_ndx), ==, col_type_Int);
+    REALM_ASSERT_3(row_ndx, <=, m_size);
+    REALM_ASSERT_3(num_rows, <=, m_size - row_ndx);
+    if (num_rows == 0)
+        return;
+    bump_version();
+
+    for (size_t i = 0; i < num_rows; ++i) {
+        int64_t value = values[num_values == 1 ? 0 : i];
+        if (is_nullable(col_ndx)) {
+            get_column_int_null(col_ndx).set(row_ndx + i, value);
+        }
+        else {
+            get_column(col_ndx).set(row_ndx + i, value);
+        }
+    }
+
+    if (Replication* repl = get_repl())
+        repl->set_int_range(this, col_ndx, row_ndx, num_rows, values, num_values); // Throws
+}
+
+void Table::do_set_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const bool* values, size_t num_values)
+{
+    REALM_ASSERT_3(col_ndx, <, get_column_count());
+    REALM_ASSERT_3(get_real_column_type(col_ndx), ==, col_type_Bool);
+    REALM_ASSERT_3(row_ndx, <=, m_size);
+    REALM_ASSERT_3(num_rows, <=, m_size - row_ndx);
+    if (num_rows == 0)
+        return;
+    bump_version();
+
+    for (size_t i = 0; i < num_rows; ++i) {
+        int64_t value = values[num_values == 1 ? 0 : i] ? 1 : 0;
+        if (is_nullable(col_ndx)) {
+            get_column_int_null(col_ndx).set(row_ndx + i, value);
+        }
+        else {
+            get_column(col_ndx).set(row_ndx + i, value);
+        }
+    }
+
+    if (Replication* repl = get_repl())
+        repl->set_bool_range(this, col_ndx, row_ndx, num_rows, values, num_values); // Throws
+}
+
+void Table::do_set_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const float* values, size_t num_values)
+{
+    REALM_ASSERT_3(col_ndx, <, get_column_count());
+    REALM_ASSERT_3(get_real_column_type(col_ndx), ==, col_type_Float);
+    REALM_ASSERT_3(row_ndx, <=, m_size);
+    REALM_ASSERT_3(num_rows, <=, m_size - row_ndx);
+    if (num_rows == 0)
+        return;
+    bump_version();
+
+    FloatColumn& col = get_column_float(col_ndx);
+    for (size_t i = 0; i < num_rows; ++i)
+        col.set(row_ndx + i, values[num_values == 1 ? 0 : i]);
+
+    if (Replication* repl = get_repl())
+        repl->set_float_range(this, col_ndx, row_ndx, num_rows, values, num_values); // Throws
+}
+
+void Table::do_set_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const double* values, size_t num_values)
+{
+    REALM_ASSERT_3(col_ndx, <, get_column_count());
+    REALM_ASSERT_3(get_real_column_type(col_ndx), ==, col_type_Double);
+    REALM_ASSERT_3(row_ndx, <=, m_size);
+    REALM_ASSERT_3(num_rows, <=, m_size - row_ndx);
+    if (num_rows == 0)
+        return;
+    bump_version();
+
+    DoubleColumn& col = get_column_double(col_ndx);
+    for (size_t i = 0; i < num_rows; ++i)
+        col.set(row_ndx + i, values[num_values == 1 ? 0 : i]);
+
+    if (Replication* repl = get_repl())
+        repl->set_double_range(this, col_ndx, row_ndx, num_rows, values, num_values); // Throws
+}
+
+void Table::do_set_null_range(size_t col_ndx, size_t row_ndx, size_t num_rows)
+{
+    if (!is_nullable(col_ndx)) {
+        throw LogicError{LogicError::column_not_nullable};
+    }
+    REALM_ASSERT_3(col_ndx, <, get_column_count());
+    REALM_ASSERT(!is_link_type(m_spec->get_column_type(col_ndx))); // Use nullify_link().
+    REALM_ASSERT_3(row_ndx, <=, m_size);
+    REALM_ASSERT_3(num_rows, <=, m_size - row_ndx);
+    if (num_rows == 0)
+        return;
+    bump_version();
+
+    ColumnBase& col = get_column_base(col_ndx);
+    for (size_t i = 0; i < num_rows; ++i)
+        col.set_null(row_ndx + i);
+
+    if (Replication* repl = get_repl())
+        repl->set_null_range(this, col_ndx, row_ndx, num_rows); // Throws
+}
+
 } // namespace realm;
 
 
@@ -6140,6 +6245,66 @@ void Table::adj_row_acc_move_over(size_t from_row_ndx, size_t to_row_ndx) noexce
 }
 
 
+void Table::begin_view_change_tracking()
+{
+    LockGuard lock(m_accessor_mutex);
+    m_tracking_view_changes = !m_views.empty();
+    for (auto& view : m_views) {
+        view->begin_change_tracking(); // Throws
+    }
+}
+
+
+void Table::track_changed_row(size_t row_ndx, size_t num_rows) noexcept
+{
+    // This function must assume no more than minimal consistency of the
+    // accessor hierarchy. This means in particular that it cannot access the
+    // underlying node structure. See AccessorConsistencyLevels.
+    if (!m_tracking_view_changes)
+        return;
+    LockGuard lock(m_accessor_mutex);
+    for (auto& view : m_views) {
+        view->track_changed_rows(row_ndx, num_rows);
+    }
+}
+
+
+void Table::discard_view_changes() noexcept
+{
+    LockGuard lock(m_accessor_mutex);
+    m_tracking_view_changes = false;
+    for (auto& view : m_views) {
+        view->discard_tracked_changes();
+    }
+}
+
+
+void Table::end_view_change_tracking() noexcept
+{
+    LockGuard lock(m_accessor_mutex);
+    m_tracking_view_changes = false;
+    for (auto& view : m_views) {
+        view->end_change_tracking();
+    }
+}
+
+
+bool Table::has_row_bound_accessors() const noexcept
+{
+    {
+        LockGuard lock(m_accessor_mutex);
+        // The rows of a view are adjusted too, until it is synced
+        if (m_row_accessors || !m_views.empty())
+            return true;
+    }
+    for (const ColumnBase* col : m_cols) {
+        if (col && col->has_row_bound_accessors())
+            return true;
+    }
+    return false;
+}
+
+
 void Table::adj_insert_column(size_t col_ndx)
 {
     // Beyond the constraints on the specified column index, this function must
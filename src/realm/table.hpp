@@ -558,6 +558,23 @@ public:
     void set_null(size_t column_ndx, size_t row_ndx, bool is_default = false);
     void set_null_unique(size_t col_ndx, size_t row_ndx);
 
+    /// Assign \a num_values consecutive rows, starting at \a row_ndx, the
+    /// specified values, or assign \a value to all rows in [\a begin, \a end).
+    /// The effect is that of calling set() for each row, but the modification
+    /// is recorded as a single instruction in the transaction log, instead of
+    /// one for each row. Available for integer, boolean, float and double
+    /// columns, and for null in any nullable column except links.
+    void set_range(size_t column_ndx, size_t row_ndx, const int64_t* values, size_t num_values);
+    void set_range(size_t column_ndx, size_t row_ndx, const bool* values, size_t num_values);
+    void set_range(size_t column_ndx, size_t row_ndx, const float* values, size_t num_values);
+    void set_range(size_t column_ndx, size_t row_ndx, const double* values, size_t num_values);
+    void fill(size_t column_ndx, size_t begin, size_t end, int value);
+    void fill(size_t column_ndx, size_t begin, size_t end, int64_t value);
+    void fill(size_t column_ndx, size_t begin, size_t end, bool value);
+    void fill(size_t column_ndx, size_t begin, size_t end, float value);
+    void fill(size_t column_ndx, size_t begin, size_t end, double value);
+    void fill(size_t column_ndx, size_t begin, size_t end, null);
+
     // Sync needs to store blobs bigger than 16 M. This function can be used for that. Data should be read
     // out again using the get_binary_at() function. Should not be used for user data as normal get_binary()
     // will just return null if the data is bigger than the limit.
@@ -1086,6 +1103,12 @@ private:
     // Mutex which must be locked any time the row accessor chain or m_views is used
     mutable util::Mutex m_accessor_mutex;
 
+    // Whether there were views to track changes for when
+    // begin_view_change_tracking() was called. Views are only added by the
+    // thread which advances the transaction, so track_changed_row() can skip
+    // locking m_accessor_mutex when there were none.
+    bool m_tracking_view_changes = false;
+
     // Used for queries: Items are added with link() method during buildup of query
     mutable std::vector<size_t> m_link_chain;
 
@@ -1110,6 +1133,13 @@ private:
     size_t do_set_unique_null(ColType& col, size_t ndx, bool& conflict);
     template <class ColType, class T>
     size_t do_set_unique(ColType& column, size_t row_ndx, T&& value, bool& conflict);
+    /// \param num_values Either `num_rows`, or 1 to assign the same value to
+    /// all of the rows.
+    void do_set_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const int64_t* values, size_t num_values);
+    void do_set_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const bool* values, size_t num_values);
+    void do_set_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const float* values, size_t num_values);
+    void do_set_range(size_t col_ndx, size_t row_ndx, size_t num_rows, const double* values, size_t num_values);
+    void do_set_null_range(size_t col_ndx, size_t row_ndx, size_t num_rows);
 
     void _add_search_index(size_t column_ndx);
     void _remove_search_index(size_t column_ndx);
@@ -1526,6 +1556,19 @@ private:
     /// Called by adj_acc_move_over() to adjust row accessors.
     void adj_row_acc_move_over(size_t from_row_ndx, size_t to_row_ndx) noexcept;
 
+    /// Used by Group::advance_transact() to let views be brought up to date
+    /// from the rows changed by the transaction logs, rather than by rerunning
+    /// their queries. See TableViewBase::begin_change_tracking().
+    void begin_view_change_tracking();
+    void track_changed_row(size_t row_ndx, size_t num_rows = 1) noexcept;
+    void discard_view_changes() noexcept;
+    void end_view_change_tracking() noexcept;
+
+    /// Whether an accessor is attached to particular rows of this table: a row
+    /// accessor, a table view, or a subtable or link list accessor. Used by
+    /// Group::refresh_transact(), which cannot move them along with their rows.
+    bool has_row_bound_accessors() const noexcept;
+
     void adj_insert_column(size_t col_ndx);
     void adj_erase_column(size_t col_ndx) noexcept;
 
@@ -2388,6 +2431,61 @@ inline void Table::set_null_unique(size_t col_ndx, size_t ndx)
     set_unique(col_ndx, ndx, null());
 }
 
+inline void Table::set_range(size_t col_ndx, size_t row_ndx, const int64_t* values, size_t num_values)
+{
+    do_set_range(col_ndx, row_ndx, num_values, values, num_values); // Throws
+}
+
+inline void Table::set_range(size_t col_ndx, size_t row_ndx, const bool* values, size_t num_values)
+{
+    do_set_range(col_ndx, row_ndx, num_values, values, num_values); // Throws
+}
+
+inline void Table::set_range(size_t col_ndx, size_t row_ndx, const float* values, size_t num_values)
+{
+    do_set_range(col_ndx, row_ndx, num_values, values, num_values); // Throws
+}
+
+inline void Table::set_range(size_t col_ndx, size_t row_ndx, const double* values, size_t num_values)
+{
+    do_set_range(col_ndx, row_ndx, num_values, values, num_values); // Throws
+}
+
+inline void Table::fill(size_t col_ndx, size_t begin, size_t end, int value)
+{
+    fill(col_ndx, begin, end, int64_t(value)); // Throws
+}
+
+inline void Table::fill(size_t col_ndx, size_t begin, size_t end, int64_t value)
+{
+    REALM_ASSERT_3(begin, <=, end);
+    do_set_range(col_ndx, begin, end - begin, &value, 1); // Throws
+}
+
+inline void Table::fill(size_t col_ndx, size_t begin, size_t end, bool value)
+{
+    REALM_ASSERT_3(begin, <=, end);
+    do_set_range(col_ndx, begin, end - begin, &value, 1); // Throws
+}
+
+inline void Table::fill(size_t col_ndx, size_t begin, size_t end, float value)
+{
+    REALM_ASSERT_3(begin, <=, end);
+    do_set_range(col_ndx, begin, end - begin, &value, 1); // Throws
+}
+
+inline void Table::fill(size_t col_ndx, size_t begin, size_t end, double value)
+{
+    REALM_ASSERT_3(begin, <=, end);
+    do_set_range(col_ndx, begin, end - begin, &value, 1); // Throws
+}
+
+inline void Table::fill(size_t col_ndx, size_t begin, size_t end, null)
+{
+    REALM_ASSERT_3(begin, <=, end);
+    do_set_null_range(col_ndx, begin, end - begin); // Throws
+}
+
 
 // This class groups together information about the target of a link column
 // This is not a valid link if the target table == nullptr
@@ -2682,6 +2780,31 @@ public:
         table.adj_acc_clear_root_table();
     }
 
+    static void begin_view_change_tracking(Table& table)
+    {
+        table.begin_view_change_tracking(); // Throws
+    }
+
+    static void track_changed_row(Table& table, size_t row_ndx, size_t num_rows = 1) noexcept
+    {
+        table.track_changed_row(row_ndx, num_rows);
+    }
+
+    static void discard_view_changes(Table& table) noexcept
+    {
+        table.discard_view_changes();
+    }
+
+    static bool has_row_bound_accessors(const Table& table) noexcept
+    {
+        return table.has_row_bound_accessors();
+    }
+
+    static void end_view_change_tracking(Table& table) noexcept
+    {
+        table.end_view_change_tracking();
+    }
+
     static void adj_acc_clear_nonroot_table(Table& table) noexcept
     {
         table.adj_acc_clear_nonroot_table();
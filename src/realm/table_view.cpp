@@ -22,7 +22,9 @@
 #include <realm/column_timestamp.hpp>
 #include <realm/column_tpl.hpp>
 #include <realm/impl/sequential_getter.hpp>
+#include <realm/query_engine.hpp>
 
+#include <algorithm>
 #include <unordered_set>
 
 using namespace realm;
@@ -420,6 +422,14 @@ void TableViewBase::aggregate(size_t group_by_column, size_t aggr_column, Table:
     m_table->aggregate(group_by_column, aggr_column, op, result, &m_row_indexes);
 }
 
+GroupByResult TableViewBase::group_by(const GroupByDescriptor& descriptor) const
+{
+    check_cookie();
+    if (&descriptor.get_table() != m_table.get())
+        throw LogicError(LogicError::illegal_combination);
+    return GroupByResult(descriptor, m_row_indexes);
+}
+
 void TableViewBase::to_json(std::ostream& out, size_t link_depth, std::map<std::string, std::string>* renames) const
 {
     check_cookie();
@@ -546,7 +556,9 @@ uint_fast64_t TableViewBase::sync_if_needed() const
 {
     if (!is_in_sync()) {
         // FIXME: Is this a reasonable handling of constness?
-        const_cast<TableViewBase*>(this)->do_sync();
+        auto& self = *const_cast<TableViewBase*>(this);
+        if (!self.apply_tracked_changes())
+            self.do_sync();
     }
     return *m_last_seen_version;
 }
@@ -555,6 +567,14 @@ uint_fast64_t TableViewBase::sync_if_needed() const
 void TableViewBase::adj_row_acc_insert_rows(size_t row_ndx, size_t num_rows) noexcept
 {
     m_row_indexes.adjust_ge(int_fast64_t(row_ndx), num_rows);
+
+    if (m_tracking_changes) {
+        for (size_t& row : m_changed_rows) {
+            if (row >= row_ndx)
+                row += num_rows;
+        }
+        track_changed_rows(row_ndx, num_rows);
+    }
 }
 
 
@@ -569,6 +589,15 @@ void TableViewBase::adj_row_acc_erase_row(size_t row_ndx) noexcept
         m_row_indexes.set(it, -1);
     }
     m_row_indexes.adjust_ge(int_fast64_t(row_ndx) + 1, -1);
+
+    if (m_tracking_changes) {
+        m_changed_rows.erase(std::remove(m_changed_rows.begin(), m_changed_rows.end(), row_ndx),
+                             m_changed_rows.end());
+        for (size_t& row : m_changed_rows) {
+            if (row > row_ndx)
+                --row;
+        }
+    }
 }
 
 
@@ -591,6 +620,17 @@ void TableViewBase::adj_row_acc_move_over(size_t from_row_ndx, size_t to_row_ndx
             break;
         m_row_indexes.set(it, to_row_ndx);
     }
+
+    if (m_tracking_changes) {
+        m_changed_rows.erase(std::remove(m_changed_rows.begin(), m_changed_rows.end(), to_row_ndx),
+                             m_changed_rows.end());
+        if (from_row_ndx != to_row_ndx) {
+            // The moved row must be put back in the order of its new index. When this is an unordered insertion
+            // rather than a removal, `from_row_ndx` is the new row.
+            track_changed_rows(to_row_ndx);
+            track_changed_rows(from_row_ndx);
+        }
+    }
 }
 
 
@@ -610,6 +650,9 @@ void TableViewBase::adj_row_acc_swap_rows(size_t row_ndx_1, size_t row_ndx_2) no
             it_2 = m_row_indexes.find_first(row_ndx_2, it_2);
         }
     }
+
+    track_changed_rows(row_ndx_1);
+    track_changed_rows(row_ndx_2);
 }
 
 
@@ -625,6 +668,8 @@ void TableViewBase::adj_row_acc_move_row(size_t from_row_ndx, size_t to_row_ndx)
     while ((it = m_row_indexes.find_first(from_row_ndx, it)) != not_found)
         m_row_indexes.set(it, to_row_ndx);
     m_row_indexes.adjust_ge(int_fast64_t(from_row_ndx), -1);
+
+    discard_tracked_changes();
 }
 
 
@@ -633,6 +678,154 @@ void TableViewBase::adj_row_acc_clear() noexcept
     m_num_detached_refs = m_row_indexes.size();
     for (size_t i = 0, num_rows = m_row_indexes.size(); i < num_rows; ++i)
         m_row_indexes.set(i, -1);
+
+    discard_tracked_changes();
+}
+
+
+namespace {
+
+// Beyond this many changed rows, rerunning the query is expected to be faster than finding every changed row in the
+// view
+const size_t max_tracked_changes = 256;
+
+} // anonymous namespace
+
+bool TableViewBase::can_apply_changes(const SortDescriptor*& sort) const
+{
+    if (!m_table || m_linkview_source || m_distinct_column_source != npos || m_linked_column)
+        return false;
+    if (!m_query.m_table || m_query.m_view || m_start != 0 || m_end != size_t(-1) || m_limit != size_t(-1))
+        return false;
+
+    sort = nullptr;
+    for (size_t i = 0; i < m_descriptor_ordering.size(); ++i) {
+        switch (m_descriptor_ordering.get_type(i)) {
+            case DescriptorType::Sort:
+                if (sort)
+                    return false;
+                sort = static_cast<const SortDescriptor*>(m_descriptor_ordering[i]);
+                if (!sort->depends_only_on_own_row())
+                    return false;
+                break;
+            case DescriptorType::Include:
+                break;
+            case DescriptorType::Distinct:
+            case DescriptorType::Limit:
+                return false;
+        }
+    }
+
+    return !m_query.has_conditions() || m_query.root_node()->depends_only_on_own_row();
+}
+
+
+void TableViewBase::begin_change_tracking()
+{
+    const SortDescriptor* sort;
+    if (!can_apply_changes(sort)) {
+        m_tracking_changes = false;
+    }
+    else if (is_in_sync()) {
+        m_changed_rows.clear();
+        m_changed_rows.reserve(max_tracked_changes); // Throws
+        m_tracking_changes = true;
+    }
+    else if (m_tracking_changes && m_changes_version != outside_version()) {
+        // Changed by the local thread since the last advance, which is not tracked
+        m_tracking_changes = false;
+    }
+}
+
+
+void TableViewBase::track_changed_rows(size_t row_ndx, size_t num_rows) noexcept
+{
+    if (!m_tracking_changes)
+        return;
+    if (num_rows > m_changed_rows.capacity() - m_changed_rows.size()) {
+        discard_tracked_changes();
+        return;
+    }
+    for (size_t i = 0; i < num_rows; ++i)
+        m_changed_rows.push_back(row_ndx + i);
+}
+
+
+void TableViewBase::discard_tracked_changes() noexcept
+{
+    m_tracking_changes = false;
+}
+
+
+void TableViewBase::end_change_tracking() noexcept
+{
+    if (m_tracking_changes)
+        m_changes_version = outside_version();
+}
+
+
+bool TableViewBase::apply_tracked_changes()
+{
+    if (!m_tracking_changes)
+        return false;
+    m_tracking_changes = false;
+
+    const SortDescriptor* sort;
+    if (!can_apply_changes(sort) || m_changes_version != outside_version())
+        return false;
+
+    // The view stays out of sync until it has been fully updated, so that it is rerun if this throws
+    m_last_seen_version = util::none;
+
+    size_t num_rows = m_table->size();
+    std::sort(m_changed_rows.begin(), m_changed_rows.end());
+    m_changed_rows.erase(std::unique(m_changed_rows.begin(), m_changed_rows.end()), m_changed_rows.end());
+    m_changed_rows.erase(std::lower_bound(m_changed_rows.begin(), m_changed_rows.end(), num_rows),
+                         m_changed_rows.end());
+
+    // Take out the removed rows and the ones which have changed, found in a single pass over the view. All others
+    // keep their relative order.
+    std::vector<size_t> positions;
+    size_t num_entries = m_row_indexes.size();
+    for (size_t i = 0; i < num_entries; ++i) {
+        int64_t value = m_row_indexes.get(i);
+        if (value == detached_ref ||
+            std::binary_search(m_changed_rows.begin(), m_changed_rows.end(), to_size_t(value)))
+            positions.push_back(i);
+    }
+    for (auto it = positions.rbegin(); it != positions.rend(); ++it)
+        m_row_indexes.erase(*it);
+    m_num_detached_refs = 0;
+
+    // Put the changed rows which match back in where they belong
+    if (!m_changed_rows.empty()) {
+        m_query.init();
+        ParentNode* root = m_query.has_conditions() ? m_query.root_node() : nullptr;
+        for (size_t row : m_changed_rows) {
+            if (root && root->find_first(row, row + 1) != row)
+                continue;
+
+            size_t pos;
+            if (sort) {
+                size_t lo = 0, hi = m_row_indexes.size();
+                while (lo < hi) {
+                    size_t mid = lo + (hi - lo) / 2;
+                    if (sort->row_less(size_t(m_row_indexes.get(mid)), row))
+                        lo = mid + 1;
+                    else
+                        hi = mid;
+                }
+                pos = lo;
+            }
+            else {
+                pos = m_row_indexes.lower_bound(int64_t(row));
+            }
+            m_row_indexes.insert(pos, int64_t(row));
+        }
+    }
+
+    m_last_seen_version = outside_version();
+    return true;
 }
 
 
@@ -754,6 +947,7 @@ void TableViewBase::do_sync()
     // - Table::get_backlink_view()
     // Here we sync with the respective source.
 
+    size_t num_excluded_by_limit = 0;
     if (m_linkview_source) {
         m_row_indexes.clear();
         for (size_t t = 0; t < m_linkview_source->size(); t++)
@@ -789,11 +983,24 @@ void TableViewBase::do_sync()
         if (m_query.m_view)
             m_query.m_view->sync_if_needed();
 
-        m_query.find_all(*const_cast<TableViewBase*>(this), m_start, m_end, m_limit);
+        // When the results are sorted and then limited, only the rows which can make it past the limit are kept
+        // while the query runs
+        size_t sort_limit;
+        const SortDescriptor* sort = m_descriptor_ordering.get_sort_before_limit(sort_limit);
+        if (sort && !m_query.m_view && m_start == 0 && m_end == size_t(-1) && m_limit == size_t(-1)) {
+            TopKCollector collector(*sort, sort_limit);
+            m_query.find_all(*this, collector);
+            num_excluded_by_limit = collector.count() - m_row_indexes.size();
+        }
+        else {
+            m_query.find_all(*const_cast<TableViewBase*>(this), m_start, m_end, m_limit);
+        }
     }
     m_num_detached_refs = 0;
+    m_tracking_changes = false;
 
     do_sort(m_descriptor_ordering);
+    m_limit_count += num_excluded_by_limit;
 
     m_last_seen_version = outside_version();
 }
@@ -23,6 +23,7 @@
 #include <realm/link_view.hpp>
 #include <realm/table.hpp>
 #include <realm/util/features.h>
+#include <realm/group_by.hpp>
 #include <realm/views.hpp>
 
 namespace realm {
@@ -249,6 +250,9 @@ public:
     // document method publicly.
     void aggregate(size_t group_by_column, size_t aggr_column, Table::AggrType op, Table& result) const;
 
+    // Grouped aggregation over the rows of this view, see GroupByDescriptor
+    GroupByResult group_by(const GroupByDescriptor& descriptor) const;
+
     // Get row index in the source table this view is "looking" at.
     size_t get_source_ndx(size_t row_ndx) const noexcept;
 
@@ -434,6 +438,29 @@ private:
     void adj_row_acc_swap_rows(size_t row_ndx_1, size_t row_ndx_2) noexcept;
     void adj_row_acc_move_row(size_t from_row_ndx, size_t to_row_ndx) noexcept;
     void adj_row_acc_clear() noexcept;
+
+    // A view which is in sync when a read transaction is advanced records the
+    // rows changed by the transaction logs, so that sync_if_needed() can
+    // update it from those rows instead of by rerunning its query. This
+    // requires that the query and the sort order (if any) decide on each row
+    // by the values of that row alone. Called by table around
+    // Group::advance_transact():
+    void begin_change_tracking();
+    void track_changed_rows(size_t row_ndx, size_t num_rows = 1) noexcept;
+    void discard_tracked_changes() noexcept;
+    void end_change_tracking() noexcept;
+
+    bool can_apply_changes(const SortDescriptor*& sort) const;
+    bool apply_tracked_changes();
+
+    // Rows which may have been changed since the view was last in sync, with
+    // duplicates, and possibly including rows which no longer exist. Never
+    // grows beyond its reserved capacity.
+    std::vector<size_t> m_changed_rows;
+    bool m_tracking_changes = false;
+    // The version of the source which applying m_changed_rows brings the view
+    // up to
+    uint_fast64_t m_changes_version = 0;
 };
 
 
@@ -583,6 +610,7 @@ private:
     friend class Query;
     friend class TableViewBase;
     friend class LinkView;
+    friend class SharedGroup;
 };
 
 
@@ -823,6 +851,9 @@ inline TableViewBase::TableViewBase(TableViewBase&& tv) noexcept
     // version number so that we can later trigger a sync if needed.
     m_last_seen_version(tv.m_last_seen_version)
     , m_num_detached_refs(tv.m_num_detached_refs)
+    , m_changed_rows(std::move(tv.m_changed_rows))
+    , m_tracking_changes(tv.m_tracking_changes)
+    , m_changes_version(tv.m_changes_version)
 {
     RowIndexes::m_limit_count = tv.m_limit_count;
     if (m_table)
@@ -859,6 +890,9 @@ inline TableViewBase& TableViewBase::operator=(TableViewBase&& tv) noexcept
     m_linkview_source = std::move(tv.m_linkview_source);
     m_descriptor_ordering = std::move(tv.m_descriptor_ordering);
     m_distinct_column_source = tv.m_distinct_column_source;
+    m_changed_rows = std::move(tv.m_changed_rows);
+    m_tracking_changes = tv.m_tracking_changes;
+    m_changes_version = tv.m_changes_version;
 
     return *this;
 }
@@ -895,6 +929,7 @@ inline TableViewBase& TableViewBase::operator=(const TableViewBase& tv)
     m_linkview_source = tv.m_linkview_source;
     m_descriptor_ordering = tv.m_descriptor_ordering;
     m_distinct_column_source = tv.m_distinct_column_source;
+    m_tracking_changes = false;
 
     return *this;
 }
@@ -22,6 +22,7 @@
 #include <cstdint>
 #include <ostream>
 #include <chrono>
+#include <functional>
 #include <realm/util/assert.hpp>
 #include <realm/null.hpp>
 
@@ -184,4 +185,17 @@ inline std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& out, const
 
 } // namespace realm
 
+namespace std {
+template <>
+struct hash<::realm::Timestamp> {
+    inline size_t operator()(const ::realm::Timestamp& ts) const noexcept
+    {
+        if (ts.is_null())
+            return 0;
+        size_t h = std::hash<int64_t>()(ts.get_seconds());
+        return h ^ (std::hash<int32_t>()(ts.get_nanoseconds()) + 0x9e3779b9 + (h << 6) + (h >> 2));
+    }
+};
+} // namespace std
+
 #endif // REALM_TIMESTAMP_HPP
@@ -100,6 +100,11 @@ size_t sequence_length(char lead);
 // Return bool(string1 < string2)
 bool utf8_compare(StringData string1, StringData string2);
 
+// Append a binary key for `string` to `key` such that comparing keys bytewise (shorter is smaller on a common
+// prefix) gives the same order as utf8_compare(). Returns false if that is not possible, which is the case for
+// invalid utf8 and when any other method than STRING_COMPARE_CORE is selected.
+bool utf8_sort_key(StringData string, std::string& key);
+
 // Return unicode value of character.
 uint32_t utf8value(const char* character);
 
@@ -952,6 +952,20 @@ void File::sync()
 }
 
 
+void File::sync_data()
+{
+#if defined(__linux__)
+    REALM_ASSERT_RELEASE(is_attached());
+
+    if (::fdatasync(m_fd) == 0)
+        return;
+    throw std::system_error(errno, std::system_category(), "fdatasync() failed");
+#else
+    sync(); // Throws
+#endif
+}
+
+
 bool File::lock(bool exclusive, bool non_blocking)
 {
     REALM_ASSERT_RELEASE(is_attached());
@@ -319,6 +319,11 @@ public:
     /// `F_FULLFSYNC`.
     void sync();
 
+    /// Like sync(), but on Linux it calls `fdatasync()`, which skips the
+    /// metadata that is not needed to read back the data, such as the
+    /// modification time.
+    void sync_data();
+
     /// Place an exclusive lock on this file. This blocks the caller
     /// until all other locks have been released.
     ///
@@ -27,6 +27,8 @@
 #include <realm/util/string_buffer.hpp>
 
 #include <cctype>
+#include <iomanip>
+#include <limits>
 
 namespace realm {
 namespace util {
@@ -50,6 +52,29 @@ std::string print_value<>(bool b)
     return "false";
 }
 
+// Floating point values are printed with all the digits needed to read them
+// back exactly, as queries with different values must be described
+// differently
+template <typename T>
+std::string print_floating_point(T value)
+{
+    std::stringstream ss;
+    ss << std::setprecision(std::numeric_limits<T>::max_digits10) << value;
+    return ss.str();
+}
+
+template <>
+std::string print_value<>(float value)
+{
+    return print_floating_point(value);
+}
+
+template <>
+std::string print_value<>(double value)
+{
+    return print_floating_point(value);
+}
+
 template <>
 std::string print_value<>(realm::null)
 {
@@ -19,17 +19,422 @@
 #include <realm/views.hpp>
 
 #include <realm/column_link.hpp>
+#include <realm/column_string.hpp>
+#include <realm/column_string_enum.hpp>
+#include <realm/column_timestamp.hpp>
 #include <realm/exceptions.hpp>
 #include <realm/group.hpp>
 #include <realm/table.hpp>
 #include <realm/table_view.hpp>
-
+#include <realm/unicode.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <numeric>
 #include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace realm;
 
 namespace {
 
+// Reads values from a column, descending the B+tree only when a row falls outside of the leaf which was read last.
+// Leaf accessors are only stable while the column is not modified, which holds for the duration of a sort.
+template <class ColType>
+class LeafCache {
+public:
+    explicit LeafCache(const ColType& column)
+        : m_column(column)
+        , m_fallback(column.get_alloc())
+    {
+    }
+
+    auto get(size_t row)
+    {
+        if (row < m_leaf_start || row >= m_leaf_end) {
+            typename ColType::LeafInfo leaf{&m_leaf, &m_fallback};
+            size_t ndx_in_leaf;
+            m_column.get_leaf(row, ndx_in_leaf, leaf);
+            m_leaf_start = row - ndx_in_leaf;
+            m_leaf_end = m_leaf_start + m_leaf->size();
+        }
+        return m_leaf->get(row - m_leaf_start);
+    }
+
+private:
+    const ColType& m_column;
+    typename ColType::LeafType m_fallback;
+    const typename ColType::LeafType* m_leaf = nullptr;
+    size_t m_leaf_start = 0;
+    size_t m_leaf_end = 0;
+};
+
+// Maps a floating point value to an unsigned integer with the same order. Negative zero maps to the same integer as
+// positive zero since they compare equal. NaN is not handled here.
+template <class UInt, class Float>
+UInt ordered_bits(Float value)
+{
+    if (value == 0)
+        value = 0;
+    UInt bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const UInt sign = UInt(1) << (sizeof(UInt) * 8 - 1);
+    return (bits & sign) ? ~bits : bits | sign;
+}
+
+// Same order as StringColumn::compare_values(): null first, then utf8_compare()
+bool string_less(StringData a, StringData b)
+{
+    if (a.is_null() || b.is_null())
+        return a.is_null() && !b.is_null();
+    return a != b && utf8_compare(a, b);
+}
+
+// Keys of the sort or distinct columns of a set of rows, extracted once per row instead of comparing column values
+// through the B+tree on every comparison. Each column is encoded as one or more 64 bit words chosen such that
+// comparing the words of two rows as unsigned integers gives the same result as ColumnsDescriptor::Sorter. For
+// sorting, strings are replaced by their rank among the sorted values and the rows are put in order by an LSD radix
+// sort which, being stable, keeps rows with equal keys in the order they come in. For distinct only equality
+// matters, so strings are replaced by an id per distinct value and the rows are deduplicated through a hash set.
+class RowKeys {
+public:
+    using IndexPair = ColumnsDescriptor::IndexPair;
+
+    RowKeys(const std::vector<IndexPair>& rows, bool ordered)
+        : m_rows(rows)
+        , m_ordered(ordered)
+    {
+    }
+
+    bool supports(const ColumnBase& column) const
+    {
+        const std::type_info& type = typeid(column);
+        if (type == typeid(StringColumn) || type == typeid(StringEnumColumn)) {
+            // A user supplied collation may consider different strings equal
+            return m_ordered || string_compare_method == STRING_COMPARE_CORE ||
+                   string_compare_method == STRING_COMPARE_CORE_SIMILAR;
+        }
+        return type == typeid(IntegerColumn) || type == typeid(IntNullColumn) || type == typeid(FloatColumn) ||
+               type == typeid(DoubleColumn) || type == typeid(TimestampColumn);
+    }
+
+    void add_column(const std::vector<const ColumnBase*>& chain, bool ascending);
+
+    // Returns the rows in sorted order
+    std::vector<IndexPair> sort();
+
+    // Returns the first of the rows with each distinct key, in the order of the rows. Rows with a null link on the
+    // way to any of the columns are left out.
+    std::vector<IndexPair> distinct();
+
+private:
+    const std::vector<IndexPair>& m_rows;
+    const bool m_ordered;
+    std::deque<std::vector<uint64_t>> m_words; // m_words[w][i] is key word `w` of m_rows[i]
+    std::vector<bool> m_has_null_link;
+
+    std::vector<uint64_t>& add_word()
+    {
+        m_words.emplace_back(m_rows.size());
+        return m_words.back();
+    }
+
+    void add_string_ranks(const std::vector<StringData>& values, std::vector<uint64_t>& out);
+};
+
+void RowKeys::add_column(const std::vector<const ColumnBase*>& chain, bool ascending)
+{
+    const size_t num_rows = m_rows.size();
+    const size_t first_word = m_words.size();
+
+    // Follow the links to the rows holding the values. Null links sort after all values when ascending, which is
+    // expressed through a leading word of their own.
+    std::vector<size_t> rows(num_rows);
+    std::vector<bool> is_null_link;
+    for (size_t i = 0; i < num_rows; ++i)
+        rows[i] = m_rows[i].index_in_column;
+    if (chain.size() > 1) {
+        is_null_link.resize(num_rows);
+        auto& link_word = add_word();
+        for (size_t i = 0; i < num_rows; ++i) {
+            for (size_t j = 0; j + 1 < chain.size(); ++j) {
+                auto link_col = static_cast<const LinkColumn*>(chain[j]);
+                if (link_col->is_null(rows[i])) {
+                    is_null_link[i] = true;
+                    link_word[i] = 1;
+                    if (m_has_null_link.empty())
+                        m_has_null_link.resize(num_rows);
+                    m_has_null_link[i] = true;
+                    break;
+                }
+                rows[i] = link_col->get_link(rows[i]);
+            }
+        }
+    }
+    auto has_value = [&](size_t i) { return is_null_link.empty() || !is_null_link[i]; };
+
+    const ColumnBase& column = *chain.back();
+    const std::type_info& type = typeid(column);
+    if (type == typeid(IntegerColumn)) {
+        LeafCache<IntegerColumn> values(static_cast<const IntegerColumn&>(column));
+        auto& word = add_word();
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (has_value(i))
+                word[i] = uint64_t(values.get(rows[i])) ^ (uint64_t(1) << 63);
+        }
+    }
+    else if (type == typeid(IntNullColumn)) {
+        LeafCache<IntNullColumn> values(static_cast<const IntNullColumn&>(column));
+        auto& not_null = add_word();
+        auto& word = add_word();
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (!has_value(i))
+                continue;
+            if (auto value = values.get(rows[i])) {
+                not_null[i] = 1;
+                word[i] = uint64_t(*value) ^ (uint64_t(1) << 63);
+            }
+        }
+    }
+    else if (type == typeid(FloatColumn)) {
+        // NaNs (including null) order before all numbers and among themselves by their bit pattern
+        LeafCache<FloatColumn> values(static_cast<const FloatColumn&>(column));
+        auto& word = add_word();
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (!has_value(i))
+                continue;
+            float value = values.get(rows[i]);
+            if (std::isnan(value)) {
+                uint32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                word[i] = bits;
+            }
+            else {
+                word[i] = (uint64_t(1) << 32) | ordered_bits<uint32_t>(value);
+            }
+        }
+    }
+    else if (type == typeid(DoubleColumn)) {
+        LeafCache<DoubleColumn> values(static_cast<const DoubleColumn&>(column));
+        auto& not_nan = add_word();
+        auto& word = add_word();
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (!has_value(i))
+                continue;
+            double value = values.get(rows[i]);
+            if (std::isnan(value)) {
+                memcpy(&word[i], &value, sizeof(value));
+            }
+            else {
+                not_nan[i] = 1;
+                word[i] = ordered_bits<uint64_t>(value);
+            }
+        }
+    }
+    else if (type == typeid(TimestampColumn)) {
+        auto& timestamps = static_cast<const TimestampColumn&>(column);
+        auto& not_null = add_word();
+        auto& seconds = add_word();
+        auto& nanoseconds = add_word();
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (!has_value(i))
+                continue;
+            Timestamp value = timestamps.get(rows[i]);
+            if (!value.is_null()) {
+                not_null[i] = 1;
+                seconds[i] = uint64_t(value.get_seconds()) ^ (uint64_t(1) << 63);
+                nanoseconds[i] = uint64_t(int64_t(value.get_nanoseconds()) - std::numeric_limits<int32_t>::min());
+            }
+        }
+    }
+    else if (type == typeid(StringEnumColumn)) {
+        // Rank the distinct values once, then every row only needs its key index. The keys are unique, so for
+        // distinct the key index itself will do.
+        auto& enums = static_cast<const StringEnumColumn&>(column);
+        const StringColumn& keys = enums.get_keys();
+        std::vector<uint64_t> key_ranks(keys.size());
+        if (m_ordered) {
+            std::vector<StringData> key_values(keys.size());
+            for (size_t k = 0; k < key_values.size(); ++k)
+                key_values[k] = keys.get(k);
+            add_string_ranks(key_values, key_ranks);
+        }
+        else {
+            std::iota(key_ranks.begin(), key_ranks.end(), 0);
+        }
+
+        LeafCache<IntegerColumn> key_ndx(enums);
+        auto& word = add_word();
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (has_value(i))
+                word[i] = key_ranks[to_size_t(key_ndx.get(rows[i]))];
+        }
+    }
+    else {
+        REALM_ASSERT(type == typeid(StringColumn));
+        auto& strings = static_cast<const StringColumn&>(column);
+        std::vector<StringData> values(num_rows);
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (has_value(i))
+                values[i] = strings.get(rows[i]);
+        }
+        if (m_ordered) {
+            add_string_ranks(values, add_word());
+        }
+        else {
+            auto& word = add_word();
+            std::unordered_map<StringData, uint64_t> ids;
+            for (size_t i = 0; i < num_rows; ++i) {
+                if (!values[i].is_null())
+                    word[i] = ids.emplace(values[i], ids.size() + 1).first->second;
+            }
+        }
+    }
+
+    if (!ascending) {
+        for (size_t w = first_word; w < m_words.size(); ++w) {
+            for (auto& word : m_words[w])
+                word = ~word;
+        }
+    }
+}
+
+void RowKeys::add_string_ranks(const std::vector<StringData>& values, std::vector<uint64_t>& out)
+{
+    // Nulls get rank 0. The others are ordered through normalized binary keys when the string compare method
+    // allows it, which turns each comparison into a memcmp, and through utf8_compare() otherwise.
+    std::vector<size_t> order;
+    order.reserve(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (!values[i].is_null())
+            order.push_back(i);
+    }
+
+    std::string buffer;
+    std::vector<size_t> offsets;
+    offsets.reserve(values.size() + 1);
+    bool use_keys = true;
+    for (size_t i = 0; i < values.size() && use_keys; ++i) {
+        offsets.push_back(buffer.size());
+        use_keys = utf8_sort_key(values[i], buffer);
+    }
+    offsets.push_back(buffer.size());
+
+    auto key_less = [&](size_t a, size_t b) {
+        size_t size_a = offsets[a + 1] - offsets[a];
+        size_t size_b = offsets[b + 1] - offsets[b];
+        int c = memcmp(buffer.data() + offsets[a], buffer.data() + offsets[b], std::min(size_a, size_b));
+        return c < 0 || (c == 0 && size_a < size_b);
+    };
+    auto less = [&](size_t a, size_t b) { return use_keys ? key_less(a, b) : string_less(values[a], values[b]); };
+    std::sort(order.begin(), order.end(), less);
+
+    uint64_t rank = 0;
+    for (size_t k = 0; k < order.size(); ++k) {
+        if (k == 0 || less(order[k - 1], order[k]))
+            ++rank;
+        out[order[k]] = rank;
+    }
+}
+
+std::vector<RowKeys::IndexPair> RowKeys::sort()
+{
+    const size_t num_rows = m_rows.size();
+    const size_t num_words = m_words.size();
+    const size_t stride = num_words + 1;
+    if (num_rows == 0)
+        return {};
+
+    // Lay out each row as its key words followed by its position in m_rows
+    std::vector<uint64_t> records(num_rows * stride);
+    for (size_t w = 0; w < num_words; ++w) {
+        for (size_t i = 0; i < num_rows; ++i)
+            records[i * stride + w] = m_words[w][i];
+        std::vector<uint64_t>().swap(m_words[w]);
+    }
+    for (size_t i = 0; i < num_rows; ++i)
+        records[i * stride + num_words] = i;
+
+    // The passes run on the calling thread. Each one scatters whole records and is bound by memory bandwidth
+    // rather than computation, so splitting a pass among threads, which takes a histogram per thread and a
+    // barrier per digit, would gain little. For the same reason, the 8 digits of a word are all counted in a
+    // single read of the records.
+    std::vector<uint64_t> buffer(records.size());
+    std::vector<size_t> counts(8 * 256);
+    for (size_t w = num_words; w-- > 0;) {
+        std::fill(counts.begin(), counts.end(), 0);
+        for (size_t i = 0; i < num_rows; ++i) {
+            uint64_t word = records[i * stride + w];
+            for (size_t b = 0; b < 8; ++b)
+                ++counts[b * 256 + ((word >> (8 * b)) & 0xFF)];
+        }
+        for (size_t b = 0; b < 8; ++b) {
+            size_t* offsets = &counts[b * 256];
+            // Nothing to do if every row has the same digit
+            if (offsets[(records[w] >> (8 * b)) & 0xFF] == num_rows)
+                continue;
+            size_t offset = 0;
+            for (size_t d = 0; d < 256; ++d) {
+                size_t count = offsets[d];
+                offsets[d] = offset;
+                offset += count;
+            }
+            for (size_t i = 0; i < num_rows; ++i) {
+                const uint64_t* record = &records[i * stride];
+                size_t pos = offsets[(record[w] >> (8 * b)) & 0xFF]++;
+                std::copy(record, record + stride, &buffer[pos * stride]);
+            }
+            records.swap(buffer);
+        }
+    }
+
+    std::vector<IndexPair> sorted;
+    sorted.reserve(num_rows);
+    for (size_t i = 0; i < num_rows; ++i)
+        sorted.push_back(m_rows[to_size_t(records[i * stride + num_words])]);
+    return sorted;
+}
+
+
+std::vector<RowKeys::IndexPair> RowKeys::distinct()
+{
+    const size_t num_rows = m_rows.size();
+    const size_t num_words = m_words.size();
+
+    std::vector<uint64_t> records(num_rows * num_words);
+    for (size_t w = 0; w < num_words; ++w) {
+        for (size_t i = 0; i < num_rows; ++i)
+            records[i * num_words + w] = m_words[w][i];
+        std::vector<uint64_t>().swap(m_words[w]);
+    }
+
+    auto hash = [&](size_t i) {
+        const uint64_t* record = &records[i * num_words];
+        uint64_t h = 0;
+        for (size_t w = 0; w < num_words; ++w) {
+            h = (h ^ record[w]) * 0x9E3779B97F4A7C15ULL;
+            h ^= h >> 32;
+        }
+        return size_t(h);
+    };
+    auto equal = [&](size_t a, size_t b) {
+        return std::equal(&records[a * num_words], &records[a * num_words] + num_words, &records[b * num_words]);
+    };
+    std::unordered_set<size_t, decltype(hash), decltype(equal)> seen(num_rows, hash, equal);
+
+    std::vector<IndexPair> result;
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (!m_has_null_link.empty() && m_has_null_link[i])
+            continue;
+        if (seen.insert(i).second)
+            result.push_back(m_rows[i]);
+    }
+    return result;
+}
 } // anonymous namespace
 
 ColumnsDescriptor::ColumnsDescriptor(Table const& table, std::vector<std::vector<size_t>> column_indices)
@@ -260,6 +665,26 @@ ColumnsDescriptor::Sorter ColumnsDescriptor::sorter(std::vector<IndexPair> const
     return Sorter(m_columns, ascending, rows);
 }
 
+bool ColumnsDescriptor::distinct_by_extracted_keys(std::vector<IndexPair>& rows) const
+{
+    REALM_ASSERT(!m_columns.empty());
+    RowKeys keys(rows, false);
+    for (auto& chain : m_columns) {
+        if (!keys.supports(*chain.back()))
+            return false;
+    }
+
+    // The row which comes first in the view is the one kept
+    auto by_view_index = [](auto a, auto b) { return a.index_in_view < b.index_in_view; };
+    if (!std::is_sorted(rows.begin(), rows.end(), by_view_index))
+        std::sort(rows.begin(), rows.end(), by_view_index);
+
+    for (auto& chain : m_columns)
+        keys.add_column(chain, true);
+    rows = keys.distinct();
+    return true;
+}
+
 
 SortDescriptor::Sorter SortDescriptor::sorter(std::vector<IndexPair> const& rows) const
 {
@@ -267,6 +692,43 @@ SortDescriptor::Sorter SortDescriptor::sorter(std::vector<IndexPair> const& rows
     return Sorter(m_columns, m_ascending, rows);
 }
 
+bool SortDescriptor::sort_by_extracted_keys(std::vector<IndexPair>& rows) const
+{
+    REALM_ASSERT(!m_columns.empty());
+    RowKeys keys(rows, true);
+    for (auto& chain : m_columns) {
+        if (!keys.supports(*chain.back()))
+            return false;
+    }
+
+    // Ties are broken by the position in the view, which is what the stable key sort preserves
+    auto by_view_index = [](auto a, auto b) { return a.index_in_view < b.index_in_view; };
+    if (!std::is_sorted(rows.begin(), rows.end(), by_view_index))
+        std::sort(rows.begin(), rows.end(), by_view_index);
+
+    for (size_t i = 0; i < m_columns.size(); ++i)
+        keys.add_column(m_columns[i], m_ascending[i]);
+    rows = keys.sort();
+    return true;
+}
+
+bool SortDescriptor::depends_only_on_own_row() const noexcept
+{
+    return std::all_of(m_columns.begin(), m_columns.end(), [](auto& chain) {
+        return chain.size() == 1 && !dynamic_cast<const LinkColumnBase*>(chain.front());
+    });
+}
+
+bool SortDescriptor::row_less(size_t a, size_t b) const
+{
+    REALM_ASSERT_DEBUG(depends_only_on_own_row());
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        if (int c = m_columns[i].front()->compare_values(a, b))
+            return m_ascending[i] ? c > 0 : c < 0;
+    }
+    return a < b;
+}
+
 bool SortDescriptor::Sorter::operator()(IndexPair i, IndexPair j, bool total_ordering) const
 {
     for (size_t t = 0; t < m_columns.size(); t++) {
@@ -296,6 +758,50 @@ bool SortDescriptor::Sorter::operator()(IndexPair i, IndexPair j, bool total_ord
     return total_ordering ? i.index_in_view < j.index_in_view : 0;
 }
 
+TopKCollector::TopKCollector(const SortDescriptor& sort, size_t limit)
+    : m_sort(sort)
+    , m_limit(limit)
+    , m_capacity(std::max(2 * limit, limit + 1000))
+{
+}
+
+void TopKCollector::add(size_t row)
+{
+    ++m_count;
+    m_candidates.push_back(row);
+    if (m_candidates.size() >= m_capacity)
+        prune();
+}
+
+void TopKCollector::prune()
+{
+    if (m_candidates.size() <= m_limit)
+        return;
+
+    // The candidates are kept in the order they were added, so their position doubles as the tie breaker
+    std::vector<ColumnsDescriptor::IndexPair> v;
+    v.reserve(m_candidates.size());
+    for (size_t i = 0; i < m_candidates.size(); ++i)
+        v.push_back({m_candidates[i], i});
+
+    SortDescriptor::Sorter predicate = m_sort.sorter(v);
+    std::nth_element(v.begin(), v.begin() + m_limit, v.end(), std::ref(predicate));
+    v.resize(m_limit);
+    std::sort(v.begin(), v.end(), [](auto a, auto b) { return a.index_in_view < b.index_in_view; });
+
+    m_candidates.clear();
+    for (auto& pair : v)
+        m_candidates.push_back(pair.index_in_column);
+}
+
+void TopKCollector::release(IntegerColumn& out)
+{
+    prune();
+    for (size_t row : m_candidates)
+        out.add(row);
+    m_candidates.clear();
+}
+
 LimitDescriptor::LimitDescriptor(size_t limit)
     : m_limit(limit)
 {
@@ -681,6 +1187,30 @@ bool DescriptorOrdering::will_limit_to_zero() const
     });
 }
 
+const SortDescriptor* DescriptorOrdering::get_sort_before_limit(size_t& limit) const
+{
+    const SortDescriptor* sort = nullptr;
+    for (auto& desc : m_descriptors) {
+        switch (desc->get_type()) {
+            case DescriptorType::Include:
+                break;
+            case DescriptorType::Sort:
+                if (sort)
+                    return nullptr;
+                sort = static_cast<const SortDescriptor*>(desc.get());
+                break;
+            case DescriptorType::Limit:
+                if (!sort)
+                    return nullptr;
+                limit = static_cast<const LimitDescriptor*>(desc.get())->get_limit();
+                return sort;
+            case DescriptorType::Distinct:
+                return nullptr;
+        }
+    }
+    return nullptr;
+}
+
 IncludeDescriptor DescriptorOrdering::compile_included_backlinks() const
 {
     IncludeDescriptor includes;
@@ -814,6 +1344,9 @@ void RowIndexes::do_sort(const DescriptorOrdering& ordering) {
             ++detached_ref_count;
     }
 
+    // Extracting the sort and distinct keys up front pays off once there are more than a handful of rows
+    const size_t min_rows_for_key_extraction = 64;
+
     const int num_descriptors = int(ordering.size());
     for (int desc_ndx = 0; desc_ndx < num_descriptors; ++desc_ndx) {
 
@@ -822,9 +1355,27 @@ void RowIndexes::do_sort(const DescriptorOrdering& ordering) {
             case DescriptorType::Sort:
             {
                 const auto* sort_descr = static_cast<const SortDescriptor*>(ordering[desc_ndx]);
-                SortDescriptor::Sorter sort_predicate = sort_descr->sorter(v);
 
-                std::sort(v.begin(), v.end(), std::ref(sort_predicate));
+                // If a limit follows, only the rows it keeps need to be put in order
+                size_t limit = v.size();
+                for (int next = desc_ndx + 1; next < num_descriptors; ++next) {
+                    DescriptorType next_type = ordering.get_type(next);
+                    if (next_type == DescriptorType::Limit)
+                        limit = static_cast<const LimitDescriptor*>(ordering[next])->get_limit();
+                    if (next_type != DescriptorType::Include)
+                        break;
+                }
+
+                bool sorted = v.size() >= min_rows_for_key_extraction && sort_descr->sort_by_extracted_keys(v);
+                if (!sorted) {
+                    SortDescriptor::Sorter sort_predicate = sort_descr->sorter(v);
+                    if (limit < v.size()) {
+                        std::partial_sort(v.begin(), v.begin() + limit, v.end(), std::ref(sort_predicate));
+                    }
+                    else {
+                        std::sort(v.begin(), v.end(), std::ref(sort_predicate));
+                    }
+                }
 
                 bool is_last_ordering = desc_ndx == num_descriptors - 1;
                 // not doing this on the last step is an optimisation
@@ -842,6 +1393,9 @@ void RowIndexes::do_sort(const DescriptorOrdering& ordering) {
             case DescriptorType::Distinct:
             {
                 const auto* distinct_descr = static_cast<const DistinctDescriptor*>(ordering[desc_ndx]);
+                if (v.size() >= min_rows_for_key_extraction && distinct_descr->distinct_by_extracted_keys(v))
+                    break;
+
                 auto distinct_predicate = distinct_descr->sorter(v);
 
                 // Remove all rows which have a null link along the way to the distinct columns
@@ -102,6 +102,11 @@ public:
     class Sorter;
     virtual Sorter sorter(std::vector<IndexPair> const& rows) const;
 
+    // Reduce `rows` to the first row in view order for every distinct value, like sorting with sorter() and removing
+    // neighbours would, but through a hash set of keys extracted up front. The result is in view order. Returns
+    // false, leaving `rows` untouched, if a column can not be handled this way.
+    bool distinct_by_extracted_keys(std::vector<IndexPair>& rows) const;
+
     // handover support
     DescriptorExport export_for_handover() const override;
 
@@ -157,6 +162,18 @@ public:
 
     Sorter sorter(std::vector<IndexPair> const& rows) const override;
 
+    // Sort `rows` into the same order as sorter() would, by extracting the sort keys of every row up front.
+    // Returns false, leaving `rows` untouched, if a column can not be sorted this way.
+    bool sort_by_extracted_keys(std::vector<IndexPair>& rows) const;
+
+    // Whether the position of a row only depends on the values of that row, i.e. no column is read through links and
+    // none holds links, whose values change when the target rows move.
+    bool depends_only_on_own_row() const noexcept;
+
+    // Whether table row `a` goes before table row `b` in the order sorter() produces for rows given in table order.
+    // Only valid if depends_only_on_own_row().
+    bool row_less(size_t a, size_t b) const;
+
     // handover support
     DescriptorExport export_for_handover() const override;
     std::string get_description(ConstTableRef attached_table) const override;
@@ -165,6 +182,34 @@ private:
     std::vector<bool> m_ascending;
 };
 
+// Selects the first `limit` rows according to a SortDescriptor from a stream of rows, while holding on to at most
+// a small multiple of `limit` candidates at any time. Rows must be added in their unsorted order, which is also what
+// ties are broken by, so the selection is identical to the first `limit` rows of a full sort.
+class TopKCollector {
+public:
+    TopKCollector(const SortDescriptor& sort, size_t limit);
+
+    void add(size_t row);
+
+    // The number of rows added so far
+    size_t count() const noexcept
+    {
+        return m_count;
+    }
+
+    // Append the selected rows to `out` in the order they were added
+    void release(IntegerColumn& out);
+
+private:
+    const SortDescriptor& m_sort;
+    size_t m_limit;
+    size_t m_capacity;
+    size_t m_count = 0;
+    std::vector<size_t> m_candidates; // in the order they were added
+
+    void prune();
+};
+
 class LimitDescriptor : public BaseDescriptor {
 public:
     LimitDescriptor(size_t limit);
@@ -220,6 +265,9 @@ public:
     bool will_apply_include() const;
     realm::util::Optional<size_t> get_min_limit() const;
     bool will_limit_to_zero() const;
+    // If the first descriptor which reorders or filters rows is a sort immediately followed by a limit, returns that
+    // sort and sets `limit`. Only the first `limit` rows by that sort can then end up in the result.
+    const SortDescriptor* get_sort_before_limit(size_t& limit) const;
     IncludeDescriptor compile_included_backlinks() const;
     std::string get_description(ConstTableRef target_table) const;
 
@@ -16,9 +16,16 @@
  *
  **************************************************************************/
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include <realm.hpp>
 #include <realm/query_expression.hpp> // only needed to compile on v2.6.0
@@ -1324,6 +1331,169 @@ struct BenchmarkNonInitatorOpen : Benchmark {
 };
 
 
+struct BenchmarkConcurrentReadTransactions : Benchmark {
+    const char* name() const
+    {
+        return "ConcurrentReadTransactions";
+    }
+    // Each thread uses a SharedGroup of its own, opened on the same Realm
+    std::unique_ptr<realm::test_util::SharedGroupTestPathGuard> path;
+    std::vector<std::unique_ptr<SharedGroup>> groups;
+    const size_t num_transactions_per_thread = 1000;
+
+    void before_all(SharedGroup&)
+    {
+        std::stringstream ident_ss;
+        ident_ss << "BenchmarkCommonTasks_" << this->name() << "_" << to_ident_cstr(m_durability);
+        path = std::unique_ptr<realm::test_util::SharedGroupTestPathGuard>(
+            new realm::test_util::SharedGroupTestPathGuard(ident_ss.str()));
+
+        size_t num_threads = std::max(std::thread::hardware_concurrency(), 2u);
+        for (size_t i = 0; i < num_threads; ++i) {
+            const std::string realm_path = *path;
+            groups.emplace_back(create_new_shared_group(realm_path, m_durability, m_encryption_key));
+        }
+        WriteTransaction tr(*groups.front());
+        TableRef t = tr.add_table(name());
+        t->add_column(type_Int, "value");
+        t->add_empty_row();
+        tr.commit();
+    }
+
+    void after_all(SharedGroup&)
+    {
+        groups.clear();
+    }
+
+    void operator()(SharedGroup&)
+    {
+        // All threads start read transactions on the latest version
+        std::vector<std::thread> threads;
+        for (auto& group : groups) {
+            SharedGroup* sg = group.get();
+            threads.emplace_back([this, sg] {
+                for (size_t i = 0; i < num_transactions_per_thread; ++i) {
+                    sg->begin_read();
+                    sg->end_read();
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+    }
+};
+
+
+#ifndef _WIN32
+struct BenchmarkChangeNotificationLatency : Benchmark {
+    const char* name() const
+    {
+        return "ChangeNotificationLatency";
+    }
+    // A child process answers each commit with a commit of its own as soon as
+    // wait_for_change() wakes it up, and the parent waits for the answer in
+    // the same way, so each round trip is two commits and two wake-ups of a
+    // waiter in another process. Encrypted Realms cannot be shared between
+    // processes, so for those the answers come from a thread instead.
+    std::unique_ptr<realm::test_util::SharedGroupTestPathGuard> path;
+    std::unique_ptr<SharedGroup> sg;
+    pid_t pid = 0;
+    std::thread thread;
+    const size_t num_round_trips = 10;
+
+    void before_all(SharedGroup&)
+    {
+        std::stringstream ident_ss;
+        ident_ss << "BenchmarkCommonTasks_" << this->name() << "_" << to_ident_cstr(m_durability);
+        path = std::unique_ptr<realm::test_util::SharedGroupTestPathGuard>(
+            new realm::test_util::SharedGroupTestPathGuard(ident_ss.str()));
+        sg.reset(create_new_shared_group(*path, m_durability, m_encryption_key));
+        WriteTransaction tr(*sg);
+        TableRef t = tr.add_table(name());
+        t->add_column(type_Int, "value");
+        t->add_empty_row();
+        tr.commit();
+
+        if (m_encryption_key) {
+            thread = std::thread([this] { answer(); });
+            return;
+        }
+        pid = fork();
+        if (pid == -1)
+            REALM_TERMINATE("fork() failed");
+        if (pid == 0) {
+            answer();
+            _exit(0);
+        }
+    }
+
+    // Runs in the child process or thread. Odd values are answered with the next even
+    // one, and a negative value ends the benchmark.
+    void answer()
+    {
+        std::unique_ptr<SharedGroup> sg_2(create_new_shared_group(*path, m_durability, m_encryption_key));
+        for (;;) {
+            const Group& g = sg_2->begin_read();
+            int64_t value = g.get_table(name())->get_int(0, 0);
+            if (value < 0) {
+                sg_2->end_read();
+                return;
+            }
+            if (value % 2 == 1) {
+                sg_2->end_read();
+                WriteTransaction tr(*sg_2);
+                tr.get_table(name())->set_int(0, 0, value + 1);
+                tr.commit();
+                continue;
+            }
+            sg_2->wait_for_change();
+            sg_2->end_read();
+        }
+    }
+
+    void set_value(int64_t value)
+    {
+        WriteTransaction tr(*sg);
+        tr.get_table(name())->set_int(0, 0, value);
+        tr.commit();
+    }
+
+    void after_all(SharedGroup&)
+    {
+        set_value(-1);
+        if (thread.joinable()) {
+            thread.join();
+        }
+        else {
+            int status = 0;
+            waitpid(pid, &status, 0);
+        }
+        sg.reset();
+    }
+
+    void operator()(SharedGroup&)
+    {
+        for (size_t i = 0; i < num_round_trips; ++i) {
+            int64_t ping;
+            {
+                ReadTransaction tr(*sg);
+                ping = tr.get_table(name())->get_int(0, 0) + 1;
+            }
+            set_value(ping);
+            for (;;) {
+                const Group& g = sg->begin_read();
+                if (g.get_table(name())->get_int(0, 0) == ping + 1) {
+                    sg->end_read();
+                    break;
+                }
+                sg->wait_for_change();
+                sg->end_read();
+            }
+        }
+    }
+};
+#endif
+
 const char* to_lead_cstr(RealmDurability level)
 {
     switch (level) {
@@ -1489,6 +1659,10 @@ int benchmark_common_tasks_main()
     BENCH(BenchmarkQueryInsensitiveString);
     BENCH(BenchmarkQueryInsensitiveStringIndexed);
     BENCH(BenchmarkNonInitatorOpen);
+    BENCH(BenchmarkConcurrentReadTransactions);
+#ifndef _WIN32
+    BENCH(BenchmarkChangeNotificationLatency);
+#endif
     BENCH(BenchmarkQueryChainedOrStrings);
     BENCH(BenchmarkQueryChainedOrInts);
     BENCH(BenchmarkQueryChainedOrIntsIndexed);
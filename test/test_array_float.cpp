@@ -529,4 +529,96 @@ TEST(ArrayDouble_Compare)
     BasicArray_Compare<ArrayDouble, double>(test_context);
 }
 
+
+template <class Condition, class A, typename T>
+void BasicArray_CheckCondition(TestContext& test_context, const A& f, T value, size_t begin, size_t end)
+{
+    Condition cond;
+    size_t first = not_found;
+    size_t count = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (cond(f.get(i), value, f.is_null(i), false)) {
+            if (first == not_found)
+                first = i;
+            ++count;
+        }
+    }
+    CHECK_EQUAL(first, f.template find_first<Condition>(value, begin, end));
+    CHECK_EQUAL(count, f.template count<Condition>(value, begin, end));
+}
+
+template <class A, typename T>
+void BasicArray_Conditions(TestContext& test_context)
+{
+    // Long enough for several vectors, with every kind of special value
+    const T inf = std::numeric_limits<T>::infinity();
+    const T values[] = {T(-2), T(-1), T(-0.0), T(0), T(1), T(2.5), inf, -inf, std::numeric_limits<T>::quiet_NaN(),
+                        null::get_null_float<T>()};
+    const size_t num_values = sizeof(values) / sizeof(values[0]);
+
+    test_util::Random random(test_util::random_int<unsigned long>()); // Seed from slow global generator
+    A f(Allocator::get_default());
+    f.create();
+    const size_t size = 100;
+    for (size_t i = 0; i < size; ++i)
+        f.add(values[random.draw_int_mod(num_values)]);
+
+    for (size_t iter = 0; iter < 50; ++iter) {
+        size_t begin = random.draw_int_mod(size);
+        size_t end = begin + random.draw_int_mod(size - begin + 1);
+
+        // The needle is anything but null
+        T value = values[random.draw_int_mod(num_values - 1)];
+        BasicArray_CheckCondition<Equal>(test_context, f, value, begin, end);
+        BasicArray_CheckCondition<NotEqual>(test_context, f, value, begin, end);
+        BasicArray_CheckCondition<Greater>(test_context, f, value, begin, end);
+        BasicArray_CheckCondition<Less>(test_context, f, value, begin, end);
+        BasicArray_CheckCondition<GreaterEqual>(test_context, f, value, begin, end);
+        BasicArray_CheckCondition<LessEqual>(test_context, f, value, begin, end);
+
+        double sum = 0;
+        size_t non_null = 0;
+        size_t max_ndx = not_found;
+        size_t min_ndx = not_found;
+        for (size_t i = begin; i < end; ++i) {
+            if (f.is_null(i))
+                continue;
+            T v = f.get(i);
+            sum += v;
+            ++non_null;
+            if (std::isnan(v))
+                continue;
+            if (max_ndx == not_found || v > f.get(max_ndx))
+                max_ndx = i;
+            if (min_ndx == not_found || v < f.get(min_ndx))
+                min_ndx = i;
+        }
+
+        size_t count;
+        double actual_sum = f.sum(begin, end, &count);
+        CHECK_EQUAL(non_null, count);
+        // The values are small integers, so the sum is exact in any order
+        if (std::isnan(sum)) {
+            CHECK(std::isnan(actual_sum));
+        }
+        else {
+            CHECK_EQUAL(sum, actual_sum);
+        }
+        CHECK_EQUAL(max_ndx, f.template find_minmax<true>(begin, end, &count));
+        CHECK_EQUAL(non_null, count);
+        CHECK_EQUAL(min_ndx, f.template find_minmax<false>(begin, end, &count));
+        CHECK_EQUAL(non_null, count);
+    }
+
+    f.destroy(); // cleanup
+}
+TEST(ArrayFloat_Conditions)
+{
+    BasicArray_Conditions<ArrayFloat, float>(test_context);
+}
+TEST(ArrayDouble_Conditions)
+{
+    BasicArray_Conditions<ArrayDouble, double>(test_context);
+}
+
 #endif // TEST_ARRAY_FLOAT
@@ -0,0 +1,302 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_ASYNC_QUERY
+
+#include <realm.hpp>
+#include <realm/history.hpp>
+#include <realm/lang_bind_helper.hpp>
+
+#include "test.hpp"
+
+using namespace realm;
+using namespace realm::test_util;
+
+// Test independence and thread-safety
+// -----------------------------------
+//
+// All tests must be thread safe and independent of each other. This
+// is required because it allows for both shuffling of the execution
+// order and for parallelized testing.
+//
+// In particular, avoid using std::rand() since it is not guaranteed
+// to be thread safe. Instead use the API offered in
+// `test/util/random.hpp`.
+//
+// All files created in tests must use the TEST_PATH macro (or one of
+// its friends) to obtain a suitable file system path. See
+// `test/util/test_path.hpp`.
+//
+//
+// Debugging and the ONLY() macro
+// ------------------------------
+//
+// A simple way of disabling all tests except one called `Foo`, is to
+// replace TEST(Foo) with ONLY(Foo) and then recompile and rerun the
+// test suite. Note that you can also use filtering by setting the
+// environment varible `UNITTEST_FILTER`. See `README.md` for more on
+// this.
+//
+// Another way to debug a particular test, is to copy that test into
+// `experiments/testcase.cpp` and then run `sh build.sh
+// check-testcase` (or one of its friends) from the command line.
+
+using State = AsyncQueryExecutor::AsyncQuery::State;
+
+namespace {
+
+AsyncQueryExecutor::HistoryFactory history_factory(const std::string& path)
+{
+    return [path] { return make_in_realm_history(path); };
+}
+
+void fill(SharedGroup& sg, size_t num_rows, int seed)
+{
+    Group& g = const_cast<Group&>(sg.begin_read());
+    LangBindHelper::promote_to_write(sg);
+    TableRef table = g.get_table("table");
+    if (!table) {
+        table = g.add_table("table");
+        table->add_column(type_Int, "int");
+        table->add_column(type_String, "str");
+    }
+    Random random(seed);
+    for (size_t i = 0; i < num_rows; ++i) {
+        size_t row = table->add_empty_row();
+        table->set_int(0, row, random.draw_int_mod(1000));
+        char c = char('a' + random.draw_int_mod(26));
+        table->set_string(1, row, StringData(&c, 1));
+    }
+    LangBindHelper::commit_and_continue_as_read(sg);
+    sg.end_read();
+}
+
+} // anonymous namespace
+
+
+TEST(AsyncQuery_Basic)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, SharedGroupOptions(crypt_key()));
+    fill(sg, 2000, 1);
+
+    AsyncQueryExecutor executor(history_factory(path), SharedGroupOptions(crypt_key()));
+
+    const Group& g = sg.begin_read();
+    ConstTableRef table = g.get_table("table");
+
+    Query query = table->where().greater(0, 500).equal(1, "q");
+    auto async_query = executor.submit(sg, query);
+    CHECK(async_query->get_version() == sg.get_version_of_current_transaction());
+
+    TableView sorted = table->where().less(0, 100).find_all();
+    sorted.sort(0, false);
+    auto async_sorted = executor.submit(sg, sorted);
+
+    std::unique_ptr<TableView> tv = async_query->import_result(sg);
+    CHECK(async_query->is_ready());
+    CHECK(async_query->get_state() == State::done);
+    CHECK(tv);
+    CHECK(tv->is_in_sync());
+    TableView expected = query.find_all();
+    CHECK_EQUAL(expected.size(), tv->size());
+    for (size_t i = 0; i < expected.size() && i < tv->size(); ++i)
+        CHECK_EQUAL(expected.get_source_ndx(i), tv->get_source_ndx(i));
+
+    // The result can only be imported once
+    CHECK(!async_query->import_result(sg));
+
+    async_sorted->wait();
+    tv = async_sorted->import_result(sg);
+    CHECK(tv);
+    CHECK(tv->is_in_sync());
+    CHECK_EQUAL(sorted.size(), tv->size());
+    for (size_t i = 0; i < sorted.size() && i < tv->size(); ++i)
+        CHECK_EQUAL(sorted.get_source_ndx(i), tv->get_source_ndx(i));
+
+    // A view which is still in sync can be changed and rerun
+    tv->sort(0, true);
+    CHECK_EQUAL(sorted.get_int(0, sorted.size() - 1), tv->get_int(0, 0));
+    sg.end_read();
+}
+
+
+TEST(AsyncQuery_ImportAtOtherVersion)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, SharedGroupOptions(crypt_key()));
+    fill(sg, 100, 2);
+
+    std::unique_ptr<Replication> hist_2(make_in_realm_history(path));
+    SharedGroup sg_2(*hist_2, SharedGroupOptions(crypt_key()));
+
+    AsyncQueryExecutor executor(history_factory(path), SharedGroupOptions(crypt_key()));
+
+    const Group& g = sg.begin_read();
+    auto async_query = executor.submit(sg, g.get_table("table")->where().greater(0, 500));
+    SharedGroup::VersionID version = async_query->get_version();
+    async_query->wait();
+
+    // Move past the version of the query, which is kept alive by the query
+    sg.end_read();
+    fill(sg, 10, 3);
+    sg.begin_read();
+    CHECK_THROW(async_query->import_result(sg), SharedGroup::BadVersion);
+
+    // The result can still be imported at the right version
+    const Group& g_2 = sg_2.begin_read(version);
+    std::unique_ptr<TableView> tv = async_query->import_result(sg_2);
+    CHECK(tv);
+    CHECK(tv->is_in_sync());
+    CHECK_EQUAL(g_2.get_table("table")->where().greater(0, 500).count(), tv->size());
+    sg_2.end_read();
+    sg.end_read();
+}
+
+
+TEST(AsyncQuery_Cancel)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, SharedGroupOptions(crypt_key()));
+    fill(sg, 1000, 4);
+
+    const size_t num_queries = 20;
+    {
+        AsyncQueryExecutor executor(history_factory(path), SharedGroupOptions(crypt_key()));
+        const Group& g = sg.begin_read();
+        ConstTableRef table = g.get_table("table");
+        std::vector<std::shared_ptr<AsyncQueryExecutor::AsyncQuery>> queries;
+        for (size_t i = 0; i < num_queries; ++i)
+            queries.push_back(executor.submit(sg, table->where().greater(0, int64_t(i))));
+        for (size_t i = 0; i < num_queries; i += 2)
+            queries[i]->cancel();
+        for (size_t i = 0; i < num_queries; ++i) {
+            std::unique_ptr<TableView> tv = queries[i]->import_result(sg);
+            State state = queries[i]->get_state();
+            if (i % 2 == 0) {
+                // The query may have finished before it was cancelled
+                CHECK(state == State::cancelled || state == State::done);
+                CHECK_EQUAL(state == State::done, bool(tv));
+            }
+            else {
+                CHECK(state == State::done);
+                CHECK(tv && tv->size() == table->where().greater(0, int64_t(i)).count());
+            }
+        }
+        sg.end_read();
+
+        // Queries still queued when the executor is destroyed are cancelled
+        table = sg.begin_read().get_table("table");
+        queries.clear();
+        for (size_t i = 0; i < num_queries; ++i)
+            queries.push_back(executor.submit(sg, table->where().greater(0, int64_t(i))));
+        sg.end_read();
+        for (auto& query : queries)
+            query->cancel();
+    }
+
+    // Check that every pinned version was released: after a new commit, only
+    // the versions in use remain
+    fill(sg, 1, 5);
+    fill(sg, 1, 6);
+    CHECK_LESS_EQUAL(sg.get_number_of_versions(), 2);
+}
+
+
+TEST(AsyncQuery_CancelOnNewVersion)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, SharedGroupOptions(crypt_key()));
+    fill(sg, 100, 7);
+
+    std::unique_ptr<Replication> hist_w(make_in_realm_history(path));
+    SharedGroup sg_w(*hist_w, SharedGroupOptions(crypt_key()));
+
+    AsyncQueryExecutor executor(history_factory(path), SharedGroupOptions(crypt_key()));
+
+    const Group& g = sg.begin_read();
+    ConstTableRef table = g.get_table("table");
+    Query query = table->where().greater(0, 100);
+
+    // Nothing was committed since, so the query runs
+    auto async_query = executor.submit(sg, query, true);
+    std::unique_ptr<TableView> tv = async_query->import_result(sg);
+    CHECK(async_query->get_state() == State::done);
+    CHECK(tv);
+
+    // A newer version exists when the query runs
+    fill(sg_w, 10, 8);
+    async_query = executor.submit(sg, query, true);
+    CHECK(!async_query->import_result(sg));
+    CHECK(async_query->get_state() == State::cancelled);
+
+    // Unless the query is submitted without cancellation
+    async_query = executor.submit(sg, query);
+    tv = async_query->import_result(sg);
+    CHECK(async_query->get_state() == State::done);
+    CHECK(tv && tv->size() == query.count());
+    sg.end_read();
+}
+
+
+TEST_IF(AsyncQuery_ConcurrentWrites, !running_with_valgrind)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, SharedGroupOptions(crypt_key()));
+    fill(sg, 500, 9);
+
+    AsyncQueryExecutor executor(history_factory(path), SharedGroupOptions(crypt_key()), 4);
+
+    const size_t num_rounds = 50;
+    Thread writer;
+    writer.start([&] {
+        std::unique_ptr<Replication> hist_w(make_in_realm_history(path));
+        SharedGroup sg_w(*hist_w, SharedGroupOptions(crypt_key()));
+        for (size_t i = 0; i < num_rounds; ++i)
+            fill(sg_w, 20, int(10 + i));
+    });
+
+    for (size_t i = 0; i < num_rounds; ++i) {
+        const Group& g = sg.begin_read();
+        ConstTableRef table = g.get_table("table");
+        Query query = table->where().greater(0, int64_t(i * 10)).Or().equal(1, "x");
+        TableView view = table->where().less(0, int64_t(i * 10)).find_all();
+        view.sort(1);
+        auto async_query = executor.submit(sg, query);
+        auto async_view = executor.submit(sg, view);
+
+        std::unique_ptr<TableView> tv = async_query->import_result(sg);
+        CHECK(tv && tv->size() == query.count());
+        tv = async_view->import_result(sg);
+        CHECK(tv && tv->size() == view.size());
+        if (tv && tv->size() == view.size()) {
+            for (size_t j = 0; j < view.size(); ++j)
+                CHECK_EQUAL(view.get_source_ndx(j), tv->get_source_ndx(j));
+        }
+        sg.end_read();
+    }
+    writer.join();
+}
+
+#endif // TEST_ASYNC_QUERY
@@ -0,0 +1,383 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_GROUP_BY
+
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+
+#include <realm.hpp>
+
+#include "test.hpp"
+
+using namespace realm;
+using namespace realm::test_util;
+
+// Test independence and thread-safety
+// -----------------------------------
+//
+// All tests must be thread safe and independent of each other. This
+// is required because it allows for both shuffling of the execution
+// order and for parallelized testing.
+//
+// In particular, avoid using std::rand() since it is not guaranteed
+// to be thread safe. Instead use the API offered in
+// `test/util/random.hpp`.
+//
+// All files created in tests must use the TEST_PATH macro (or one of
+// its friends) to obtain a suitable file system path. See
+// `test/util/test_path.hpp`.
+//
+//
+// Debugging and the ONLY() macro
+// ------------------------------
+//
+// A simple way of disabling all tests except one called `Foo`, is to
+// replace TEST(Foo) with ONLY(Foo) and then recompile and rerun the
+// test suite. Note that you can also use filtering by setting the
+// environment varible `UNITTEST_FILTER`. See `README.md` for more on
+// this.
+//
+// Another way to debug a particular test, is to copy that test into
+// `experiments/testcase.cpp` and then run `sh build.sh
+// check-testcase` (or one of its friends) from the command line.
+
+using Aggregate = GroupByDescriptor::Aggregate;
+
+TEST(GroupBy_Basic)
+{
+    Table table;
+    size_t name_col = table.add_column(type_String, "name", true);
+    size_t int_col = table.add_column(type_Int, "int", true);
+    size_t double_col = table.add_column(type_Double, "double");
+    size_t bool_col = table.add_column(type_Bool, "bool");
+    size_t ts_col = table.add_column(type_Timestamp, "ts", true);
+
+    // name   int   double  bool   ts
+    // "a"    1     1.5     true   10
+    // "b"    2     2.5     false  20
+    // "a"    null  3.5     true   null
+    // null   4     4.5     false  30
+    // "a"    5     -0.5    false  10
+    // "b"    2     0.5     false  50
+    table.add_empty_row(6);
+    const char* names[] = {"a", "b", "a", nullptr, "a", "b"};
+    for (size_t i = 0; i < 6; ++i) {
+        table.set_string(name_col, i, names[i]);
+        if (i != 2) {
+            int64_t values[] = {1, 2, 0, 4, 5, 2};
+            table.set_int(int_col, i, values[i]);
+            int64_t seconds[] = {10, 20, 0, 30, 10, 50};
+            table.set_timestamp(ts_col, i, Timestamp(seconds[i], 0));
+        }
+        double doubles[] = {1.5, 2.5, 3.5, 4.5, -0.5, 0.5};
+        table.set_double(double_col, i, doubles[i]);
+        table.set_bool(bool_col, i, i == 0 || i == 2);
+    }
+
+    GroupByDescriptor descriptor(table);
+    descriptor.add_key({name_col});
+    descriptor.add_aggregate(Aggregate::count);
+    descriptor.add_aggregate(Aggregate::count, {int_col});
+    descriptor.add_aggregate(Aggregate::sum, {int_col});
+    descriptor.add_aggregate(Aggregate::average, {double_col});
+    descriptor.add_aggregate(Aggregate::min, {double_col});
+    descriptor.add_aggregate(Aggregate::max, {ts_col});
+    descriptor.add_aggregate(Aggregate::count_distinct, {int_col});
+    CHECK_EQUAL(descriptor.key_count(), 1);
+    CHECK_EQUAL(descriptor.aggregate_count(), 7);
+
+    GroupByResult result = table.where().group_by(descriptor);
+
+    // Groups come in the order they are first seen
+    CHECK_EQUAL(result.size(), 3);
+    CHECK_EQUAL(result.get_key(0, 0)->get_string(), "a");
+    CHECK_EQUAL(result.get_key(1, 0)->get_string(), "b");
+    CHECK_NOT(result.get_key(2, 0));
+
+    // "a"
+    CHECK_EQUAL(result.get_aggregate(0, 0)->get_int(), 3);
+    CHECK_EQUAL(result.get_aggregate(0, 1)->get_int(), 2);
+    CHECK_EQUAL(result.get_aggregate(0, 2)->get_int(), 6);
+    CHECK_EQUAL(result.get_aggregate(0, 3)->get_double(), 1.5);
+    CHECK_EQUAL(result.get_aggregate(0, 4)->get_double(), -0.5);
+    CHECK_EQUAL(result.get_aggregate(0, 5)->get_timestamp(), Timestamp(10, 0));
+    CHECK_EQUAL(result.get_aggregate(0, 6)->get_int(), 2);
+
+    // "b"
+    CHECK_EQUAL(result.get_aggregate(1, 0)->get_int(), 2);
+    CHECK_EQUAL(result.get_aggregate(1, 2)->get_int(), 4);
+    CHECK_EQUAL(result.get_aggregate(1, 5)->get_timestamp(), Timestamp(50, 0));
+    CHECK_EQUAL(result.get_aggregate(1, 6)->get_int(), 1);
+
+    // null
+    CHECK_EQUAL(result.get_aggregate(2, 0)->get_int(), 1);
+    CHECK_EQUAL(result.get_aggregate(2, 3)->get_double(), 4.5);
+
+    // Multiple keys, over a restricted query
+    GroupByDescriptor by_bool_and_int(table);
+    by_bool_and_int.add_key({bool_col}).add_key({int_col}).add_aggregate(Aggregate::sum, {double_col});
+    result = table.where().not_equal(name_col, "a").group_by(by_bool_and_int);
+    CHECK_EQUAL(result.size(), 2);
+    CHECK_EQUAL(result.get_key(0, 0)->get_bool(), false);
+    CHECK_EQUAL(result.get_key(0, 1)->get_int(), 2);
+    CHECK_EQUAL(result.get_aggregate(0, 0)->get_double(), 3.0);
+    CHECK_EQUAL(result.get_key(1, 1)->get_int(), 4);
+    CHECK_EQUAL(result.get_aggregate(1, 0)->get_double(), 4.5);
+
+    // Aggregates without values
+    GroupByDescriptor min_int(table);
+    min_int.add_key({bool_col}).add_aggregate(Aggregate::min, {int_col}).add_aggregate(Aggregate::average, {int_col});
+    result = table.where().equal(name_col, "a").equal(bool_col, true).find_all().group_by(min_int);
+    CHECK_EQUAL(result.size(), 1);
+    CHECK_EQUAL(result.get_aggregate(0, 0)->get_int(), 1);
+    result = table.where().equal(int_col, null()).find_all().group_by(min_int);
+    CHECK_EQUAL(result.size(), 1);
+    CHECK_NOT(result.get_aggregate(0, 0));
+    CHECK_NOT(result.get_aggregate(0, 1));
+
+    // No rows, no groups
+    result = table.where().equal(name_col, "none").group_by(descriptor);
+    CHECK_EQUAL(result.size(), 0);
+
+    // The string keys move with the result
+    GroupByResult moved(table.where().group_by(descriptor));
+    result = std::move(moved);
+    CHECK_EQUAL(result.size(), 3);
+    CHECK_EQUAL(result.get_key(0, 0)->get_string(), "a");
+
+    // The rows must be those of the table that the descriptor was made for
+    Table other;
+    other.add_column(type_String, "name");
+    other.add_empty_row();
+    CHECK_LOGIC_ERROR(other.where().group_by(descriptor), LogicError::illegal_combination);
+    CHECK_LOGIC_ERROR(other.where().find_all().group_by(descriptor), LogicError::illegal_combination);
+}
+
+TEST(GroupBy_TimestampBuckets)
+{
+    Table table;
+    size_t ts_col = table.add_column(type_Timestamp, "ts");
+    size_t int_col = table.add_column(type_Int, "int");
+
+    // Two hour buckets, including negative timestamps which must round down
+    int64_t seconds[] = {-7201, -1, 0, 3599, 7199, 7200, 86400};
+    int32_t nanoseconds[] = {0, -5, 0, 999999999, 0, 0, 0};
+    table.add_empty_row(7);
+    for (size_t i = 0; i < 7; ++i) {
+        table.set_timestamp(ts_col, i, Timestamp(seconds[i], nanoseconds[i]));
+        table.set_int(int_col, i, 1);
+    }
+
+    GroupByDescriptor descriptor(table);
+    descriptor.add_timestamp_bucket({ts_col}, 7200);
+    descriptor.add_aggregate(Aggregate::sum, {int_col});
+    GroupByResult result = table.where().group_by(descriptor);
+
+    std::map<int64_t, int64_t> counts;
+    for (size_t g = 0; g < result.size(); ++g)
+        counts[result.get_key(g, 0)->get_timestamp().get_seconds()] = result.get_aggregate(g, 0)->get_int();
+    std::map<int64_t, int64_t> expected = {{-14400, 1}, {-7200, 1}, {0, 3}, {7200, 1}, {86400, 1}};
+    CHECK(counts == expected);
+
+    CHECK_THROW(descriptor.add_timestamp_bucket({int_col}, 60), LogicError);
+    CHECK_THROW(descriptor.add_timestamp_bucket({ts_col}, 0), LogicError);
+    CHECK_EQUAL(descriptor.key_count(), 1);
+}
+
+TEST(GroupBy_Links)
+{
+    Group g;
+    TableRef customers = g.add_table("customers");
+    TableRef orders = g.add_table("orders");
+    size_t city_col = customers->add_column(type_String, "city");
+    size_t customer_col = orders->add_column_link(type_Link, "customer", *customers);
+    size_t amount_col = orders->add_column(type_Int, "amount");
+
+    customers->add_empty_row(3);
+    customers->set_string(city_col, 0, "Oslo");
+    customers->set_string(city_col, 1, "Rome");
+    customers->set_string(city_col, 2, "Oslo");
+
+    // customer: 0, 1, 2, null, 0, 2
+    orders->add_empty_row(6);
+    size_t links[] = {0, 1, 2, npos, 0, 2};
+    for (size_t i = 0; i < 6; ++i) {
+        if (links[i] != npos)
+            orders->set_link(customer_col, i, links[i]);
+        orders->set_int(amount_col, i, int64_t(i + 1));
+    }
+
+    // By target row
+    GroupByDescriptor by_customer(*orders);
+    by_customer.add_key({customer_col}).add_aggregate(Aggregate::sum, {amount_col});
+    GroupByResult result = orders->where().group_by(by_customer);
+    CHECK_EQUAL(result.size(), 4);
+    CHECK_EQUAL(result.get_key(0, 0)->get_int(), 0);
+    CHECK_EQUAL(result.get_aggregate(0, 0)->get_int(), 1 + 5);
+    CHECK_EQUAL(result.get_key(2, 0)->get_int(), 2);
+    CHECK_EQUAL(result.get_aggregate(2, 0)->get_int(), 3 + 6);
+    CHECK_NOT(result.get_key(3, 0));
+
+    // By a property of the target, and counting distinct targets
+    GroupByDescriptor by_city(*orders);
+    by_city.add_key({customer_col, city_col});
+    by_city.add_aggregate(Aggregate::count);
+    by_city.add_aggregate(Aggregate::count_distinct, {customer_col});
+    by_city.add_aggregate(Aggregate::count_distinct, {customer_col, city_col});
+    result = orders->where().group_by(by_city);
+    CHECK_EQUAL(result.size(), 3);
+    CHECK_EQUAL(result.get_key(0, 0)->get_string(), "Oslo");
+    CHECK_EQUAL(result.get_aggregate(0, 0)->get_int(), 4);
+    CHECK_EQUAL(result.get_aggregate(0, 1)->get_int(), 2);
+    CHECK_EQUAL(result.get_aggregate(0, 2)->get_int(), 1);
+    CHECK_EQUAL(result.get_key(1, 0)->get_string(), "Rome");
+    CHECK_NOT(result.get_key(2, 0));
+    CHECK_EQUAL(result.get_aggregate(2, 1)->get_int(), 0);
+
+    // The result owns its strings
+    customers->set_string(city_col, 0, "Bergen");
+    CHECK_EQUAL(result.get_key(0, 0)->get_string(), "Oslo");
+
+    // Invalid descriptors
+    GroupByDescriptor invalid(*orders);
+    CHECK_THROW(invalid.add_key({amount_col, city_col}), LogicError);
+    CHECK_THROW(invalid.add_key({}), LogicError);
+    CHECK_THROW(invalid.add_key({10}), LogicError);
+    CHECK_THROW(invalid.add_aggregate(Aggregate::sum, {customer_col}), LogicError);
+    CHECK_THROW(invalid.add_aggregate(Aggregate::sum), LogicError);
+    CHECK_EQUAL(invalid.key_count(), 0);
+    CHECK_EQUAL(invalid.aggregate_count(), 0);
+}
+
+TEST(GroupBy_Random)
+{
+    // Compare against a straightforward aggregation through std::map
+    Table table;
+    size_t str_col = table.add_column(type_String, "str");
+    size_t int_col = table.add_column(type_Int, "int");
+    size_t float_col = table.add_column(type_Float, "float");
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const size_t num_rows = 5000;
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        std::string str = "s" + util::to_string(random.draw_int_mod(20));
+        table.set_string(str_col, i, str);
+        table.set_int(int_col, i, random.draw_int<int64_t>(-5, 5));
+        table.set_float(float_col, i, float(random.draw_int_mod(10)));
+    }
+    table.optimize();
+
+    using GroupKey = std::pair<std::string, int64_t>;
+    struct Expected {
+        int64_t count = 0;
+        double sum = 0;
+        float max = 0;
+        std::set<float> distinct;
+    };
+    std::map<GroupKey, Expected> expected;
+    TableView view = table.where().greater(int_col, -3).find_all();
+    for (size_t i = 0; i < view.size(); ++i) {
+        auto& e = expected[GroupKey(view.get_string(str_col, i), view.get_int(int_col, i))];
+        float value = view.get_float(float_col, i);
+        e.max = e.count++ == 0 ? value : std::max(e.max, value);
+        e.sum += value;
+        e.distinct.insert(value);
+    }
+
+    GroupByDescriptor descriptor(table);
+    descriptor.add_key({str_col}).add_key({int_col});
+    descriptor.add_aggregate(Aggregate::count);
+    descriptor.add_aggregate(Aggregate::sum, {float_col});
+    descriptor.add_aggregate(Aggregate::max, {float_col});
+    descriptor.add_aggregate(Aggregate::count_distinct, {float_col});
+    GroupByResult result = view.group_by(descriptor);
+
+    CHECK_EQUAL(result.size(), expected.size());
+    for (size_t g = 0; g < result.size(); ++g) {
+        GroupKey key(result.get_key(g, 0)->get_string(), result.get_key(g, 1)->get_int());
+        auto it = expected.find(key);
+        if (!CHECK(it != expected.end()))
+            continue;
+        CHECK_EQUAL(result.get_aggregate(g, 0)->get_int(), it->second.count);
+        CHECK_EQUAL(result.get_aggregate(g, 1)->get_double(), it->second.sum);
+        CHECK_EQUAL(result.get_aggregate(g, 2)->get_float(), it->second.max);
+        CHECK_EQUAL(result.get_aggregate(g, 3)->get_int(), int64_t(it->second.distinct.size()));
+    }
+}
+
+TEST(GroupBy_Threads)
+{
+    // Ranges of rows aggregated by separate threads must give the groups, in
+    // the same order, and the values of a single range
+    Table table;
+    size_t str_col = table.add_column(type_String, "str", true);
+    size_t int_col = table.add_column(type_Int, "int");
+    size_t float_col = table.add_column(type_Float, "float");
+    size_t ts_col = table.add_column(type_Timestamp, "ts", true);
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const size_t num_rows = 70000; // enough for 4 threads
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        // Some groups are only seen in the later ranges
+        size_t num_strings = i < num_rows / 2 ? 50 : 60;
+        size_t str = random.draw_int_mod(num_strings);
+        std::string value = "s" + util::to_string(str);
+        table.set_string(str_col, i, str == 0 ? StringData() : StringData(value));
+        table.set_int(int_col, i, random.draw_int<int64_t>(-3, 3));
+        table.set_float(float_col, i, float(random.draw_int_mod(100)));
+        if (random.draw_int_mod(10) != 0)
+            table.set_timestamp(ts_col, i, Timestamp(random.draw_int<int64_t>(-1000, 1000), 0));
+    }
+
+    GroupByDescriptor descriptor(table);
+    descriptor.add_key({str_col}).add_key({int_col});
+    descriptor.add_aggregate(Aggregate::count);
+    descriptor.add_aggregate(Aggregate::sum, {int_col});
+    descriptor.add_aggregate(Aggregate::average, {float_col});
+    descriptor.add_aggregate(Aggregate::min, {ts_col});
+    descriptor.add_aggregate(Aggregate::max, {float_col});
+    descriptor.add_aggregate(Aggregate::count_distinct, {float_col});
+    descriptor.add_aggregate(Aggregate::count_distinct, {str_col});
+    TableView view = table.where().find_all();
+    GroupByResult expected = view.group_by(descriptor.set_max_threads(1));
+    GroupByResult result = view.group_by(descriptor.set_max_threads(4));
+
+    CHECK_EQUAL(result.size(), 60 * 7);
+    CHECK_EQUAL(result.size(), expected.size());
+    for (size_t g = 0; g < result.size() && g < expected.size(); ++g) {
+        CHECK_EQUAL(bool(result.get_key(g, 0)), bool(expected.get_key(g, 0)));
+        if (result.get_key(g, 0) && expected.get_key(g, 0))
+            CHECK_EQUAL(result.get_key(g, 0)->get_string(), expected.get_key(g, 0)->get_string());
+        CHECK_EQUAL(result.get_key(g, 1)->get_int(), expected.get_key(g, 1)->get_int());
+        CHECK_EQUAL(result.get_aggregate(g, 0)->get_int(), expected.get_aggregate(g, 0)->get_int());
+        CHECK_EQUAL(result.get_aggregate(g, 1)->get_int(), expected.get_aggregate(g, 1)->get_int());
+        CHECK_EQUAL(result.get_aggregate(g, 2)->get_double(), expected.get_aggregate(g, 2)->get_double());
+        CHECK_EQUAL(result.get_aggregate(g, 3)->get_timestamp(), expected.get_aggregate(g, 3)->get_timestamp());
+        CHECK_EQUAL(result.get_aggregate(g, 4)->get_float(), expected.get_aggregate(g, 4)->get_float());
+        CHECK_EQUAL(result.get_aggregate(g, 5)->get_int(), expected.get_aggregate(g, 5)->get_int());
+        CHECK_EQUAL(result.get_aggregate(g, 6)->get_int(), expected.get_aggregate(g, 6)->get_int());
+    }
+}
+
+#endif // TEST_GROUP_BY
@@ -3531,6 +3531,133 @@ TEST(LangBindHelper_AdvanceReadTransact_SimpleSwapRows)
 }
 
 
+TEST(LangBindHelper_AdvanceReadTransact_TableViewChanges)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    ShortCircuitHistory hist(path);
+    SharedGroup sg(hist, SharedGroupOptions(crypt_key()));
+    SharedGroup sg_w(hist, SharedGroupOptions(crypt_key()));
+
+    {
+        WriteTransaction wt(sg_w);
+        TableRef target = wt.add_table("target");
+        target->add_column(type_Int, "value");
+        target->add_empty_row(10);
+        TableRef origin = wt.add_table("origin");
+        origin->add_column(type_Int, "int");
+        origin->add_column(type_String, "str", true);
+        origin->add_column_link(type_Link, "link", *target);
+        origin->add_search_index(1);
+        wt.commit();
+    }
+
+    ReadTransaction rt(sg);
+    ConstTableRef origin = rt.get_table("origin");
+    ConstTableRef target = rt.get_table("target");
+
+    auto sorted = [&](Query query) {
+        TableView tv = query.find_all();
+        tv.sort(SortDescriptor(*origin, {{1}, {0}}, {true, false}));
+        return tv;
+    };
+    auto check_same_rows = [&](const TableView& view, const TableView& expected) {
+        if (!CHECK_EQUAL(view.size(), expected.size()))
+            return;
+        for (size_t i = 0; i < view.size(); ++i)
+            CHECK_EQUAL(view.get_source_ndx(i), expected.get_source_ndx(i));
+    };
+
+    // These views are brought up to date from the changed rows
+    TableView by_int = origin->where().greater(0, 10).find_all();
+    TableView by_str = origin->where().equal(1, "a").Or().equal(1, "c").find_all();
+    TableView all = origin->where().find_all();
+    TableView by_str_and_int = sorted(origin->where().less(0, 50));
+    std::vector<TableView*> updated = {&by_int, &by_str, &all, &by_str_and_int};
+
+    // These depend on more than the values of each row, so they are rerun
+    TableView by_link = origin->where().links_to(2, target->get(0)).find_all();
+    auto sorted_by_link = [&] {
+        TableView tv = origin->where().find_all();
+        tv.sort(SortDescriptor(*origin, {{2, 0}}));
+        return tv;
+    };
+    TableView by_link_value = sorted_by_link();
+    TableView limited = origin->where().find_all(0, size_t(-1), 5);
+    auto distinct_by_str = [&] {
+        TableView tv = origin->where().find_all();
+        tv.distinct(1);
+        return tv;
+    };
+    TableView distinct = distinct_by_str();
+
+    Random random(random_int<unsigned long>());
+    const char* strings[] = {"a", "b", "c", nullptr};
+    for (int i = 0; i < 100; ++i) {
+        // More changes than are tracked
+        bool bulk_insert = i % 25 == 24;
+        {
+            WriteTransaction wt(sg_w);
+            TableRef origin_w = wt.get_table("origin");
+            TableRef target_w = wt.get_table("target");
+            auto set_values = [&](size_t row) {
+                origin_w->set_int(0, row, random.draw_int_mod(100));
+                origin_w->set_string(1, row, strings[random.draw_int_mod(4)]);
+                if (random.draw_bool())
+                    origin_w->set_link(2, row, random.draw_int_mod(target_w->size()));
+            };
+            if (bulk_insert)
+                origin_w->add_empty_row(1000);
+            for (int n = random.draw_int(1, 5); n > 0; --n) {
+                size_t size = origin_w->size();
+                switch (random.draw_int_mod(8)) {
+                    case 0:
+                        set_values(origin_w->add_empty_row());
+                        break;
+                    case 1:
+                        origin_w->insert_empty_row(random.draw_int_mod(size + 1));
+                        break;
+                    case 2:
+                        if (size > 0)
+                            origin_w->move_last_over(random.draw_int_mod(size));
+                        break;
+                    case 3:
+                        if (size > 0)
+                            origin_w->remove(random.draw_int_mod(size));
+                        break;
+                    case 4:
+                        // Nullifies the links to the removed row. Row 0 is kept, as by_link follows it.
+                        target_w->move_last_over(random.draw_int(size_t(1), target_w->size() - 1));
+                        target_w->add_empty_row();
+                        break;
+                    default:
+                        if (size > 0)
+                            set_values(random.draw_int_mod(size));
+                        break;
+                }
+            }
+            wt.commit();
+        }
+        LangBindHelper::advance_read(sg);
+
+        for (TableView* view : updated)
+            view->sync_if_needed();
+        check_same_rows(by_int, origin->where().greater(0, 10).find_all());
+        check_same_rows(by_str, origin->where().equal(1, "a").Or().equal(1, "c").find_all());
+        check_same_rows(all, origin->where().find_all());
+        check_same_rows(by_str_and_int, sorted(origin->where().less(0, 50)));
+
+        by_link.sync_if_needed();
+        check_same_rows(by_link, origin->where().links_to(2, target->get(0)).find_all());
+        by_link_value.sync_if_needed();
+        check_same_rows(by_link_value, sorted_by_link());
+        limited.sync_if_needed();
+        check_same_rows(limited, origin->where().find_all(0, size_t(-1), 5));
+        distinct.sync_if_needed();
+        check_same_rows(distinct, distinct_by_str());
+    }
+}
+
+
 TEST(LangBindHelper_AdvanceReadTransact_ChangeLinkTargets)
 {
     SHARED_GROUP_TEST_PATH(path);
@@ -7908,6 +8035,10 @@ public:
     {
         return false;
     }
+    bool refresh_table()
+    {
+        return false;
+    }
 };
 
 struct AdvanceReadTransact {
@@ -8098,6 +8229,191 @@ TEST_TYPES(LangBindHelper_AdvanceReadTransact_TransactLog, AdvanceReadTransact,
 }
 
 
+TEST(LangBindHelper_AdvanceReadTransact_RefreshAccessors)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroupOptions options(crypt_key());
+    options.accessor_refresh_threshold = 0; // Whenever possible
+    SharedGroup sg(*hist, options);
+    std::unique_ptr<Replication> hist_w(make_in_realm_history(path));
+    SharedGroup sg_w(*hist_w, SharedGroupOptions(crypt_key()));
+
+    {
+        WriteTransaction wt(sg_w);
+        TableRef target = wt.add_table("target");
+        target->add_column(type_Int, "int");
+        target->add_empty_row(10);
+        TableRef origin = wt.add_table("origin");
+        origin->add_column(type_Int, "int");
+        origin->add_column(type_String, "str");
+        origin->add_column_link(type_Link, "link", *target);
+        origin->add_empty_row(10);
+        TableRef unchanged = wt.add_table("unchanged");
+        unchanged->add_column(type_Int, "int");
+        unchanged->add_empty_row(10);
+        wt.commit();
+    }
+
+    ReadTransaction rt(sg);
+    const Group& group = rt.get_group();
+    ConstTableRef target = group.get_table("target");
+    ConstTableRef origin = group.get_table("origin");
+    ConstTableRef unchanged = group.get_table("unchanged");
+    TableView unchanged_view = unchanged->where().find_all();
+
+    // Without any accessors attached to the rows of the changed tables, the
+    // accessors are refreshed from those tables, and the observer still gets
+    // all the instructions
+    {
+        WriteTransaction wt(sg_w);
+        TableRef origin_w = wt.get_table("origin");
+        origin_w->add_empty_row(90);
+        for (size_t i = 0; i < 100; ++i) {
+            origin_w->set_int(0, i, int64_t(i));
+            std::string str = util::to_string(i);
+            origin_w->set_string(1, i, str);
+            origin_w->set_link(2, i, i % 10);
+        }
+        wt.get_table("target")->set_int(0, 9, 9);
+        wt.commit();
+    }
+    struct : _impl::NullInstructionObserver {
+        size_t num_set_int = 0;
+        bool set_int(size_t, size_t, int_fast64_t, _impl::Instruction, size_t)
+        {
+            ++num_set_int;
+            return true;
+        }
+    } parser;
+    LangBindHelper::advance_read(sg, parser);
+    group.verify();
+    CHECK_EQUAL(parser.num_set_int, 101);
+    CHECK(origin->is_attached());
+    CHECK_EQUAL(origin->size(), 100);
+    CHECK_EQUAL(origin->get_int(0, 99), 99);
+    CHECK_EQUAL(origin->get_string(1, 42), "42");
+    CHECK_EQUAL(origin->get_link(2, 42), 2);
+    CHECK_EQUAL(target->get_int(0, 9), 9);
+    CHECK_EQUAL(unchanged->size(), 10);
+    CHECK(unchanged_view.is_in_sync());
+    TableView by_int = origin->where().greater(0, 50).find_all();
+    CHECK_EQUAL(by_int.size(), 49);
+    CHECK_EQUAL(by_int.get_source_ndx(0), 51);
+
+    // Views are adjusted by replaying the changesets
+    {
+        WriteTransaction wt(sg_w);
+        wt.get_table("origin")->move_last_over(51);
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    group.verify();
+    CHECK(!by_int.is_in_sync());
+    CHECK_EQUAL(by_int.size(), 49);
+    CHECK(!by_int.is_row_attached(0));
+    CHECK_EQUAL(by_int.get_source_ndx(48), 51);
+    by_int = TableView();
+    CHECK_EQUAL(origin->get_int(0, 51), 99);
+
+    // Row accessors are moved along with their rows by replaying the changesets
+    ConstRow row = origin->get(42);
+    {
+        WriteTransaction wt(sg_w);
+        wt.get_table("origin")->insert_empty_row(0);
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    group.verify();
+    CHECK(row.is_attached());
+    CHECK_EQUAL(row.get_index(), 43);
+    CHECK_EQUAL(row.get_int(0), 42);
+    row.detach();
+
+    // So is a schema change
+    {
+        WriteTransaction wt(sg_w);
+        wt.get_table("origin")->insert_column(0, type_Bool, "bool");
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    group.verify();
+    CHECK_EQUAL(origin->get_column_count(), 4);
+    CHECK_EQUAL(origin->get_int(1, 43), 42);
+    CHECK_EQUAL(origin->get_link(3, 43), 2);
+}
+
+
+TEST(LangBindHelper_AdvanceReadTransact_SetRange)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, SharedGroupOptions(crypt_key()));
+    std::unique_ptr<Replication> hist_w(make_in_realm_history(path));
+    SharedGroup sg_w(*hist_w, SharedGroupOptions(crypt_key()));
+
+    {
+        WriteTransaction wt(sg_w);
+        TableRef table = wt.add_table("table");
+        table->add_column(type_Int, "int");
+        table->add_column(type_Int, "nullable", true);
+        table->add_empty_row(100);
+        for (size_t i = 0; i < 100; ++i)
+            table->set_int(0, i, int64_t(i));
+        wt.commit();
+    }
+
+    ReadTransaction rt(sg);
+    ConstTableRef table = rt.get_group().get_table("table");
+    TableView view = table->where().greater(0, 50).find_all();
+    CHECK_EQUAL(view.size(), 49);
+    ConstRow row = table->get(95);
+
+    {
+        WriteTransaction wt(sg_w);
+        TableRef table_w = wt.get_table("table");
+        std::vector<int64_t> zeros(10, 0);
+        table_w->fill(0, 0, 10, 100);
+        table_w->set_range(0, 90, zeros.data(), zeros.size());
+        table_w->fill(1, 20, 25, null());
+        wt.commit();
+    }
+
+    // The advancer handles each instr_SetRange in one go, but an observer
+    // still sees every row
+    struct : _impl::NullInstructionObserver {
+        size_t num_set_int = 0;
+        size_t num_set_null = 0;
+        bool set_int(size_t, size_t, int_fast64_t, _impl::Instruction, size_t)
+        {
+            ++num_set_int;
+            return true;
+        }
+        bool set_null(size_t, size_t, _impl::Instruction, size_t)
+        {
+            ++num_set_null;
+            return true;
+        }
+    } parser;
+    LangBindHelper::advance_read(sg, parser);
+    rt.get_group().verify();
+    CHECK_EQUAL(parser.num_set_int, 20);
+    CHECK_EQUAL(parser.num_set_null, 5);
+    CHECK(row.is_attached());
+    CHECK_EQUAL(row.get_int(0), 0);
+    CHECK(table->is_null(1, 22));
+
+    // The changed rows were tracked for the view
+    CHECK(!view.is_in_sync());
+    view.sync_if_needed();
+    CHECK_EQUAL(view.size(), 49);
+    CHECK_EQUAL(view.get_source_ndx(0), 0);
+    CHECK_EQUAL(view.get_source_ndx(9), 9);
+    CHECK_EQUAL(view.get_source_ndx(10), 51);
+    CHECK_EQUAL(view.get_source_ndx(48), 89);
+}
+
+
 TEST(LangBindHelper_AdvanceReadTransact_ErrorInObserver)
 {
     SHARED_GROUP_TEST_PATH(path);
@@ -8884,6 +9200,78 @@ TEST(LangBindHelper_RollbackAndContinueAsRead_IntIndex)
 }
 
 
+TEST(LangBindHelper_RollbackAndContinueAsRead_SetRange)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, SharedGroupOptions(crypt_key()));
+
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("table");
+        table->add_column(type_Int, "int");
+        table->add_column(type_Double, "double", true);
+        table->add_empty_row(100);
+        for (size_t i = 0; i < 100; ++i)
+            table->set_int(0, i, int64_t(i));
+        wt.commit();
+    }
+
+    Group& g = const_cast<Group&>(sg.begin_read());
+    TableRef table = g.get_table("table");
+    TableView view = table->where().greater(0, 50).find_all();
+    Row row = table->get(95);
+
+    LangBindHelper::promote_to_write(sg);
+    std::vector<int64_t> values(30);
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = int64_t(1000 + i);
+    table->set_range(0, 70, values.data(), values.size());
+    table->fill(0, 0, 10, 100);
+    table->fill(1, 0, 100, 2.5);
+    table->fill(1, 40, 50, null());
+    CHECK_EQUAL(row.get_int(0), 1025);
+
+    // The reversed log still expands the ranges into a set_*() per row
+    struct : _impl::NullInstructionObserver {
+        size_t num_set_int = 0;
+        size_t num_set_double = 0;
+        size_t num_set_null = 0;
+        bool set_int(size_t, size_t, int_fast64_t, _impl::Instruction, size_t)
+        {
+            ++num_set_int;
+            return true;
+        }
+        bool set_double(size_t, size_t, double, _impl::Instruction)
+        {
+            ++num_set_double;
+            return true;
+        }
+        bool set_null(size_t, size_t, _impl::Instruction, size_t)
+        {
+            ++num_set_null;
+            return true;
+        }
+    } parser;
+    LangBindHelper::rollback_and_continue_as_read(sg, parser);
+    g.verify();
+    CHECK_EQUAL(parser.num_set_int, 40);
+    CHECK_EQUAL(parser.num_set_double, 100);
+    CHECK_EQUAL(parser.num_set_null, 10);
+
+    CHECK(row.is_attached());
+    CHECK_EQUAL(row.get_int(0), 95);
+    for (size_t i = 0; i < 100; ++i) {
+        CHECK_EQUAL(table->get_int(0, i), int64_t(i));
+        CHECK(table->is_null(1, i));
+    }
+    view.sync_if_needed();
+    CHECK_EQUAL(view.size(), 49);
+    CHECK_EQUAL(view.get_source_ndx(0), 51);
+    CHECK_EQUAL(view.get_source_ndx(48), 99);
+}
+
+
 TEST(LangBindHelper_RollbackAndContinueAsRead_TransactLog)
 {
     SHARED_GROUP_TEST_PATH(path);
@@ -2040,4 +2040,99 @@ TEST(BackLink_Query_MultipleLevelsAndTables)
     CHECK_TABLE_VIEW(q.find_all(), {1});
 }
 
+// Conditions on a column behind links may be evaluated by finding the matching target rows first and following
+// their backlinks. The results must not depend on which direction is chosen.
+TEST(Link_QueryReverseTraversal)
+{
+    Group group;
+    TableRef person = group.add_table("person");
+    TableRef dog = group.add_table("dog");
+    TableRef walker = group.add_table("walker");
+    size_t col_name = person->add_column(type_String, "name", true);
+    size_t col_age = person->add_column(type_Int, "age", true);
+    size_t col_owner = dog->add_column_link(type_Link, "owner", *person);
+    size_t col_dogs = walker->add_column_link(type_LinkList, "dogs", *dog);
+
+    const size_t num_persons = 1000;
+    const size_t num_dogs = 3000;
+    const size_t num_walkers = 2000;
+    person->add_empty_row(num_persons);
+    dog->add_empty_row(num_dogs);
+    walker->add_empty_row(num_walkers);
+    for (size_t i = 0; i < num_persons; ++i) {
+        if (i % 100 == 42)
+            continue; // leave as null
+        std::string name = "p" + util::to_string(i);
+        person->set_string(col_name, i, name);
+        person->set_int(col_age, i, int64_t(i % 100));
+    }
+    for (size_t i = 0; i < num_dogs; ++i) {
+        if (i % 10 != 5)
+            dog->set_link(col_owner, i, (i * 7) % num_persons);
+    }
+    for (size_t i = 0; i < num_walkers; ++i) {
+        LinkViewRef dogs = walker->get_linklist(col_dogs, i);
+        for (size_t j = 0; j < i % 4; ++j)
+            dogs->add((i * 13 + j * 101) % num_dogs);
+    }
+
+    auto dog_matches = [&](size_t d, std::function<bool(size_t)> pred) {
+        return !dog->is_null_link(col_owner, d) && pred(dog->get_link(col_owner, d));
+    };
+    auto count_dogs = [&](std::function<bool(size_t)> pred) {
+        size_t n = 0;
+        for (size_t d = 0; d < num_dogs; ++d)
+            n += dog_matches(d, pred) ? 1 : 0;
+        return n;
+    };
+    auto count_walkers = [&](std::function<bool(size_t)> pred) {
+        size_t n = 0;
+        for (size_t w = 0; w < num_walkers; ++w) {
+            LinkViewRef dogs = walker->get_linklist(col_dogs, w);
+            bool match = false;
+            for (size_t j = 0; j < dogs->size(); ++j)
+                match = match || dog_matches(dogs->get(j).get_index(), pred);
+            n += match ? 1 : 0;
+        }
+        return n;
+    };
+    auto age_is = [&](size_t p, std::function<bool(int64_t)> pred) {
+        return !person->is_null(col_age, p) && pred(person->get_int(col_age, p));
+    };
+
+    // selective conditions, one and two levels deep
+    Query q = dog->link(col_owner).column<String>(col_name) == "p7";
+    CHECK_EQUAL(q.count(), count_dogs([](size_t p) { return p == 7; }));
+    TableView tv = q.find_all();
+    for (size_t i = 0; i < tv.size(); ++i)
+        CHECK_EQUAL(dog->get_link(col_owner, tv.get_source_ndx(i)), 7);
+
+    q = dog->link(col_owner).column<Int>(col_age) > 97;
+    CHECK_EQUAL(q.count(), count_dogs([&](size_t p) { return age_is(p, [](int64_t a) { return a > 97; }); }));
+    q = walker->link(col_dogs).link(col_owner).column<Int>(col_age) == 3;
+    CHECK_EQUAL(q.count(), count_walkers([&](size_t p) { return age_is(p, [](int64_t a) { return a == 3; }); }));
+    q = walker->link(col_dogs).link(col_owner).column<String>(col_name).begins_with("p99");
+    CHECK_EQUAL(q.count(), count_walkers([](size_t p) { return p >= 990 || p == 99; }));
+
+    // conditions matching most rows
+    q = dog->link(col_owner).column<Int>(col_age) >= 2;
+    CHECK_EQUAL(q.count(), count_dogs([&](size_t p) { return age_is(p, [](int64_t a) { return a >= 2; }); }));
+    q = walker->link(col_dogs).link(col_owner).column<Int>(col_age) < 90;
+    CHECK_EQUAL(q.count(), count_walkers([&](size_t p) { return age_is(p, [](int64_t a) { return a < 90; }); }));
+
+    // conditions which match a missing link must still be evaluated forward
+    q = dog->link(col_owner).column<String>(col_name) != "p7";
+    CHECK_EQUAL(q.count(), num_dogs - count_dogs([](size_t p) { return p == 7; }));
+    q = dog->link(col_owner).column<Int>(col_age) == null();
+    CHECK_EQUAL(q.count(), num_dogs - count_dogs([&](size_t p) { return !person->is_null(col_age, p); }));
+
+    // kept up to date in a view
+    tv = (dog->link(col_owner).column<String>(col_name) == "p21").find_all();
+    size_t before = tv.size();
+    CHECK_EQUAL(before, count_dogs([](size_t p) { return p == 21; }));
+    dog->set_link(col_owner, 5, 21);
+    tv.sync_if_needed();
+    CHECK_EQUAL(tv.size(), before + 1);
+}
+
 #endif
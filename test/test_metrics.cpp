@@ -780,6 +780,80 @@ TEST(Metrics_TransactionTimings)
 }
 
 
+TEST(Metrics_CommitPhases)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroupOptions options(crypt_key());
+    options.enable_metrics = true;
+    SharedGroup sg(*hist, options);
+    {
+        WriteTransaction wt(sg);
+        TableRef t = wt.add_table("table");
+        t->add_column(type_String, "str");
+        t->add_empty_row(1000);
+        for (size_t i = 0; i < 1000; ++i)
+            t->set_string(0, i, "a string which is long enough to need some space");
+        wt.commit();
+    }
+    {
+        ReadTransaction rt(sg);
+    }
+
+    // Make the next write transaction wait for the write lock
+    std::unique_ptr<Replication> hist_2(make_in_realm_history(path));
+    SharedGroup sg_2(*hist_2, SharedGroupOptions(crypt_key()));
+    sg_2.begin_write();
+    auto writer = std::async(std::launch::async, [&] {
+        WriteTransaction wt(sg);
+        wt.get_table(0)->set_string(0, 0, "modified");
+        wt.commit();
+    });
+    using namespace std::literals::chrono_literals;
+    std::this_thread::sleep_for(50ms);
+    sg_2.rollback();
+    writer.get();
+
+    std::unique_ptr<Metrics::TransactionInfoList> transactions = sg.get_metrics()->take_transactions();
+    CHECK_EQUAL(transactions->size(), 3);
+
+    const TransactionInfo& first = transactions->at(0);
+    CHECK_EQUAL(first.get_transaction_type(), TransactionInfo::write_transaction);
+    CHECK_GREATER(first.get_num_bytes_written(), 1000 * 48);
+    CHECK_GREATER(first.get_num_pages_dirtied(), 0);
+    CHECK_GREATER_EQUAL(first.get_num_pages_dirtied() * page_size(), first.get_num_bytes_written());
+    CHECK_GREATER(first.get_file_growth(), 0);
+    CHECK_GREATER(first.get_commit_phase_time_nanoseconds(TransactionInfo::commit_FreeListRead), 0);
+    CHECK_GREATER(first.get_commit_phase_time_nanoseconds(TransactionInfo::commit_FreeListRecreate), 0);
+    CHECK_GREATER(first.get_commit_phase_time_nanoseconds(TransactionInfo::commit_FileGrowth), 0);
+    CHECK_GREATER(first.get_commit_phase_time_nanoseconds(TransactionInfo::commit_ReaderRefresh), 0);
+    CHECK_LESS_EQUAL(first.get_commit_phase_time_nanoseconds(TransactionInfo::commit_FreeListRead) +
+                         first.get_commit_phase_time_nanoseconds(TransactionInfo::commit_FreeListRecreate),
+                     first.get_write_time_nanoseconds());
+    CHECK_LESS_EQUAL(first.get_commit_phase_time_nanoseconds(TransactionInfo::commit_DataSync) +
+                         first.get_commit_phase_time_nanoseconds(TransactionInfo::commit_HeaderSync),
+                     first.get_fsync_time_nanoseconds());
+    if (get_disable_sync_to_disk()) {
+        CHECK_EQUAL(first.get_commit_phase_time_nanoseconds(TransactionInfo::commit_DataSync), 0);
+        CHECK_EQUAL(first.get_commit_phase_time_nanoseconds(TransactionInfo::commit_HeaderSync), 0);
+    }
+
+    const TransactionInfo& read = transactions->at(1);
+    CHECK_EQUAL(read.get_transaction_type(), TransactionInfo::read_transaction);
+    CHECK_EQUAL(read.get_num_bytes_written(), 0);
+    for (int phase = 0; phase < TransactionInfo::num_commit_phases; ++phase)
+        CHECK_EQUAL(read.get_commit_phase_time_nanoseconds(TransactionInfo::CommitPhase(phase)), 0);
+
+    // A small change rewrites a few arrays
+    const TransactionInfo& second = transactions->at(2);
+    CHECK_EQUAL(second.get_transaction_type(), TransactionInfo::write_transaction);
+    // How long depends on when the writer thread got to block
+    CHECK_GREATER(second.get_commit_phase_time_nanoseconds(TransactionInfo::commit_WriteLockWait), 0);
+    CHECK_GREATER(second.get_num_bytes_written(), 0);
+    CHECK_LESS(second.get_num_bytes_written(), first.get_num_bytes_written());
+}
+
+
 TEST(Metrics_TransactionData)
 {
     SHARED_GROUP_TEST_PATH(path);
@@ -1071,6 +1145,36 @@ TEST(Metrics_MemoryChecks)
     }
 }
 
+TEST(Metrics_BackgroundSync)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(SharedGroupOptions::Durability::Background);
+    options.enable_metrics = true;
+    SharedGroup sg(path, false, options);
+    std::shared_ptr<Metrics> metrics = sg.get_metrics();
+    CHECK(metrics);
+
+    const size_t num_commits = 20;
+    {
+        WriteTransaction wt(sg);
+        wt.add_table("table")->add_column(type_Int, "int");
+        wt.commit();
+    }
+    for (size_t i = 1; i < num_commits; ++i) {
+        WriteTransaction wt(sg);
+        wt.get_table("table")->add_empty_row();
+        wt.commit();
+    }
+    sg.close();
+
+    // Each commit was made durable by one of the syncs, which may have made
+    // several commits durable at once
+    CHECK_GREATER_EQUAL(metrics->num_background_syncs(), 1);
+    CHECK_LESS_EQUAL(metrics->num_background_syncs(), num_commits);
+    CHECK_EQUAL(metrics->num_background_synced_versions(), num_commits);
+    CHECK_GREATER_EQUAL(metrics->max_background_sync_lag(), 0);
+}
+
 #else // REALM_METRICS
 
 #include <realm.hpp>
@@ -234,6 +234,13 @@ static std::vector<std::string> valid_queries = {
     // backlinks
     "p.@links.class.prop.@count > 2",
     "p.@links.class.prop.@sum.prop2 > 2",
+
+    // value lists
+    "a IN {1, 2, 3}",
+    "a in {}",
+    "a IN { 'x',$0 , null }",
+    "a IN[c] {\"x\", 'y'}",
+    "a IN {true, false} && b IN {-1.5, 0x1F}",
 };
 
 static std::vector<std::string> invalid_queries = {
@@ -257,6 +264,10 @@ static std::vector<std::string> invalid_queries = {
     "- = a",
     "a..b = a",
     "{} = $0",
+    "{1, 2} IN a",
+    "a IN {1, 2",
+    "a IN {1 2}",
+    "a IN {b, c}", // only constants are allowed in a value list
 
     // operators
     "0===>0",
@@ -3034,6 +3045,46 @@ TEST(Parser_OperatorIN)
 }
 
 
+TEST(Parser_InValueList)
+{
+    Group g;
+    TableRef t = g.add_table("table");
+    size_t int_col = t->add_column(type_Int, "int_col", true);
+    size_t str_col = t->add_column(type_String, "str_col", true);
+    size_t ts_col = t->add_column(type_Timestamp, "ts_col", true);
+    t->add_empty_row(10);
+    for (size_t i = 0; i < t->size(); ++i) {
+        t->set_int(int_col, i, int64_t(i));
+        char str[] = {char('a' + i)};
+        t->set_string(str_col, i, StringData(str, 1));
+        t->set_timestamp(ts_col, i, Timestamp(int64_t(i), 0));
+    }
+    t->set_null(int_col, 9);
+    t->set_null(str_col, 9);
+
+    verify_query(test_context, t, "int_col IN {1, 3, 5, 100}", 3);
+    verify_query(test_context, t, "int_col IN {1, null}", 2);
+    verify_query(test_context, t, "!(int_col IN {1, 3, 5})", 7);
+    verify_query(test_context, t, "int_col IN {}", 0);
+    verify_query(test_context, t, "str_col IN {'a', \"c\", 'zz'}", 2);
+    verify_query(test_context, t, "str_col IN[c] {'A', 'C'}", 2);
+    verify_query(test_context, t, "ts_col IN {T1:0, T2:0, T2:1}", 2);
+    verify_query(test_context, t, "int_col IN {1, 2, 3} AND str_col IN {'c', 'd'}", 2);
+
+    t->add_search_index(int_col);
+    t->add_search_index(str_col);
+    verify_query(test_context, t, "int_col IN {1, 3, 5, 100}", 3);
+    verify_query(test_context, t, "str_col IN {'a', 'c', 'zz'}", 2);
+
+    util::Any args[] = {Int(4), Int(6)};
+    verify_query_sub(test_context, t, "int_col IN {$0, $1, 7}", args, 2, 3);
+
+    std::string message;
+    CHECK_THROW_ANY_GET_MESSAGE(verify_query(test_context, t, "int_col == {1, 2}", 0), message);
+    CHECK_EQUAL(message, "A list of values can only be used with the 'IN' operator.");
+}
+
+
 // we won't support full object comparisons until we have stable keys in core, but as an exception
 // we allow comparison with null objects because we can serialise that and bindings use it to check agains nulls.
 TEST(Parser_RowIndex)
@@ -3218,4 +3269,64 @@ TEST(Parser_TimestampNullable)
 }
 
 
+TEST(Parser_PreparedQueryCache)
+{
+    Group g;
+    TableRef t = g.add_table("person");
+    size_t int_col_ndx = t->add_column(type_Int, "age");
+    size_t str_col_ndx = t->add_column(type_String, "name");
+    t->add_empty_row(5);
+    std::vector<std::string> names = {"Billy", "Bob", "Joe", "Jane", "Joel"};
+    for (size_t i = 0; i < t->size(); ++i) {
+        t->set_int(int_col_ndx, i, i);
+        t->set_string(str_col_ndx, i, names[i]);
+    }
+
+    parser::ParserCache cache(2);
+    query_builder::AnyContext ctx;
+
+    query_builder::PreparedQuery prepared(t, "age > $0 SORT(age DESC) LIMIT(2)", cache);
+    CHECK(prepared.has_arguments());
+    CHECK_EQUAL(cache.misses(), 1);
+    CHECK_EQUAL(cache.hits(), 0);
+
+    for (int64_t bound = 0; bound < 5; ++bound) {
+        util::Any args[] = {Int(bound)};
+        query_builder::ArgumentConverter<util::Any, query_builder::AnyContext> converter(ctx, args, 1);
+        Query q = prepared.bind(converter);
+        CHECK_EQUAL(q.count(), size_t(4 - bound));
+        TableView tv = q.find_all(prepared.bind_ordering(converter));
+        CHECK_EQUAL(tv.size(), std::min(size_t(2), size_t(4 - bound)));
+        if (tv.size() > 0)
+            CHECK_EQUAL(tv.get_int(int_col_ndx, 0), 4);
+    }
+
+    // same text is served from the cache and shares the parsed tree
+    query_builder::PreparedQuery same(t, "age > $0 SORT(age DESC) LIMIT(2)", cache);
+    CHECK_EQUAL(&same.parsed(), &prepared.parsed());
+    CHECK_EQUAL(cache.hits(), 1);
+
+    query_builder::PreparedQuery no_args(t, "name BEGINSWITH 'J'", cache);
+    CHECK(!no_args.has_arguments());
+    query_builder::NoArguments none;
+    CHECK_EQUAL(no_args.bind(none).count(), 3);
+    CHECK_EQUAL(cache.size(), 2);
+
+    // the least recently used entry is evicted
+    cache.get("age == 1");
+    CHECK_EQUAL(cache.size(), 2);
+    cache.get("name BEGINSWITH 'J'");
+    CHECK_EQUAL(cache.misses(), 3);
+    cache.get("age > $0 SORT(age DESC) LIMIT(2)");
+    CHECK_EQUAL(cache.misses(), 4);
+
+    // syntax errors are reported and not cached
+    CHECK_THROW_ANY(cache.get("age >"));
+    CHECK_EQUAL(cache.size(), 2);
+
+    cache.clear();
+    CHECK_EQUAL(cache.size(), 0);
+}
+
+
 #endif // TEST_PARSER
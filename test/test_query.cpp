@@ -4519,6 +4519,95 @@ TEST(Query_FindWithDescriptorOrdering)
 }
 
 
+TEST(Query_SortLimitTopK)
+{
+    // Sort followed by limit is collected incrementally for query backed views;
+    // the result must match a full sort truncated to the limit, including the
+    // stable order of ties.
+    Group g;
+    TableRef target = g.add_table("target");
+    TableRef origin = g.add_table("origin");
+    size_t target_int_col = target->add_column(type_Int, "int");
+    size_t int_col = origin->add_column(type_Int, "int");
+    size_t str_col = origin->add_column(type_String, "str");
+    size_t link_col = origin->add_column_link(type_Link, "link", *target);
+
+    const size_t num_targets = 100;
+    target->add_empty_row(num_targets);
+    for (size_t i = 0; i < num_targets; ++i)
+        target->set_int(target_int_col, i, (i * 37) % 23);
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const size_t num_rows = 150000;
+    origin->add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        origin->set_int(int_col, i, random.draw_int_mod(1000));
+        std::string str = util::to_string(random.draw_int_mod(500));
+        origin->set_string(str_col, i, str);
+        origin->set_link(link_col, i, random.draw_int_mod(num_targets));
+    }
+
+    auto check_against_full_sort = [&](Query query, SortDescriptor sort, size_t limit) {
+        DescriptorOrdering full;
+        full.append_sort(sort);
+        TableView expected = query.find_all(full);
+
+        DescriptorOrdering ordering;
+        ordering.append_sort(sort);
+        ordering.append_limit({limit});
+        TableView tv = query.find_all(ordering);
+
+        size_t expected_size = std::min(limit, expected.size());
+        CHECK_EQUAL(tv.size(), expected_size);
+        CHECK_EQUAL(tv.get_num_results_excluded_by_limit(), expected.size() - expected_size);
+        for (size_t i = 0; i < tv.size() && i < expected_size; ++i)
+            CHECK_EQUAL(tv.get_source_ndx(i), expected.get_source_ndx(i));
+    };
+
+    for (size_t limit : {size_t(0), size_t(1), size_t(10), size_t(1000), size_t(5000), num_rows + 1}) {
+        check_against_full_sort(origin->where(), SortDescriptor(*origin, {{int_col}}, {true}), limit);
+        check_against_full_sort(origin->where(), SortDescriptor(*origin, {{int_col}}, {false}), limit);
+        check_against_full_sort(origin->where().greater(int_col, 500),
+                                SortDescriptor(*origin, {{str_col}, {int_col}}, {true, false}), limit);
+        check_against_full_sort(origin->where(), SortDescriptor(*origin, {{link_col, target_int_col}}, {false}),
+                                limit);
+    }
+
+    // An include between sort and limit does not prevent the optimization
+    {
+        DescriptorOrdering ordering;
+        ordering.append_sort(SortDescriptor(*origin, {{int_col}}, {true}));
+        ordering.append_include(IncludeDescriptor(*origin, {}));
+        ordering.append_limit({7});
+        TableView tv = origin->where().find_all(ordering);
+        CHECK_EQUAL(tv.size(), 7);
+        CHECK_EQUAL(tv.get_num_results_excluded_by_limit(), num_rows - 7);
+        for (size_t i = 1; i < tv.size(); ++i)
+            CHECK(tv.get_int(int_col, i - 1) <= tv.get_int(int_col, i));
+    }
+
+    // Multiple limits, the smaller one wins
+    {
+        DescriptorOrdering ordering;
+        ordering.append_sort(SortDescriptor(*origin, {{int_col}}, {false}));
+        ordering.append_limit({20});
+        ordering.append_limit({5});
+        TableView tv = origin->where().find_all(ordering);
+        CHECK_EQUAL(tv.size(), 5);
+        CHECK_EQUAL(tv.get_num_results_excluded_by_limit(), num_rows - 5);
+        for (size_t i = 1; i < tv.size(); ++i)
+            CHECK(tv.get_int(int_col, i - 1) >= tv.get_int(int_col, i));
+    }
+
+    // A query restricted by a view goes through the regular sort
+    {
+        TableView restriction = origin->where().less(int_col, 100).find_all();
+        Query query = origin->where(&restriction);
+        check_against_full_sort(query, SortDescriptor(*origin, {{int_col}}, {false}), 42);
+    }
+}
+
+
 TEST(Query_FindWithDescriptorOrderingOverTableviewSync)
 {
     Group g;
@@ -6247,6 +6336,84 @@ TEST(Query_FindNext2)
     CHECK_EQUAL(6, res1);
 }
 
+TEST(Query_Iterate)
+{
+    Table table;
+    table.add_column(type_Int, "int");
+    table.add_column(type_String, "str");
+    const size_t num_rows = 3 * QueryCursor::batch_size + 17;
+    table.add_empty_row(num_rows);
+    Random random(random_int<unsigned long>());
+    for (size_t i = 0; i < num_rows; ++i) {
+        table.set_int(0, i, random.draw_int_mod(100));
+        table.set_string(1, i, random.draw_bool() ? "a" : "b");
+    }
+    TableView restricting = table.where().less(0, 50).find_all();
+
+    auto check = [&](Query q, size_t start, size_t end, size_t limit) {
+        TableView expected = q.find_all(start, end, limit);
+
+        std::vector<size_t> rows;
+        QueryCursor cursor = q.iterate(start, end, limit);
+        for (size_t i = 0; i < expected.size(); ++i)
+            CHECK_EQUAL(expected.get_source_ndx(i), cursor.next());
+        CHECK_EQUAL(not_found, cursor.next());
+        CHECK_EQUAL(expected.size(), cursor.get_count());
+        CHECK(!cursor.next_batch(rows));
+        CHECK(rows.empty());
+
+        cursor = q.iterate(start, end, limit);
+        size_t n = 0;
+        while (cursor.next_batch(rows)) {
+            CHECK(!rows.empty());
+            for (size_t row : rows) {
+                CHECK(n < expected.size() && expected.get_source_ndx(n) == row);
+                ++n;
+            }
+        }
+        CHECK_EQUAL(expected.size(), n);
+        CHECK(cursor.at_end() || expected.size() == 0);
+        CHECK_EQUAL(expected.size(), cursor.get_count());
+    };
+
+    std::vector<Query> queries;
+    queries.push_back(table.where());
+    queries.push_back(table.where().equal(0, 7));
+    queries.push_back(table.where().greater(0, 20).equal(1, "a"));
+    queries.push_back(table.where().equal(0, 3).Or().equal(1, "b"));
+    queries.push_back(table.where().equal(0, 1000));
+    queries.push_back(table.where(&restricting));
+    queries.push_back(table.where(&restricting).equal(1, "a"));
+    for (Query& q : queries) {
+        check(q, 0, size_t(-1), size_t(-1));
+        check(q, 0, size_t(-1), 5);
+        check(q, 0, size_t(-1), 0);
+        check(q, 100, 2500, size_t(-1));
+        check(q, 100, 2500, 1);
+        check(q, num_rows, size_t(-1), size_t(-1));
+    }
+
+    // A batch of a table-backed query holds matches from one window of rows
+    QueryCursor cursor = table.where().greater(0, 10).iterate();
+    std::vector<size_t> rows;
+    while (cursor.next_batch(rows))
+        CHECK_EQUAL(rows.front() / QueryCursor::batch_size, rows.back() / QueryCursor::batch_size);
+
+    // The cursor holds its own copy of the query, and stops early
+    cursor = table.where().equal(1, "a").iterate();
+    size_t first = cursor.next();
+    CHECK_EQUAL(table.where().equal(1, "a").find(), first);
+    CHECK(!cursor.at_end());
+    CHECK_EQUAL(1, cursor.get_count());
+
+    // Degenerate table
+    Table empty;
+    empty.add_column(type_Int, "int");
+    cursor = empty.where().equal(0, 1).iterate();
+    CHECK_EQUAL(not_found, cursor.next());
+    CHECK(!cursor.next_batch(rows));
+}
+
 TEST(Query_FindAll1)
 {
     TestTable ttt;
@@ -10789,6 +10956,64 @@ TEST(Query_Timestamp_Null)
     CHECK_EQUAL(match, 0);
 }
 
+TEST(Query_TimestampOrdering)
+{
+    // Many values share their seconds, so the nanoseconds decide most comparisons. The rows in the middle have
+    // seconds which are too wide to be compared as packed keys.
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    Table table;
+    auto col = table.add_column(type_Timestamp, "date", true);
+    const size_t num_rows = 3000;
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (random.draw_int_mod(10) == 0) {
+            table.set_null(col, i);
+            continue;
+        }
+        int64_t seconds = random.draw_int(-3, 3);
+        if (i > 1000 && i < 1200 && random.draw_bool())
+            seconds *= int64_t(1) << 40;
+        int32_t nanos = random.draw_int(0, 3) * 250000000 + (random.draw_bool() ? 1 : 0);
+        if (seconds < 0 || (seconds == 0 && random.draw_bool()))
+            nanos = -nanos;
+        table.set_timestamp(col, i, Timestamp(seconds, nanos));
+    }
+
+    std::vector<Timestamp> needles = {Timestamp(0, 0), Timestamp(0, 500000000), Timestamp(0, -500000000),
+                                      Timestamp(1, 0), Timestamp(-1, -1), Timestamp(2, 999999999),
+                                      Timestamp(int64_t(1) << 40, 0), Timestamp(-(int64_t(1) << 40), 0),
+                                      Timestamp{}};
+    for (const Timestamp& needle : needles) {
+        size_t greater = 0, less = 0, greater_equal = 0, less_equal = 0;
+        size_t first_greater = npos, first_less_equal = npos;
+        for (size_t i = 0; i < num_rows; ++i) {
+            Timestamp value = table.get_timestamp(col, i);
+            if (value.is_null() || needle.is_null()) {
+                bool both_null = value.is_null() && needle.is_null();
+                greater_equal += both_null;
+                less_equal += both_null;
+                if (both_null && first_less_equal == npos)
+                    first_less_equal = i;
+                continue;
+            }
+            greater += value > needle;
+            less += value < needle;
+            greater_equal += value >= needle;
+            less_equal += value <= needle;
+            if (value > needle && first_greater == npos)
+                first_greater = i;
+            if (value <= needle && first_less_equal == npos)
+                first_less_equal = i;
+        }
+        CHECK_EQUAL(greater, table.where().greater(col, needle).count());
+        CHECK_EQUAL(less, table.where().less(col, needle).count());
+        CHECK_EQUAL(greater_equal, table.where().greater_equal(col, needle).count());
+        CHECK_EQUAL(less_equal, table.where().less_equal(col, needle).count());
+        CHECK_EQUAL(first_greater, table.where().greater(col, needle).find());
+        CHECK_EQUAL(first_less_equal, table.where().less_equal(col, needle).find());
+    }
+}
+
 // Ensure that coyping a Query copies a restricting TableView if the query owns the view.
 TEST(Query_CopyRestrictingTableViewWhenOwned)
 {
@@ -12316,4 +12541,142 @@ TEST(Query_NotImmediatelyBeforeKnownRange)
 }
 
 
+TEST(Query_IndexedOrNotCombination)
+{
+    Group g;
+    TableRef origin = g.add_table("origin");
+    TableRef target = g.add_table("target");
+    size_t col_int = target->add_column(type_Int, "int", true);
+    size_t col_str = target->add_column(type_String, "str", true);
+    size_t col_plain = target->add_column(type_Int, "plain");
+    size_t col_link = origin->add_column_link(type_Link, "link", *target);
+    size_t col_list = origin->add_column_link(type_LinkList, "list", *target);
+
+    const size_t num_rows = 66000; // spans two bitmap chunks
+    target->add_empty_row(num_rows);
+    origin->add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        target->set_int(col_int, i, i % 100);
+        target->set_string(col_str, i, (i % 7) ? "other" : "seven");
+        target->set_int(col_plain, i, i % 3);
+        origin->set_link(col_link, i, i % 10);
+        if (i % 1000 == 0)
+            origin->get_linklist(col_list, i)->add(3);
+    }
+    target->add_search_index(col_int);
+    target->add_search_index(col_str);
+
+    auto count_rows = [&](std::function<bool(size_t)> pred) {
+        size_t n = 0;
+        for (size_t i = 0; i < num_rows; ++i)
+            n += pred(i) ? 1 : 0;
+        return n;
+    };
+
+    // every alternative has an index
+    Query q = target->where().equal(col_int, 5).Or().equal(col_str, "seven").Or().equal(col_int, 99);
+    size_t expected = count_rows([](size_t i) { return i % 100 == 5 || i % 7 == 0 || i % 100 == 99; });
+    CHECK_EQUAL(q.count(), expected);
+    TableView tv = q.find_all();
+    CHECK_EQUAL(tv.size(), expected);
+    bool ascending = true;
+    for (size_t i = 1; i < tv.size(); ++i)
+        ascending = ascending && tv.get_source_ndx(i - 1) < tv.get_source_ndx(i);
+    CHECK(ascending);
+
+    // an AND'ed condition inside an alternative is intersected
+    q = target->where().group().equal(col_int, 5).equal(col_str, "seven").end_group().Or().equal(col_int, 6);
+    expected = count_rows([](size_t i) { return (i % 100 == 5 && i % 7 == 0) || i % 100 == 6; });
+    CHECK_EQUAL(q.count(), expected);
+
+    // a non-indexed alternative falls back to row by row evaluation
+    q = target->where().equal(col_int, 5).Or().equal(col_plain, 1);
+    expected = count_rows([](size_t i) { return i % 100 == 5 || i % 3 == 1; });
+    CHECK_EQUAL(q.count(), expected);
+
+    // negation of indexed conditions, including of an OR over them
+    q = target->where().Not().equal(col_int, 5);
+    CHECK_EQUAL(q.count(), num_rows - num_rows / 100);
+    q = target->where().Not().group().equal(col_int, 5).Or().equal(col_str, "seven").end_group();
+    expected = count_rows([](size_t i) { return !(i % 100 == 5 || i % 7 == 0); });
+    CHECK_EQUAL(q.count(), expected);
+    q = target->where().Not().equal(col_int, 5).equal(col_plain, 2);
+    expected = count_rows([](size_t i) { return i % 100 != 5 && i % 3 == 2; });
+    CHECK_EQUAL(q.count(), expected);
+
+    // restricted to a view
+    TableView view = target->where().less(col_plain, 2).find_all();
+    q = target->where(&view).equal(col_int, 5).Or().equal(col_int, 6);
+    expected = count_rows([](size_t i) { return i % 3 < 2 && (i % 100 == 5 || i % 100 == 6); });
+    CHECK_EQUAL(q.count(), expected);
+
+    // links_to is answered through the backlinks of the targets
+    q = origin->where().links_to(col_link, target->get(3)).Or().links_to(col_list, target->get(3));
+    expected = count_rows([](size_t i) { return i % 10 == 3 || i % 1000 == 0; });
+    CHECK_EQUAL(q.count(), expected);
+    q = origin->where().Not().links_to(col_link, target->get(3));
+    CHECK_EQUAL(q.count(), num_rows - num_rows / 10);
+    q = origin->where().links_to(col_list, target->get(3));
+    CHECK_EQUAL(q.count(), num_rows / 1000);
+    CHECK_EQUAL(q.find(1), 1000);
+}
+
+
+TEST_TYPES(Query_In, std::false_type, std::true_type)
+{
+    const bool indexed = TEST_TYPE::value;
+    Table table;
+    size_t col_int = table.add_column(type_Int, "int", true);
+    size_t col_str = table.add_column(type_String, "str", true);
+    size_t col_ts = table.add_column(type_Timestamp, "ts", true);
+    if (indexed) {
+        table.add_search_index(col_int);
+        table.add_search_index(col_str);
+        table.add_search_index(col_ts);
+    }
+
+    const size_t num_rows = 1000;
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (i % 10 == 9) {
+            table.set_null(col_int, i);
+            table.set_null(col_str, i);
+            table.set_null(col_ts, i);
+            continue;
+        }
+        table.set_int(col_int, i, i % 100);
+        std::string str = util::to_string(i % 50);
+        table.set_string(col_str, i, str);
+        table.set_timestamp(col_ts, i, Timestamp(int64_t(i % 20), int32_t(i % 2)));
+    }
+
+    // int values 1, 2, 3, 50 and 1000 occur 10, 10, 10, 10 and 0 times
+    std::vector<int64_t> ints = {1, 2, 3, 50, 1000};
+    CHECK_EQUAL(table.where().in(col_int, ints).count(), 40);
+    CHECK_EQUAL(table.where().Not().in(col_int, ints).count(), num_rows - 40);
+    CHECK_EQUAL(table.where().in(col_int, std::vector<int64_t>{7}).count(), 10);
+    CHECK_EQUAL(table.where().in(col_int, std::vector<int64_t>{}).count(), 0);
+    CHECK_EQUAL(table.where().equal(col_str, "1").in(col_int, ints).count(), 10);
+
+    // a long list, as produced by bindings passing the primary keys of a result set
+    std::vector<int64_t> many;
+    for (int64_t i = 0; i < 1000; i += 2)
+        many.push_back(i);
+    CHECK_EQUAL(table.where().in(col_int, many).count(), 500);
+
+    std::vector<StringData> strings = {"1", "2", "x", StringData()};
+    CHECK_EQUAL(table.where().in(col_str, strings).count(), 140);
+    TableView tv = table.where().in(col_str, strings).find_all();
+    CHECK_EQUAL(tv.size(), 140);
+    CHECK_EQUAL(tv.get_source_ndx(0), 1);
+    CHECK_EQUAL(tv.get_source_ndx(1), 2);
+    CHECK_EQUAL(tv.get_source_ndx(2), 9);
+    CHECK_EQUAL(table.where().in(col_str, std::vector<StringData>{"X", "10"}, false).count(), 20);
+
+    std::vector<Timestamp> timestamps = {Timestamp(1, 1), Timestamp(2, 0), Timestamp(2, 1), Timestamp()};
+    CHECK_EQUAL(table.where().in(col_ts, timestamps).count(), 200);
+    CHECK_EQUAL(table.where().in(col_ts, std::vector<Timestamp>{Timestamp(3, 0)}).count(), 0);
+}
+
+
 #endif // TEST_QUERY
@@ -0,0 +1,365 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_QUERY_CACHE
+
+#include <realm.hpp>
+#include <realm/history.hpp>
+#include <realm/lang_bind_helper.hpp>
+
+#include "test.hpp"
+
+using namespace realm;
+using namespace realm::test_util;
+
+// Test independence and thread-safety
+// -----------------------------------
+//
+// All tests must be thread safe and independent of each other. This
+// is required because it allows for both shuffling of the execution
+// order and for parallelized testing.
+//
+// In particular, avoid using std::rand() since it is not guaranteed
+// to be thread safe. Instead use the API offered in
+// `test/util/random.hpp`.
+//
+// All files created in tests must use the TEST_PATH macro (or one of
+// its friends) to obtain a suitable file system path. See
+// `test/util/test_path.hpp`.
+//
+//
+// Debugging and the ONLY() macro
+// ------------------------------
+//
+// A simple way of disabling all tests except one called `Foo`, is to
+// replace TEST(Foo) with ONLY(Foo) and then recompile and rerun the
+// test suite. Note that you can also use filtering by setting the
+// environment varible `UNITTEST_FILTER`. See `README.md` for more on
+// this.
+//
+// Another way to debug a particular test, is to copy that test into
+// `experiments/testcase.cpp` and then run `sh build.sh
+// check-testcase` (or one of its friends) from the command line.
+
+namespace {
+
+SharedGroupOptions cache_options(std::shared_ptr<QueryResultCache> cache)
+{
+    SharedGroupOptions options(crypt_key());
+    options.query_cache = std::move(cache);
+    options.enable_metrics = true;
+    return options;
+}
+
+// origin: int, link to target
+// target: int
+// other: int
+void create_tables(SharedGroup& sg, size_t num_rows)
+{
+    WriteTransaction wt(sg);
+    TableRef origin = wt.add_table("origin");
+    TableRef target = wt.add_table("target");
+    TableRef other = wt.add_table("other");
+    origin->add_column(type_Int, "int");
+    origin->add_column_link(type_Link, "link", *target);
+    target->add_column(type_Int, "int");
+    other->add_column(type_Int, "int");
+    origin->add_empty_row(num_rows);
+    target->add_empty_row(num_rows);
+    other->add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        origin->set_int(0, i, int64_t(i % 10));
+        origin->set_link(1, i, (i * 7) % num_rows);
+        target->set_int(0, i, int64_t(i % 5));
+        other->set_int(0, i, int64_t(i));
+    }
+    wt.commit();
+}
+
+void set_int(SharedGroup& sg, const char* table_name, size_t row, int64_t value)
+{
+    WriteTransaction wt(sg);
+    wt.get_table(table_name)->set_int(0, row, value);
+    wt.commit();
+}
+
+bool same_rows(const TableView& a, const TableView& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a.get_source_ndx(i) != b.get_source_ndx(i))
+            return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+
+TEST(QueryCache_Basic)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    auto cache = std::make_shared<QueryResultCache>();
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, cache_options(cache));
+    std::unique_ptr<Replication> hist_w(make_in_realm_history(path));
+    SharedGroup sg_w(*hist_w, cache_options(cache));
+    create_tables(sg_w, 100);
+    auto metrics = sg.get_metrics();
+    CHECK(metrics);
+
+    const Group& g = sg.begin_read();
+    ConstTableRef origin = g.get_table("origin");
+    Query query = origin->where().greater(0, 4);
+    DescriptorOrdering ordering;
+    ordering.append_sort(SortDescriptor(*origin, {{0}}, {false}));
+
+    TableView tv = sg.find_all_cached(query);
+    CHECK_EQUAL(0, metrics->num_query_cache_hits());
+    CHECK_EQUAL(1, metrics->num_query_cache_misses());
+    CHECK_EQUAL(1, cache->size());
+    CHECK(same_rows(query.find_all(), tv));
+
+    tv = sg.find_all_cached(query);
+    CHECK_EQUAL(1, metrics->num_query_cache_hits());
+    CHECK(tv.is_in_sync());
+    CHECK(same_rows(query.find_all(), tv));
+
+    // The ordering is part of the key
+    TableView sorted = sg.find_all_cached(query, ordering);
+    CHECK_EQUAL(2, metrics->num_query_cache_misses());
+    sorted = sg.find_all_cached(query, ordering);
+    CHECK_EQUAL(2, metrics->num_query_cache_hits());
+    CHECK(same_rows(query.find_all(ordering), sorted));
+
+    // A query built separately has the same description
+    tv = sg.find_all_cached(origin->where().greater(0, 4));
+    CHECK_EQUAL(3, metrics->num_query_cache_hits());
+
+    // Changing a table the results do not depend on keeps them, both for the
+    // SharedGroup advancing over the change, and for a read transaction
+    // started after it
+    set_int(sg_w, "other", 0, 100);
+    LangBindHelper::advance_read(sg);
+    tv = sg.find_all_cached(query);
+    sorted = sg.find_all_cached(query, ordering);
+    CHECK_EQUAL(5, metrics->num_query_cache_hits());
+    CHECK(same_rows(query.find_all(), tv));
+    CHECK(same_rows(query.find_all(ordering), sorted));
+    sg.end_read();
+
+    set_int(sg_w, "other", 1, 100);
+    origin = sg.begin_read().get_table("origin");
+    query = origin->where().greater(0, 4);
+    tv = sg.find_all_cached(query);
+    CHECK_EQUAL(6, metrics->num_query_cache_hits());
+    CHECK(same_rows(query.find_all(), tv));
+
+    // The view can be brought in sync after later changes
+    set_int(sg_w, "origin", 0, 9);
+    LangBindHelper::advance_read(sg);
+    CHECK(!tv.is_in_sync());
+    tv.sync_if_needed();
+    CHECK(same_rows(query.find_all(), tv));
+
+    // Changing the queried table drops the result
+    size_t misses = metrics->num_query_cache_misses();
+    tv = sg.find_all_cached(query);
+    CHECK_EQUAL(misses + 1, metrics->num_query_cache_misses());
+    CHECK(same_rows(query.find_all(), tv));
+
+    // So does changing a linked table, even if the query does not follow links
+    set_int(sg_w, "target", 0, 4);
+    LangBindHelper::advance_read(sg);
+    tv = sg.find_all_cached(query);
+    CHECK_EQUAL(misses + 2, metrics->num_query_cache_misses());
+
+    // and changing the schema
+    {
+        WriteTransaction wt(sg_w);
+        wt.add_table("new");
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    tv = sg.find_all_cached(query);
+    CHECK_EQUAL(misses + 3, metrics->num_query_cache_misses());
+    sg.end_read();
+}
+
+
+TEST(QueryCache_Bypass)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    auto cache = std::make_shared<QueryResultCache>();
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, cache_options(cache));
+    create_tables(sg, 20);
+    auto metrics = sg.get_metrics();
+
+    // A query restricted by a view
+    {
+        ReadTransaction rt(sg);
+        ConstTableRef origin = rt.get_table("origin");
+        TableView restricting = origin->where().less(0, 5).find_all();
+        Query query = origin->where(&restricting).greater(0, 2);
+        TableView tv = sg.find_all_cached(query);
+        CHECK(same_rows(query.find_all(), tv));
+    }
+
+    // A write transaction
+    {
+        WriteTransaction wt(sg);
+        TableRef origin = wt.get_table("origin");
+        origin->set_int(0, 0, 4);
+        Query query = origin->where().greater(0, 2);
+        TableView tv = sg.find_all_cached(query);
+        CHECK(same_rows(query.find_all(), tv));
+    }
+
+    CHECK_EQUAL(0, metrics->num_query_cache_hits());
+    CHECK_EQUAL(0, metrics->num_query_cache_misses());
+    CHECK_EQUAL(0, cache->size());
+
+    // Without a cache
+    std::unique_ptr<Replication> hist_2(make_in_realm_history(path));
+    SharedGroup sg_2(*hist_2, SharedGroupOptions(crypt_key()));
+    ReadTransaction rt(sg_2);
+    Query query = rt.get_table("origin")->where().greater(0, 2);
+    TableView tv = sg_2.find_all_cached(query);
+    CHECK(same_rows(query.find_all(), tv));
+}
+
+
+TEST(QueryCache_FloatingPointConstants)
+{
+    // Constants which only differ beyond the default precision of a stream
+    // must give different keys
+    SHARED_GROUP_TEST_PATH(path);
+    auto cache = std::make_shared<QueryResultCache>();
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, cache_options(cache));
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("table");
+        table->add_column(type_Double, "double");
+        table->add_column(type_Float, "float");
+        table->add_empty_row(2);
+        table->set_double(0, 0, 1.00000015);
+        table->set_double(0, 1, 1.00000025);
+        table->set_float(1, 0, 1.0000001f);
+        table->set_float(1, 1, 1.0000005f);
+        wt.commit();
+    }
+
+    const Group& g = sg.begin_read();
+    ConstTableRef table = g.get_table("table");
+    CHECK_EQUAL(2, sg.find_all_cached(table->where().greater(0, 1.0000001)).size());
+    CHECK_EQUAL(1, sg.find_all_cached(table->where().greater(0, 1.0000002)).size());
+    CHECK_EQUAL(2, sg.find_all_cached(table->where().greater(1, 1.0f)).size());
+    CHECK_EQUAL(1, sg.find_all_cached(table->where().greater(1, 1.0000002f)).size());
+    CHECK_EQUAL(4, cache->size());
+    sg.end_read();
+}
+
+
+TEST(QueryCache_Eviction)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    auto cache = std::make_shared<QueryResultCache>(4);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, cache_options(cache));
+    create_tables(sg, 20);
+    auto metrics = sg.get_metrics();
+
+    ReadTransaction rt(sg);
+    ConstTableRef other = rt.get_table("other");
+    for (int64_t i = 0; i < 6; ++i)
+        sg.find_all_cached(other->where().equal(0, i));
+    CHECK_EQUAL(4, cache->size());
+    CHECK_EQUAL(6, metrics->num_query_cache_misses());
+
+    // The least recently used results were evicted
+    sg.find_all_cached(other->where().equal(0, 5));
+    CHECK_EQUAL(1, metrics->num_query_cache_hits());
+    sg.find_all_cached(other->where().equal(0, 0));
+    CHECK_EQUAL(7, metrics->num_query_cache_misses());
+
+    cache->clear();
+    CHECK_EQUAL(0, cache->size());
+}
+
+
+TEST(QueryCache_Random)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    auto cache = std::make_shared<QueryResultCache>();
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, cache_options(cache));
+    std::unique_ptr<Replication> hist_w(make_in_realm_history(path));
+    SharedGroup sg_w(*hist_w, cache_options(cache));
+    const size_t num_rows = 50;
+    create_tables(sg_w, num_rows);
+
+    Random random(random_int<unsigned long>());
+    const char* table_names[] = {"origin", "target", "other"};
+    Group& g = const_cast<Group&>(sg.begin_read());
+    for (int i = 0; i < 200; ++i) {
+        int action = random.draw_int_mod(4);
+        if (action < 2) {
+            set_int(sg_w, table_names[random.draw_int_mod(3)], random.draw_int_mod(num_rows),
+                    random.draw_int_mod(10));
+        }
+        else if (action == 2) {
+            WriteTransaction wt(sg_w);
+            TableRef origin = wt.get_table("origin");
+            origin->set_link(1, random.draw_int_mod(num_rows), random.draw_int_mod(num_rows));
+            wt.commit();
+        }
+
+        if (random.draw_bool()) {
+            LangBindHelper::advance_read(sg);
+        }
+        else {
+            sg.end_read();
+            sg.begin_read();
+        }
+
+        TableRef origin = g.get_table("origin");
+        TableRef target = g.get_table("target");
+        TableRef other = g.get_table("other");
+        std::vector<Query> queries;
+        queries.push_back(origin->where().greater(0, 5));
+        queries.push_back(origin->link(1).column<Int>(0) > 2);
+        queries.push_back(target->where().equal(0, 3));
+        queries.push_back(target->backlink(*origin, 1).column<Int>(0) == 7);
+        queries.push_back(other->where().less(0, 5));
+        for (Query& q : queries)
+            CHECK(same_rows(q.find_all(), sg.find_all_cached(q)));
+
+        DescriptorOrdering ordering;
+        ordering.append_sort(SortDescriptor(*origin, {{1, 0}, {0}}));
+        Query q = origin->where().less(0, 8);
+        CHECK(same_rows(q.find_all(ordering), sg.find_all_cached(q, ordering)));
+    }
+    sg.end_read();
+    CHECK_GREATER(sg.get_metrics()->num_query_cache_hits(), 0);
+}
+
+#endif // TEST_QUERY_CACHE
@@ -3835,6 +3835,78 @@ TEST(Replication_Substrings)
 }
 
 
+TEST(Replication_SetRange)
+{
+    SHARED_GROUP_TEST_PATH(path_1);
+    SHARED_GROUP_TEST_PATH(path_2);
+
+    util::Logger& replay_logger = test_context.logger;
+
+    MyTrivialReplication repl(path_1);
+    SharedGroup sg_1(repl);
+    SharedGroup sg_2(path_2);
+
+    {
+        WriteTransaction wt(sg_1);
+        TableRef table = wt.add_table("table");
+        table->add_column(type_Int, "int");
+        table->add_column(type_Int, "int_null", true);
+        table->add_column(type_Bool, "bool");
+        table->add_column(type_Float, "float");
+        table->add_column(type_Double, "double", true);
+        table->add_column(type_String, "string", true);
+        table->add_empty_row(100);
+        table->set_string(5, 0, "foo");
+        wt.commit();
+    }
+    {
+        WriteTransaction wt(sg_1);
+        TableRef table = wt.get_table("table");
+        std::vector<int64_t> ints;
+        std::vector<float> floats;
+        for (int i = 0; i < 100; ++i) {
+            ints.push_back(i * 1000);
+            floats.push_back(i + 0.5f);
+        }
+        table->set_range(0, 0, ints.data(), ints.size());
+        table->set_range(1, 10, ints.data(), 20);
+        table->fill(1, 50, 100, 7);
+        bool bools[] = {true, false, true};
+        table->set_range(2, 97, bools, 3);
+        table->set_range(3, 0, floats.data(), floats.size());
+        table->fill(4, 0, 100, 2.5);
+        table->fill(4, 90, 95, null());
+        table->fill(5, 0, 1, null());
+        table->fill(0, 3, 3, int64_t(1)); // Empty range
+        wt.commit();
+    }
+    repl.replay_transacts(sg_2, replay_logger);
+    {
+        ReadTransaction rt_1(sg_1);
+        ReadTransaction rt_2(sg_2);
+        rt_2.get_group().verify();
+        CHECK(rt_1.get_group() == rt_2.get_group());
+        auto table = rt_2.get_table("table");
+        CHECK_EQUAL(99000, table->get_int(0, 99));
+        CHECK(table->is_null(1, 9));
+        CHECK_EQUAL(19000, table->get_int(1, 29));
+        CHECK(table->is_null(1, 30));
+        CHECK_EQUAL(7, table->get_int(1, 50));
+        CHECK_EQUAL(7, table->get_int(1, 99));
+        CHECK(!table->get_bool(2, 96));
+        CHECK(table->get_bool(2, 97));
+        CHECK(!table->get_bool(2, 98));
+        CHECK(table->get_bool(2, 99));
+        CHECK_EQUAL(42.5f, table->get_float(3, 42));
+        CHECK_EQUAL(2.5, table->get_double(4, 89));
+        CHECK(table->is_null(4, 90));
+        CHECK(table->is_null(4, 94));
+        CHECK_EQUAL(2.5, table->get_double(4, 95));
+        CHECK(table->is_null(5, 0));
+    }
+}
+
+
 TEST(Replication_MoveSelectedLinkView)
 {
     // 1st: Create table with two rows
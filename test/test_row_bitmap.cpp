@@ -0,0 +1,164 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_ROW_BITMAP
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <vector>
+
+#include <realm/row_bitmap.hpp>
+
+#include "test.hpp"
+
+using namespace realm;
+using namespace realm::test_util;
+
+namespace {
+
+std::vector<size_t> members(const RowBitmap& bitmap)
+{
+    std::vector<size_t> result;
+    bitmap.for_each([&](size_t row) { result.push_back(row); });
+    return result;
+}
+
+RowBitmap from_set(const std::set<size_t>& rows)
+{
+    RowBitmap bitmap;
+    for (auto row : rows)
+        bitmap.add(row);
+    return bitmap;
+}
+
+// Draw a set that mixes sparse and dense chunks
+std::set<size_t> random_rows(Random& random, size_t row_count)
+{
+    std::set<size_t> rows;
+    for (size_t chunk = 0; chunk < row_count; chunk += 65536) {
+        size_t n = random.draw_int<size_t>(0, 3) == 0 ? 10000 : random.draw_int<size_t>(0, 100);
+        for (size_t i = 0; i < n; ++i)
+            rows.insert(chunk + random.draw_int<size_t>(0, std::min(size_t(65535), row_count - chunk - 1)));
+    }
+    return rows;
+}
+
+} // anonymous namespace
+
+TEST(RowBitmap_Basic)
+{
+    RowBitmap bitmap;
+    CHECK(bitmap.empty());
+    CHECK_EQUAL(bitmap.find_first(), not_found);
+
+    bitmap.add(70000);
+    bitmap.add(5);
+    bitmap.add(5);
+    bitmap.add(65536);
+    CHECK_EQUAL(bitmap.size(), 3);
+    CHECK(bitmap.contains(5));
+    CHECK(bitmap.contains(65536));
+    CHECK(!bitmap.contains(6));
+    CHECK_EQUAL(bitmap.find_first(), 5);
+    CHECK_EQUAL(bitmap.find_first(6), 65536);
+    CHECK_EQUAL(bitmap.find_first(65537), 70000);
+    CHECK_EQUAL(bitmap.find_first(6, 65536), not_found);
+    CHECK_EQUAL(bitmap.find_first(70001), not_found);
+
+    // grow a chunk past the sparse limit
+    for (size_t i = 0; i < 10000; i += 2)
+        bitmap.add(i);
+    CHECK_EQUAL(bitmap.size(), 5003);
+    CHECK(bitmap.contains(9998));
+    CHECK(!bitmap.contains(9999));
+    CHECK_EQUAL(bitmap.find_first(9999), 65536);
+    CHECK_EQUAL(bitmap.find_first(7), 8);
+
+    bitmap.clear();
+    CHECK_EQUAL(bitmap.size(), 0);
+}
+
+TEST(RowBitmap_Complement)
+{
+    RowBitmap bitmap;
+    bitmap.complement(0);
+    CHECK(bitmap.empty());
+
+    bitmap.complement(100);
+    CHECK_EQUAL(bitmap.size(), 100);
+    bitmap.add(150);
+    bitmap.complement(130);
+    CHECK_EQUAL(bitmap.size(), 30);
+    CHECK_EQUAL(bitmap.find_first(), 100);
+    CHECK(!bitmap.contains(150));
+
+    bitmap.clear();
+    bitmap.add(3);
+    bitmap.add(65536 + 7);
+    bitmap.complement(65536 + 10);
+    CHECK_EQUAL(bitmap.size(), 65536 + 8);
+    CHECK(!bitmap.contains(3));
+    CHECK(!bitmap.contains(65536 + 7));
+    CHECK(bitmap.contains(65536 + 9));
+    CHECK(!bitmap.contains(65536 + 10));
+}
+
+TEST(RowBitmap_SetOperations)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const size_t row_count = 300000;
+    for (int iter = 0; iter < 10; ++iter) {
+        std::set<size_t> a = random_rows(random, row_count);
+        std::set<size_t> b = random_rows(random, row_count);
+        std::vector<size_t> expected;
+
+        RowBitmap bm = from_set(a);
+        CHECK_EQUAL(bm.size(), a.size());
+        CHECK(bm == from_set(a));
+
+        bm |= from_set(b);
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+        CHECK(members(bm) == expected);
+
+        bm = from_set(a);
+        bm &= from_set(b);
+        expected.clear();
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+        CHECK(members(bm) == expected);
+        CHECK_EQUAL(bm.size(), expected.size());
+
+        bm = from_set(a);
+        bm -= from_set(b);
+        expected.clear();
+        std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+        CHECK(members(bm) == expected);
+
+        bm = from_set(a);
+        bm.complement(row_count);
+        CHECK_EQUAL(bm.size(), row_count - a.size());
+        size_t start = random.draw_int<size_t>(0, row_count - 1);
+        size_t first = start;
+        while (first < row_count && a.count(first))
+            ++first;
+        CHECK_EQUAL(bm.find_first(start), first < row_count ? first : not_found);
+    }
+}
+
+#endif // TEST_ROW_BITMAP
@@ -19,6 +19,7 @@
 #include "testsettings.hpp"
 #ifdef TEST_SHARED
 
+#include <atomic>
 #include <condition_variable>
 #include <streambuf>
 #include <fstream>
@@ -1488,6 +1489,440 @@ TEST(Shared_WriterThreads)
 }
 
 
+namespace {
+
+SharedGroupOptions group_commit_options(std::chrono::microseconds window)
+{
+    SharedGroupOptions options(crypt_key());
+    options.group_commit_window = window;
+    return options;
+}
+
+} // anonymous namespace
+
+TEST(Shared_GroupCommit)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    const size_t thread_count = 8;
+    const int num_commits = 50;
+    {
+        SharedGroup sg(path, false, group_commit_options(std::chrono::milliseconds(100)));
+        {
+            WriteTransaction wt(sg);
+            TableRef t = wt.add_table("test");
+            t->add_column(type_Int, "count");
+            t->add_empty_row(thread_count);
+            wt.commit();
+        }
+
+        // One of the writers does not use group commit, and makes all the
+        // versions before its own durable
+        Thread threads[thread_count];
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads[i].start([&, i] {
+                auto window = i == 0 ? std::chrono::microseconds::zero() : std::chrono::microseconds(100000);
+                SharedGroup sg_2(path, false, group_commit_options(window));
+                for (int j = 0; j < num_commits; ++j) {
+                    WriteTransaction wt(sg_2);
+                    wt.get_table("test")->add_int(0, i, 1);
+                    wt.commit();
+                }
+            });
+        }
+        for (size_t i = 0; i < thread_count; ++i)
+            threads[i].join();
+
+        ReadTransaction rt(sg);
+        ConstTableRef t = rt.get_table("test");
+        for (size_t i = 0; i < thread_count; ++i)
+            CHECK_EQUAL(num_commits, t->get_int(0, i));
+    }
+
+    // A new session starts from the version the header of the file refers to
+    SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+    ReadTransaction rt(sg);
+    ConstTableRef t = rt.get_table("test");
+    for (size_t i = 0; i < thread_count; ++i)
+        CHECK_EQUAL(num_commits, t->get_int(0, i));
+}
+
+
+TEST(Shared_GroupCommitWithRollback)
+{
+    // A writer that leaves the sync to a waiting writer, which then rolls
+    // back, must sync itself
+    SHARED_GROUP_TEST_PATH(path);
+    {
+        SharedGroup sg(path, false, group_commit_options(std::chrono::milliseconds(20)));
+        SharedGroup sg_2(path, false, group_commit_options(std::chrono::milliseconds(20)));
+        {
+            WriteTransaction wt(sg);
+            wt.add_table("test")->add_column(type_Int, "int");
+            wt.commit();
+        }
+
+        WriteTransaction wt(sg);
+        wt.get_table("test")->add_empty_row();
+        Thread thread;
+        thread.start([&] {
+            WriteTransaction wt_2(sg_2);
+            wt_2.get_table("test")->add_empty_row();
+        });
+        // Give the thread time to start waiting for the write mutex
+        millisleep(50);
+        wt.commit();
+        thread.join();
+
+        ReadTransaction rt(sg_2);
+        CHECK_EQUAL(1, rt.get_table("test")->size());
+    }
+
+    SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+    ReadTransaction rt(sg);
+    CHECK_EQUAL(1, rt.get_table("test")->size());
+}
+
+TEST(Shared_BackgroundDurability)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    const size_t thread_count = 4;
+    const int num_commits = 50;
+    const SharedGroupOptions options(SharedGroupOptions::Durability::Background);
+    {
+        SharedGroup sg(path, false, options);
+        SharedGroup::version_type version;
+        {
+            WriteTransaction wt(sg);
+            TableRef t = wt.add_table("test");
+            t->add_column(type_Int, "count");
+            t->add_empty_row(thread_count);
+            version = wt.commit();
+        }
+        sg.wait_for_durable(version);
+        CHECK_EQUAL(version, sg.get_durable_version());
+
+        Thread threads[thread_count];
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads[i].start([&, i] {
+                SharedGroup sg_2(path, false, options);
+                SharedGroup::version_type last_version = 0;
+                for (int j = 0; j < num_commits; ++j) {
+                    WriteTransaction wt(sg_2);
+                    wt.get_table("test")->add_int(0, i, 1);
+                    last_version = wt.commit();
+                }
+                sg_2.wait_for_durable(last_version);
+                CHECK_GREATER_EQUAL(sg_2.get_durable_version(), last_version);
+            });
+        }
+        for (size_t i = 0; i < thread_count; ++i)
+            threads[i].join();
+
+        // Versions committed by other SharedGroups
+        sg.begin_read();
+        version = sg.get_version_of_current_transaction().version;
+        sg.end_read();
+        sg.wait_for_durable(version);
+        CHECK_EQUAL(version, sg.get_durable_version());
+
+        // The background thread is stopped during compaction, and restarted
+        CHECK(sg.compact());
+        {
+            WriteTransaction wt(sg);
+            wt.get_table("test")->add_int(0, 0, 1);
+            version = wt.commit();
+        }
+        sg.wait_for_durable(version);
+        CHECK_EQUAL(version, sg.get_durable_version());
+    }
+
+    // A new session starts from the version the header of the file refers to
+    SharedGroup sg(path, false, SharedGroupOptions(SharedGroupOptions::Durability::Full));
+    ReadTransaction rt(sg);
+    ConstTableRef t = rt.get_table("test");
+    CHECK_EQUAL(num_commits + 1, t->get_int(0, 0));
+    for (size_t i = 1; i < thread_count; ++i)
+        CHECK_EQUAL(num_commits, t->get_int(0, i));
+}
+
+
+TEST(Shared_BackgroundDurabilityErrors)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroup sg(path, false, SharedGroupOptions(SharedGroupOptions::Durability::Background));
+    CHECK_LOGIC_ERROR(sg.wait_for_durable(sg.get_durable_version() + 1), LogicError::bad_version);
+    {
+        WriteTransaction wt(sg);
+        CHECK_LOGIC_ERROR(sg.wait_for_durable(sg.get_durable_version()), LogicError::wrong_transact_state);
+    }
+    CHECK_LOGIC_ERROR(SharedGroup(path, false, SharedGroupOptions(SharedGroupOptions::Durability::Full)),
+                      LogicError::mixed_durability);
+
+    SHARED_GROUP_TEST_PATH(path_2);
+    const char* key = "1234567890123456789012345678901123456789012345678901234567890123";
+    SharedGroupOptions options(SharedGroupOptions::Durability::Background, key);
+    CHECK_THROW(SharedGroup(path_2, false, options), std::runtime_error);
+}
+
+TEST(Shared_ChangesetLog)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(path_2);
+    const int num_commits = 20;
+    const SharedGroupOptions options(SharedGroupOptions::Durability::ChangesetLog);
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path));
+        SharedGroup sg(*hist, options);
+        {
+            WriteTransaction wt(sg);
+            TableRef t = wt.add_table("test");
+            t->add_column(type_Int, "value");
+            t->add_column(type_String, "name");
+            t->add_empty_row();
+            wt.commit();
+        }
+        for (int i = 0; i < num_commits; ++i) {
+            WriteTransaction wt(sg);
+            TableRef t = wt.get_table("test");
+            t->add_int(0, 0, 1);
+            std::string name = "name " + util::to_string(i);
+            t->set_string(1, 0, name);
+            SharedGroup::version_type version = wt.commit();
+            CHECK_EQUAL(version, sg.get_durable_version());
+        }
+        CHECK_GREATER(File(std::string(path) + ".changeset_log").get_size(), 0);
+
+        // Simulate a crash by copying the files while the session is open. The
+        // header of the copy refers to the initial version, and the rest is in
+        // the log.
+        File::copy(path, path_2);
+        File::copy(std::string(path) + ".changeset_log", std::string(path_2) + ".changeset_log");
+    }
+
+    // The session ended with a checkpoint
+    CHECK_EQUAL(0, File(std::string(path) + ".changeset_log").get_size());
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path));
+        SharedGroup sg(*hist, options);
+        ReadTransaction rt(sg);
+        ConstTableRef t = rt.get_table("test");
+        CHECK_EQUAL(num_commits, t->get_int(0, 0));
+        CHECK_EQUAL("name " + util::to_string(num_commits - 1), t->get_string(1, 0));
+    }
+
+    // The changesets are replayed when the next session starts
+    std::unique_ptr<Replication> hist(make_in_realm_history(path_2));
+    SharedGroup sg(*hist, options);
+    {
+        ReadTransaction rt(sg);
+        ConstTableRef t = rt.get_table("test");
+        CHECK(t);
+        CHECK_EQUAL(num_commits, t->get_int(0, 0));
+        CHECK_EQUAL("name " + util::to_string(num_commits - 1), t->get_string(1, 0));
+    }
+    {
+        WriteTransaction wt(sg);
+        wt.get_table("test")->add_int(0, 0, 1);
+        wt.commit();
+    }
+    ReadTransaction rt(sg);
+    CHECK_EQUAL(num_commits + 1, rt.get_table("test")->get_int(0, 0));
+}
+
+
+TEST(Shared_ChangesetLogCheckpoint)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(path_2);
+    const int num_commits = 100;
+    SharedGroupOptions options(SharedGroupOptions::Durability::ChangesetLog);
+    options.changeset_log_checkpoint_size = 256;
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path));
+        SharedGroup sg(*hist, options);
+        {
+            WriteTransaction wt(sg);
+            TableRef t = wt.add_table("test");
+            t->add_column(type_Int, "value");
+            wt.commit();
+        }
+        for (int i = 0; i < num_commits; ++i) {
+            WriteTransaction wt(sg);
+            wt.get_table("test")->add_empty_row();
+            wt.get_table("test")->set_int(0, i, i);
+            wt.commit();
+        }
+        File::copy(path, path_2);
+        File::copy(std::string(path) + ".changeset_log", std::string(path_2) + ".changeset_log");
+    }
+
+    // The log is restarted at the checkpoints, so only the changesets after
+    // the last one are replayed
+    std::unique_ptr<Replication> hist(make_in_realm_history(path_2));
+    SharedGroup sg(*hist, options);
+    ReadTransaction rt(sg);
+    ConstTableRef t = rt.get_table("test");
+    CHECK_EQUAL(num_commits, t->size());
+    for (int i = 0; i < num_commits; ++i)
+        CHECK_EQUAL(i, t->get_int(0, i));
+}
+
+
+TEST_IF(Shared_ChangesetLogReplayFailure, _impl::SimulatedFailure::is_enabled())
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(path_2);
+    const int num_commits = 20;
+    const SharedGroupOptions options(SharedGroupOptions::Durability::ChangesetLog);
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path));
+        SharedGroup sg(*hist, options);
+        {
+            WriteTransaction wt(sg);
+            wt.add_table("test")->add_column(type_Int, "value");
+            wt.commit();
+        }
+        for (int i = 0; i < num_commits; ++i) {
+            WriteTransaction wt(sg);
+            wt.get_table("test")->add_empty_row();
+            wt.get_table("test")->set_int(0, i, i);
+            wt.commit();
+        }
+        File::copy(path, path_2);
+        File::copy(std::string(path) + ".changeset_log", std::string(path_2) + ".changeset_log");
+    }
+
+    // Fail after the first changeset has been replayed. That one is not synced
+    // to the Realm file, so the log must keep all of them.
+    std::string log_path = std::string(path_2) + ".changeset_log";
+    auto log_size = File(log_path).get_size();
+    {
+        using sf = _impl::SimulatedFailure;
+        std::unique_ptr<Replication> hist(make_in_realm_history(path_2));
+        sf::OneShotPrimeGuard pg(sf::shared_group__replay_changeset_log);
+        CHECK_THROW(SharedGroup(*hist, options), sf);
+    }
+    CHECK_EQUAL(log_size, File(log_path).get_size());
+
+    std::unique_ptr<Replication> hist(make_in_realm_history(path_2));
+    SharedGroup sg(*hist, options);
+    ReadTransaction rt(sg);
+    ConstTableRef t = rt.get_table("test");
+    CHECK_EQUAL(num_commits, t->size());
+    for (int i = 0; i < num_commits; ++i)
+        CHECK_EQUAL(i, t->get_int(0, i));
+}
+
+
+TEST(Shared_ChangesetLogOtherDurability)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(path_2);
+    std::string log_path = std::string(path_2) + ".changeset_log";
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path));
+        SharedGroup sg(*hist, SharedGroupOptions(SharedGroupOptions::Durability::ChangesetLog));
+        WriteTransaction wt(sg);
+        wt.add_table("test")->add_column(type_Int, "value");
+        wt.get_table("test")->add_empty_row();
+        wt.commit();
+        File::copy(path, path_2);
+        File::copy(std::string(path) + ".changeset_log", log_path);
+    }
+
+    // The logged commit must not be skipped
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path_2));
+        SharedGroupOptions options(SharedGroupOptions::Durability::Full);
+        CHECK_THROW(SharedGroup(*hist, options), std::runtime_error);
+        options.durability = SharedGroupOptions::Durability::MemOnly;
+        CHECK_THROW(SharedGroup(*hist, options), std::runtime_error);
+    }
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path_2));
+        SharedGroup sg(*hist, SharedGroupOptions(SharedGroupOptions::Durability::ChangesetLog));
+        ReadTransaction rt(sg);
+        CHECK_EQUAL(1, rt.get_table("test")->size());
+    }
+
+    // Once it is in the Realm file, a session with another durability removes
+    // the log
+    CHECK(File::exists(log_path));
+    std::unique_ptr<Replication> hist(make_in_realm_history(path_2));
+    SharedGroup sg(*hist, SharedGroupOptions(SharedGroupOptions::Durability::Full));
+    CHECK_NOT(File::exists(log_path));
+    {
+        WriteTransaction wt(sg);
+        wt.get_table("test")->add_empty_row();
+        wt.commit();
+    }
+    ReadTransaction rt(sg);
+    CHECK_EQUAL(2, rt.get_table("test")->size());
+}
+
+
+TEST(Shared_ChangesetLogOfAnotherFile)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(path_2);
+    SHARED_GROUP_TEST_PATH(path_3);
+    auto populate = [](const std::string& p, size_t num_rows) {
+        std::unique_ptr<Replication> hist(make_in_realm_history(p));
+        SharedGroup sg(*hist, SharedGroupOptions(SharedGroupOptions::Durability::Full));
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("test");
+        table->add_column(type_Int, "value");
+        table->add_empty_row(num_rows);
+        for (size_t i = 0; i < num_rows; ++i)
+            table->set_int(0, i, int64_t(i));
+        return wt.commit();
+    };
+
+    // Two files at the same version, but with different contents
+    SharedGroup::version_type version = populate(path, 10);
+    CHECK_EQUAL(version, populate(path_2, 1000));
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path));
+        SharedGroup sg(*hist, SharedGroupOptions(SharedGroupOptions::Durability::ChangesetLog));
+        WriteTransaction wt(sg);
+        wt.get_table("test")->set_int(0, 0, 1);
+        CHECK_EQUAL(version + 1, wt.commit());
+        File::copy(path, path_3);
+        File::copy(std::string(path) + ".changeset_log", std::string(path_2) + ".changeset_log");
+    }
+
+    // The log continues from the version of the second file, but was not
+    // committed on top of it
+    std::unique_ptr<Replication> hist(make_in_realm_history(path_2));
+    SharedGroupOptions options(SharedGroupOptions::Durability::ChangesetLog);
+    CHECK_THROW(SharedGroup(*hist, options), std::runtime_error);
+    options.durability = SharedGroupOptions::Durability::Full;
+    CHECK_THROW(SharedGroup(*hist, options), std::runtime_error);
+
+    // The first file replays it
+    File::copy(std::string(path_2) + ".changeset_log", std::string(path_3) + ".changeset_log");
+    std::unique_ptr<Replication> hist_3(make_in_realm_history(path_3));
+    SharedGroup sg(*hist_3, SharedGroupOptions(SharedGroupOptions::Durability::ChangesetLog));
+    ReadTransaction rt(sg);
+    CHECK_EQUAL(10, rt.get_table("test")->size());
+    CHECK_EQUAL(1, rt.get_table("test")->get_int(0, 0));
+}
+
+
+TEST(Shared_ChangesetLogErrors)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    const SharedGroupOptions options(SharedGroupOptions::Durability::ChangesetLog);
+
+    // The changesets are obtained from the history
+    CHECK_THROW(SharedGroup(path, false, options), std::runtime_error);
+
+    const char* key = "1234567890123456789012345678901123456789012345678901234567890123";
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroupOptions options_2(SharedGroupOptions::Durability::ChangesetLog, key);
+    CHECK_THROW(SharedGroup(*hist, options_2), std::runtime_error);
+}
+
 #if !REALM_ENABLE_ENCRYPTION && defined(ENABLE_ROBUST_AGAINST_DEATH_DURING_WRITE)
 // this unittest has issues that has not been fully understood, but could be
 // related to interaction between posix robust mutexes and the fork() system call.
@@ -2718,6 +3153,114 @@ TEST(Shared_VersionCount)
     CHECK_EQUAL(2, sg_r.get_number_of_versions());
 }
 
+TEST(Shared_ReaderSlots)
+{
+    // More readers than there are reader slots, so that some of them hold
+    // their read locks through the ringbuffer
+    SHARED_GROUP_TEST_PATH(path);
+    const size_t num_readers = 80;
+    SharedGroup sg_w(path);
+    {
+        WriteTransaction wt(sg_w);
+        TableRef t = wt.add_table("test");
+        t->add_column(type_Int, "value");
+        t->add_empty_row();
+        wt.commit();
+    }
+    std::unique_ptr<SharedGroup> readers[num_readers];
+    const Group* groups[num_readers];
+    for (size_t i = 0; i < num_readers; ++i) {
+        readers[i].reset(new SharedGroup(path));
+        groups[i] = &readers[i]->begin_read();
+        WriteTransaction wt(sg_w);
+        wt.get_table("test")->set_int(0, 0, int64_t(i + 1));
+        wt.commit();
+    }
+    CHECK_EQUAL(num_readers + 1, sg_w.get_number_of_versions());
+
+    // The versions are retained until the readers end their transactions
+    for (size_t i = 0; i < num_readers; ++i) {
+        {
+            WriteTransaction wt(sg_w);
+            wt.commit();
+        }
+        ConstTableRef t = groups[i]->get_table("test");
+        CHECK_EQUAL(int64_t(i), t->get_int(0, 0));
+        readers[i]->end_read();
+    }
+    {
+        WriteTransaction wt(sg_w);
+        wt.commit();
+    }
+    CHECK_EQUAL(2, sg_w.get_number_of_versions());
+
+    // A second read lock of a SharedGroup is held through the ringbuffer
+    SharedGroup& sg_r = *readers[0];
+    sg_r.begin_read();
+    SharedGroup::VersionID version = sg_r.pin_version();
+    sg_r.end_read();
+    for (int i = 0; i < 3; ++i) {
+        WriteTransaction wt(sg_w);
+        wt.commit();
+    }
+    CHECK_EQUAL(4, sg_w.get_number_of_versions());
+    sg_r.begin_read(version);
+    sg_r.end_read();
+    sg_r.unpin_version(version);
+    {
+        WriteTransaction wt(sg_w);
+        wt.commit();
+    }
+    CHECK_EQUAL(2, sg_w.get_number_of_versions());
+}
+
+
+TEST(Shared_ReaderSlotsConcurrentReads)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    const size_t num_readers = 8;
+    const int num_commits = 200;
+    {
+        SharedGroup sg(path);
+        WriteTransaction wt(sg);
+        TableRef t = wt.add_table("test");
+        t->add_column(type_Int, "a");
+        t->add_column(type_Int, "b");
+        t->add_empty_row();
+        wt.commit();
+    }
+
+    // The writer keeps the two values equal, and frees the versions the
+    // readers are done with
+    std::atomic<bool> done(false);
+    Thread readers[num_readers];
+    for (size_t i = 0; i < num_readers; ++i) {
+        readers[i].start([&] {
+            SharedGroup sg(path);
+            while (!done) {
+                ReadTransaction rt(sg);
+                ConstTableRef t = rt.get_table("test");
+                int64_t a = t->get_int(0, 0);
+                int64_t b = t->get_int(1, 0);
+                if (a != b)
+                    CHECK_EQUAL(a, b);
+            }
+        });
+    }
+    SharedGroup sg(path);
+    for (int i = 0; i < num_commits; ++i) {
+        WriteTransaction wt(sg);
+        TableRef t = wt.get_table("test");
+        t->set_int(0, 0, i);
+        t->add_empty_row(10);
+        t->set_int(1, 0, i);
+        wt.commit();
+    }
+    done = true;
+    for (size_t i = 0; i < num_readers; ++i)
+        readers[i].join();
+}
+
 TEST(Shared_MultipleRollbacks)
 {
     SHARED_GROUP_TEST_PATH(path);
@@ -3183,6 +3726,340 @@ TEST(Shared_CompactEmpty)
 }
 
 
+namespace {
+
+// Leaves a file whose live data is at the end, after the free space left by
+// the table "big"
+void fill_for_incremental_compaction(SharedGroup& sg)
+{
+    std::string value(200, 'x');
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("big");
+        table->add_column(type_String, "value");
+        table->add_empty_row(20000);
+        for (size_t i = 0; i < 20000; ++i)
+            table->set_string(0, i, value);
+        wt.commit();
+    }
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("small");
+        table->add_column(type_String, "value");
+        table->add_column(type_Int, "index");
+        table->add_empty_row(1000);
+        for (size_t i = 0; i < 1000; ++i) {
+            table->set_string(0, i, value);
+            table->set_int(1, i, int64_t(i));
+        }
+        wt.commit();
+    }
+    {
+        WriteTransaction wt(sg);
+        wt.get_table("big")->clear();
+        wt.commit();
+    }
+}
+
+void check_after_incremental_compaction(TestContext& test_context, const Group& group)
+{
+    group.verify();
+    CHECK_EQUAL(0, group.get_table("big")->size());
+    ConstTableRef table = group.get_table("small");
+    CHECK_EQUAL(1000, table->size());
+    for (size_t i = 0; i < table->size(); ++i) {
+        CHECK_EQUAL(std::string(200, 'x'), table->get_string(0, i));
+        CHECK_EQUAL(int64_t(i), table->get_int(1, i));
+    }
+}
+
+} // anonymous namespace
+
+
+TEST(Shared_CompactIncrementally)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist = make_in_realm_history(path);
+    SharedGroup sg(*hist);
+    fill_for_incremental_compaction(sg);
+    size_t size_before = size_t(File(path).get_size());
+
+    size_t num_steps = 0;
+    while (sg.compact_incrementally(std::chrono::microseconds(200))) {
+        if (!CHECK_LESS(++num_steps, 10000))
+            break;
+    }
+#ifndef _WIN32
+    CHECK_LESS(size_t(File(path).get_size()) * 2, size_before);
+#endif
+    {
+        ReadTransaction rt(sg);
+        check_after_incremental_compaction(test_context, rt.get_group());
+    }
+
+    // Compacting again does not make the file grow
+    size_t size_after = size_t(File(path).get_size());
+    for (int i = 0; i < 3; ++i) {
+        num_steps = 0;
+        while (sg.compact_incrementally()) {
+            if (!CHECK_LESS(++num_steps, 10000))
+                break;
+        }
+    }
+    CHECK_LESS_EQUAL(size_t(File(path).get_size()), size_after);
+
+    // The file grows again as needed
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.get_table("big");
+        std::string value(200, 'y');
+        table->add_empty_row(20000);
+        for (size_t i = 0; i < 20000; ++i)
+            table->set_string(0, i, value);
+        wt.commit();
+    }
+    {
+        ReadTransaction rt(sg);
+        rt.get_group().verify();
+        CHECK_EQUAL(20000, rt.get_table("big")->size());
+        CHECK_EQUAL(std::string(200, 'y'), rt.get_table("big")->get_string(0, 19999));
+    }
+}
+
+
+TEST(Shared_CompactIncrementallyWithReader)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist = make_in_realm_history(path);
+    std::unique_ptr<Replication> hist_2 = make_in_realm_history(path);
+    SharedGroup sg(*hist);
+    SharedGroup sg_2(*hist_2);
+    fill_for_incremental_compaction(sg);
+    size_t size_before = size_t(File(path).get_size());
+
+    // A reader bound before the relocation keeps the space at the end in use,
+    // while the arrays are relocated one per step
+    CHECK(sg.compact_incrementally(std::chrono::microseconds(0)));
+    {
+        ReadTransaction rt(sg_2);
+        for (int i = 0; i < 1000; ++i) {
+            if (!sg.compact_incrementally(std::chrono::microseconds(0)))
+                break;
+        }
+        check_after_incremental_compaction(test_context, rt.get_group());
+    }
+
+    size_t num_steps = 0;
+    while (sg.compact_incrementally(std::chrono::microseconds(0))) {
+        if (!CHECK_LESS(++num_steps, 10000))
+            break;
+    }
+#ifndef _WIN32
+    CHECK_LESS(size_t(File(path).get_size()) * 2, size_before);
+#endif
+    ReadTransaction rt(sg_2);
+    check_after_incremental_compaction(test_context, rt.get_group());
+}
+
+
+TEST(Shared_CompactIncrementallyKeepsAccessors)
+{
+    // Accessors kept across advance_read() must follow the relocated arrays
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist = make_in_realm_history(path);
+    std::unique_ptr<Replication> hist_2 = make_in_realm_history(path);
+    SharedGroup sg(*hist);
+    SharedGroup sg_2(*hist_2);
+    fill_for_incremental_compaction(sg);
+
+    const Group& group = sg_2.begin_read();
+    ConstTableRef table = group.get_table("small");
+    ConstRow row = table->get(999);
+    ConstTableView view = table->where().greater_equal(1, 500).find_all();
+    CHECK_EQUAL(500, view.size());
+
+    auto check_accessors = [&] {
+        CHECK_EQUAL(1000, table->size());
+        CHECK_EQUAL(999, row.get_int(1));
+        CHECK_EQUAL(std::string(200, 'x'), row.get_string(0));
+        CHECK_EQUAL(500, table->get_int(1, 500));
+        CHECK_EQUAL(500, view.size());
+        CHECK_EQUAL(500, view.get_int(1, 0));
+        CHECK_EQUAL(std::string(200, 'x'), view.get_string(0, 499));
+    };
+
+    size_t num_steps = 0;
+    while (sg.compact_incrementally(std::chrono::microseconds(0))) {
+        LangBindHelper::advance_read(sg_2);
+        check_accessors();
+        if (!CHECK_LESS(++num_steps, 10000))
+            break;
+    }
+    LangBindHelper::advance_read(sg_2);
+    check_accessors();
+
+    // Reuse the space that the arrays were relocated from
+    {
+        WriteTransaction wt(sg);
+        TableRef big = wt.get_table("big");
+        std::string value(200, 'y');
+        big->add_empty_row(20000);
+        for (size_t i = 0; i < 20000; ++i)
+            big->set_string(0, i, value);
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg_2);
+    check_accessors();
+    sg_2.end_read();
+}
+
+
+TEST(Shared_ParallelTableWrites)
+{
+    // Enough changes in several tables for them to be written in parallel
+    // where there is more than one core
+    SHARED_GROUP_TEST_PATH(path);
+    const size_t num_tables = 6;
+    const size_t num_rows = 10000;
+    auto value = [](size_t t, size_t i) { return std::string("table ") + util::to_string(t) + " row " +
+                                                 util::to_string(i); };
+    auto check_tables = [&](const Group& g, size_t num_changed) {
+        for (size_t t = 0; t < num_tables; ++t) {
+            ConstTableRef table = g.get_table(t);
+            CHECK_EQUAL(table->size(), num_rows);
+            for (size_t i = 0; i < num_rows; ++i) {
+                int64_t expected = t < num_changed ? int64_t(2 * i) : int64_t(i);
+                if (!CHECK_EQUAL(table->get_int(0, i), expected))
+                    return;
+                std::string expected_string = value(t, i);
+                if (!CHECK_EQUAL(table->get_string(1, i), expected_string))
+                    return;
+            }
+        }
+    };
+
+    SharedGroup sg(path);
+    {
+        WriteTransaction wt(sg);
+        for (size_t t = 0; t < num_tables; ++t) {
+            std::string name = "table_" + util::to_string(t);
+            TableRef table = wt.add_table(name);
+            table->add_column(type_Int, "int");
+            table->add_column(type_String, "string");
+            table->add_empty_row(num_rows);
+            for (size_t i = 0; i < num_rows; ++i) {
+                std::string string = value(t, i);
+                table->set_int(0, i, i);
+                table->set_string(1, i, string);
+            }
+        }
+        wt.commit();
+    }
+    // Modify some of the tables only
+    {
+        WriteTransaction wt(sg);
+        for (size_t t = 0; t < num_tables / 2; ++t) {
+            TableRef table = wt.get_table(t);
+            for (size_t i = 0; i < num_rows; ++i)
+                table->set_int(0, i, 2 * i);
+        }
+        wt.commit();
+    }
+
+    SharedGroup sg_2(path);
+    ReadTransaction rt(sg_2);
+    rt.get_group().verify();
+    check_tables(rt.get_group(), num_tables / 2);
+}
+
+
+TEST(Shared_ParallelTableWritesLayout)
+{
+    // The tables are laid out in the file the same way whatever the number of
+    // threads that write them
+    SHARED_GROUP_TEST_PATH(path_1);
+    SHARED_GROUP_TEST_PATH(path_2);
+    const size_t num_tables = 6;
+    const size_t num_rows = 20000;
+    auto write = [&](const std::string& path, size_t max_write_threads, size_t& free_space, size_t& used_space) {
+        SharedGroupOptions options;
+        options.max_write_threads = max_write_threads;
+        SharedGroup sg(path, false, options);
+        {
+            WriteTransaction wt(sg);
+            for (size_t t = 0; t < num_tables; ++t) {
+                std::string name = "table_" + util::to_string(t);
+                TableRef table = wt.add_table(name);
+                table->add_column(type_Int, "int");
+                table->add_column(type_String, "string");
+                table->add_empty_row(num_rows);
+                for (size_t i = 0; i < num_rows; ++i) {
+                    std::string string = "table " + util::to_string(t) + " row " + util::to_string(i);
+                    table->set_int(0, i, i);
+                    table->set_string(1, i, string);
+                }
+            }
+            wt.commit();
+        }
+        // Rewrite some of the tables, leaving the space they took up free
+        {
+            WriteTransaction wt(sg);
+            for (size_t t = 0; t < num_tables / 2; ++t) {
+                TableRef table = wt.get_table(t);
+                for (size_t i = 0; i < num_rows; ++i) {
+                    std::string string = "changed " + util::to_string(i);
+                    table->set_int(0, i, int64_t(1) << 40);
+                    table->set_string(1, i, string);
+                }
+            }
+            wt.commit();
+        }
+        sg.get_stats(free_space, used_space);
+    };
+    // The entries of the top array, which include the refs of the tables and
+    // of the free-lists and the logical file size, followed by the free-lists.
+    // The rest of the file may differ in the padding at the end of the arrays,
+    // which is copied from uninitialized memory.
+    auto get_layout = [](const std::string& path) {
+        SharedGroup sg(path);
+        ReadTransaction rt(sg);
+        Allocator& alloc = const_cast<Allocator&>(_impl::GroupFriend::get_alloc(rt.get_group()));
+        std::vector<int64_t> layout;
+        layout.push_back(int64_t(_impl::GroupFriend::get_top_ref(rt.get_group())));
+        Array top(alloc);
+        top.init_from_ref(_impl::GroupFriend::get_top_ref(rt.get_group()));
+        for (size_t i = 0; i < top.size(); ++i)
+            layout.push_back(top.get(i));
+        for (size_t i = 3; i <= 4; ++i) {
+            Array free_list(alloc);
+            free_list.init_from_ref(top.get_as_ref(i));
+            layout.push_back(int64_t(free_list.size()));
+            for (size_t j = 0; j < free_list.size(); ++j)
+                layout.push_back(free_list.get(j));
+        }
+        return layout;
+    };
+
+    size_t free_space_1 = 0, used_space_1 = 0;
+    write(path_1, 1, free_space_1, used_space_1);
+    size_t free_space_2 = 0, used_space_2 = 0;
+    write(path_2, 4, free_space_2, used_space_2);
+    CHECK_EQUAL(free_space_1, free_space_2);
+    CHECK_EQUAL(used_space_1, used_space_2);
+    CHECK_GREATER(free_space_1, 0);
+    std::vector<int64_t> layout_1 = get_layout(path_1);
+    std::vector<int64_t> layout_2 = get_layout(path_2);
+    CHECK(layout_1 == layout_2);
+    CHECK_EQUAL(util::File(path_1).get_size(), util::File(path_2).get_size());
+
+    SharedGroup sg(path_2);
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    CHECK_EQUAL(rt.get_table(0)->get_int(0, 0), int64_t(1) << 40);
+    CHECK_EQUAL(rt.get_table(num_tables - 1)->get_int(0, num_rows - 1), int64_t(num_rows - 1));
+}
+
+
 TEST(Shared_VersionOfBoundSnapshot)
 {
     SHARED_GROUP_TEST_PATH(path);
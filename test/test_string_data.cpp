@@ -24,6 +24,7 @@
 #include <sstream>
 
 #include <realm.hpp>
+#include <realm/like_pattern.hpp>
 #include <realm/string_data.hpp>
 #include <realm/unicode.hpp>
 
@@ -371,6 +372,53 @@ TEST(StringData_Like_CaseInsensitive)
     CHECK(!string_like_ins(foobarfoo, "*f*x*"));
 }
 
+TEST(StringData_LikePattern)
+{
+    // Compare the compiled patterns with the backtracking matcher, on random
+    // texts and patterns over a small alphabet with multi-byte characters and
+    // characters which have a case
+    const char* pieces[] = {"a", "A", "b", "B", "*", "?", "\xc3\xa6", "\xc3\x86", "\xe6\x97\xa5"}; // æ, Æ, 日
+    const size_t num_pieces = sizeof pieces / sizeof pieces[0];
+    const char* text_pieces[] = {"a", "A", "b", "B", "\xc3\xa6", "\xc3\x86", "\xe6\x97\xa5"};
+    const size_t num_text_pieces = sizeof text_pieces / sizeof text_pieces[0];
+    test_util::Random random(test_util::random_int<unsigned long>()); // Seed from slow global generator
+
+    for (int i = 0; i < 2000; ++i) {
+        std::string pattern;
+        size_t pattern_size = random.draw_int<size_t>(0, 6);
+        for (size_t j = 0; j < pattern_size; ++j)
+            pattern += pieces[random.draw_int_mod(num_pieces)];
+
+        LikePattern compiled(pattern);
+        std::string upper = *case_map(pattern, true);
+        std::string lower = *case_map(pattern, false);
+        LikePattern compiled_ins(upper, lower);
+
+        for (int k = 0; k < 20; ++k) {
+            std::string text;
+            size_t text_size = random.draw_int<size_t>(0, 8);
+            for (size_t j = 0; j < text_size; ++j)
+                text += text_pieces[random.draw_int_mod(num_text_pieces)];
+            // Split a multi-byte character now and then
+            if (!text.empty() && random.chance(1, 10))
+                text.erase(random.draw_int_mod(text.size()), 1);
+
+            StringData t(text);
+            CHECK_EQUAL(t.like(pattern), compiled.matches(t));
+            CHECK_EQUAL(string_like_ins(t, lower, upper), compiled_ins.matches(t));
+        }
+    }
+
+    StringData null = realm::null();
+    CHECK(LikePattern(null).matches(null));
+    CHECK(!LikePattern(null).matches(""));
+    CHECK(!LikePattern("*").matches(null));
+    CHECK(LikePattern().matches(null));
+    CHECK(!LikePattern().matches("*"));
+    CHECK(LikePattern("FOO*", "foo*").matches("fOobar"));
+    CHECK(!LikePattern("FOO*", "foo*").matches("fbar"));
+}
+
 TEST(StringData_Substrings)
 {
     // Reasoning behind behaviour is that if you append strings A + B then B is a suffix of a, and hence A
@@ -1522,6 +1522,246 @@ TEST(TableView_MultiColSort)
     CHECK_EQUAL(tv.get_float(1, 2), 1.f);
 }
 
+TEST(TableView_SortByExtractedKeys)
+{
+    // Views with more than a few rows are sorted by keys extracted up front. Check that the order agrees with the
+    // column comparison for every supported type, including nulls, NaN, signed zeroes, non-latin strings and null
+    // links, and that ties keep the order of the view.
+    Group g;
+    TableRef target = g.add_table("target");
+    TableRef origin = g.add_table("origin");
+    size_t target_int_col = target->add_column(type_Int, "int", true);
+    size_t target_str_col = target->add_column(type_String, "str", true);
+
+    size_t int_col = origin->add_column(type_Int, "int");
+    size_t null_int_col = origin->add_column(type_Int, "null_int", true);
+    size_t bool_col = origin->add_column(type_Bool, "bool");
+    size_t float_col = origin->add_column(type_Float, "float", true);
+    size_t double_col = origin->add_column(type_Double, "double", true);
+    size_t ts_col = origin->add_column(type_Timestamp, "ts", true);
+    size_t str_col = origin->add_column(type_String, "str", true);
+    size_t enum_col = origin->add_column(type_String, "enum", true);
+    size_t link_col = origin->add_column_link(type_Link, "link", *target);
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const char* characters[] = {"a", "B", "b", "\xc3\xa5", "\xc4\x80", "\xca\x92", "\xe4\xb8\xad", "\xf0\x9f\x98\x80"};
+    auto random_string = [&]() {
+        std::string str;
+        size_t len = random.draw_int_mod(10);
+        for (size_t i = 0; i < len; ++i)
+            str += characters[random.draw_int_mod(8)];
+        return str;
+    };
+    const float floats[] = {0.f, -0.f, 1.5f, -1.5f, std::numeric_limits<float>::infinity(),
+                            -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN()};
+    const double doubles[] = {0., -0., 2.5, -2.5, std::numeric_limits<double>::lowest(),
+                              std::numeric_limits<double>::max(), std::numeric_limits<double>::quiet_NaN()};
+
+    const size_t num_targets = 50;
+    target->add_empty_row(num_targets);
+    for (size_t i = 0; i < num_targets; ++i) {
+        if (random.draw_bool())
+            target->set_int(target_int_col, i, random.draw_int<int64_t>(-5, 5));
+        if (random.draw_bool()) {
+            std::string str = random_string();
+            target->set_string(target_str_col, i, str);
+        }
+    }
+
+    const size_t num_rows = 3000;
+    origin->add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        origin->set_int(int_col, i, random.draw_bool() ? random.draw_int<int64_t>(-100, 100)
+                                                       : random.draw_int<int64_t>());
+        if (random.draw_int_mod(4))
+            origin->set_int(null_int_col, i, random.draw_int<int64_t>(-3, 3));
+        origin->set_bool(bool_col, i, random.draw_bool());
+        if (random.draw_int_mod(8))
+            origin->set_float(float_col, i, floats[random.draw_int_mod(7)]);
+        if (random.draw_int_mod(8))
+            origin->set_double(double_col, i, doubles[random.draw_int_mod(7)]);
+        if (random.draw_int_mod(8)) {
+            int64_t seconds = random.draw_int<int64_t>(-3, 3);
+            int32_t nanoseconds = random.draw_int<int32_t>(0, 9) * 100000000;
+            if (seconds < 0 || (seconds == 0 && random.draw_bool()))
+                nanoseconds = -nanoseconds;
+            origin->set_timestamp(ts_col, i, Timestamp(seconds, nanoseconds));
+        }
+        if (random.draw_int_mod(8)) {
+            std::string str = random_string();
+            origin->set_string(str_col, i, str);
+        }
+        if (random.draw_int_mod(8))
+            origin->set_string(enum_col, i, characters[random.draw_int_mod(8)]);
+        if (random.draw_int_mod(8))
+            origin->set_link(link_col, i, random.draw_int_mod(num_targets));
+    }
+    origin->optimize(); // turns only the column with few distinct values into an enum column
+
+    using tf = _impl::TableFriend;
+    auto check_sorted = [&](std::vector<std::vector<size_t>> columns, std::vector<bool> ascending) {
+        TableView tv = origin->where().find_all();
+        tv.sort(SortDescriptor(*origin, columns, ascending));
+        CHECK_EQUAL(tv.size(), num_rows);
+
+        // Returns whether row `a` goes before (-1) or after (1) row `b`, or 0 if they are tied
+        auto order = [&](size_t a, size_t b) {
+            for (size_t i = 0; i < columns.size(); ++i) {
+                const Table* table = origin.get();
+                size_t row_a = a, row_b = b;
+                if (columns[i].size() == 2) {
+                    bool null_a = origin->is_null_link(link_col, a);
+                    bool null_b = origin->is_null_link(link_col, b);
+                    if (null_a && null_b)
+                        continue;
+                    if (null_a || null_b)
+                        return null_a == ascending[i] ? 1 : -1;
+                    row_a = origin->get_link(link_col, a);
+                    row_b = origin->get_link(link_col, b);
+                    table = target.get();
+                }
+                int c = tf::get_column(*table, columns[i].back()).compare_values(row_a, row_b);
+                if (c != 0)
+                    return ascending[i] ? -c : c;
+            }
+            return 0;
+        };
+        for (size_t i = 1; i < tv.size(); ++i) {
+            size_t a = tv.get_source_ndx(i - 1);
+            size_t b = tv.get_source_ndx(i);
+            int c = order(a, b);
+            CHECK(c < 0 || (c == 0 && a < b));
+        }
+    };
+
+    for (bool ascending : {true, false}) {
+        for (size_t col : {int_col, null_int_col, bool_col, float_col, double_col, ts_col, str_col, enum_col})
+            check_sorted({{col}}, {ascending});
+        check_sorted({{link_col, target_int_col}}, {ascending});
+        check_sorted({{link_col, target_str_col}}, {ascending});
+        check_sorted({{bool_col}, {str_col}, {link_col, target_int_col}, {ts_col}},
+                     {ascending, !ascending, ascending, !ascending});
+    }
+
+    // Other string compare methods go through utf8_compare() instead of binary keys
+    set_string_compare_method(STRING_COMPARE_CORE_SIMILAR, nullptr);
+    check_sorted({{str_col}}, {true});
+    check_sorted({{enum_col}, {str_col}}, {false, true});
+    set_string_compare_method(STRING_COMPARE_CORE, nullptr);
+}
+
+TEST(TableView_DistinctByExtractedKeys)
+{
+    // Views with more than a few rows are made distinct through a hash of keys extracted up front. The result must
+    // be the first row of every group of equal values, in view order, without rows having a null link on the way.
+    Group g;
+    TableRef target = g.add_table("target");
+    TableRef origin = g.add_table("origin");
+    size_t target_str_col = target->add_column(type_String, "str", true);
+
+    size_t int_col = origin->add_column(type_Int, "int", true);
+    size_t float_col = origin->add_column(type_Float, "float", true);
+    size_t double_col = origin->add_column(type_Double, "double", true);
+    size_t ts_col = origin->add_column(type_Timestamp, "ts", true);
+    size_t str_col = origin->add_column(type_String, "str", true);
+    size_t link_col = origin->add_column_link(type_Link, "link", *target);
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const char* strings[] = {"", "a", "A", "\xc3\xa5", "\xe4\xb8\xad"};
+    const float floats[] = {0.f, -0.f, 1.5f, std::numeric_limits<float>::quiet_NaN()};
+    const double doubles[] = {0., -0., -2.5, std::numeric_limits<double>::quiet_NaN()};
+
+    const size_t num_targets = 10;
+    target->add_empty_row(num_targets);
+    for (size_t i = 0; i < num_targets; ++i) {
+        if (random.draw_bool())
+            target->set_string(target_str_col, i, strings[random.draw_int_mod(5)]);
+    }
+
+    const size_t num_rows = 1000;
+    origin->add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (random.draw_int_mod(4))
+            origin->set_int(int_col, i, random.draw_int<int64_t>(-3, 3));
+        if (random.draw_int_mod(4))
+            origin->set_float(float_col, i, floats[random.draw_int_mod(4)]);
+        if (random.draw_int_mod(4))
+            origin->set_double(double_col, i, doubles[random.draw_int_mod(4)]);
+        if (random.draw_int_mod(4))
+            origin->set_timestamp(ts_col, i, Timestamp(random.draw_int<int64_t>(0, 2), 0));
+        if (random.draw_int_mod(4))
+            origin->set_string(str_col, i, strings[random.draw_int_mod(5)]);
+        if (random.draw_int_mod(4))
+            origin->set_link(link_col, i, random.draw_int_mod(num_targets));
+    }
+
+    using tf = _impl::TableFriend;
+    auto check_distinct = [&](std::vector<std::vector<size_t>> columns) {
+        TableView tv = origin->where().find_all();
+        tv.distinct(DistinctDescriptor(*origin, columns));
+
+        auto is_null_link = [&](size_t row) {
+            for (auto& chain : columns) {
+                if (chain.size() == 2 && origin->is_null_link(link_col, row))
+                    return true;
+            }
+            return false;
+        };
+        auto equal = [&](size_t a, size_t b) {
+            for (auto& chain : columns) {
+                const Table* table = origin.get();
+                size_t row_a = a, row_b = b;
+                if (chain.size() == 2) {
+                    row_a = origin->get_link(link_col, a);
+                    row_b = origin->get_link(link_col, b);
+                    table = target.get();
+                }
+                if (tf::get_column(*table, chain.back()).compare_values(row_a, row_b) != 0)
+                    return false;
+            }
+            return true;
+        };
+        std::vector<size_t> expected;
+        for (size_t row = 0; row < num_rows; ++row) {
+            if (is_null_link(row))
+                continue;
+            if (std::none_of(expected.begin(), expected.end(), [&](size_t kept) { return equal(kept, row); }))
+                expected.push_back(row);
+        }
+
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+            CHECK_EQUAL(tv.get_source_ndx(i), expected[i]);
+    };
+
+    for (size_t col : {int_col, float_col, double_col, ts_col, str_col})
+        check_distinct({{col}});
+    check_distinct({{link_col, target_str_col}});
+    check_distinct({{str_col}, {link_col, target_str_col}, {ts_col}});
+
+    origin->optimize(true);
+    check_distinct({{str_col}});
+    check_distinct({{int_col}, {str_col}});
+
+    // A preceding sort decides which row of a group is kept
+    TableView tv = origin->where().find_all();
+    DescriptorOrdering ordering;
+    ordering.append_sort(SortDescriptor(*origin, {{int_col}}, {false}));
+    ordering.append_distinct(DistinctDescriptor(*origin, {{str_col}}));
+    tv.apply_descriptor_ordering(ordering);
+    CHECK_EQUAL(tv.size(), 6); // 5 strings and null
+    for (size_t i = 0; i < tv.size(); ++i) {
+        StringData str = tv.get_string(str_col, i);
+        util::Optional<int64_t> max;
+        for (size_t row = 0; row < num_rows; ++row) {
+            if (origin->get_string(str_col, row) == str && !origin->is_null(int_col, row))
+                max = std::max(max.value_or(std::numeric_limits<int64_t>::min()), origin->get_int(int_col, row));
+        }
+        if (max)
+            CHECK_EQUAL(tv.get_int(int_col, i), *max);
+    }
+}
+
 TEST(TableView_QueryCopy)
 {
     Table table;
@@ -43,6 +43,7 @@
 #define TEST_ARRAY_FLOAT
 #define TEST_ARRAY_STRING
 #define TEST_ARRAY_STRING_LONG
+#define TEST_ASYNC_QUERY
 #define TEST_COLUMN
 #define TEST_COLUMN_BASIC
 #define TEST_COLUMN_BINARY
@@ -53,12 +54,14 @@
 #define TEST_FILE
 #define TEST_FILE_LOCKS
 #define TEST_GROUP
+#define TEST_GROUP_BY
 #define TEST_UPGRADE
 #define TEST_INDEX_STRING
 #define TEST_LANG_BIND_HELPER
 #define TEST_METRICS
 #define TEST_PARSER
 #define TEST_QUERY
+#define TEST_QUERY_CACHE
 #define TEST_SHARED
 #define TEST_STRING_DATA
 #define TEST_BINARY_DATA
@@ -69,6 +72,7 @@
 #define TEST_TRANSACTIONS
 #define TEST_TRANSACTIONS_LASSE
 #define TEST_REPLICATION
+#define TEST_ROW_BITMAP
 #define TEST_UTF8
 #define TEST_COLUMN_LARGE
 #define TEST_JSON